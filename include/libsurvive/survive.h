@@ -3,6 +3,8 @@
 
 #include "assert.h"
 #include "poser.h"
+#include "survive_metrics.h"
+#include "survive_trace.h"
 #include "survive_types.h"
 #include <stdbool.h>
 #include <stdint.h>
@@ -124,6 +126,24 @@ SURVIVE_EXPORT survive_long_timecode SurviveSensorActivations_last_time(const Su
  */
 SURVIVE_IMPORT extern survive_timecode SurviveSensorActivations_default_tolerance;
 
+#define SURVIVE_LATENCY_SAMPLES 1024
+
+/**
+ * Tracks how old published poses are relative to the host time the data that produced them was received.
+ */
+typedef struct SurviveObjectLatency {
+	// OGGetAbsoluteTimeUS of when the data currently being processed for the object was received. Drivers set this
+	// before dispatching the data; 0 means unknown and no latency is recorded.
+	uint64_t data_received_us;
+
+	// Ring of the most recent SURVIVE_LATENCY_SAMPLES latencies, in microseconds; allocated with the first one
+	uint32_t *samples_us;
+	uint64_t sample_cnt;
+	uint32_t max_us;
+
+	struct SurviveMetric *metric;
+} SurviveObjectLatency;
+
 struct SurviveObject {
 	SurviveContext *ctx;
 
@@ -220,6 +240,8 @@ struct SurviveObject {
 		uint32_t extent_hits, extent_misses, naive_hits;
 		FLT min_extent, max_extent;
 	} stats;
+
+	SurviveObjectLatency latency;
 };
 
 // These exports are mostly for language binding against
@@ -231,6 +253,14 @@ SURVIVE_EXPORT bool survive_object_charging(SurviveObject *so);
 
 SURVIVE_EXPORT const SurvivePose *survive_object_pose(SurviveObject *so);
 
+// Records the age of a pose about to be published against latency.data_received_us
+SURVIVE_EXPORT void survive_object_record_latency(SurviveObject *so);
+/**
+ * @return The given percentile (0 to 100) of the recent photon / IMU to pose latencies of the object in microseconds,
+ * or -1 if none were recorded.
+ */
+SURVIVE_EXPORT FLT survive_object_latency_percentile(const SurviveObject *so, FLT percentile);
+
 SURVIVE_EXPORT int8_t survive_object_sensor_ct(SurviveObject *so);
 SURVIVE_EXPORT const FLT *survive_object_sensor_locations(SurviveObject *so);
 SURVIVE_EXPORT const FLT *survive_object_sensor_normals(SurviveObject *so);
@@ -334,6 +364,7 @@ struct SurviveContext {
 
 	void *disambiguator_data;			 // global disambiguator data
 	struct SurviveRecordingData *recptr; // Iff recording is attached
+	struct SurviveMetrics *metrics;
 	SurviveObject **objs;
 	int objs_ct;
 
@@ -411,6 +442,29 @@ SURVIVE_EXPORT void survive_close(SurviveContext *ctx);
 SURVIVE_EXPORT void survive_get_ctx_lock(SurviveContext *ctx);
 SURVIVE_EXPORT void survive_release_ctx_lock(SurviveContext *ctx);
 
+struct survive_thread_pool;
+
+/**
+ * The context's worker threads; 'worker-threads' of them, shared by every solver that can split its work up. 0 if
+ * there are none, which every function below takes to mean the calling thread does all the work.
+ */
+SURVIVE_EXPORT struct survive_thread_pool *survive_get_thread_pool(SurviveContext *ctx);
+// Replaces the context's pool, returning the old one. The context frees whichever pool it has on close.
+SURVIVE_EXPORT struct survive_thread_pool *survive_install_thread_pool(SurviveContext *ctx,
+																	   struct survive_thread_pool *pool);
+
+// A pool of 'thread_cnt' threads, or of 'worker-threads' if that is negative
+SURVIVE_EXPORT struct survive_thread_pool *survive_thread_pool_create(SurviveContext *ctx, int thread_cnt);
+SURVIVE_EXPORT void survive_thread_pool_free(struct survive_thread_pool *pool);
+SURVIVE_EXPORT int survive_thread_pool_thread_cnt(const struct survive_thread_pool *pool);
+
+/**
+ * Runs fn(arg, i) for every i in [0, cnt) across the pool and the calling thread, and returns once all of them have.
+ * The pool runs one of these at a time; a call made while it is busy, including one from inside 'fn', runs on the
+ * calling thread. Matches mp_parallel_for.
+ */
+SURVIVE_EXPORT void survive_thread_pool_parallel_for(void *pool, int cnt, void (*fn)(void *arg, int i), void *arg);
+
 SURVIVE_EXPORT const char *survive_build_tag();
 
 SURVIVE_EXPORT SurviveObject *survive_get_so_by_name(SurviveContext *ctx, const char *name);
@@ -464,7 +518,9 @@ SURVIVE_EXPORT int8_t survive_get_bsd_idx(SurviveContext *ctx, survive_channel c
 	{                                                                                                                  \
 		if (ctx->hook##proc) {                                                                                         \
 			FLT start_time = OGRelativeTime();                                                                         \
+			SV_TRACE_BEGIN("hook " #hook);                                                                             \
 			ctx->hook##proc(ctx, __VA_ARGS__);                                                                         \
+			SV_TRACE_END("hook " #hook);                                                                               \
 			FLT this_time = OGRelativeTime() - start_time;                                                             \
 			if (this_time > ctx->hook##_max_call_time)                                                                 \
 				ctx->hook##_max_call_time = this_time;                                                                 \
@@ -479,7 +535,9 @@ SURVIVE_EXPORT int8_t survive_get_bsd_idx(SurviveContext *ctx, survive_channel c
 	{                                                                                                                  \
 		if (so->ctx->hook##proc) {                                                                                     \
 			FLT start_time = OGRelativeTime();                                                                         \
+			SV_TRACE_BEGIN_SO("hook " #hook, so);                                                                      \
 			so->ctx->hook##proc(so, ##__VA_ARGS__);                                                                    \
+			SV_TRACE_END("hook " #hook);                                                                               \
 			FLT this_time = OGRelativeTime() - start_time;                                                             \
 			if (this_time > so->ctx->hook##_max_call_time)                                                             \
 				so->ctx->hook##_max_call_time = this_time;                                                             \
@@ -554,6 +612,12 @@ SURVIVE_EXPORT void survive_default_sweep_process(SurviveObject *so, survive_cha
 												  survive_timecode timecode, bool flag);
 SURVIVE_EXPORT void survive_default_sweep_angle_process(SurviveObject *so, survive_channel channel, int sensor_id,
 														survive_timecode timecode, int8_t plane, FLT angle);
+SURVIVE_EXPORT void survive_default_lightcap_batch_process(SurviveObject *so, const LightcapElement *les, size_t cnt);
+SURVIVE_EXPORT void survive_default_sweep_batch_process(SurviveObject *so, const SurviveSweepEvent *events, size_t cnt);
+SURVIVE_EXPORT void survive_default_sweep_angle_batch_process(SurviveObject *so, const SurviveSweepAngleEvent *events,
+															  size_t cnt);
+SURVIVE_EXPORT void survive_default_raw_imu_batch_process(SurviveObject *so, const SurviveImuEvent *events, size_t cnt);
+SURVIVE_EXPORT void survive_default_imu_batch_process(SurviveObject *so, const SurviveImuEvent *events, size_t cnt);
 SURVIVE_EXPORT void survive_default_button_process(SurviveObject *so, enum SurviveInputEvent eventType,
 												   enum SurviveButton buttonId, const enum SurviveAxis *axisIds,
 												   const SurviveAxisVal_t *axisVals);
@@ -616,6 +680,10 @@ SURVIVE_EXPORT void survive_reset_lighthouse_position(SurviveContext *ctx, int b
 // This is the disambiguator function, for taking light timing and figuring out place-in-sweep for a given photodiode.
 SURVIVE_EXPORT uint8_t survive_map_sensor_id(SurviveObject *so, uint8_t reported_id);
 SURVIVE_EXPORT bool handle_lightcap(SurviveObject *so, const LightcapElement *le);
+// Same as calling handle_lightcap on each element in order, but the elements go out through the lightcap_batch hook.
+// Drivers that decode several pulses per packet should prefer this. Returns the number of elements that got past
+// lighthouse version detection and had a valid sensor id.
+SURVIVE_EXPORT size_t handle_lightcaps(SurviveObject *so, const LightcapElement *les, size_t cnt);
 
 SURVIVE_EXPORT const char *survive_colorize(const char *str);
 SURVIVE_EXPORT const char *survive_colorize_codename(const SurviveObject *so);
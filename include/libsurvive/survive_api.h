@@ -126,6 +126,14 @@ SURVIVE_EXPORT FLT survive_simple_object_get_latest_pose(const SurviveSimpleObje
  */
 SURVIVE_EXPORT FLT survive_simple_object_get_latest_velocity(const SurviveSimpleObject *sao, SurviveVelocity *pose);
 
+/**
+ * Gets a percentile of the time between receiving the light or IMU data for an object and publishing the pose computed
+ * from it, over its recent poses.
+ * @param percentile Percentile from 0 to 100; 50 is the median and 100 the maximum
+ * @return The latency in seconds, or -1 if it isn't known for this object
+ */
+SURVIVE_EXPORT FLT survive_simple_object_get_latency(const SurviveSimpleObject *sao, FLT percentile);
+
 /**
  * @return Whether or not the object is charging
  */
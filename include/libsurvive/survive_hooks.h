@@ -42,5 +42,12 @@ SURVIVE_HOOK_PROCESS_DEF(lighthouse_pose)
 
 SURVIVE_HOOK_PROCESS_DEF(datalog)
 
+// Batched forms of the hooks above
+SURVIVE_HOOK_PROCESS_DEF(lightcap_batch)
+SURVIVE_HOOK_PROCESS_DEF(sweep_batch)
+SURVIVE_HOOK_PROCESS_DEF(sweep_angle_batch)
+SURVIVE_HOOK_PROCESS_DEF(raw_imu_batch)
+SURVIVE_HOOK_PROCESS_DEF(imu_batch)
+
 #undef SURVIVE_HOOK_PROCESS_DEF
 #undef SURVIVE_HOOK_FEEDBACK_DEF
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "survive_types.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Registry of counters, gauges and histograms that subsystems publish their statistics into, so that tracking health
+ * can be watched while running instead of only from the logs at shutdown. The metrics plugin ('--metrics') serves the
+ * registry over HTTP in the Prometheus text format.
+ *
+ * A metric is identified by its name and label set; asking for one that already exists returns the existing one.
+ * Metrics live until the context closes, so hot paths should look them up once and keep the pointer. All the update
+ * functions accept a null metric and do nothing, which is what the lookups return for contexts without a registry.
+ *
+ * Names follow the Prometheus conventions -- lowercase, '_' separated, counters ending in '_total' and units spelled
+ * out as in '_seconds'. Labels are passed preformatted, eg 'object="HMD",reason="late"', or 0 for none.
+ */
+
+typedef enum SurviveMetricType {
+	SURVIVE_METRIC_COUNTER,
+	SURVIVE_METRIC_GAUGE,
+	SURVIVE_METRIC_HISTOGRAM,
+} SurviveMetricType;
+
+typedef struct SurviveMetric SurviveMetric;
+typedef struct SurviveMetrics SurviveMetrics;
+
+SURVIVE_EXPORT SurviveMetrics *survive_metrics_create();
+SURVIVE_EXPORT void survive_metrics_free(SurviveMetrics *metrics);
+
+SURVIVE_EXPORT SurviveMetric *survive_metric(SurviveContext *ctx, SurviveMetricType type, const char *name,
+											 const char *help, const char *labels);
+// Same as survive_metric, labelled with the codename of the object
+SURVIVE_EXPORT SurviveMetric *survive_object_metric(SurviveObject *so, SurviveMetricType type, const char *name,
+													const char *help);
+
+/**
+ * Replaces the buckets of a histogram with the given ascending upper bounds; a +Inf bucket is always implied. Must be
+ * called before anything is observed. Histograms otherwise get buckets suited to durations from 100us to 1s.
+ */
+SURVIVE_EXPORT void survive_metric_set_buckets(SurviveMetric *metric, const double *bounds, size_t bounds_cnt);
+
+// Adds to a counter or gauge
+SURVIVE_EXPORT void survive_metric_add(SurviveMetric *metric, double v);
+SURVIVE_EXPORT void survive_metric_set(SurviveMetric *metric, double v);
+SURVIVE_EXPORT void survive_metric_observe(SurviveMetric *metric, double v);
+
+// The value of a counter or gauge, or the number of observations of a histogram
+SURVIVE_EXPORT double survive_metric_value(const SurviveMetric *metric);
+
+/**
+ * Formats every metric in the Prometheus text exposition format.
+ * @return A string the caller frees, or 0 if the context has no registry
+ */
+SURVIVE_EXPORT char *survive_metrics_prometheus(SurviveContext *ctx);
+
+#ifdef __cplusplus
+};
+#endif
@@ -25,6 +25,22 @@ typedef struct {
 struct mp_par_struct;
 struct mp_result_struct;
 
+/**
+ * Loss applied to the light measurement deviates. MPFIT only minimizes sums of squares, so a robust loss rho is
+ * applied by handing it sign(r) * sqrt(2 rho(r)) in place of each deviate r; the sum of squares is then exactly the
+ * robust objective. Measurements far outside optimizer-robust-scale -- reflections, mostly -- pull on the solution
+ * less instead of having to be filtered out and solved again.
+ */
+enum survive_optimizer_loss {
+	// Whatever optimizer-robust-loss is set to
+	SURVIVE_OPTIMIZER_LOSS_DEFAULT,
+	SURVIVE_OPTIMIZER_LOSS_SQUARED,
+	// r^2 / 2 up to the scale s and s |r| - s^2 / 2 past it
+	SURVIVE_OPTIMIZER_LOSS_HUBER,
+	// s^2 / 2 log(1 + (r / s)^2); the pull of large deviates falls off towards zero
+	SURVIVE_OPTIMIZER_LOSS_CAUCHY,
+};
+
 typedef struct survive_optimizer {
 	const survive_reproject_model_t *reprojectModel;
 
@@ -51,14 +67,26 @@ typedef struct survive_optimizer {
 
 	bool needsFiltering;
 
+	// Left at zero, these are filled in from optimizer-robust-loss and optimizer-robust-scale on the first run
+	enum survive_optimizer_loss loss;
+	FLT loss_scale;
+
 	struct {
 		uint32_t total_meas_cnt;
 		uint32_t total_lh_cnt;
 		uint32_t dropped_meas_cnt;
 		uint32_t dropped_lh_cnt;
+
+		// Robust loss weights rho'(r) / r at the end of each run; weight_sum / weighted_meas_cnt is the average, and
+		// downweighted measurements are the ones past loss_scale
+		uint32_t weighted_meas_cnt;
+		uint32_t downweighted_meas_cnt;
+		FLT weight_sum;
 	} stats;
 
 	void *user;
+	// Called after every evaluation of the deviates. Setting it keeps MPFIT's numerical jacobian columns off of the
+	// context's worker threads, so it is always called from the thread running the solve, one evaluation at a time.
 	void (*iteration_cb)(struct survive_optimizer *opt_ctx, int m, int n, FLT *p, FLT *deviates, FLT **derivs);
 } survive_optimizer;
 
@@ -149,6 +177,33 @@ SURVIVE_EXPORT int survive_optimizer_nonfixed_cnt(const survive_optimizer *optim
 SURVIVE_EXPORT void survive_optimizer_get_nonfixed(const survive_optimizer *optimizer, FLT *params);
 SURVIVE_EXPORT void survive_optimizer_set_nonfixed(survive_optimizer *optimizer, FLT *params);
 
+/**
+ * The deviate MPFIT sees for a measurement deviate under 'loss'. 'd_deviate' is set to its derivative with respect to
+ * 'deviate', which is what the measurement's jacobian row gets scaled by.
+ */
+SURVIVE_EXPORT FLT survive_optimizer_robust_deviate(enum survive_optimizer_loss loss, FLT scale, FLT deviate,
+													FLT *d_deviate);
+
+struct survive_optimizer_ransac;
+
+/**
+ * Creates the state survive_optimizer_ransac_run keeps between runs for one object; its solvers, one for each of the
+ * context's worker threads and the calling thread, that hypotheses are spread over.
+ */
+SURVIVE_EXPORT struct survive_optimizer_ransac *survive_optimizer_ransac_create(SurviveObject *so);
+SURVIVE_EXPORT void survive_optimizer_ransac_free(struct survive_optimizer_ransac *ransac);
+
+/**
+ * Robust pre-solve for an optimizer set up to solve for one object against fixed lighthouses. Pose hypotheses are
+ * made with the barycentric SVD solver from small random sets of sensors seen by one lighthouse, and scored by how
+ * many of the optimizer's measurements they reproject to within optimizer-ransac-threshold. Measurements outside of
+ * the best hypothesis' consensus -- typically reflections -- are marked invalid. The optimizer's starting pose is
+ * scored as a hypothesis too, and is replaced if a sampled one does better.
+ *
+ * @return The number of measurements marked invalid, or -1 if no hypothesis had enough support and nothing changed
+ */
+SURVIVE_EXPORT int survive_optimizer_ransac_run(struct survive_optimizer_ransac *ransac, survive_optimizer *optimizer);
+
 #ifdef __cplusplus
 }
 #endif
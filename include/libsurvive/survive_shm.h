@@ -0,0 +1,249 @@
+#pragma once
+
+/**
+ * Layout of the shared memory segment written by the shm driver (`--shm`), and a header only reader for it.
+ *
+ * The segment holds a SurviveShmHeader followed by `capacity` SurviveShmObject slots. Each slot is guarded by its own
+ * sequence lock: the writer makes `seq` odd while it updates the slot and even again when it is done, so a reader
+ * that sees the same even `seq` before and after copying the slot knows it got a consistent snapshot. Readers never
+ * block the writer and need no access to the devices; they only need to include this file:
+ *
+ *     SurviveShmReader reader;
+ *     if (survive_shm_reader_open(&reader, SURVIVE_SHM_DEFAULT_NAME) == 0) {
+ *         SurviveShmObject obj;
+ *         int idx = survive_shm_reader_find(&reader, "T20");
+ *         if (idx >= 0 && survive_shm_reader_read(&reader, idx, &obj))
+ *             ... obj.pose ...
+ *         survive_shm_reader_close(&reader);
+ *     }
+ *
+ * All values are doubles regardless of how libsurvive itself was built.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SURVIVE_SHM_DEFAULT_NAME "/libsurvive"
+#define SURVIVE_SHM_MAGIC 0x4d485356u // 'VSHM'
+#define SURVIVE_SHM_VERSION 1
+#define SURVIVE_SHM_READ_RETRIES 1000
+
+/*
+ * Readers may be built with a different compiler than libsurvive, so the alignment and the memory ordering the
+ * sequence lock needs are spelled per compiler here rather than assumed to be GCC's.
+ */
+#ifdef _MSC_VER
+#define SURVIVE_SHM_ALIGNED(n) __declspec(align(n))
+#if defined(_M_ARM) || defined(_M_ARM64)
+// 0xB is the inner shareable full barrier on both ARM and ARM64
+#define SURVIVE_SHM_FENCE() __dmb(0xB)
+#else
+// x86 doesn't reorder loads with loads or stores with stores, so keeping the compiler in order is enough
+#define SURVIVE_SHM_FENCE() _ReadWriteBarrier()
+#endif
+#define SURVIVE_SHM_ACQUIRE_FENCE() SURVIVE_SHM_FENCE()
+#define SURVIVE_SHM_RELEASE_FENCE() SURVIVE_SHM_FENCE()
+#else
+#define SURVIVE_SHM_ALIGNED(n) __attribute__((aligned(n)))
+#define SURVIVE_SHM_ACQUIRE_FENCE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define SURVIVE_SHM_RELEASE_FENCE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+static inline uint32_t survive_shm_load_acquire(const volatile uint32_t *p) {
+	uint32_t v = *p;
+	SURVIVE_SHM_ACQUIRE_FENCE();
+	return v;
+}
+
+static inline void survive_shm_store_release(volatile uint32_t *p, uint32_t v) {
+	SURVIVE_SHM_RELEASE_FENCE();
+	*p = v;
+}
+
+typedef struct SurviveShmHeader {
+	uint32_t magic;
+	uint32_t version;
+	// Size of the header and of each object slot, so readers can step over fields added in later versions
+	uint32_t header_size;
+	uint32_t object_size;
+	uint32_t capacity;
+	// Number of slots in use; only ever grows while the writer is running
+	volatile uint32_t object_count;
+	// Creation time of the segment, so readers can tell a restarted publisher from a stale mapping
+	uint64_t generation;
+} SurviveShmHeader;
+
+typedef struct SURVIVE_SHM_ALIGNED(64) SurviveShmObject {
+	// Sequence lock; odd while the writer is updating this slot
+	volatile uint32_t seq;
+	uint32_t flags;
+
+	char codename[16];
+	char serial_number[32];
+
+	// Number of pose and velocity updates published for this object
+	uint64_t pose_count;
+	uint64_t velocity_count;
+
+	// Device timecode (48MHz ticks) and libsurvive run time in seconds of the last update
+	uint64_t pose_timecode;
+	double pose_time;
+	uint64_t velocity_timecode;
+	double velocity_time;
+
+	// Position xyz followed by rotation quaternion wxyz
+	double pose[7];
+	// Linear velocity xyz followed by the axis-angle angular velocity
+	double velocity[6];
+
+	// Covariance of the kalman tracker's pose and velocity state, row major. The tracker state is in the IMU frame so
+	// this is approximate for objects whose head and IMU frames differ. Only valid with HasCovariance set in flags.
+	double pose_covariance[7 * 7];
+	double velocity_covariance[6 * 6];
+} SurviveShmObject;
+
+enum SurviveShmObjectFlags {
+	SurviveShmObjectFlags_HasPose = 1,
+	SurviveShmObjectFlags_HasVelocity = 2,
+	SurviveShmObjectFlags_HasCovariance = 4,
+};
+
+static inline size_t survive_shm_segment_size(uint32_t capacity) {
+	size_t header_size = (sizeof(SurviveShmHeader) + 63) & ~(size_t)63;
+	return header_size + capacity * sizeof(SurviveShmObject);
+}
+
+static inline SurviveShmObject *survive_shm_objects(const SurviveShmHeader *header) {
+	return (SurviveShmObject *)((char *)header + header->header_size);
+}
+
+/**
+ * Writer side of the sequence lock. Only one thread may write a given slot at a time.
+ */
+static inline void survive_shm_write_begin(SurviveShmObject *obj) {
+	obj->seq = obj->seq + 1;
+	SURVIVE_SHM_RELEASE_FENCE();
+}
+
+static inline void survive_shm_write_end(SurviveShmObject *obj) {
+	survive_shm_store_release(&obj->seq, obj->seq + 1);
+}
+
+/**
+ * Copies a consistent snapshot of a slot into 'out'. Returns false if the writer kept the slot busy for more than
+ * SURVIVE_SHM_READ_RETRIES attempts.
+ */
+static inline bool survive_shm_read_object(const SurviveShmHeader *header, int idx, SurviveShmObject *out) {
+	if (idx < 0 || (uint32_t)idx >= survive_shm_load_acquire(&header->object_count))
+		return false;
+
+	const SurviveShmObject *obj =
+		(const SurviveShmObject *)((const char *)header + header->header_size + (size_t)idx * header->object_size);
+	for (int i = 0; i < SURVIVE_SHM_READ_RETRIES; i++) {
+		uint32_t before = survive_shm_load_acquire(&obj->seq);
+		if (before & 1)
+			continue;
+
+		memcpy(out, (const void *)obj, sizeof(*out));
+
+		SURVIVE_SHM_ACQUIRE_FENCE();
+		if (obj->seq == before) {
+			out->seq = before;
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline int survive_shm_find_object(const SurviveShmHeader *header, const char *codename) {
+	uint32_t count = survive_shm_load_acquire(&header->object_count);
+	for (uint32_t i = 0; i < count; i++) {
+		const SurviveShmObject *obj =
+			(const SurviveShmObject *)((const char *)header + header->header_size + (size_t)i * header->object_size);
+		// Names are written once before object_count is bumped and never change afterwards
+		if (strncmp(obj->codename, codename, sizeof(obj->codename)) == 0)
+			return (int)i;
+	}
+	return -1;
+}
+
+#ifndef _WIN32
+typedef struct SurviveShmReader {
+	const SurviveShmHeader *header;
+	size_t size;
+} SurviveShmReader;
+
+/**
+ * Maps the segment read only. Returns 0 on success, -1 if it doesn't exist (no publisher running) or is from an
+ * incompatible version.
+ */
+static inline int survive_shm_reader_open(SurviveShmReader *reader, const char *name) {
+	memset(reader, 0, sizeof(*reader));
+
+	int fd = shm_open(name ? name : SURVIVE_SHM_DEFAULT_NAME, O_RDONLY, 0);
+	if (fd < 0)
+		return -1;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SurviveShmHeader)) {
+		close(fd);
+		return -1;
+	}
+
+	void *p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return -1;
+
+	const SurviveShmHeader *header = (const SurviveShmHeader *)p;
+	if (header->magic != SURVIVE_SHM_MAGIC || header->version != SURVIVE_SHM_VERSION ||
+		header->object_size < sizeof(SurviveShmObject) ||
+		header->header_size + (size_t)header->capacity * header->object_size > (size_t)st.st_size) {
+		munmap(p, (size_t)st.st_size);
+		return -1;
+	}
+
+	reader->header = header;
+	reader->size = (size_t)st.st_size;
+	return 0;
+}
+
+static inline void survive_shm_reader_close(SurviveShmReader *reader) {
+	if (reader->header)
+		munmap((void *)reader->header, reader->size);
+	memset(reader, 0, sizeof(*reader));
+}
+
+static inline int survive_shm_reader_count(const SurviveShmReader *reader) {
+	return (int)survive_shm_load_acquire(&reader->header->object_count);
+}
+
+static inline int survive_shm_reader_find(const SurviveShmReader *reader, const char *codename) {
+	return survive_shm_find_object(reader->header, codename);
+}
+
+static inline bool survive_shm_reader_read(const SurviveShmReader *reader, int idx, SurviveShmObject *out) {
+	return survive_shm_read_object(reader->header, idx, out);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
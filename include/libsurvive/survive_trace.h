@@ -0,0 +1,44 @@
+#pragma once
+
+#include "survive_types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lightweight tracing of the hot paths. Each thread records begin / end events into its own ring buffer, so recording
+ * an event takes no locks; when the buffer is full the oldest events are overwritten. While tracing isn't running an
+ * event costs a call and a branch.
+ *
+ * Tracing is started with the 'trace' option, which names the file the trace is written to on survive_close. The file
+ * is in the Chrome trace event format, which chrome://tracing and https://ui.perfetto.dev can open.
+ *
+ * Event names are stored as pointers, so they must be string literals or otherwise outlive the trace.
+ */
+
+// Starts recording events, keeping the last 'events_per_thread' for every thread. Returns false if already running.
+SURVIVE_EXPORT bool survive_trace_start(size_t events_per_thread);
+// Stops recording. The events recorded so far can still be exported until the next start.
+SURVIVE_EXPORT void survive_trace_stop();
+SURVIVE_EXPORT bool survive_trace_running();
+
+// Writes the events recorded so far to 'path'. Returns the number of events written, or -1 if the file couldn't be
+// opened. Threads still recording while this runs can have their newest events left out.
+SURVIVE_EXPORT int survive_trace_export(const char *path);
+
+// 'object' is optional and shows up as an argument of the event; usually the codename of the device involved. Only
+// its first 7 characters are kept.
+SURVIVE_EXPORT void survive_trace_begin(const char *name, const char *object);
+SURVIVE_EXPORT void survive_trace_end(const char *name);
+
+#define SV_TRACE_BEGIN(name) survive_trace_begin(name, 0)
+#define SV_TRACE_BEGIN_SO(name, so) survive_trace_begin(name, (so)->codename)
+#define SV_TRACE_END(name) survive_trace_end(name)
+
+#ifdef __cplusplus
+};
+#endif
@@ -329,6 +329,40 @@ typedef void (*lighthouse_pose_process_func)(SurviveContext *ctx, uint8_t bsd_id
  * Called when a new object is added into the system.
  */
 typedef void (*new_object_process_func)(SurviveObject *so);
+
+/**
+ * Batched forms of the lightcap, sweep, sweep_angle, raw_imu and imu hooks, for drivers that produce several events at
+ * once -- eg everything in one USB packet. The events are in the order they happened. The default implementations
+ * hand each event to the single event hook in turn, so overriding only the single event hook keeps working. Overriding
+ * a batch hook takes over the whole batch, and with it the choice of whether the single event hook still sees it.
+ */
+typedef struct SurviveSweepEvent {
+	survive_channel channel;
+	int sensor_id;
+	survive_timecode timecode;
+	bool half_clock_flag;
+} SurviveSweepEvent;
+
+typedef struct SurviveSweepAngleEvent {
+	survive_channel channel;
+	int sensor_id;
+	survive_timecode timecode;
+	int8_t plane;
+	FLT angle;
+} SurviveSweepAngleEvent;
+
+typedef struct SurviveImuEvent {
+	int mask;
+	FLT accelgyromag[9];
+	survive_timecode timecode;
+	int id;
+} SurviveImuEvent;
+
+typedef void (*lightcap_batch_process_func)(SurviveObject *so, const LightcapElement *les, size_t cnt);
+typedef void (*sweep_batch_process_func)(SurviveObject *so, const SurviveSweepEvent *events, size_t cnt);
+typedef void (*sweep_angle_batch_process_func)(SurviveObject *so, const SurviveSweepAngleEvent *events, size_t cnt);
+typedef void (*raw_imu_batch_process_func)(SurviveObject *so, const SurviveImuEvent *events, size_t cnt);
+typedef void (*imu_batch_process_func)(SurviveObject *so, const SurviveImuEvent *events, size_t cnt);
 /************************************************ End Hook definitions ************************************************/
 
 typedef int (*haptic_func)(SurviveObject *so, FLT freq, FLT amp, FLT duration);
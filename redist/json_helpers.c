@@ -199,7 +199,7 @@ int json_run_callbacks(struct json_callbacks *cbs, const char *_JSON_STRING, int
 	jsmn_parser parser;
 	jsmn_init(&parser);
 	int32_t items = jsmn_parse(&parser, _JSON_STRING, JSON_STRING_LEN);
-	if (items < 0) {
+	if (items <= 0) {
 		return items;
 	}
 	char *JSON_STRING = malloc(JSON_STRING_LEN);
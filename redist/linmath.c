@@ -923,6 +923,87 @@ inline void ApplyAxisAnglePoseToPose(LinmathAxisAnglePose *pout, const LinmathAx
 		assert(!isnan(pout->Pos[i]));
 }
 
+// Same rotation quatrotatevector applies, including for quaternions that aren't quite unit length
+static inline void quatrotationmatrix33(FLT *m, const LinmathQuat q) {
+	FLT xx = q[1] * q[1], yy = q[2] * q[2], zz = q[3] * q[3];
+	FLT xy = q[1] * q[2], xz = q[1] * q[3], yz = q[2] * q[3];
+	FLT wx = q[0] * q[1], wy = q[0] * q[2], wz = q[0] * q[3];
+
+	m[0] = 1 - 2 * (yy + zz);
+	m[1] = 2 * (xy - wz);
+	m[2] = 2 * (xz + wy);
+
+	m[3] = 2 * (xy + wz);
+	m[4] = 1 - 2 * (xx + zz);
+	m[5] = 2 * (yz - wx);
+
+	m[6] = 2 * (xz - wy);
+	m[7] = 2 * (yz + wx);
+	m[8] = 1 - 2 * (xx + yy);
+}
+
+// With one rotation for every point, it is cheaper as a matrix; the points are used as they are laid out since
+// splitting them out per coordinate costs more than it saves
+static void transform_points(FLT *pout, const FLT *m, const FLT *t, const FLT *pin, size_t cnt) {
+	for (size_t i = 0; i < cnt; i++) {
+		FLT x = pin[3 * i], y = pin[3 * i + 1], z = pin[3 * i + 2];
+		pout[3 * i] = m[0] * x + m[1] * y + m[2] * z + t[0];
+		pout[3 * i + 1] = m[3] * x + m[4] * y + m[5] * z + t[1];
+		pout[3 * i + 2] = m[6] * x + m[7] * y + m[8] * z + t[2];
+	}
+}
+
+void quatrotatevectors(FLT *vec3out, const LinmathQuat quat, const FLT *vec3in, size_t cnt) {
+	FLT m[9];
+	FLT zero[3] = {0};
+	quatrotationmatrix33(m, quat);
+	transform_points(vec3out, m, zero, vec3in, cnt);
+}
+
+void ApplyPoseToPoints(FLT *pout, const LinmathPose *pose, const FLT *pin, size_t cnt) {
+	FLT m[9];
+	quatrotationmatrix33(m, pose->Rot);
+	transform_points(pout, m, pose->Pos, pin, cnt);
+	for (size_t i = 0; i < 3 * cnt; i++)
+		assert(!isnan(pout[i]));
+}
+
+// Poses are split out per component a block at a time so the rotations vectorize for whichever width FLT is
+#define LINMATH_BATCH_SIZE 16
+
+void ApplyPosesToPoint(FLT *pout, const LinmathPose *poses, size_t cnt, const LinmathPoint3d pin) {
+	for (size_t start = 0; start < cnt; start += LINMATH_BATCH_SIZE) {
+		size_t n = cnt - start < LINMATH_BATCH_SIZE ? cnt - start : LINMATH_BATCH_SIZE;
+		const LinmathPose *pose = poses + start;
+		FLT *out = pout + 3 * start;
+
+		FLT w[LINMATH_BATCH_SIZE], qx[LINMATH_BATCH_SIZE], qy[LINMATH_BATCH_SIZE], qz[LINMATH_BATCH_SIZE];
+		for (size_t i = 0; i < n; i++) {
+			w[i] = pose[i].Rot[0];
+			qx[i] = pose[i].Rot[1];
+			qy[i] = pose[i].Rot[2];
+			qz[i] = pose[i].Rot[3];
+		}
+
+		// quatrotatevector for every pose at once: v + 2 * q x (q x v + w * v)
+		FLT ox[LINMATH_BATCH_SIZE], oy[LINMATH_BATCH_SIZE], oz[LINMATH_BATCH_SIZE];
+		for (size_t i = 0; i < n; i++) {
+			FLT tx = qy[i] * pin[2] - qz[i] * pin[1] + w[i] * pin[0];
+			FLT ty = qz[i] * pin[0] - qx[i] * pin[2] + w[i] * pin[1];
+			FLT tz = qx[i] * pin[1] - qy[i] * pin[0] + w[i] * pin[2];
+			ox[i] = pin[0] + 2 * (qy[i] * tz - qz[i] * ty);
+			oy[i] = pin[1] + 2 * (qz[i] * tx - qx[i] * tz);
+			oz[i] = pin[2] + 2 * (qx[i] * ty - qy[i] * tx);
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			out[3 * i] = ox[i] + pose[i].Pos[0];
+			out[3 * i + 1] = oy[i] + pose[i].Pos[1];
+			out[3 * i + 2] = oz[i] + pose[i].Pos[2];
+		}
+	}
+}
+
 inline void InvertPose(LinmathPose *poseout, const LinmathPose *pose) {
 	quatgetreciprocal(poseout->Rot, pose->Rot);
 
@@ -260,6 +260,14 @@ LINMATH_EXPORT void ApplyAxisAnglePoseToPoint(LinmathPoint3d pout, const Linmath
 LINMATH_EXPORT void ApplyAxisAnglePoseToPose(LinmathAxisAnglePose *pout, const LinmathAxisAnglePose *lhs_pose,
 											 const LinmathAxisAnglePose *rhs_pose);
 
+// Batch versions of quatrotatevector and ApplyPoseToPoint for 'cnt' points packed as xyz triples, eg the sensor
+// locations of an object. The output can be the same array as the input. Results match the single point versions to
+// rounding.
+LINMATH_EXPORT void quatrotatevectors(FLT *vec3out, const LinmathQuat quat, const FLT *vec3in, size_t cnt);
+LINMATH_EXPORT void ApplyPoseToPoints(FLT *pout, const LinmathPose *pose, const FLT *pin, size_t cnt);
+// Applies each of 'cnt' poses to the same point; 'pout' gets 'cnt' xyz triples
+LINMATH_EXPORT void ApplyPosesToPoint(FLT *pout, const LinmathPose *poses, size_t cnt, const LinmathPoint3d pin);
+
 // This is the quat equivlant of 'pose_in^-1'; so that ApplyPoseToPose(..., InvertPose(..., pose_in), pose_in) ==
 // Identity ( [0, 0, 0], [1, 0, 0, 0] )
 // by definition.
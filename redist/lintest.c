@@ -10,6 +10,7 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 bool assertFLTEquals(FLT a, FLT b) { return fabs(a - b) < 0.0001; }
 
@@ -117,6 +118,46 @@ void testApplyPoseToPoint() {
 	}
 }
 
+static void testApplyPoseToPoints() {
+	LinmathPose poses[21];
+	FLT pts[37 * 3];
+	for (int i = 0; i < 21; i++) {
+		for (int j = 0; j < 7; j++)
+			((FLT *)&poses[i])[j] = linmath_normrand(0, 1);
+		// Every other pose is left unnormalized; the batch versions should still agree with the single ones
+		if (i % 2)
+			quatnormalize(poses[i].Rot, poses[i].Rot);
+	}
+	for (int i = 0; i < 37 * 3; i++)
+		pts[i] = linmath_normrand(0, 1);
+
+	for (int i = 0; i < 21; i++) {
+		FLT out[37 * 3], rotated[37 * 3], in_place[37 * 3];
+		ApplyPoseToPoints(out, &poses[i], pts, 37);
+		quatrotatevectors(rotated, poses[i].Rot, pts, 37);
+		memcpy(in_place, pts, sizeof(pts));
+		ApplyPoseToPoints(in_place, &poses[i], in_place, 37);
+
+		for (int j = 0; j < 37; j++) {
+			FLT expected[3];
+			ApplyPoseToPoint(expected, &poses[i], pts + 3 * j);
+			ASSERT_FLTA_EQUALS(out + 3 * j, expected, 3);
+			ASSERT_FLTA_EQUALS(in_place + 3 * j, expected, 3);
+
+			quatrotatevector(expected, poses[i].Rot, pts + 3 * j);
+			ASSERT_FLTA_EQUALS(rotated + 3 * j, expected, 3);
+		}
+	}
+
+	FLT out[21 * 3];
+	ApplyPosesToPoint(out, poses, 21, pts);
+	for (int i = 0; i < 21; i++) {
+		FLT expected[3];
+		ApplyPoseToPoint(expected, &poses[i], pts);
+		ASSERT_FLTA_EQUALS(out + 3 * i, expected, 3);
+	}
+}
+
 void testKabsch() {
 	FLT pts[] = {0, 0, 0, 100, 100, 100, 10, 0, 10, 50, 50, 0, 0, 0, 1000, -100, 0, 100};
 
@@ -298,6 +339,7 @@ int main()
 
 	testInvertPose();
 	testApplyPoseToPoint();
+	testApplyPoseToPoints();
 	testApplyPoseToPose();
 	testKabsch();
 	testKabsch2();
@@ -30,7 +30,8 @@
 /* Forward declarations of functions in this module */
 static int mp_fdjac2(mp_func funct, int m, int n, int *ifree, int npar, FLT *x, FLT *fvec, FLT *fjac, int ldfjac,
 					 FLT epsfcn, FLT *wa, void *priv, int *nfev, FLT *step, FLT *dstep, int *dside, int *qulimited,
-					 FLT *ulimit, int *ddebug, FLT *ddrtol, FLT *ddatol, FLT *wa2, FLT **dvecptr);
+					 FLT *ulimit, int *ddebug, FLT *ddrtol, FLT *ddatol, FLT *wa2, FLT **dvecptr, FLT *fdjac_xs,
+					 FLT *fdjac_wa, int *fdjac_iflags, mp_parallel_for parallel_for, void *parallel_for_data);
 static void mp_qrfac(int m, int n, FLT *a, int lda, int pivot, int *ipvt, int lipvt, FLT *rdiag, FLT *acnorm, FLT *wa);
 static void mp_qrsolv(int n, FLT *r, int ldr, int *ipvt, FLT *diag, FLT *qtb, FLT *x, FLT *sdiag, FLT *wa);
 static void mp_lmpar(int n, FLT *r, int ldr, int *ipvt, int *ifree, FLT *diag, FLT *qtb, FLT delta, FLT *par, FLT *x,
@@ -318,6 +319,10 @@ int mpfit(mp_func funct, int m, int npar, FLT *xall, mp_par *pars, mp_config *co
 	mp_declare(dvecptr, FLT *);
 	mp_declare(ipvt, int);
 
+	mp_declare(fdjac_xs, FLT);
+	mp_declare(fdjac_wa, FLT);
+	mp_declare(fdjac_iflags, int);
+
 	int ldfjac;
 
 	/* Default configuration */
@@ -333,6 +338,8 @@ int mpfit(mp_func funct, int m, int npar, FLT *xall, mp_par *pars, mp_config *co
 	conf.maxfev = 0;
 	conf.covtol = 1e-14;
 	conf.nofinitecheck = 0;
+	conf.parallel_for = 0;
+	conf.parallel_for_data = 0;
 
 	if (config) {
 		/* Transfer any user-specified configurations */
@@ -362,6 +369,8 @@ int mpfit(mp_func funct, int m, int npar, FLT *xall, mp_par *pars, mp_config *co
 		if (config->normtol > 0.)
 			conf.normtol = FLT_SQRT(config->normtol);
 		conf.maxfev = config->maxfev;
+		conf.parallel_for = config->parallel_for;
+		conf.parallel_for_data = config->parallel_for_data;
 	}
 
 	info = MP_ERR_INPUT; /* = 0 */
@@ -476,12 +485,26 @@ int mpfit(mp_func funct, int m, int npar, FLT *xall, mp_par *pars, mp_config *co
 	ldfjac = m;
 	mp_malloc(diag, FLT, npar);
 	mp_malloc(wa1, FLT, npar);
-	mp_malloc(wa2, FLT, npar);
+	/* mp_fdjac2 keeps f(x+h) here for two-sided derivatives */
+	mp_malloc(wa2, FLT, (npar > m ? npar : m));
 	mp_malloc(wa3, FLT, npar);
 	mp_malloc(wa4, FLT, m);
 	mp_malloc(ipvt, int, npar);
 	mp_malloc(dvecptr, FLT *, npar);
 
+	/* Each numerical derivative column evaluated through parallel_for gets its own parameters and residuals */
+	if (conf.parallel_for) {
+		int two_sided = 0;
+		for (i = 0; i < nfree; i++)
+			two_sided |= mpside && mpside[ifree[i]] == 2;
+
+		mp_malloc(fdjac_xs, FLT, nfree * npar);
+		if (two_sided) {
+			mp_malloc(fdjac_wa, FLT, nfree * m);
+		}
+		mp_malloc(fdjac_iflags, int, nfree);
+	}
+
 	/* Evaluate user function with initial parameter values */
 	iflag = mp_call(funct, m, npar, xall, fvec, 0, private_data);
 	nfev += 1;
@@ -520,7 +543,8 @@ OUTER_LOOP:
 
 	/* Calculate the jacobian matrix */
 	iflag = mp_fdjac2(funct, m, nfree, ifree, npar, xnew, fvec, fjac, ldfjac, conf.epsfcn, wa4, private_data, &nfev,
-					  step, dstep, mpside, qulim, ulim, ddebug, ddrtol, ddatol, wa2, dvecptr);
+					  step, dstep, mpside, qulim, ulim, ddebug, ddrtol, ddatol, wa2, dvecptr, fdjac_xs, fdjac_wa,
+					  fdjac_iflags, conf.parallel_for, conf.parallel_for_data);
 	if (iflag < 0) {
 		goto CLEANUP;
 	}
@@ -1010,6 +1034,9 @@ CLEANUP:
 	mp_free(wa3);
 	mp_free(wa4);
 	mp_free(ipvt);
+	mp_free(fdjac_xs);
+	mp_free(fdjac_wa);
+	mp_free(fdjac_iflags);
 	mp_free(pfixed);
 	mp_free(step);
 	mp_free(dstep);
@@ -1028,9 +1055,86 @@ CLEANUP:
 
 /************************fdjac2.c*************************/
 
+/* Finite difference step for free parameter j; negative for a backwards difference */
+static FLT mp_fdjac_step(int j, int *ifree, FLT *x, FLT eps, FLT *step, FLT *dstep, int *dside, int *qulimited,
+						 FLT *ulimit) {
+	static FLT zero = 0.0;
+	int dsidei = (dside) ? (dside[ifree[j]]) : (0);
+	FLT temp = x[ifree[j]];
+	FLT h = eps * fabs(temp);
+	if (step && step[ifree[j]] > 0)
+		h = step[ifree[j]];
+	if (dstep && dstep[ifree[j]] > 0)
+		h = fabs(dstep[ifree[j]] * temp);
+	if (h == zero)
+		h = eps;
+
+	/* If negative step requested, or we are against the upper limit */
+	if ((dside && dsidei == -1) ||
+		(dside && dsidei == 0 && qulimited && ulimit && qulimited[j] && (temp > (ulimit[j] - h)))) {
+		h = -h;
+	}
+	return h;
+}
+
+/* Numerical derivative columns shared with mp_fdjac_column through mp_config.parallel_for */
+struct mp_fdjac_columns {
+	mp_func funct;
+	int m, npar;
+	int *ifree;
+	FLT *x, *fvec, *fjac;
+	FLT eps;
+	FLT *step, *dstep;
+	int *dside, *qulimited;
+	FLT *ulimit;
+	void *priv;
+
+	FLT *xs;	 /* npar parameters for each column */
+	FLT *wa;	 /* m residuals for each column, for two-sided derivatives */
+	int *iflags; /* What the user function returned for each column */
+};
+
+/* Same arithmetic as the serial loop in mp_fdjac2, so either gives identical results */
+static void mp_fdjac_column(void *arg, int j) {
+	struct mp_fdjac_columns *c = arg;
+	int i, m = c->m;
+	int dsidei = (c->dside) ? (c->dside[c->ifree[j]]) : (0);
+	FLT *x = c->xs + j * c->npar, *col = c->fjac + j * m;
+	FLT temp = c->x[c->ifree[j]];
+
+	c->iflags[j] = 0;
+	if (c->dside && dsidei == 3)
+		return;
+
+	FLT h = mp_fdjac_step(j, c->ifree, c->x, c->eps, c->step, c->dstep, c->dside, c->qulimited, c->ulimit);
+	memcpy(x, c->x, sizeof(FLT) * c->npar);
+	x[c->ifree[j]] = temp + h;
+	c->iflags[j] = mp_call(c->funct, m, c->npar, x, col, 0, c->priv);
+	if (c->iflags[j] < 0)
+		return;
+
+	if (dsidei <= 1) {
+		for (i = 0; i < m; i++) {
+			col[i] = (col[i] - c->fvec[i]) / h;
+			assert(isfinite(col[i]));
+		}
+		return;
+	}
+
+	FLT *wa = c->wa + j * m;
+	x[c->ifree[j]] = temp - h;
+	c->iflags[j] = mp_call(c->funct, m, c->npar, x, wa, 0, c->priv);
+	if (c->iflags[j] < 0)
+		return;
+	for (i = 0; i < m; i++) {
+		col[i] = (col[i] - wa[i]) / (2 * h);
+	}
+}
+
 static int mp_fdjac2(mp_func funct, int m, int n, int *ifree, int npar, FLT *x, FLT *fvec, FLT *fjac, int ldfjac,
 					 FLT epsfcn, FLT *wa, void *priv, int *nfev, FLT *step, FLT *dstep, int *dside, int *qulimited,
-					 FLT *ulimit, int *ddebug, FLT *ddrtol, FLT *ddatol, FLT *wa2, FLT **dvec) {
+					 FLT *ulimit, int *ddebug, FLT *ddrtol, FLT *ddatol, FLT *wa2, FLT **dvec, FLT *fdjac_xs,
+					 FLT *fdjac_wa, int *fdjac_iflags, mp_parallel_for parallel_for, void *parallel_for_data) {
 	/*
 	 *     **********
 	 *
@@ -1095,6 +1199,10 @@ static int mp_fdjac2(mp_func funct, int m, int n, int *ifree, int npar, FLT *x,
 	 *
 	 *	wa is a work array of length m.
 	 *
+	 *	fdjac_xs, fdjac_wa and fdjac_iflags are only used with
+	 *	  parallel_for: work arrays of length n*npar, n*m (when any
+	 *	  derivative is two-sided) and n.
+	 *
 	 *     subprograms called
 	 *
 	 *	user-supplied ...... fcn
@@ -1111,7 +1219,6 @@ static int mp_fdjac2(mp_func funct, int m, int n, int *ifree, int npar, FLT *x,
 	int i, j, ij;
 	int iflag = 0;
 	FLT eps, h, temp;
-	static FLT zero = 0.0;
 	int has_analytical_deriv = 0, has_numerical_deriv = 0;
 	int has_debug_deriv = 0;
 
@@ -1163,8 +1270,38 @@ static int mp_fdjac2(mp_func funct, int m, int n, int *ifree, int npar, FLT *x,
 				"DIFF_REL");
 	}
 
-	/* Any parameters requiring numerical derivatives */
-	if (has_numerical_deriv)
+	/* Any parameters requiring numerical derivatives. Each column only depends on the parameters and fvec, so
+	   they can all be evaluated at once if the caller has a way to; debugging output is always serial. */
+	if (has_numerical_deriv && parallel_for && !has_debug_deriv) {
+		struct mp_fdjac_columns columns = {.funct = funct,
+										   .m = m,
+										   .npar = npar,
+										   .ifree = ifree,
+										   .x = x,
+										   .fvec = fvec,
+										   .fjac = fjac,
+										   .eps = eps,
+										   .step = step,
+										   .dstep = dstep,
+										   .dside = dside,
+										   .qulimited = qulimited,
+										   .ulimit = ulimit,
+										   .priv = priv,
+										   .xs = fdjac_xs,
+										   .wa = fdjac_wa,
+										   .iflags = fdjac_iflags};
+		parallel_for(parallel_for_data, n, mp_fdjac_column, &columns);
+
+		for (j = 0; j < n; j++) {
+			int dsidei = (dside) ? (dside[ifree[j]]) : (0);
+			if (dside && dsidei == 3)
+				continue;
+			if (nfev)
+				*nfev = *nfev + (dsidei <= 1 ? 1 : 2);
+			if (columns.iflags[j] < 0 && iflag >= 0)
+				iflag = columns.iflags[j];
+		}
+	} else if (has_numerical_deriv)
 		for (j = 0; j < n; j++) { /* Loop thru free parms */
 			int dsidei = (dside) ? (dside[ifree[j]]) : (0);
 			int debug = ddebug[ifree[j]];
@@ -1180,19 +1317,9 @@ static int mp_fdjac2(mp_func funct, int m, int n, int *ifree, int npar, FLT *x,
 				continue;
 
 			temp = x[ifree[j]];
-			h = eps * fabs(temp);
-			if (step && step[ifree[j]] > 0)
-				h = step[ifree[j]];
-			if (dstep && dstep[ifree[j]] > 0)
-				h = fabs(dstep[ifree[j]] * temp);
-			if (h == zero)
-				h = eps;
-
-			/* If negative step requested, or we are against the upper limit */
-			if ((dside && dsidei == -1) ||
-				(dside && dsidei == 0 && qulimited && ulimit && qulimited[j] && (temp > (ulimit[j] - h)))) {
-				h = -h;
-			}
+			h = mp_fdjac_step(j, ifree, x, eps, step, dstep, dside, qulimited, ulimit);
+			/* Columns of analytical derivatives are skipped above, so index by column rather than counting */
+			ij = j * m;
 
 			x[ifree[j]] = temp + h;
 			iflag = mp_call(funct, m, npar, x, wa, 0, priv);
@@ -1243,7 +1370,7 @@ static int mp_fdjac2(mp_func funct, int m, int n, int *ifree, int npar, FLT *x,
 				if (!debug) {
 					/* Non-debug path for speed */
 					for (i = 0; i < m; i++, ij++) {
-						fjac[ij] = (fjac[ij] - wa[i]) / (2 * h); /* fjac[i+m*j] */
+						fjac[ij] = (wa2[i] - wa[i]) / (2 * h); /* fjac[i+m*j] */
 					}
 				} else {
 					/* Debug path for correctness */
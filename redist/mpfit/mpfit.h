@@ -69,6 +69,10 @@ struct mp_par_struct {
 /* Just a placeholder - do not use!! */
 typedef void (*mp_iterproc)(void);
 
+/* Runs fn(arg, i) for every i in [0, cnt), possibly concurrently, and
+   returns once all of them have */
+typedef void (*mp_parallel_for)(void *data, int cnt, void (*fn)(void *arg, int i), void *arg);
+
 /* Definition of MPFIT configuration structure */
 struct mp_config_struct {
 	/* NOTE: the user may set the value explicitly; OR, if the passed
@@ -99,6 +103,13 @@ struct mp_config_struct {
 					*/
 	mp_iterproc iterproc; /* Placeholder pointer - must set to 0 */
 	FLT normtol;		  /* Norm convergence criteria Default: 0 */
+	mp_parallel_for parallel_for; /* If set, numerical derivative columns are
+					 evaluated through it, each with its own copy of
+					 the parameters and its own residual buffer. The
+					 user function is then called concurrently with
+					 dvec == 0 and must be safe for that.
+					 Default: 0 (columns evaluated in turn) */
+	void *parallel_for_data;	  /* Passed through to parallel_for */
 };
 
 /* Definition of results structure, for when fit completes */
@@ -43,6 +43,9 @@ static size_t mat_size_bytes(const SvMat *mat) { return (size_t)sizeof(FLT) * ma
 #define LAPACKE_getri LAPACKE_sgetri
 #define LAPACKE_gelss LAPACKE_sgelss
 #define LAPACKE_gesvd LAPACKE_sgesvd
+#define LAPACKE_getrs_work LAPACKE_sgetrs_work
+#define LAPACKE_getrf_work LAPACKE_sgetrf_work
+#define LAPACKE_gelss_work LAPACKE_sgelss_work
 #define LAPACKE_gesvd_work LAPACKE_sgesvd_work
 #define LAPACKE_getri_work LAPACKE_sgetri_work
 #define LAPACKE_ge_trans LAPACKE_sge_trans
@@ -54,6 +57,9 @@ static size_t mat_size_bytes(const SvMat *mat) { return (size_t)sizeof(FLT) * ma
 #define LAPACKE_getri LAPACKE_dgetri
 #define LAPACKE_gelss LAPACKE_dgelss
 #define LAPACKE_gesvd LAPACKE_dgesvd
+#define LAPACKE_getrs_work LAPACKE_dgetrs_work
+#define LAPACKE_getrf_work LAPACKE_dgetrf_work
+#define LAPACKE_gelss_work LAPACKE_dgelss_work
 #define LAPACKE_gesvd_work LAPACKE_dgesvd_work
 #define LAPACKE_getri_work LAPACKE_dgetri_work
 #define LAPACKE_ge_trans LAPACKE_dge_trans
@@ -211,80 +217,140 @@ SURVIVE_LOCAL_ONLY void svMulTransposed(const SvMat *src, SvMat *dst, int order,
 	FLT *_##name = alloca(rows * cols * sizeof(FLT));                                                                  \
 	SvMat name = svMat(rows, cols, _##name);
 
-static lapack_int LAPACKE_gesvd_static_alloc(int matrix_layout, char jobu, char jobvt, lapack_int m, lapack_int n,
-											 FLT *a, lapack_int lda, FLT *s, FLT *u, lapack_int ldu, FLT *vt,
-											 lapack_int ldvt, FLT *superb) {
-	lapack_int info = 0;
-	lapack_int lwork = -1;
-	FLT *work = NULL;
-	FLT work_query;
-	lapack_int i;
-	if (matrix_layout != LAPACK_COL_MAJOR && matrix_layout != LAPACK_ROW_MAJOR) {
-		LAPACKE_xerbla("LAPACKE_dgesvd", -1);
-		return -1;
+#ifdef _MSC_VER
+#define SV_THREAD_LOCAL __declspec(thread)
+#else
+#define SV_THREAD_LOCAL __thread
+#endif
+
+/*
+ * The LAPACK routines that need scratch space only say how much when called with lwork = -1, and for the sizes the
+ * posers use that query costs about as much as the decomposition itself. So the answer is remembered per routine and
+ * shape, and the scratch space is a per thread buffer that grows to the largest size asked for and is then reused; in
+ * steady state a solve neither queries nor allocates. The buffer is only held across one LAPACK call, so nothing here
+ * nests. It isn't released when a thread exits, which is fine for the long lived threads that do the solving.
+ *
+ * Everything is also called with the column major layout -- LAPACKE implements row major by allocating transposed
+ * copies of every matrix argument on each call. A row major matrix is the column major transpose, so most routines
+ * can just be pointed at the transpose instead; see the individual callers.
+ */
+enum sv_lapack_routine { SV_LAPACK_GESVD, SV_LAPACK_GETRI, SV_LAPACK_GELSS };
+
+#define SV_LWORK_CACHE_SIZE 16
+
+typedef struct sv_lwork_entry {
+	enum sv_lapack_routine routine;
+	lapack_int m, n, k;
+	lapack_int lwork;
+} sv_lwork_entry;
+
+typedef struct sv_workspace {
+	FLT *work;
+	lapack_int work_size;
+
+	sv_lwork_entry lwork[SV_LWORK_CACHE_SIZE];
+	int lwork_cnt, lwork_next;
+} sv_workspace;
+
+static SV_THREAD_LOCAL sv_workspace workspace;
+
+// Slot for the work size of the given routine and shape; 0 until the caller has queried it
+static lapack_int *cached_lwork(enum sv_lapack_routine routine, lapack_int m, lapack_int n, lapack_int k) {
+	for (int i = 0; i < workspace.lwork_cnt; i++) {
+		sv_lwork_entry *entry = &workspace.lwork[i];
+		if (entry->routine == routine && entry->m == m && entry->n == n && entry->k == k)
+			return &entry->lwork;
 	}
 
-	/* Query optimal working array(s) size */
-	info = LAPACKE_gesvd_work(matrix_layout, jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, &work_query, lwork);
-	if (info != 0) {
-		goto exit_level_0;
+	sv_lwork_entry *entry = &workspace.lwork[workspace.lwork_next];
+	workspace.lwork_next = (workspace.lwork_next + 1) % SV_LWORK_CACHE_SIZE;
+	if (workspace.lwork_cnt < SV_LWORK_CACHE_SIZE)
+		workspace.lwork_cnt++;
+
+	*entry = (sv_lwork_entry){.routine = routine, .m = m, .n = n, .k = k};
+	return &entry->lwork;
+}
+
+static FLT *workspace_work(lapack_int size) {
+	if (workspace.work_size < size) {
+		free(workspace.work);
+		workspace.work = malloc(sizeof(FLT) * size);
+		workspace.work_size = workspace.work ? size : 0;
 	}
-	lwork = (lapack_int)work_query;
-	/* Allocate memory for work arrays */
-	work = (FLT *)SV_MATRIX_ALLOC(sizeof(FLT) * lwork);
-	memset(work, 0, sizeof(FLT) * lwork);
+	return workspace.work;
+}
 
+static lapack_int LAPACKE_gesvd_cached(char jobu, char jobvt, lapack_int m, lapack_int n, FLT *a, lapack_int lda,
+									   FLT *s, FLT *u, lapack_int ldu, FLT *vt, lapack_int ldvt) {
+	lapack_int *lwork = cached_lwork(SV_LAPACK_GESVD, m, n, jobu << 8 | jobvt);
+	if (*lwork == 0) {
+		FLT work_query;
+		lapack_int info =
+			LAPACKE_gesvd_work(LAPACK_COL_MAJOR, jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, &work_query, -1);
+		if (info != 0)
+			return info;
+		*lwork = (lapack_int)work_query;
+	}
+
+	FLT *work = workspace_work(*lwork);
 	if (work == NULL) {
-		info = LAPACK_WORK_MEMORY_ERROR;
-		goto exit_level_0;
+		LAPACKE_xerbla("LAPACKE_dgesvd", LAPACK_WORK_MEMORY_ERROR);
+		return LAPACK_WORK_MEMORY_ERROR;
 	}
-	/* Call middle-level interface */
-	info = LAPACKE_gesvd_work(matrix_layout, jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, work, lwork);
-	/* Backup significant data from working array(s) */
-	for (i = 0; i < MIN(m, n) - 1; i++) {
-		superb[i] = work[i + 1];
+	return LAPACKE_gesvd_work(LAPACK_COL_MAJOR, jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, work, *lwork);
+}
+
+static lapack_int LAPACKE_getri_cached(lapack_int n, FLT *a, lapack_int lda, const lapack_int *ipiv) {
+	lapack_int *lwork = cached_lwork(SV_LAPACK_GETRI, n, n, 0);
+	if (*lwork == 0) {
+		FLT work_query;
+		lapack_int info = LAPACKE_getri_work(LAPACK_COL_MAJOR, n, a, lda, ipiv, &work_query, -1);
+		if (info != 0)
+			return info;
+		*lwork = (lapack_int)work_query;
 	}
-	SV_MATRIX_FREE(work);
 
-exit_level_0:
-	if (info == LAPACK_WORK_MEMORY_ERROR) {
-		LAPACKE_xerbla("LAPACKE_dgesvd", info);
+	FLT *work = workspace_work(*lwork);
+	if (work == NULL) {
+		LAPACKE_xerbla("LAPACKE_dgetri", LAPACK_WORK_MEMORY_ERROR);
+		return LAPACK_WORK_MEMORY_ERROR;
 	}
-	return info;
+	return LAPACKE_getri_work(LAPACK_COL_MAJOR, n, a, lda, ipiv, work, *lwork);
 }
 
-static inline lapack_int LAPACKE_getri_static_alloc(int matrix_layout, lapack_int n, FLT *a, lapack_int lda,
-													const lapack_int *ipiv) {
-	lapack_int info = 0;
-	lapack_int lwork = -1;
-	FLT *work = NULL;
-	FLT work_query;
-	if (matrix_layout != LAPACK_COL_MAJOR && matrix_layout != LAPACK_ROW_MAJOR) {
-		LAPACKE_xerbla("LAPACKE_dgetri", -1);
-		return -1;
+static lapack_int LAPACKE_gelss_cached(lapack_int m, lapack_int n, lapack_int nrhs, FLT *a, lapack_int lda, FLT *b,
+									   lapack_int ldb, FLT *s, FLT rcond, lapack_int *rank) {
+	lapack_int *lwork = cached_lwork(SV_LAPACK_GELSS, m, n, nrhs);
+	if (*lwork == 0) {
+		FLT work_query;
+		lapack_int info =
+			LAPACKE_gelss_work(LAPACK_COL_MAJOR, m, n, nrhs, a, lda, b, ldb, s, rcond, rank, &work_query, -1);
+		if (info != 0)
+			return info;
+		*lwork = (lapack_int)work_query;
 	}
-	/* Query optimal working array(s) size */
-	info = LAPACKE_getri_work(matrix_layout, n, a, lda, ipiv, &work_query, lwork);
-	if (info != 0) {
-		goto exit_level_0;
-	}
-	lwork = (lapack_int)work_query;
-	/* Allocate memory for work arrays */
-	work = (FLT *)alloca(sizeof(FLT) * lwork);
-	memset(work, 0, sizeof(FLT) * lwork);
+
+	FLT *work = workspace_work(*lwork);
 	if (work == NULL) {
-		info = LAPACK_WORK_MEMORY_ERROR;
-		goto exit_level_0;
+		LAPACKE_xerbla("LAPACKE_dgelss", LAPACK_WORK_MEMORY_ERROR);
+		return LAPACK_WORK_MEMORY_ERROR;
 	}
-	/* Call middle-level interface */
-	info = LAPACKE_getri_work(matrix_layout, n, a, lda, ipiv, work, lwork);
-	/* Release memory and exit */
+	return LAPACKE_gelss_work(LAPACK_COL_MAJOR, m, n, nrhs, a, lda, b, ldb, s, rcond, rank, work, *lwork);
+}
 
-exit_level_0:
-	if (info == LAPACK_WORK_MEMORY_ERROR) {
-		LAPACKE_xerbla("LAPACKE_dgetri", info);
+// Column major copy of the row major rows x cols matrix 'src', with 'ld' rows allocated per column
+static void to_col_major(FLT *dst, lapack_int ld, const FLT *src, lapack_int rows, lapack_int cols) {
+	for (lapack_int i = 0; i < rows; i++) {
+		for (lapack_int j = 0; j < cols; j++)
+			dst[j * ld + i] = src[i * cols + j];
+	}
+}
+
+static void from_col_major(FLT *dst, lapack_int rows, lapack_int cols, const FLT *src, lapack_int ld) {
+	for (lapack_int i = 0; i < rows; i++) {
+		for (lapack_int j = 0; j < cols; j++)
+			dst[i * cols + j] = src[j * ld + i];
 	}
-	return info;
 }
 
 SURVIVE_LOCAL_ONLY double svInvert(const SvMat *srcarr, SvMat *dstarr, enum svInvertMethod method) {
@@ -301,33 +367,27 @@ SURVIVE_LOCAL_ONLY double svInvert(const SvMat *srcarr, SvMat *dstarr, enum svIn
 	print_mat(srcarr);
 #endif
 	if (method == SV_INVERT_METHOD_LU) {
+		assert(rows == cols);
 		lapack_int *ipiv = SV_MATRIX_ALLOC(sizeof(lapack_int) * MIN(srcarr->rows, srcarr->cols));
 
-		lapack_int lda_t = MAX(1, rows);
-
-		FLT *a_t = (FLT *)SV_MATRIX_ALLOC(sizeof(FLT) * lda_t * MAX(1, cols));
-		LAPACKE_ge_trans(LAPACK_ROW_MAJOR, rows, cols, a, lda, a_t, lda_t);
-
-		inf = LAPACKE_getrf(LAPACK_COL_MAJOR, rows, cols, a_t, lda, ipiv);
-		assert(inf == 0);
-
-		inf = LAPACKE_getri_static_alloc(LAPACK_COL_MAJOR, rows, a_t, lda, ipiv);
+		// LAPACK sees the transpose of 'a', and inverting that in place leaves the transpose of the inverse -- which
+		// read back as row major is just the inverse.
+		inf = LAPACKE_getrf_work(LAPACK_COL_MAJOR, rows, cols, a, lda, ipiv);
 		assert(inf >= 0);
 
-		LAPACKE_ge_trans(LAPACK_COL_MAJOR, rows, cols, a_t, lda, a, lda_t);
+		if (inf == 0) {
+			inf = LAPACKE_getri_cached(rows, a, lda, ipiv);
+			assert(inf >= 0);
+		}
 
 		if (inf > 0) {
 			printf("Warning: Singular matrix: \n");
 			// print_mat(srcarr);
 		}
 
-		SV_MATRIX_FREE(a_t);
 		SV_MATRIX_FREE(ipiv);
-		// free(ipiv);
 
 	} else if (method == DECOMP_SVD) {
-		// TODO: There is no way this needs this many allocations,
-		// but in my defense I was very tired when I wrote this code
 		SV_CREATE_STACK_MAT(w, 1, MIN(dstarr->rows, dstarr->cols));
 		SV_CREATE_STACK_MAT(u, dstarr->cols, dstarr->cols);
 		SV_CREATE_STACK_MAT(v, dstarr->rows, dstarr->rows);
@@ -341,12 +401,11 @@ SURVIVE_LOCAL_ONLY double svInvert(const SvMat *srcarr, SvMat *dstarr, enum svIn
 				svMatrixSet(&um, i, i, 1. / (_w)[i]);
 		}
 
-		SvMat *tmp = svCreateMat(dstarr->cols, dstarr->rows);
-		svGEMM(&v, &um, 1, 0, 0, tmp, SV_GEMM_FLAG_A_T);
-		svGEMM(tmp, &u, 1, 0, 0, dstarr, SV_GEMM_FLAG_B_T);
-
-		svReleaseMat(&tmp);
+		SV_CREATE_STACK_MAT(tmp, dstarr->cols, dstarr->rows);
+		svGEMM(&v, &um, 1, 0, 0, &tmp, SV_GEMM_FLAG_A_T);
+		svGEMM(&tmp, &u, 1, 0, 0, dstarr, SV_GEMM_FLAG_B_T);
 
+		SV_FREE_STACK_MAT(tmp);
 		SV_FREE_STACK_MAT(um);
 		SV_FREE_STACK_MAT(v);
 		SV_FREE_STACK_MAT(u);
@@ -359,33 +418,23 @@ SURVIVE_LOCAL_ONLY double svInvert(const SvMat *srcarr, SvMat *dstarr, enum svIn
 	return 0;
 }
 
-#define SV_CLONE_MAT_ALLOCA(stack_mat, mat)                                                                            \
-	SV_CREATE_MAT_ALLOCA(stack_mat, mat->rows, mat->cols)                                                              \
-	svCopy(mat, stack_mat, 0);
-
 static int svSolve_LU(const SvMat *Aarr, const SvMat *Barr, SvMat *xarr) {
 	lapack_int inf;
-	lapack_int arows = Aarr->rows;
-	lapack_int acols = Aarr->cols;
+	lapack_int n = Aarr->rows;
 	lapack_int xcols = Barr->cols;
-	lapack_int xrows = Barr->rows;
-	lapack_int lda = acols; // Aarr->step / sizeof(double);
 
+	assert(Aarr->rows == Aarr->cols);
 	assert(Aarr->cols == xarr->rows);
 	assert(Barr->rows == Aarr->rows);
 	assert(xarr->cols == Barr->cols);
 
-	svCopy(Barr, xarr, 0);
 	FLT *a_ws = SV_MATRIX_ALLOC(mat_size_bytes(Aarr));
 	memcpy(a_ws, SV_RAW_PTR(Aarr), mat_size_bytes(Aarr));
 
-	lapack_int brows = xarr->rows;
-	lapack_int bcols = xarr->cols;
-	lapack_int ldb = bcols; // Barr->step / sizeof(double);
+	lapack_int *ipiv = SV_MATRIX_ALLOC(sizeof(lapack_int) * n);
 
-	lapack_int *ipiv = SV_MATRIX_ALLOC(sizeof(lapack_int) * MIN(Aarr->rows, Aarr->cols));
-
-	inf = LAPACKE_getrf(LAPACK_ROW_MAJOR, arows, acols, (a_ws), lda, ipiv);
+	// This factors the transpose of A; solving with the transpose of that then solves against A itself
+	inf = LAPACKE_getrf_work(LAPACK_COL_MAJOR, n, n, a_ws, n, ipiv);
 	assert(inf >= 0);
 	if (inf > 0) {
 		printf("Warning: Singular matrix: \n");
@@ -398,9 +447,23 @@ static int svSolve_LU(const SvMat *Aarr, const SvMat *Barr, SvMat *xarr) {
 	print_mat(Barr);
 #endif
 
-	inf = LAPACKE_getrs(LAPACK_ROW_MAJOR, CblasNoTrans, arows, bcols, (a_ws), lda, ipiv, SV_RAW_PTR(xarr), ldb);
+	// A single column is the same in either layout; anything wider has to be turned around for LAPACK and back
+	FLT *b = SV_RAW_PTR(xarr);
+	if (xcols > 1) {
+		b = SV_MATRIX_ALLOC(mat_size_bytes(Barr));
+		to_col_major(b, n, SV_RAW_PTR(Barr), n, xcols);
+	} else {
+		svCopy(Barr, xarr, 0);
+	}
+
+	inf = LAPACKE_getrs_work(LAPACK_COL_MAJOR, 'T', n, xcols, a_ws, n, ipiv, b, n);
 	assert(inf == 0);
 
+	if (xcols > 1) {
+		from_col_major(SV_RAW_PTR(xarr), n, xcols, b, n);
+		SV_MATRIX_FREE(b);
+	}
+
 	SV_MATRIX_FREE(a_ws);
 	SV_MATRIX_FREE(ipiv);
 	return 0;
@@ -411,41 +474,28 @@ static inline int svSolve_SVD(const SvMat *Aarr, const SvMat *Barr, SvMat *xarr)
 	lapack_int acols = Aarr->cols;
 	lapack_int xcols = Barr->cols;
 
-	bool xLargerThanB = Barr->rows > acols;
-	SvMat *xCpy = 0;
-	if (xLargerThanB) {
-		SV_CLONE_MAT_ALLOCA(xCpyStack, Barr);
-		xCpy = xCpyStack;
-	} else {
-		xCpy = xarr;
-		memcpy(SV_RAW_PTR(xarr), SV_RAW_PTR(Barr), mat_size_bytes(Barr));
-	}
+	assert(Barr->rows == arows);
+	assert(xarr->rows == acols);
+	assert(xarr->cols == xcols);
 
-	// SvMat *aCpy = svCloneMat(Aarr);
-	FLT *aCpy = SV_MATRIX_ALLOC(mat_size_bytes(Aarr));
-	memcpy(aCpy, SV_RAW_PTR(Aarr), mat_size_bytes(Aarr));
+	// gelss needs the real A rather than its transpose, so both sides get a column major copy. B's is tall enough to
+	// hold the solution too, which is what gelss returns in it.
+	lapack_int ldb = MAX(1, MAX(arows, acols));
+	FLT *a = SV_MATRIX_ALLOC(mat_size_bytes(Aarr));
+	to_col_major(a, arows, SV_RAW_PTR(Aarr), arows, acols);
+	FLT *b = SV_MATRIX_ALLOC(sizeof(FLT) * ldb * xcols);
+	to_col_major(b, ldb, SV_RAW_PTR(Barr), arows, xcols);
 
 	FLT *S = SV_MATRIX_ALLOC(sizeof(FLT) * MIN(arows, acols));
-	// FLT *S = malloc(sizeof(FLT) * MIN(arows, acols));
 	FLT rcond = -1;
-	lapack_int *rank = SV_MATRIX_ALLOC(sizeof(lapack_int) * MIN(arows, acols));
-	lapack_int inf =
-		LAPACKE_gelss(LAPACK_ROW_MAJOR, arows, acols, xcols, (aCpy), acols, SV_RAW_PTR(xCpy), xcols, S, rcond, rank);
-	assert(xarr->rows == acols);
-	assert(xarr->cols == xCpy->cols);
+	lapack_int rank = 0;
+	lapack_int inf = LAPACKE_gelss_cached(arows, acols, xcols, a, MAX(1, arows), b, ldb, S, rcond, &rank);
 
-	if (xLargerThanB) {
-		xCpy->rows = acols;
-		svCopy(xCpy, xarr, 0);
-		// svReleaseMat(&xCpy);
-	}
+	from_col_major(SV_RAW_PTR(xarr), acols, xcols, b, ldb);
 
-	SV_MATRIX_FREE(rank);
-	SV_MATRIX_FREE(aCpy);
+	SV_MATRIX_FREE(a);
+	SV_MATRIX_FREE(b);
 	SV_MATRIX_FREE(S);
-	if (xLargerThanB) {
-		SV_MAT_ALLOCA_FREE(xCpy);
-	}
 
 	assert(inf == 0);
 	if (inf != 0)
@@ -500,8 +550,11 @@ SURVIVE_LOCAL_ONLY void svSVD(SvMat *aarr, SvMat *warr, SvMat *uarr, SvMat *varr
 
 	lapack_int inf;
 
+	SvMat a_copy;
 	if ((flags & SV_SVD_MODIFY_A) == 0) {
-		aarr = svCloneMat(aarr);
+		a_copy = svMat(aarr->rows, aarr->cols, SV_MATRIX_ALLOC(mat_size_bytes(aarr)));
+		svCopy(aarr, &a_copy, 0);
+		aarr = &a_copy;
 	}
 
 	if (uarr == 0)
@@ -515,12 +568,12 @@ SURVIVE_LOCAL_ONLY void svSVD(SvMat *aarr, SvMat *warr, SvMat *uarr, SvMat *varr
 	FLT *pu = uarr ? SV_RAW_PTR(uarr) : (FLT *)CALLOCA(sizeof(FLT) * arows * arows);
 	FLT *pv = varr ? SV_RAW_PTR(varr) : (FLT *)CALLOCA(sizeof(FLT) * acols * acols);
 
-	lapack_int ulda = uarr ? uarr->cols : acols;
+	lapack_int ulda = uarr ? uarr->cols : arows;
 	lapack_int plda = varr ? varr->cols : acols;
 
-	FLT *superb = CALLOCA(sizeof(FLT) * MIN(arows, acols));
-	inf = LAPACKE_gesvd_static_alloc(LAPACK_ROW_MAJOR, jobu, jobvt, arows, acols, SV_RAW_PTR(aarr), acols, pw, pu, ulda,
-									 pv, plda, superb);
+	// LAPACK sees a^t = v * w * u^t, so its 'u' is our v and its 'vt' our u^t. Those come out column major, which read
+	// as row major gives v^t and u -- exactly what the row major call used to produce.
+	inf = LAPACKE_gesvd_cached(jobvt, jobu, acols, arows, SV_RAW_PTR(aarr), acols, pw, pv, plda, pu, ulda);
 
 	switch (inf) {
 	case -6:
@@ -541,7 +594,7 @@ SURVIVE_LOCAL_ONLY void svSVD(SvMat *aarr, SvMat *warr, SvMat *uarr, SvMat *varr
 	}
 
 	if ((flags & SV_SVD_MODIFY_A) == 0) {
-		svReleaseMat(&aarr);
+		SV_MATRIX_FREE(SV_RAW_PTR(&a_copy));
 	}
 }
 
@@ -0,0 +1,288 @@
+#include "sv_matrix.h"
+#include "sv_matrix.small.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define SURVIVE_LOCAL_ONLY
+#include <malloc.h>
+#define alloca _alloca
+#else
+#define SURVIVE_LOCAL_ONLY __attribute__((visibility("hidden")))
+#endif
+
+#ifdef SV_MATRIX_IS_COL_MAJOR
+#error "The small matrix backend only supports row major matrices"
+#endif
+
+// Scratch space that is always completely written before it's read, so unlike SV_CREATE_STACK_MAT it isn't cleared
+#define SV_SMALL_WORKSPACE(type, name, cnt) type *name = (type *)alloca(sizeof(type) * (cnt))
+
+#define SV_SMALL_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/*
+ * With the length of the innermost loop known at compile time it is unrolled without any remainder handling, which
+ * is worth close to 2x at these sizes. These are the lengths that come up: rotations, poses, and the kalman tracker
+ * state in the sizes it is configured with.
+ */
+#define SV_SMALL_GEMM_WIDTHS(X) X(3) X(7) X(13) X(16) X(19) X(22)
+
+static void small_gemm(FLT *dst, const FLT *a, const FLT *b, const FLT *c, int m, int n, int k, FLT alpha, FLT beta,
+					   bool a_t, bool b_t, bool c_t) {
+	// Rows of b are contiguous, so the inner loop runs along n -- unless b is transposed, where it runs along k
+	int width = b_t ? k : n;
+	if (m == 3 && n == 3 && k == 3) {
+		sv_small_gemm(dst, a, b, c, 3, 3, 3, alpha, beta, a_t, b_t, c_t);
+		return;
+	}
+
+	switch (width) {
+#define SV_SMALL_GEMM_WIDTH_CASE(w)                                                                                    \
+	case w:                                                                                                            \
+		if (b_t)                                                                                                       \
+			sv_small_gemm(dst, a, b, c, m, n, w, alpha, beta, a_t, true, c_t);                                         \
+		else                                                                                                           \
+			sv_small_gemm(dst, a, b, c, m, w, k, alpha, beta, a_t, false, c_t);                                        \
+		return;
+		SV_SMALL_GEMM_WIDTHS(SV_SMALL_GEMM_WIDTH_CASE)
+#undef SV_SMALL_GEMM_WIDTH_CASE
+	default:
+		sv_small_gemm(dst, a, b, c, m, n, k, alpha, beta, a_t, b_t, c_t);
+	}
+}
+
+SURVIVE_LOCAL_ONLY void svGEMM(const SvMat *src1, const SvMat *src2, double alpha, const SvMat *src3, double beta,
+							   SvMat *dst, enum svGEMMFlags tABC) {
+	bool a_t = tABC & SV_GEMM_FLAG_A_T, b_t = tABC & SV_GEMM_FLAG_B_T, c_t = tABC & SV_GEMM_FLAG_C_T;
+	int rows1 = a_t ? src1->cols : src1->rows;
+	int cols1 = a_t ? src1->rows : src1->cols;
+	int rows2 = b_t ? src2->cols : src2->rows;
+	int cols2 = b_t ? src2->rows : src2->cols;
+
+	if (src3) {
+		assert((c_t ? src3->cols : src3->rows) == dst->rows);
+		assert((c_t ? src3->rows : src3->cols) == dst->cols);
+		assert(!c_t || SV_FLT_PTR(src3) != SV_FLT_PTR(dst));
+	}
+	assert(cols1 == rows2);
+	assert(rows1 == dst->rows);
+	assert(cols2 == dst->cols);
+	assert(SV_FLT_PTR(dst) != SV_FLT_PTR(src1));
+	assert(SV_FLT_PTR(dst) != SV_FLT_PTR(src2));
+	(void)cols2;
+
+	small_gemm(SV_FLT_PTR(dst), SV_FLT_PTR(src1), SV_FLT_PTR(src2), src3 ? SV_FLT_PTR(src3) : 0, rows1, dst->cols, cols1,
+			   alpha, beta, a_t, b_t, c_t);
+}
+
+// dst = scale * src ^ t * src     iff order == 1
+// dst = scale *     src * src ^ t iff order == 0
+SURVIVE_LOCAL_ONLY void svMulTransposed(const SvMat *src, SvMat *dst, int order, const SvMat *delta, double scale) {
+	int rows = src->rows, cols = src->cols;
+	assert(dst->rows == dst->cols);
+	assert(dst->cols == (order == 1 ? cols : rows));
+
+	const FLT *s = SV_FLT_PTR(src);
+	if (delta) {
+		assert(delta->rows == rows && delta->cols == cols);
+		SV_SMALL_WORKSPACE(FLT, diff, rows * cols);
+		for (int i = 0; i < rows * cols; i++)
+			diff[i] = s[i] - SV_FLT_PTR(delta)[i];
+		s = diff;
+	}
+
+	if (order == 1)
+		small_gemm(SV_FLT_PTR(dst), s, s, 0, cols, cols, rows, scale, 0, true, false, false);
+	else
+		small_gemm(SV_FLT_PTR(dst), s, s, 0, rows, rows, cols, scale, 0, false, true, false);
+}
+
+SURVIVE_LOCAL_ONLY void svTranspose(const SvMat *M, SvMat *dst) {
+	const FLT *src = SV_FLT_PTR(M);
+	if (SV_FLT_PTR(M) == SV_FLT_PTR(dst)) {
+		SV_SMALL_WORKSPACE(FLT, copy, M->rows * M->cols);
+		memcpy(copy, src, sizeof(FLT) * M->rows * M->cols);
+		src = copy;
+	} else {
+		assert(M->rows == dst->cols);
+		assert(M->cols == dst->rows);
+	}
+	sv_small_transpose(SV_FLT_PTR(dst), src, M->rows, M->cols);
+}
+
+/*
+ * Writes the square basis whose first 'cols' columns are given in 'thin' to 'dst', filling in the columns from 'rank'
+ * onward -- the decomposition only fixes as many directions as there are nonzero singular values.
+ */
+static void store_basis(SvMat *dst, const FLT *thin, int rows, int cols, int rank, bool transpose) {
+	assert(dst->rows == rows && dst->cols == rows);
+
+	SV_SMALL_WORKSPACE(FLT, full, rows * rows);
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < rows; j++)
+			full[i * rows + j] = j < rank ? thin[i * cols + j] : 0;
+	}
+	sv_small_complete_basis(full, rows, rows, rank);
+
+	if (transpose)
+		sv_small_transpose(SV_FLT_PTR(dst), full, rows, rows);
+	else
+		memcpy(SV_FLT_PTR(dst), full, sizeof(FLT) * rows * rows);
+}
+
+SURVIVE_LOCAL_ONLY void svSVD(SvMat *aarr, SvMat *warr, SvMat *uarr, SvMat *varr, enum svSVDFlags flags) {
+	int m = aarr->rows, n = aarr->cols;
+
+	// The decomposition wants at least as many rows as columns; for wide matrices take it of the transpose, which
+	// just trades the roles of u and v
+	bool wide = m < n;
+	int work_rows = wide ? n : m, work_cols = wide ? m : n;
+	SvMat *thin_out = wide ? varr : uarr;
+	SvMat *square_out = wide ? uarr : varr;
+
+	SV_SMALL_WORKSPACE(FLT, work, work_rows * work_cols);
+	if (wide)
+		sv_small_transpose(work, SV_FLT_PTR(aarr), m, n);
+	else
+		memcpy(work, SV_FLT_PTR(aarr), sizeof(FLT) * m * n);
+
+	SV_SMALL_WORKSPACE(FLT, w, work_cols);
+	SV_SMALL_WORKSPACE(FLT, square, work_cols * work_cols);
+	int rank = sv_small_svd(work, work_rows, work_cols, w, square_out ? square : 0);
+
+	if (warr) {
+		if (warr->rows == 1 || warr->cols == 1) {
+			assert(warr->rows * warr->cols >= work_cols);
+			memcpy(SV_FLT_PTR(warr), w, sizeof(FLT) * work_cols);
+		} else {
+			sv_set_zero(warr);
+			for (int i = 0; i < work_cols; i++)
+				svMatrixSet(warr, i, i, w[i]);
+		}
+	}
+
+	bool u_t = flags & SV_SVD_U_T, v_t = flags & SV_SVD_V_T;
+	if (thin_out)
+		store_basis(thin_out, work, work_rows, work_cols, rank, wide ? v_t : u_t);
+	if (square_out)
+		store_basis(square_out, square, work_cols, work_cols, work_cols, wide ? u_t : v_t);
+}
+
+/*
+ * x = pinv(A) * B, by way of the SVD. Singular values below the precision of the largest are treated as zero, which
+ * gives the least squares solution, and the minimum norm one if there are many.
+ */
+static void solve_svd(const SvMat *Aarr, const FLT *b, int bcols, SvMat *xarr) {
+	int m = Aarr->rows, n = Aarr->cols;
+	bool wide = m < n;
+	int work_rows = wide ? n : m, rank_max = wide ? m : n;
+	assert(xarr->rows == n && xarr->cols == bcols);
+
+	SV_SMALL_WORKSPACE(FLT, work, m * n);
+	if (wide)
+		sv_small_transpose(work, SV_FLT_PTR(Aarr), m, n);
+	else
+		memcpy(work, SV_FLT_PTR(Aarr), sizeof(FLT) * m * n);
+
+	SV_SMALL_WORKSPACE(FLT, w, rank_max);
+	SV_SMALL_WORKSPACE(FLT, square, rank_max * rank_max);
+	sv_small_svd(work, work_rows, rank_max, w, square);
+
+	// A = left * diag(w) * right^t, with left m x rank_max and right n x rank_max
+	const FLT *left = wide ? square : work;
+	const FLT *right = wide ? work : square;
+
+	SV_SMALL_WORKSPACE(FLT, tmp, rank_max * bcols);
+	small_gemm(tmp, left, b, 0, rank_max, bcols, m, 1, 0, true, false, false);
+
+	FLT tolerance = SV_SMALL_EPSILON * SV_SMALL_MAX(m, n) * w[0];
+	for (int i = 0; i < rank_max; i++) {
+		FLT inv = w[i] > tolerance ? 1. / w[i] : 0;
+		for (int j = 0; j < bcols; j++)
+			tmp[i * bcols + j] *= inv;
+	}
+
+	small_gemm(SV_FLT_PTR(xarr), right, tmp, 0, n, bcols, rank_max, 1, 0, false, false, false);
+}
+
+SURVIVE_LOCAL_ONLY double svInvert(const SvMat *srcarr, SvMat *dstarr, enum svInvertMethod method) {
+	int m = srcarr->rows, n = srcarr->cols;
+	assert(dstarr->rows == n && dstarr->cols == m);
+
+	if (method == SV_INVERT_METHOD_LU) {
+		assert(m == n);
+		SV_SMALL_WORKSPACE(FLT, lu, n * n);
+		SV_SMALL_WORKSPACE(int, piv, n);
+		memcpy(lu, SV_FLT_PTR(srcarr), sizeof(FLT) * n * n);
+		if (!sv_small_lu(lu, n, piv)) {
+			printf("Warning: Singular matrix: \n");
+		}
+
+		sv_eye(dstarr, 0);
+		sv_small_lu_solve(lu, piv, n, SV_FLT_PTR(dstarr), n);
+	} else {
+		SV_SMALL_WORKSPACE(FLT, eye, m * m);
+		for (int i = 0; i < m * m; i++)
+			eye[i] = i % (m + 1) == 0;
+		solve_svd(srcarr, eye, m, dstarr);
+	}
+	return 0;
+}
+
+SURVIVE_LOCAL_ONLY int svSolve(const SvMat *Aarr, const SvMat *Barr, SvMat *xarr, enum svInvertMethod method) {
+	assert(Barr->rows == Aarr->rows);
+	assert(xarr->rows == Aarr->cols);
+	assert(xarr->cols == Barr->cols);
+
+	if (method == SV_INVERT_METHOD_LU) {
+		int n = Aarr->rows;
+		assert(Aarr->cols == n);
+		SV_SMALL_WORKSPACE(FLT, lu, n * n);
+		SV_SMALL_WORKSPACE(int, piv, n);
+		memcpy(lu, SV_FLT_PTR(Aarr), sizeof(FLT) * n * n);
+		if (!sv_small_lu(lu, n, piv)) {
+			printf("Warning: Singular matrix: \n");
+		}
+
+		if (SV_FLT_PTR(xarr) != SV_FLT_PTR(Barr))
+			svCopy(Barr, xarr, 0);
+		sv_small_lu_solve(lu, piv, n, SV_FLT_PTR(xarr), xarr->cols);
+		return 0;
+	} else if (method == SV_INVERT_METHOD_SVD || method == SV_INVERT_METHOD_QR) {
+		const FLT *b = SV_FLT_PTR(Barr);
+		if (SV_FLT_PTR(xarr) == b) {
+			SV_SMALL_WORKSPACE(FLT, copy, Barr->rows * Barr->cols);
+			memcpy(copy, b, sizeof(FLT) * Barr->rows * Barr->cols);
+			b = copy;
+		}
+		solve_svd(Aarr, b, Barr->cols, xarr);
+		return 0;
+	}
+
+	assert("Unknown method to solve" && 0);
+	return -1;
+}
+
+SURVIVE_LOCAL_ONLY double svDet(const SvMat *M) {
+	assert(M->rows == M->cols);
+	const FLT *m = SV_FLT_PTR(M);
+
+	switch (M->rows) {
+	case 1:
+		return m[0];
+	case 2:
+		return m[0] * m[3] - m[1] * m[2];
+	case 3:
+		return m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) +
+			   m[2] * (m[3] * m[7] - m[4] * m[6]);
+	default: {
+		int n = M->rows;
+		SV_SMALL_WORKSPACE(FLT, lu, n * n);
+		SV_SMALL_WORKSPACE(int, piv, n);
+		memcpy(lu, m, sizeof(FLT) * n * n);
+		sv_small_lu(lu, n, piv);
+		return sv_small_lu_det(lu, piv, n);
+	}
+	}
+}
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "linmath.h"
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Kernels for the small dense matrices the trackers work with -- 3x3 rotations, the ~19 wide kalman state and the
+ * barycentric solver systems. Everything is inline and works on plain row major arrays, so with sizes known at
+ * compile time the compiler unrolls it completely, and otherwise there is still no library call, workspace query
+ * or dispatch in the way, which for these sizes costs more than the arithmetic does.
+ *
+ * These back sv_matrix.h when built with USE_SMALL_MATRIX, but don't depend on it and can be called directly on
+ * fixed size arrays. None of them allocate; where scratch space is needed the caller passes it in.
+ */
+
+#ifdef USE_FLOAT
+#define SV_SMALL_EPSILON FLT_EPSILON
+#else
+#define SV_SMALL_EPSILON DBL_EPSILON
+#endif
+
+#define SV_SMALL_SVD_MAX_SWEEPS 64
+
+#if defined(__cplusplus) || defined(_MSC_VER)
+#define SV_SMALL_RESTRICT __restrict
+#else
+#define SV_SMALL_RESTRICT restrict
+#endif
+
+/**
+ * dst = alpha * op(a) * op(b) + beta * op(c), where op transposes its argument if the matching flag is set. dst is
+ * m x n and the inner dimension is k; 'c' may be null, and may be dst itself when it isn't transposed. dst must not
+ * alias a or b.
+ */
+static inline void sv_small_gemm(FLT *dst, const FLT *SV_SMALL_RESTRICT a, const FLT *SV_SMALL_RESTRICT b, const FLT *c,
+								 int m, int n, int k, FLT alpha, FLT beta, bool a_t, bool b_t, bool c_t) {
+	if (c == 0) {
+		for (int i = 0; i < m * n; i++)
+			dst[i] = 0;
+	} else if (c_t) {
+		for (int i = 0; i < m; i++) {
+			for (int j = 0; j < n; j++)
+				dst[i * n + j] = beta * c[j * m + i];
+		}
+	} else {
+		for (int i = 0; i < m * n; i++)
+			dst[i] = beta * c[i];
+	}
+
+	// Each case gets its own loops so the inner one is always a straight run over contiguous memory
+	if (b_t && a_t) {
+		for (int i = 0; i < m; i++) {
+			for (int j = 0; j < n; j++) {
+				FLT s = 0;
+				for (int l = 0; l < k; l++)
+					s += a[l * m + i] * b[j * k + l];
+				dst[i * n + j] += alpha * s;
+			}
+		}
+	} else if (b_t) {
+		for (int i = 0; i < m; i++) {
+			for (int j = 0; j < n; j++) {
+				FLT s = 0;
+				for (int l = 0; l < k; l++)
+					s += a[i * k + l] * b[j * k + l];
+				dst[i * n + j] += alpha * s;
+			}
+		}
+	} else if (a_t) {
+		for (int l = 0; l < k; l++) {
+			for (int i = 0; i < m; i++) {
+				FLT s = alpha * a[l * m + i];
+				for (int j = 0; j < n; j++)
+					dst[i * n + j] += s * b[l * n + j];
+			}
+		}
+	} else {
+		for (int i = 0; i < m; i++) {
+			for (int l = 0; l < k; l++) {
+				FLT s = alpha * a[i * k + l];
+				for (int j = 0; j < n; j++)
+					dst[i * n + j] += s * b[l * n + j];
+			}
+		}
+	}
+}
+
+static inline void sv_small_transpose(FLT *dst, const FLT *src, int rows, int cols) {
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < cols; j++)
+			dst[j * rows + i] = src[i * cols + j];
+	}
+}
+
+/**
+ * In place LU decomposition with partial pivoting of the n x n matrix 'a'; row i was swapped with row piv[i] on step
+ * i. The unit lower and upper triangles both end up in 'a'.
+ * @return false if the matrix is singular; the decomposition is still completed, but solving with it divides by zero
+ */
+static inline bool sv_small_lu(FLT *a, int n, int *piv) {
+	bool nonsingular = true;
+	for (int i = 0; i < n; i++) {
+		int p = i;
+		for (int r = i + 1; r < n; r++) {
+			if (fabs(a[r * n + i]) > fabs(a[p * n + i]))
+				p = r;
+		}
+		piv[i] = p;
+		if (p != i) {
+			for (int j = 0; j < n; j++) {
+				FLT t = a[i * n + j];
+				a[i * n + j] = a[p * n + j];
+				a[p * n + j] = t;
+			}
+		}
+
+		FLT pivot = a[i * n + i];
+		if (pivot == 0) {
+			nonsingular = false;
+			continue;
+		}
+
+		for (int r = i + 1; r < n; r++) {
+			FLT f = a[r * n + i] /= pivot;
+			for (int j = i + 1; j < n; j++)
+				a[r * n + j] -= f * a[i * n + j];
+		}
+	}
+	return nonsingular;
+}
+
+// Solves a * x = b in place for the n x cols 'b', given the decomposition of 'a' from sv_small_lu
+static inline void sv_small_lu_solve(const FLT *lu, const int *piv, int n, FLT *b, int cols) {
+	for (int i = 0; i < n; i++) {
+		if (piv[i] != i) {
+			for (int j = 0; j < cols; j++) {
+				FLT t = b[i * cols + j];
+				b[i * cols + j] = b[piv[i] * cols + j];
+				b[piv[i] * cols + j] = t;
+			}
+		}
+	}
+
+	for (int i = 1; i < n; i++) {
+		for (int l = 0; l < i; l++) {
+			FLT f = lu[i * n + l];
+			for (int j = 0; j < cols; j++)
+				b[i * cols + j] -= f * b[l * cols + j];
+		}
+	}
+
+	for (int i = n - 1; i >= 0; i--) {
+		for (int l = i + 1; l < n; l++) {
+			FLT f = lu[i * n + l];
+			for (int j = 0; j < cols; j++)
+				b[i * cols + j] -= f * b[l * cols + j];
+		}
+		FLT inv = 1. / lu[i * n + i];
+		for (int j = 0; j < cols; j++)
+			b[i * cols + j] *= inv;
+	}
+}
+
+// Determinant from the decomposition of sv_small_lu
+static inline FLT sv_small_lu_det(const FLT *lu, const int *piv, int n) {
+	FLT det = 1;
+	for (int i = 0; i < n; i++) {
+		det *= lu[i * n + i];
+		if (piv[i] != i)
+			det = -det;
+	}
+	return det;
+}
+
+static inline void sv_small_swap_cols(FLT *a, int rows, int cols, int i, int j) {
+	for (int r = 0; r < rows; r++) {
+		FLT t = a[r * cols + i];
+		a[r * cols + i] = a[r * cols + j];
+		a[r * cols + j] = t;
+	}
+}
+
+/**
+ * Thin singular value decomposition a = u * diag(w) * v^t of an m x n matrix with m >= n, by one sided Jacobi
+ * rotations. Jacobi is slower than bidiagonalization for big matrices, but it's compact, accurate to full precision
+ * even for the smallest singular values, and is quick for matrices this size.
+ *
+ * 'a' is overwritten with the m x n 'u'. 'w' gets the n singular values in descending order. 'v' is n x n and
+ * optional. Columns of 'u' that belong to zero singular values are left zero, see sv_small_complete_basis.
+ * @return The rank; the number of leading columns of 'u' that are filled in
+ */
+static inline int sv_small_svd(FLT *a, int m, int n, FLT *w, FLT *v) {
+	if (v) {
+		for (int i = 0; i < n; i++) {
+			for (int j = 0; j < n; j++)
+				v[i * n + j] = i == j;
+		}
+	}
+
+	for (int sweep = 0; sweep < SV_SMALL_SVD_MAX_SWEEPS; sweep++) {
+		bool rotated = false;
+		for (int p = 0; p < n - 1; p++) {
+			for (int q = p + 1; q < n; q++) {
+				FLT alpha = 0, beta = 0, gamma = 0;
+				for (int r = 0; r < m; r++) {
+					FLT ap = a[r * n + p], aq = a[r * n + q];
+					alpha += ap * ap;
+					beta += aq * aq;
+					gamma += ap * aq;
+				}
+				if (gamma == 0 || fabs(gamma) <= SV_SMALL_EPSILON * sqrt(alpha * beta))
+					continue;
+				rotated = true;
+
+				// Rotation that makes columns p and q orthogonal
+				FLT zeta = (beta - alpha) / (2 * gamma);
+				FLT t = (zeta >= 0 ? 1. : -1.) / (fabs(zeta) + sqrt(1 + zeta * zeta));
+				FLT c = 1. / sqrt(1 + t * t), s = c * t;
+				for (int r = 0; r < m; r++) {
+					FLT ap = a[r * n + p], aq = a[r * n + q];
+					a[r * n + p] = c * ap - s * aq;
+					a[r * n + q] = s * ap + c * aq;
+				}
+				if (v) {
+					for (int r = 0; r < n; r++) {
+						FLT vp = v[r * n + p], vq = v[r * n + q];
+						v[r * n + p] = c * vp - s * vq;
+						v[r * n + q] = s * vp + c * vq;
+					}
+				}
+			}
+		}
+		if (!rotated)
+			break;
+	}
+
+	for (int j = 0; j < n; j++) {
+		FLT norm = 0;
+		for (int r = 0; r < m; r++)
+			norm += a[r * n + j] * a[r * n + j];
+		w[j] = sqrt(norm);
+	}
+
+	int rank = 0;
+	for (int j = 0; j < n; j++) {
+		int largest = j;
+		for (int l = j + 1; l < n; l++) {
+			if (w[l] > w[largest])
+				largest = l;
+		}
+		if (largest != j) {
+			FLT t = w[j];
+			w[j] = w[largest];
+			w[largest] = t;
+			sv_small_swap_cols(a, m, n, j, largest);
+			if (v)
+				sv_small_swap_cols(v, n, n, j, largest);
+		}
+
+		// Whatever is left of a column with a negligible singular value is rounding noise, not a direction
+		if (w[j] <= SV_SMALL_EPSILON * w[0] * m) {
+			for (int r = 0; r < m; r++)
+				a[r * n + j] = 0;
+		} else {
+			for (int r = 0; r < m; r++)
+				a[r * n + j] /= w[j];
+			rank++;
+		}
+	}
+	return rank;
+}
+
+/**
+ * Fills columns 'from' and on of the rows x cols matrix 'u' so that all its columns are orthonormal, given that the
+ * columns before 'from' already are. Used to get the full 'u' out of a thin decomposition.
+ */
+static inline void sv_small_complete_basis(FLT *u, int rows, int cols, int from) {
+	for (int j = from; j < cols; j++) {
+		// Gram-Schmidt on the unit vector that is least covered by the columns so far
+		FLT best_norm = -1;
+		int best = 0;
+		for (int e = 0; e < rows; e++) {
+			FLT covered = 0;
+			for (int l = 0; l < j; l++)
+				covered += u[e * cols + l] * u[e * cols + l];
+			if (1 - covered > best_norm) {
+				best_norm = 1 - covered;
+				best = e;
+			}
+		}
+
+		for (int r = 0; r < rows; r++)
+			u[r * cols + j] = r == best;
+		// Twice, since once isn't numerically orthogonal when the candidate was mostly covered already
+		for (int pass = 0; pass < 2; pass++) {
+			for (int l = 0; l < j; l++) {
+				FLT d = 0;
+				for (int r = 0; r < rows; r++)
+					d += u[r * cols + l] * u[r * cols + j];
+				for (int r = 0; r < rows; r++)
+					u[r * cols + j] -= d * u[r * cols + l];
+			}
+		}
+
+		FLT norm = 0;
+		for (int r = 0; r < rows; r++)
+			norm += u[r * cols + j] * u[r * cols + j];
+		norm = sqrt(norm);
+		for (int r = 0; r < rows; r++)
+			u[r * cols + j] /= norm;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
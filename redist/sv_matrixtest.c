@@ -185,6 +185,68 @@ static void test_svd() {
 	assertFLTAEquals(sv_as_vector(&w), wgt, 3);
 }
 
+// u * diag(w) * v^t has to give back the input for tall, wide and rank deficient matrices alike
+static void test_svd_reconstructs(int rows, int cols, const FLT *a) {
+	int rank_max = rows < cols ? rows : cols;
+	SV_CREATE_STACK_MAT(A, rows, cols);
+	SV_CREATE_STACK_MAT(w, rank_max, 1);
+	SV_CREATE_STACK_MAT(u, rows, rows);
+	SV_CREATE_STACK_MAT(v, cols, cols);
+	SV_CREATE_STACK_MAT(uw, rows, cols);
+	SV_CREATE_STACK_MAT(usv, rows, cols);
+	sv_copy_in_row_major(&A, a, cols);
+
+	svSVD(&A, &w, &u, &v, 0);
+	PRINT_MAT(w);
+
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < cols; j++)
+			svMatrixSet(&uw, i, j, j < rank_max ? svMatrixGet(&u, i, j) * _w[j] : 0);
+	}
+	svGEMM(&uw, &v, 1, 0, 0, &usv, SV_GEMM_FLAG_B_T);
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < cols; j++)
+			assert(assertFLTEquals(svMatrixGet(&usv, i, j), a[i * cols + j]));
+	}
+
+	// Both bases have to be complete, even where the singular values are zero
+	SV_CREATE_STACK_MAT(utu, rows, rows);
+	svMulTransposed(&u, &utu, 1, 0, 1);
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < rows; j++)
+			assert(assertFLTEquals(svMatrixGet(&utu, i, j), i == j));
+	}
+	SV_CREATE_STACK_MAT(vtv, cols, cols);
+	svMulTransposed(&v, &vtv, 1, 0, 1);
+	for (int i = 0; i < cols; i++) {
+		for (int j = 0; j < cols; j++)
+			assert(assertFLTEquals(svMatrixGet(&vtv, i, j), i == j));
+	}
+
+	SV_FREE_STACK_MAT(vtv);
+	SV_FREE_STACK_MAT(utu);
+	SV_FREE_STACK_MAT(usv);
+	SV_FREE_STACK_MAT(uw);
+	SV_FREE_STACK_MAT(v);
+	SV_FREE_STACK_MAT(u);
+	SV_FREE_STACK_MAT(w);
+	SV_FREE_STACK_MAT(A);
+}
+
+static void test_svd_shapes() {
+	printf("SVD shapes:\n");
+
+	FLT tall[4 * 3] = {1, 2, 3, 4, 5, 6, 7, 8, 12, -1, 0, 2};
+	test_svd_reconstructs(4, 3, tall);
+
+	FLT wide[2 * 3] = {1, 2, 3, 4, 5, 6};
+	test_svd_reconstructs(2, 3, wide);
+
+	// Third row is the sum of the first two
+	FLT rank_deficient[3 * 3] = {1, 2, 3, 4, 5, 6, 5, 7, 9};
+	test_svd_reconstructs(3, 3, rank_deficient);
+}
+
 static void test_multrans() {
 	FLT _A[3] = {1, 2, 3};
 	SvMat A = svMat(3, 1, _A);
@@ -343,6 +405,7 @@ int main()
 	test_gemm();
 	test_solve();
 	test_svd();
+	test_svd_shapes();
 	test_multrans();
 
 	/*
@@ -10,6 +10,50 @@
 
 #pragma GCC diagnostic ignored "-Wpedantic"
 
+void bc_svd_survive_fill_m(void *user, FLT *eq, int axis, FLT angle) {
+	SurviveObject *so = user;
+
+	FLT sv = sin(angle), cv = cos(angle);
+	switch (so->ctx->lh_version) {
+	case 0: {
+		switch (axis) {
+		case 0:
+			eq[0] = cv;
+			eq[1] = 0;
+			eq[2] = -sv;
+			break;
+		case 1:
+			eq[0] = 0;
+			eq[1] = cv;
+			eq[2] = -sv;
+			break;
+		}
+
+	} break;
+	case 1: {
+		FLT tan30 = 0.57735026919;
+		switch (axis) {
+		case 0:
+			eq[0] = cv;
+			eq[1] = -tan30;
+			eq[2] = -sv;
+			break;
+		case 1:
+			eq[0] = cv;
+			eq[1] = tan30;
+			eq[2] = -sv;
+			break;
+		}
+	} break;
+	case 3: {
+		eq[0] = eq[1] = eq[2] = 0;
+		break;
+	}
+	default:
+		assert(false);
+	}
+}
+
 static void bc_svd_choose_control_points(bc_svd *self) {
 	// Take C0 as the reference points centroid:
 	self->setup.control_points[0][0] = self->setup.control_points[0][1] = self->setup.control_points[0][2] = 0;
@@ -94,8 +138,14 @@ void bc_svd_bc_svd(bc_svd *self, void *user, bc_svd_fill_M_fn fillFn, const Linm
 	bc_svd_compute_barycentric_coordinates(self);
 }
 
+void bc_svd_bc_svd_shared(bc_svd *self, const bc_svd *model) {
+	*self = (bc_svd){.setup = model->setup, .shared_setup = true};
+	self->object_pts_in_camera = SV_CALLOC_N(self->setup.obj_cnt, sizeof(self->setup.alphas[0]));
+}
+
 void bc_svd_dtor(bc_svd *self) {
-	free(self->setup.alphas);
+	if (!self->shared_setup)
+		free(self->setup.alphas);
 	free(self->object_pts_in_camera);
 	free(self->meas);
 }
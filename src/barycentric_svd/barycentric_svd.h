@@ -13,6 +13,12 @@ typedef FLT LinmathPoint4d[4];
 
 typedef void (*bc_svd_fill_M_fn)(void *user, FLT *eq, int axis, FLT angle);
 
+/**
+ * bc_svd_fill_M_fn for lighthouse angles, with 'user' the SurviveObject being solved for. Uses the equations of the
+ * context's lighthouse generation.
+ */
+void bc_svd_survive_fill_m(void *user, FLT *eq, int axis, FLT angle);
+
 typedef struct {
 	size_t obj_cnt;
 	const LinmathPoint3d *obj_pts;
@@ -32,6 +38,8 @@ typedef struct {
 
 typedef struct {
 	bc_svd_setup setup;
+	// Set when 'setup' belongs to another solver, see bc_svd_bc_svd_shared
+	bool shared_setup;
 
 	size_t meas_space, meas_cnt;
 	bc_svd_meas_t *meas; // [meas_cnt]
@@ -41,6 +49,12 @@ typedef struct {
 } bc_svd;
 
 void bc_svd_bc_svd(bc_svd *self, void *user, bc_svd_fill_M_fn fillFn, const LinmathPoint3d *obj_pts, size_t obj_cnt);
+/**
+ * Makes a solver that uses the control points and barycentric coordinates of 'model' instead of computing its own.
+ * Those only depend on the object points, so any number of solvers -- e.g. one per lighthouse, running on different
+ * threads -- can share them. 'model' has to outlive the new solver.
+ */
+void bc_svd_bc_svd_shared(bc_svd *self, const bc_svd *model);
 void bc_svd_dtor(bc_svd *self);
 
 void bc_svd_reset_correspondences(bc_svd *self);
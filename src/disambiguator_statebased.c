@@ -213,29 +213,13 @@ typedef struct {
 	LightcapElement sweep_data[];
 } Disambiguator_data_t;
 
-static int find_acode(uint32_t pulseLen) {
-	const static int offset = 50;
-	if (pulseLen < 2500 + offset)
-		return -1;
-
-	if (pulseLen < 3000 + offset)
-		return 0;
-	if (pulseLen < 3500 + offset)
-		return 1;
-	if (pulseLen < 4000 + offset)
-		return 2;
-	if (pulseLen < 4500 + offset)
-		return 3;
-	if (pulseLen < 5000 + offset)
-		return 4;
-	if (pulseLen < 5500 + offset)
-		return 5;
-	if (pulseLen < 6000 + offset)
-		return 6;
-	if (pulseLen < 6500 + offset)
-		return 7;
-
-	return -1;
+// Acodes are 500 ticks apart starting at 2500, with some slack; computed without branches so batches of pulses can be
+// classified in a vectorizable loop.
+static inline int find_acode(uint32_t pulseLen) {
+	const int offset = 50;
+	int acode = ((int)pulseLen - (2500 + offset)) / 500;
+	bool valid = pulseLen >= 2500 + offset && pulseLen < 6500 + offset;
+	return valid ? acode : -1;
 }
 
 static int32_t overlap_area(const LightcapElement *a, const LightcapElement *b) {
@@ -281,14 +265,9 @@ LightcapElement get_last_sync(Disambiguator_data_t *d) {
 }
 
 enum LightcapClassification { LCC_SWEEP, LCC_SYNC };
-static enum LightcapClassification naive_classify(Disambiguator_data_t *d, const LightcapElement *le) {
+static inline enum LightcapClassification naive_classify(const LightcapElement *le) {
 	bool clearlyNotSync = le->length < LOWER_SYNC_TIME || le->length > UPPER_SYNC_TIME;
-
-	if (clearlyNotSync) {
-		return LCC_SWEEP;
-	} else {
-		return LCC_SYNC;
-	}
+	return clearlyNotSync ? LCC_SWEEP : LCC_SYNC;
 }
 
 static uint32_t SolveForMod_Offset(Disambiguator_data_t *d, enum LighthouseState state, const LightcapElement *le) {
@@ -356,10 +335,17 @@ static uint32_t apply_mod_offset(uint32_t timestamp, uint32_t mod_offset, enum L
 	return rtn;
 }
 
-static int find_inliers(Disambiguator_data_t *d, uint32_t guess_mod, bool test60hz) {
+/**
+ * Counts the syncs in the history that agree with 'guess_mod'. Counting stops once the guess can no longer get to
+ * 'min_inliers', so the count is only exact if it reaches that.
+ */
+static int find_inliers(Disambiguator_data_t *d, uint32_t guess_mod, bool test60hz, int min_inliers) {
 	int inliers = 0;
 	SurviveContext *ctx = d->so->ctx;
 	for (int i = 0; i < SYNC_HISTORY_LEN && d->sync_history[i].length > 0; i++) {
+		if (inliers + SYNC_HISTORY_LEN - i < min_inliers)
+			break;
+
 		const LightcapElement *le = &d->sync_history[i];
 
 		int end_of_mod = test60hz ? LS_WaitLHB_ACode0 : LS_END;
@@ -397,6 +383,10 @@ static enum LighthouseState find_relative_offset(Disambiguator_data_t *d, uint32
 	Global_Disambiguator_data_t *g = d->so->ctx->disambiguator_data;
 	Disambiguator_data_t *best_d = get_best_latest_state(g);
 
+	// Every sync in the history has to agree with a guess; until it is full there is no point in searching
+	if (d->sync_history[SYNC_HISTORY_LEN - 1].length == 0)
+		return LS_UNKNOWN;
+
 	int ri = (d->sync_offset + (SYNC_HISTORY_LEN - 1)) % SYNC_HISTORY_LEN;
 	LightcapElement *re = d->sync_history + ri;
 	int acode = find_acode(re->length) & 0x5;
@@ -415,7 +405,7 @@ static enum LighthouseState find_relative_offset(Disambiguator_data_t *d, uint32
 				if (best_d && test60hz != g->single_60hz_mode)
 					continue;
 
-				int inliers = find_inliers(d, guess_mod, test60hz);
+				int inliers = find_inliers(d, guess_mod, test60hz, SYNC_HISTORY_LEN);
 				DEBUG_LOCK("With 60hz -- %d %d", test60hz, inliers);
 				if (inliers > SYNC_HISTORY_LEN - 1) {
 					*mod = guess_mod;
@@ -469,7 +459,8 @@ static void ResetSync(Disambiguator_data_t *d) {
 	d->last_sync_timestamp = d->last_sync_length = d->last_sync_count = 0;
 }
 
-static enum LighthouseState AttemptFindState(Disambiguator_data_t *d, const LightcapElement *le) {
+static enum LighthouseState AttemptFindState(Disambiguator_data_t *d, const LightcapElement *le,
+											 enum LightcapClassification classification) {
 	/*
 	enum LighthouseState best_guess = get_best_latest_state(d->so->ctx->disambiguator_data);
 	if(best_guess != LS_UNKNOWN) {
@@ -480,8 +471,6 @@ static enum LighthouseState AttemptFindState(Disambiguator_data_t *d, const Ligh
 	}
 */
 
-	enum LightcapClassification classification = naive_classify(d, le);
-
 	if (classification == LCC_SYNC) {
 		LightcapElement lastSync = get_last_sync(d);
 
@@ -757,6 +746,37 @@ static void PropagateState(Disambiguator_data_t *d, const LightcapElement *le) {
 	}
 }
 
+// Returns the state for the object, or 0 if it can't take any light yet
+static Disambiguator_data_t *get_disambiguator_data(SurviveObject *so) {
+	SurviveContext *ctx = so->ctx;
+	if (ctx->state == SURVIVE_CLOSING) {
+		return 0;
+	}
+
+	// Note, this happens if we don't have config yet -- just bail
+	if (so->sensor_ct == 0) {
+		return 0;
+	}
+
+	if (so->ctx->disambiguator_data == NULL) {
+		Global_Disambiguator_data_t *d = SV_CALLOC(sizeof(Global_Disambiguator_data_t));
+		d->ctx = ctx;
+		ctx->disambiguator_data = d;
+		Global_Disambiguator_data_t_attach_config(ctx, d);
+	}
+
+	if (so->disambiguator_data == NULL) {
+		Disambiguator_data_t *d = SV_CALLOC(sizeof(Disambiguator_data_t) + sizeof(LightcapElement) * so->sensor_ct);
+		d->so = so;
+		so->disambiguator_data = d;
+	}
+
+	return so->disambiguator_data;
+}
+
+static void process_lightcap(Disambiguator_data_t *d, const LightcapElement *le,
+							 enum LightcapClassification classification);
+
 void DisambiguatorStateBased(SurviveObject *so, const LightcapElement *le) {
 	SurviveContext *ctx = so->ctx;
 
@@ -783,41 +803,77 @@ void DisambiguatorStateBased(SurviveObject *so, const LightcapElement *le) {
 		return;
 	}
 
-	if (ctx->state == SURVIVE_CLOSING) {
+	Disambiguator_data_t *d = get_disambiguator_data(so);
+	if (d == 0) {
 		return;
 	}
 
-	// Note, this happens if we don't have config yet -- just bail
-	if (so->sensor_ct == 0) {
+	// It seems like the first few hundred lightcapelements are missing a ton of data; let it stabilize.
+	if (d->stabalize < 200) {
+		d->stabalize++;
 		return;
 	}
 
-	if (so->ctx->disambiguator_data == NULL) {
-		Global_Disambiguator_data_t *d = SV_CALLOC(sizeof(Global_Disambiguator_data_t));
-		d->ctx = ctx;
-		ctx->disambiguator_data = d;
-		Global_Disambiguator_data_t_attach_config(ctx, d);
-	}
+	process_lightcap(d, le, naive_classify(le));
+}
 
-	if (so->disambiguator_data == NULL) {
-		Disambiguator_data_t *d = SV_CALLOC(sizeof(Disambiguator_data_t) + sizeof(LightcapElement) * so->sensor_ct);
-		d->so = so;
-		so->disambiguator_data = d;
+#define MAX_BATCH 32
+
+/**
+ * Same as calling DisambiguatorStateBased on each element in turn, for all the pulses of a USB packet at once. The per
+ * call setup is done once and the pulses are sorted into syncs and sweeps in a single pass before the state machine
+ * runs over them in the order they arrived.
+ *
+ * Installed as the lightcap_batch hook whenever this is the disambiguator in use.
+ */
+void LightcapBatchStateBased(SurviveObject *so, const LightcapElement *les, size_t cnt) {
+	SurviveContext *ctx = so->ctx;
+
+	// If something else took over the lightcap hook, it should see these pulses instead
+	if (ctx->lightcapproc != DisambiguatorStateBased) {
+		survive_default_lightcap_batch_process(so, les, cnt);
+		return;
 	}
 
-	Disambiguator_data_t *d = so->disambiguator_data;
+	Disambiguator_data_t *d = get_disambiguator_data(so);
+	if (d == 0) {
+		return;
+	}
 
-	// It seems like the first few hundred lightcapelements are missing a ton of data; let it stabilize.
 	if (d->stabalize < 200) {
-		d->stabalize++;
-		return;
+		size_t skip = linmath_imin(200 - d->stabalize, cnt);
+		d->stabalize += skip;
+		les += skip;
+		cnt -= skip;
 	}
 
+	uint8_t classification[MAX_BATCH];
+	while (cnt > 0) {
+		size_t batch_cnt = linmath_imin(cnt, MAX_BATCH);
+
+		for (size_t i = 0; i < batch_cnt; i++) {
+			classification[i] = naive_classify(&les[i]);
+		}
+
+		for (size_t i = 0; i < batch_cnt && ctx->state != SURVIVE_CLOSING; i++) {
+			process_lightcap(d, &les[i], classification[i]);
+		}
+
+		les += batch_cnt;
+		cnt -= batch_cnt;
+	}
+}
+
+static void process_lightcap(Disambiguator_data_t *d, const LightcapElement *le,
+							 enum LightcapClassification classification) {
+	SurviveObject *so = d->so;
+	SurviveContext *ctx = so->ctx;
+
 	SV_VERBOSE(3000, "%s LE: %2u\t%4u\t%10u\t%2u\t%7u", so->codename, le->sensor_id, le->length, le->timestamp,
 			   d->state, offset_from_state(d, le));
 
 	if (d->state == LS_UNKNOWN) {
-		enum LighthouseState new_state = AttemptFindState(d, le);
+		enum LighthouseState new_state = AttemptFindState(d, le, classification);
 		if (new_state != LS_UNKNOWN) {
 			d->confidence = 0;
 			d->failures = 0;
@@ -854,3 +910,4 @@ void DisambiguatorStateBased(SurviveObject *so, const LightcapElement *le) {
 }
 
 REGISTER_LINKTIME(DisambiguatorStateBased)
+REGISTER_LINKTIME(LightcapBatchStateBased)
@@ -0,0 +1,172 @@
+// Serves the metrics registry (see survive_metrics.h) over HTTP in the Prometheus text format, so that dashboards can
+// scrape solver, filter and USB statistics while libsurvive is running.
+#include "os_generic.h"
+#include "survive_config.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <survive.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+STATIC_CONFIG_ITEM(METRICS_ENABLE, "metrics", 'i', "Serve metrics over HTTP in the Prometheus text format", 0)
+STATIC_CONFIG_ITEM(METRICS_PORT, "metrics-port", 'i', "Port to serve metrics on", 9465)
+STATIC_CONFIG_ITEM(METRICS_ADDRESS, "metrics-address", 's', "Address to serve metrics on", "127.0.0.1")
+
+typedef struct SurviveDriverMetrics {
+	SurviveContext *ctx;
+	int sock;
+	bool *keep_running;
+
+	SurviveMetric *scrapes, *run_time, *objects;
+} SurviveDriverMetrics;
+
+static bool send_all(int sock, const char *data, size_t len) {
+	while (len > 0) {
+		ssize_t sent = send(sock, data, len, MSG_NOSIGNAL);
+		if (sent <= 0)
+			return false;
+		data += sent;
+		len -= sent;
+	}
+	return true;
+}
+
+static void send_response(int sock, const char *status, const char *content_type, const char *body) {
+	char header[256];
+	int header_len = snprintf(header, sizeof(header),
+							  "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %lu\r\nConnection: close\r\n\r\n",
+							  status, content_type, (unsigned long)strlen(body));
+	if (send_all(sock, header, header_len))
+		send_all(sock, body, strlen(body));
+}
+
+static void handle_connection(SurviveDriverMetrics *driver, int sock) {
+	SurviveContext *ctx = driver->ctx;
+
+	// Scrapers send small requests; a slow or idle client shouldn't hold up the server for long
+	struct timeval timeout = {.tv_sec = 1};
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	char request[2048];
+	size_t len = 0;
+	while (len < sizeof(request) - 1) {
+		ssize_t cnt = recv(sock, request + len, sizeof(request) - 1 - len, 0);
+		if (cnt <= 0)
+			break;
+		len += cnt;
+		request[len] = 0;
+		if (strstr(request, "\r\n\r\n"))
+			break;
+	}
+	request[len] = 0;
+
+	char method[8] = {0}, path[256] = {0};
+	if (sscanf(request, "%7s %255s", method, path) != 2) {
+		send_response(sock, "400 Bad Request", "text/plain", "Bad request\n");
+		return;
+	}
+
+	char *query = strchr(path, '?');
+	if (query)
+		*query = 0;
+
+	if (strcmp(method, "GET") != 0) {
+		send_response(sock, "405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+	} else if (strcmp(path, "/metrics") == 0) {
+		survive_get_ctx_lock(ctx);
+		survive_metric_set(driver->run_time, survive_run_time(ctx));
+		survive_metric_set(driver->objects, ctx->objs_ct);
+		survive_release_ctx_lock(ctx);
+		survive_metric_add(driver->scrapes, 1);
+
+		char *body = survive_metrics_prometheus(ctx);
+		send_response(sock, "200 OK", "text/plain; version=0.0.4; charset=utf-8", body ? body : "");
+		free(body);
+	} else if (strcmp(path, "/") == 0) {
+		send_response(sock, "200 OK", "text/html", "<html><body><a href=\"/metrics\">Metrics</a></body></html>\n");
+	} else {
+		send_response(sock, "404 Not Found", "text/plain", "Not found\n");
+	}
+}
+
+static void *metrics_thread(void *_driver) {
+	SurviveDriverMetrics *driver = _driver;
+	SurviveContext *ctx = driver->ctx;
+
+	// keep_running is only set once the thread is already started
+	while (driver->keep_running == 0 || *driver->keep_running) {
+		struct pollfd pfd = {.fd = driver->sock, .events = POLLIN};
+		int r = poll(&pfd, 1, 100);
+		if (r < 0 && errno != EINTR) {
+			SV_WARN("Metrics server stopped: %s", strerror(errno));
+			break;
+		}
+		if (r <= 0)
+			continue;
+
+		int client = accept(driver->sock, 0, 0);
+		if (client < 0)
+			continue;
+		handle_connection(driver, client);
+		close(client);
+	}
+	return 0;
+}
+
+static int metrics_close(SurviveContext *ctx, void *_driver) {
+	SurviveDriverMetrics *driver = _driver;
+	close(driver->sock);
+	free(driver);
+	return 0;
+}
+
+int DriverRegMetrics(SurviveContext *ctx) {
+	int port = survive_configi(ctx, "metrics-port", SC_GET, 9465);
+	const char *address = survive_configs(ctx, "metrics-address", SC_GET, "127.0.0.1");
+
+	struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+	if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+		SV_WARN("Invalid metrics address %s", address);
+		return -1;
+	}
+
+	int sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (sock < 0) {
+		SV_WARN("Could not create metrics socket: %s", strerror(errno));
+		return -1;
+	}
+
+	int reuse = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 8) < 0) {
+		SV_WARN("Could not serve metrics on %s:%d: %s", address, port, strerror(errno));
+		close(sock);
+		return -1;
+	}
+
+	SurviveDriverMetrics *driver = SV_CALLOC(sizeof(SurviveDriverMetrics));
+	driver->ctx = ctx;
+	driver->sock = sock;
+	driver->scrapes = survive_metric(ctx, SURVIVE_METRIC_COUNTER, "survive_metrics_scrapes_total",
+									 "Requests for these metrics", 0);
+	driver->run_time =
+		survive_metric(ctx, SURVIVE_METRIC_GAUGE, "survive_run_time_seconds", "Time since libsurvive started", 0);
+	driver->objects = survive_metric(ctx, SURVIVE_METRIC_GAUGE, "survive_objects", "Number of tracked objects", 0);
+
+	SV_INFO("Serving metrics on http://%s:%d/metrics", address, port);
+	driver->keep_running = survive_add_threaded_driver(ctx, driver, "metrics", metrics_thread, metrics_close);
+	return SURVIVE_DRIVER_PASSIVE;
+}
+
+REGISTER_LINKTIME(DriverRegMetrics)
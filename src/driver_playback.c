@@ -1,5 +1,14 @@
 #include <errno.h>
+#include <fcntl.h>
 #include <math.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 #include "os_generic.h"
 #include "survive.h"
@@ -10,6 +19,7 @@
 #include "survive_default_devices.h"
 
 #include "survive_gz.h"
+#include "survive_str.h"
 
 STATIC_CONFIG_ITEM(PLAYBACK_REPLAY_POSE, "playback-replay-pose", 'i', "Whether or not to output pose", 0)
 STATIC_CONFIG_ITEM(PLAYBACK_REPLAY_EXTERNAL_POSE, "playback-replay-external-pose", 'i',
@@ -19,6 +29,8 @@ STATIC_CONFIG_ITEM(PLAYBACK_FACTOR, "playback-factor", 'f',
 				   "Time factor of playback -- 1 is run at the same timing as original, 0 is run as fast as possible.",
 				   1.0f)
 STATIC_CONFIG_ITEM(PLAYBACK_TIME, "playback-time", 'f', "End time of playback", -1.0f)
+STATIC_CONFIG_ITEM(PLAYBACK_START, "playback-start", 'f',
+				   "Start time of playback. Seeks directly there if the recording has a .idx file.", 0.f)
 
 STATIC_CONFIG_ITEM(PLAYBACK_RUN_TIME, "run-time", 'f', "How long to run for", -1.)
 
@@ -26,30 +38,25 @@ STATIC_CONFIG_ITEM(PLAYBACK_RUN_TIME, "run-time", 'f', "How long to run for", -1
   
 #ifdef _MSC_VER
 typedef long ssize_t;
-#define SSIZE_MAX LONG_MAX
-
-ssize_t getdelim(char **lineptr, size_t *n, int delimiter, FILE *stream);
-ssize_t getline(char **lineptr, size_t *n, FILE *stream);
-#define RESTRICT_KEYWORD
-#else
-#define RESTRICT_KEYWORD restrict
 #endif
 
-ssize_t gzgetdelim(char **RESTRICT_KEYWORD lineptr, size_t *RESTRICT_KEYWORD n, int delimiter,
-				   gzFile RESTRICT_KEYWORD stream);
-ssize_t gzgetline(char **RESTRICT_KEYWORD lineptr, size_t *RESTRICT_KEYWORD n, gzFile RESTRICT_KEYWORD stream);
-
 typedef struct SurvivePlaybackData {
     SurviveContext *ctx;
     const char *playback_dir;
     gzFile playback_file;
     int lineno;
 
+	// Reused for every line; line_cursor points past the timestamp of the line waiting to be played back
+	char *line;
+	size_t line_size;
+	char *line_cursor;
+
     double next_time_s;
 	double time_start;
 	double time_now;
     FLT playback_factor;
 	FLT playback_time;
+	FLT playback_start;
 	bool hasRawLight;
     bool hasSweepAngle;
 	bool outputCalculatedPose, outputExternalPose;
@@ -77,18 +84,35 @@ static SurviveObject *find_or_warn(SurvivePlaybackData *driver, const char *dev)
 
 		return 0;
 	}
+
+	// Replayed data counts as received when it is dispatched
+	so->latency.data_received_us = OGGetAbsoluteTimeUS();
 	return so;
 }
 
-static int parse_and_run_sweep(char *line, SurvivePlaybackData *driver) {
-	char dev[10];
+// Reads the next count numeric tokens; returns how many were read before the first missing or malformed one
+static int next_ints(char **cursor, int64_t *out, int count) {
+	for (int i = 0; i < count; i++) {
+		char *token = str_next_token(cursor);
+		if (token == 0 || !str_parse_int(token, &out[i]))
+			return i;
+	}
+	return count;
+}
 
-	survive_channel channel;
-	int sensor_id;
-	survive_timecode timecode;
-	uint8_t flag;
+static int next_flts(char **cursor, FLT *out, int count) {
+	for (int i = 0; i < count; i++) {
+		char *token = str_next_token(cursor);
+		if (token == 0 || !str_parse_flt(token, &out[i]))
+			return i;
+	}
+	return count;
+}
 
-	int rr = sscanf(line, SWEEP_SCANF, SWEEP_SCANF_ARGS);
+static int parse_and_run_sweep(const char *dev, char *cursor, SurvivePlaybackData *driver) {
+	// channel, sensor_id, timecode, flag
+	int64_t v[4];
+	int rr = 1 + next_ints(&cursor, v, 4);
 	if (rr != 5) {
 		SurviveContext *ctx = driver->ctx;
 		SV_WARN("Only got %d values for a sweep", rr);
@@ -101,18 +125,14 @@ static int parse_and_run_sweep(char *line, SurvivePlaybackData *driver) {
 	}
 
 	driver->hasSweepAngle = true;
-	SURVIVE_INVOKE_HOOK_SO(sweep, so, channel, sensor_id, timecode, flag);
+	SURVIVE_INVOKE_HOOK_SO(sweep, so, (survive_channel)v[0], (int)v[1], (survive_timecode)v[2], (uint8_t)v[3]);
 	return 0;
 }
 
-static int parse_and_run_sync(char *line, SurvivePlaybackData *driver) {
-	char dev[10];
-
-	survive_channel channel;
-	survive_timecode timecode;
-	uint8_t ootx, gen;
-
-	int rr = sscanf(line, SYNC_SCANF, SYNC_SCANF_ARGS);
+static int parse_and_run_sync(const char *dev, char *cursor, SurvivePlaybackData *driver) {
+	// channel, timecode, ootx, gen
+	int64_t v[4];
+	int rr = 1 + next_ints(&cursor, v, 4);
 	if (rr != 5) {
 		SurviveContext *ctx = driver->ctx;
 		SV_WARN("Only got %d values for a sync", rr);
@@ -124,20 +144,18 @@ static int parse_and_run_sync(char *line, SurvivePlaybackData *driver) {
 		return 0;
 	}
 
-	SURVIVE_INVOKE_HOOK_SO(sync, so, channel, timecode, ootx, gen);
+	SURVIVE_INVOKE_HOOK_SO(sync, so, (survive_channel)v[0], (survive_timecode)v[1], (uint8_t)v[2], (uint8_t)v[3]);
 	return 0;
 }
 
-static int parse_and_run_sweep_angle(char *line, SurvivePlaybackData *driver) {
-	char dev[10];
-
-	survive_channel channel;
-	int sensor_id;
-	survive_timecode timecode;
-	int8_t plane;
+static int parse_and_run_sweep_angle(const char *dev, char *cursor, SurvivePlaybackData *driver) {
+	// channel, sensor_id, timecode, plane
+	int64_t v[4];
 	FLT angle;
 
-	int rr = sscanf(line, SWEEP_ANGLE_SCANF, SWEEP_ANGLE_SCANF_ARGS);
+	int rr = 1 + next_ints(&cursor, v, 4);
+	if (rr == 5)
+		rr += next_flts(&cursor, &angle, 1);
 
 	if (rr != 6) {
 		SurviveContext *ctx = driver->ctx;
@@ -150,16 +168,19 @@ static int parse_and_run_sweep_angle(char *line, SurvivePlaybackData *driver) {
 		return 0;
 	}
 
-	SURVIVE_INVOKE_HOOK_SO(sweep_angle, so, channel, sensor_id, timecode, plane, angle);
+	SURVIVE_INVOKE_HOOK_SO(sweep_angle, so, (survive_channel)v[0], (int)v[1], (survive_timecode)v[2], (int8_t)v[3],
+						   angle);
 	return 0;
 }
 
-static int parse_and_run_pose(const char *line, SurvivePlaybackData *driver) {
+static int parse_and_run_pose(const char *dev, char *cursor, SurvivePlaybackData *driver) {
 	char name[128] = "replay_";
-	SurvivePose pose;
+	strncat(name, dev, sizeof(name) - strlen(name) - 1);
 
-	int rr = sscanf(line, "%s POSE " SurvivePose_sformat "\r\n", name + strlen(name), &pose.Pos[0], &pose.Pos[1],
-					&pose.Pos[2], &pose.Rot[0], &pose.Rot[1], &pose.Rot[2], &pose.Rot[3]);
+	SurvivePose pose;
+	int rr = 1 + next_flts(&cursor, pose.Pos, 3);
+	if (rr == 4)
+		rr += next_flts(&cursor, pose.Rot, 4);
 
 	SurviveContext *ctx = driver->ctx;
 	if (rr != 8) {
@@ -170,67 +191,63 @@ static int parse_and_run_pose(const char *line, SurvivePlaybackData *driver) {
 	SURVIVE_INVOKE_HOOK(external_pose, ctx, name, &pose);
 	return 0;
 }
-static int parse_and_run_imu(const char *line, SurvivePlaybackData *driver, bool raw) {
-	char dev[10];
-	int timecode = 0;
+
+static int parse_and_run_imu(const char *dev, char *cursor, SurvivePlaybackData *driver, bool raw) {
+	// mask, timecode
+	int64_t v[2] = {0};
+	int64_t id = 0;
 	FLT accelgyro[9] = { 0 };
-	int mask;
-	int id;
 	SurviveContext *ctx = driver->ctx;
 
-	char i_char = 0;
-
-	int rr = sscanf(line,
-					"%s %c %d %d " FLT_sformat " " FLT_sformat " " FLT_sformat " " FLT_sformat " " FLT_sformat
-					" " FLT_sformat " " FLT_sformat " " FLT_sformat " " FLT_sformat "%d",
-					dev, &i_char, &mask, &timecode, &accelgyro[0], &accelgyro[1], &accelgyro[2], &accelgyro[3],
-					&accelgyro[4], &accelgyro[5], &accelgyro[6], &accelgyro[7], &accelgyro[8], &id);
+	int rr = 2 + next_ints(&cursor, v, 2);
+	if (rr == 4)
+		rr += next_flts(&cursor, accelgyro, 9);
+	if (rr == 13)
+		rr += next_ints(&cursor, &id, 1);
 
 	if (rr == 11) {
 		// Older formats might not have mag data
 		id = accelgyro[6];
 		accelgyro[6] = 0;
 	} else if (rr != 14) {
-		SV_WARN("On line %d, only %d values read: '%s'", driver->lineno, rr, line);
+		SV_WARN("On line %d, only %d values read for %s", driver->lineno, rr, dev);
 		return -1;
 	}
 
-	assert(raw ^ i_char == 'I');
-
 	SurviveObject *so = find_or_warn(driver, dev);
 	if (so) {
 		if (raw) {
-			SURVIVE_INVOKE_HOOK_SO(raw_imu, so, mask, accelgyro, timecode, id);
+			SURVIVE_INVOKE_HOOK_SO(raw_imu, so, (int)v[0], accelgyro, (uint32_t)v[1], (int)id);
 		} else {
-			SURVIVE_INVOKE_HOOK_SO(imu, so, mask, accelgyro, timecode, id);
+			SURVIVE_INVOKE_HOOK_SO(imu, so, (int)v[0], accelgyro, (uint32_t)v[1], (int)id);
 		}
 	}
 
 	return 0;
 }
 
-static int parse_and_run_lhpose(const char *line, struct SurvivePlaybackData *driver) {
+static int parse_and_run_lhpose(const char *lh_str, char *cursor, struct SurvivePlaybackData *driver) {
 	SurvivePose pose;
-	int lh = -1;
-	int rr = sscanf(line, "%d LH_POSE " SurvivePose_sformat "\n", &lh, &pose.Pos[0], &pose.Pos[1], &pose.Pos[2],
-					&pose.Rot[0], &pose.Rot[1], &pose.Rot[2], &pose.Rot[3]);
+	int64_t lh = -1;
+	str_parse_int(lh_str, &lh);
+	next_flts(&cursor, pose.Pos, 3);
+	next_flts(&cursor, pose.Rot, 4);
 
 	SurviveContext *ctx = driver->ctx;
 	if (driver->outputCalculatedPose) {
 		char buffer[32] = {0};
-		snprintf(buffer, 31, "previous_LH%d", lh);
+		snprintf(buffer, 31, "previous_LH%d", (int)lh);
 		SURVIVE_INVOKE_HOOK(external_pose, ctx, buffer, &pose);
 	}
 	return 0;
 }
 
-static int parse_and_run_externalpose(const char *line, SurvivePlaybackData *driver) {
-	char name[128] = { 0 };
+static int parse_and_run_externalpose(const char *name, char *cursor, SurvivePlaybackData *driver) {
 	SurvivePose pose;
 
 	if (driver->outputExternalPose) {
-		int rr = sscanf(line, "%s EXTERNAL_POSE " SurvivePose_sformat "\n", name, &pose.Pos[0], &pose.Pos[1],
-						&pose.Pos[2], &pose.Rot[0], &pose.Rot[1], &pose.Rot[2], &pose.Rot[3]);
+		next_flts(&cursor, pose.Pos, 3);
+		next_flts(&cursor, pose.Rot, 4);
 
 		SurviveContext *ctx = driver->ctx;
 		SURVIVE_INVOKE_HOOK(external_pose, ctx, name, &pose);
@@ -238,22 +255,14 @@ static int parse_and_run_externalpose(const char *line, SurvivePlaybackData *dri
 	return 0;
 }
 
-static int parse_and_run_config(const char *line, SurvivePlaybackData *driver) {
-	const char *configStart = line;
+static int parse_and_run_config(const char *dev, const char *configStart, SurvivePlaybackData *driver) {
 	SurviveContext *ctx = driver->ctx;
 
-	char dev[10] = {0};
-	for (int i = 0; i < sizeof(dev) && *configStart != ' '; i++) {
-		dev[i] = *configStart++;
-	}
-
 	SurviveObject *old_so = survive_get_so_by_name(ctx, dev);
 	if (old_so) {
 		survive_destroy_device(old_so);
 	}
 
-	configStart += strlen("CONFIG") + 1;
-
 	size_t len = strlen(configStart);
 
 	SurviveObject *so = survive_create_device(ctx, "replay", driver, dev, 0);
@@ -270,13 +279,14 @@ static int parse_and_run_config(const char *line, SurvivePlaybackData *driver) {
 	return 0;
 }
 
-static int parse_and_run_rawlight(const char *line, SurvivePlaybackData *driver) {
+static int parse_and_run_rawlight(const char *dev, char *cursor, SurvivePlaybackData *driver) {
 	driver->hasRawLight = 1;
 
-	char dev[10];
-	char op[10];
-	LightcapElement le;
-	int rr = sscanf(line, "%s %s %hhu %u %hu\n", dev, op, &le.sensor_id, &le.timestamp, &le.length);
+	// sensor_id, timestamp, length
+	int64_t v[3] = {0};
+	next_ints(&cursor, v, 3);
+
+	LightcapElement le = {.sensor_id = (uint8_t)v[0], .timestamp = (uint32_t)v[1], .length = (uint16_t)v[2]};
 
 	SurviveObject *so = find_or_warn(driver, dev);
 	if (so) {
@@ -285,146 +295,178 @@ static int parse_and_run_rawlight(const char *line, SurvivePlaybackData *driver)
 	return 0;
 }
 
-static int parse_and_run_lightcode(const char *line, SurvivePlaybackData *driver) {
-	char lhn[10];
-	char axn[10];
-	char dev[10];
-	uint32_t timecode = 0;
-	int sensor_id = 0;
-	int acode = 0;
-	int timeinsweep = 0;
-	uint32_t length = 0;
-	uint32_t lh = 0;
+static int parse_and_run_lightcode(const char *dev, char *cursor, SurvivePlaybackData *driver) {
+	// sensor_id, acode, timeinsweep, timecode, length, lh
+	int64_t v[6];
 	SurviveContext *ctx = driver->ctx;
 
-	int rr = sscanf(line, "%8s %8s %8s %d %d %d %u %u %u\n", dev, lhn, axn, &sensor_id, &acode, &timeinsweep, &timecode,
-					&length, &lh);
+	// Skip the axis token; the acode carries that information
+	int rr = 2 + (str_next_token(&cursor) != 0);
+	if (rr == 3)
+		rr += next_ints(&cursor, v, 6);
 
 	if (rr != 9) {
-		SV_WARN("Warning:  On line %d, only %d values read: '%s'\n", driver->lineno, rr, line);
+		SV_WARN("Warning:  On line %d, only %d values read for %s\n", driver->lineno, rr, dev);
 		return -1;
 	}
 
 	SurviveObject *so = find_or_warn(driver, dev);
 	if (so)
-		SURVIVE_INVOKE_HOOK_SO(light, so, sensor_id, acode, timeinsweep, timecode, length, lh);
+		SURVIVE_INVOKE_HOOK_SO(light, so, (int)v[0], (int)v[1], (int)v[2], (uint32_t)v[3], (uint32_t)v[4],
+							   (uint32_t)v[5]);
 	return 0;
 }
 
+/*
+ * Reads the next line of the playback file into the driver's reusable line buffer, stripping the line ending. Returns
+ * the length of the line or -1 on EOF.
+ */
+static ssize_t playback_read_line(SurvivePlaybackData *driver) {
+	gzFile f = driver->playback_file;
+	size_t len = 0;
 
+	for (;;) {
+		if (driver->line_size - len < 2) {
+			driver->line_size = driver->line_size ? driver->line_size * 2 : 1024;
+			driver->line = SV_REALLOC(driver->line, driver->line_size);
+		}
 
-static int playback_pump_msg(struct SurviveContext *ctx, void *_driver) {
-	SurvivePlaybackData *driver = _driver;
-	gzFile f = driver->playback_file;
+		if (gzgets(f, driver->line + len, (int)(driver->line_size - len)) == 0)
+			break;
 
-	if (f && !gzeof(f) && !gzerror_dropin(f)) {
-		driver->lineno++;
-		char *line = 0;
-
-		if (driver->next_time_s == 0) {
-			size_t n = 0;
-			ssize_t r = gzgetdelim(&line, &n, ' ', f);
-			if (r <= 0) {
-				free(line);
-				return 0;
-			}
+		len += strlen(driver->line + len);
+		if (len > 0 && driver->line[len - 1] == '\n')
+			break;
+	}
 
-			if (sscanf(line, "%lf", &driver->next_time_s) != 1) {
-				free(line);
-				return 0;
-			}
+	if (len == 0)
+		return -1;
 
-			if(!isfinite(driver->next_time_s)) {
-				driver->next_time_s = 0;
-			}
-			free(line);
-			line = 0;
-		}
+	while (len && (driver->line[len - 1] == '\n' || driver->line[len - 1] == '\r')) {
+		driver->line[--len] = 0;
+	}
+	return len;
+}
 
-		if (driver->next_time_s * driver->playback_factor > (OGRelativeTime() + driver->time_start))
-			return 0;
+/*
+ * Reads the next line and parses its timestamp into next_time_s; the rest of the line waits in line_cursor until it is
+ * due. Returns false if there was no line or it had no timestamp.
+ */
+static bool playback_read_next(SurvivePlaybackData *driver) {
+	if (playback_read_line(driver) < 0)
+		return false;
+	driver->lineno++;
+
+	driver->line_cursor = driver->line;
+	const char *time_str = str_next_token(&driver->line_cursor);
+	if (time_str == 0 || !str_parse_double(time_str, &driver->next_time_s)) {
+		return false;
+	}
 
-		driver->time_now = driver->next_time_s;
+	if (!isfinite(driver->next_time_s)) {
 		driver->next_time_s = 0;
+	}
+	return true;
+}
 
-		size_t n = 0;
-		ssize_t r = gzgetline(&line, &n, f);
+// Peeks at the op of a line read by playback_read_next without consuming it
+static bool playback_line_is_config(const SurvivePlaybackData *driver) {
+	const char *p = driver->line_cursor;
+	while (*p == ' ')
+		p++;
+	while (*p && *p != ' ')
+		p++;
+	return strncmp(p, " CONFIG ", 8) == 0;
+}
 
-		if (r <= 0) {
-			free(line);
-			return 0;
+static void playback_run_line(SurvivePlaybackData *driver, char *cursor) {
+	SurviveContext *ctx = driver->ctx;
+	const char *dev = str_next_token(&cursor);
+	char *op = dev ? str_next_token(&cursor) : 0;
+	if (op == 0) {
+		return;
+	}
+
+	if (strcmp(dev, "OPTION") == 0) {
+		return;
+	}
+
+	survive_get_ctx_lock(ctx);
+	switch (op[0]) {
+	case 'W':
+		if (op[1] == 0)
+			parse_and_run_sweep(dev, cursor, driver);
+		break;
+	case 'B':
+		if (op[1] == 0 && driver->hasSweepAngle == false)
+			parse_and_run_sweep_angle(dev, cursor, driver);
+		break;
+	case 'Y':
+		if (op[1] == 0)
+			parse_and_run_sync(dev, cursor, driver);
+		break;
+	case 'E':
+		if (strcmp(op, "EXTERNAL_POSE") == 0) {
+			parse_and_run_externalpose(dev, cursor, driver);
+			break;
 		}
-		while (r && (line[r - 1] == '\n' || line[r - 1] == '\r')) {
-			line[--r] = 0;
+	case 'C':
+		if (op[1] == 0) {
+			parse_and_run_rawlight(dev, cursor, driver);
+		} else if (strcmp(op, "CONFIG") == 0) {
+			// The config is handed over verbatim, starting from the delimiter after CONFIG
+			char *config = op + strlen(op);
+			if (config != cursor)
+				*config = ' ';
+			parse_and_run_config(dev, config, driver);
 		}
-		char dev[32];
-		char op[32];
-		if (sscanf(line, "%31s %31s", dev, op) < 2) {
-			free(line);
-			return 0;
+		break;
+	case 'L':
+		if (strcmp(op, "LH_POSE") == 0) {
+			parse_and_run_lhpose(dev, cursor, driver);
+			break;
 		}
+	case 'R':
+		if (op[1] == 0 && driver->hasRawLight == false)
+			parse_and_run_lightcode(dev, cursor, driver);
+		break;
+	case 'i':
+		if (op[1] == 0)
+			parse_and_run_imu(dev, cursor, driver, true);
+		break;
+	case 'I':
+		if (op[1] == 0)
+			parse_and_run_imu(dev, cursor, driver, false);
+		break;
+	case 'P':
+		if (strcmp(op, "POSE") == 0 && driver->outputCalculatedPose)
+			parse_and_run_pose(dev, cursor, driver);
+		break;
+	case 'A':
+	case 'V':
+		break;
+	default:
+		SV_WARN("Playback doesn't understand '%s' op on line %d", op, driver->lineno);
+	}
+	survive_release_ctx_lock(ctx);
+}
+
+static int playback_pump_msg(struct SurviveContext *ctx, void *_driver) {
+	SurvivePlaybackData *driver = _driver;
+	gzFile f = driver->playback_file;
 
-		if (strcmp(dev, "OPTION") == 0) {
-			free(line);
+	if (f && !gzeof(f) && !gzerror_dropin(f)) {
+		if (driver->next_time_s == 0 && !playback_read_next(driver)) {
 			return 0;
 		}
 
-		survive_get_ctx_lock(ctx);
-		switch (op[0]) {
-		case 'W':
-			if (op[1] == 0)
-				parse_and_run_sweep(line, driver);
-			break;
-		case 'B':
-			if (op[1] == 0 && driver->hasSweepAngle == false)
-				parse_and_run_sweep_angle(line, driver);
-			break;
-		case 'Y':
-			if (op[1] == 0)
-				parse_and_run_sync(line, driver);
-			break;
-		case 'E':
-			if (strcmp(op, "EXTERNAL_POSE") == 0) {
-				parse_and_run_externalpose(line, driver);
-				break;
-			}
-		case 'C':
-			if (op[1] == 0) {
-				parse_and_run_rawlight(line, driver);
-			} else if (strcmp(op, "CONFIG") == 0) {
-				parse_and_run_config(line, driver);
-			}
-			break;
-		case 'L':
-			if (strcmp(op, "LH_POSE") == 0) {
-				parse_and_run_lhpose(line, driver);
-				break;
-			}
-		case 'R':
-			if (op[1] == 0 && driver->hasRawLight == false)
-				parse_and_run_lightcode(line, driver);
-			break;
-		case 'i':
-			if (op[1] == 0)
-				parse_and_run_imu(line, driver, true);
-			break;
-		case 'I':
-			if (op[1] == 0)
-				parse_and_run_imu(line, driver, false);
-			break;
-		case 'P':
-			if (strcmp(op, "POSE") == 0 && driver->outputCalculatedPose)
-				parse_and_run_pose(line, driver);
-			break;
-		case 'A':
-		case 'V':
-			break;
-		default:
-			SV_WARN("Playback doesn't understand '%s' op in '%s'", op, line);
-		}
-		survive_release_ctx_lock(ctx);
+		if (driver->next_time_s * driver->playback_factor > (OGRelativeTime() + driver->time_start))
+			return 0;
+
+		driver->time_now = driver->next_time_s;
+		driver->next_time_s = 0;
 
-		free(line);
+		playback_run_line(driver, driver->line_cursor);
 	} else {
 		SV_VERBOSE(100, "EOF for playback received.");
 		if (f) {
@@ -437,9 +479,109 @@ static int playback_pump_msg(struct SurviveContext *ctx, void *_driver) {
 	return 0;
 }
 
+static gzFile playback_open_at(const char *path, int64_t offset) {
+	int fd = open(path, O_RDONLY | O_BINARY);
+	if (fd < 0)
+		return 0;
+
+	if (lseek(fd, offset, SEEK_SET) != offset) {
+		close(fd);
+		return 0;
+	}
+
+	gzFile f = gzdopen(fd, "r");
+	if (f == 0)
+		close(fd);
+	return f;
+}
+
+/*
+ * Positions playback at the first line at or after 'start'. With the index written alongside the recording, configs
+ * from before 'start' are run from their own chunks and reading resumes at the last seek point before it. Without one,
+ * the file is read from the beginning and only the configs are run. Skipped lines are never parsed past their time.
+ */
+static void playback_seek(SurvivePlaybackData *driver, double start) {
+	SurviveContext *ctx = driver->ctx;
+
+	char index_path[1024];
+	snprintf(index_path, sizeof(index_path), "%s.idx", driver->playback_dir);
+	FILE *index = fopen(index_path, "r");
+
+	bool use_index = index != 0;
+	int64_t resume_offset = -1;
+	char entry[128];
+	while (index && fgets(entry, sizeof(entry), index)) {
+		char *cursor = entry;
+		const char *type = str_next_token(&cursor);
+		const char *time_str = type ? str_next_token(&cursor) : 0;
+		const char *offset_str = time_str ? str_next_token(&cursor) : 0;
+
+		double time;
+		int64_t offset;
+		if (offset_str == 0 || !str_parse_double(time_str, &time) || !str_parse_int(offset_str, &offset)) {
+			SV_WARN("Ignoring malformed entry in %s.idx: %s", driver->playback_dir, entry);
+			continue;
+		}
+
+		if (time > start)
+			break;
+
+		if (type[0] == 'T') {
+			resume_offset = offset;
+		} else if (type[0] == 'C') {
+			gzFile f = driver->playback_file;
+			driver->playback_file = playback_open_at(driver->playback_dir, offset);
+			if (driver->playback_file && playback_read_next(driver)) {
+				playback_run_line(driver, driver->line_cursor);
+			}
+			if (driver->playback_file)
+				gzclose(driver->playback_file);
+			driver->playback_file = f;
+		}
+	}
+
+	if (index)
+		fclose(index);
+
+	if (resume_offset >= 0) {
+		gzFile f = playback_open_at(driver->playback_dir, resume_offset);
+		if (f) {
+			gzclose(driver->playback_file);
+			driver->playback_file = f;
+		} else {
+			SV_WARN("Could not seek to offset %" PRId64 " of %s; reading from the start", resume_offset,
+					driver->playback_dir);
+			use_index = false;
+		}
+	}
+
+	SV_INFO("Seeking to %fs in '%s' %s", start, driver->playback_dir,
+			use_index ? "using its index" : "without an index");
+
+	driver->next_time_s = 0;
+	while (!gzeof(driver->playback_file) && !gzerror_dropin(driver->playback_file)) {
+		if (!playback_read_next(driver))
+			continue;
+
+		if (driver->next_time_s >= start) {
+			driver->time_start = driver->next_time_s;
+			return;
+		}
+
+		if (!use_index && playback_line_is_config(driver)) {
+			playback_run_line(driver, driver->line_cursor);
+		}
+	}
+	driver->next_time_s = 0;
+}
+
 static void *playback_thread(void *_driver) {
 	SurvivePlaybackData *driver = _driver;
 	int last_output_minute = 0;
+
+	if (driver->playback_start > 0) {
+		playback_seek(driver, driver->playback_start);
+	}
 	while (driver->keepRunning == 0 || *driver->keepRunning) {
 		double next_time_s_scaled = driver->next_time_s * driver->playback_factor;
 		double time_now = OGRelativeTime() + driver->time_start;
@@ -483,6 +625,7 @@ static int playback_close(struct SurviveContext *ctx, void *_driver) {
 	survive_detach_config(ctx, "playback-factor", &driver->playback_factor);
 	survive_detach_config(ctx, "playback-time", &driver->playback_time);
 	survive_install_run_time_fn(ctx, 0, 0);
+	free(driver->line);
 	free(driver);
 	return 0;
 }
@@ -520,31 +663,25 @@ int DriverRegPlayback(SurviveContext *ctx) {
 	survive_install_run_time_fn(ctx, survive_playback_run_time, sp);
 	survive_attach_configf(ctx, "playback-factor", &sp->playback_factor);
 	survive_attach_configf(ctx, "playback-time", &sp->playback_time);
+	sp->playback_start = survive_configf(ctx, PLAYBACK_START_TAG, SC_GET, 0);
 
 	SV_INFO("Using playback file '%s' with timefactor of %f until %f", playback_file, sp->playback_factor,
 			sp->playback_time);
 
-	FLT time = 0;
-	char *line = 0;
-	size_t n;
-	int r = gzgetline(&line, &n, sp->playback_file);
-
-	if (r > 0) {
-		if (line[0] == 0x1f) {
+	if (playback_read_line(sp) > 0) {
+		if (sp->line[0] == 0x1f) {
 			SV_ERROR(SURVIVE_ERROR_INVALID_CONFIG, "Attempting to playback a gz compressed file without gz support.");
-			free(line);
 			return -1;
 		}
 
-		char dev[32];
-		char command[32];
-
-		if (sscanf(line, FLT_sformat " %s %s", &time, dev, command) == 3) {
+		char *cursor = sp->line;
+		const char *time_str = str_next_token(&cursor);
+		double time = 0;
+		if (time_str && str_parse_double(time_str, &time) && str_next_token(&cursor) && str_next_token(&cursor)) {
 			sp->time_start = time;
 		}
 	}
 
-	free(line);
 	gzseek(sp->playback_file, 0, SEEK_SET); // same as rewind(f);
 
 	sp->keepRunning = survive_add_threaded_driver(ctx, sp, "playback", playback_thread, playback_close);
@@ -552,83 +689,3 @@ int DriverRegPlayback(SurviveContext *ctx) {
 }
 
 REGISTER_LINKTIME(DriverRegPlayback)
-
-  
-#define _GETDELIM_GROWBY 128 /* amount to grow line buffer by */
-#define _GETDELIM_MINLEN 4   /* minimum line buffer size */
-
-#if defined(__has_feature)
-#if __has_feature(memory_sanitizer)
-#define MEMORY_SANITIZER_IGNORE __attribute__((no_sanitize("memory")))
-#endif
-#endif
-#ifndef MEMORY_SANITIZER_IGNORE
-#define MEMORY_SANITIZER_IGNORE
-#endif
-
-MEMORY_SANITIZER_IGNORE ssize_t gzgetdelim(char **RESTRICT_KEYWORD lineptr, size_t *RESTRICT_KEYWORD n, int delimiter,
-										   gzFile RESTRICT_KEYWORD stream) {
-	char *buf = 0, *pos = 0;
-	int c = 0;
-	ssize_t bytes = 0;
-
-	if (lineptr == NULL || n == NULL) {
-		errno = EINVAL;
-		return -1;
-	}
-	if (stream == NULL) {
-		errno = EBADF;
-		return -1;
-	}
-
-	/* resize (or allocate) the line buffer if necessary */
-	buf = *lineptr;
-	if (buf == NULL || *n < _GETDELIM_MINLEN) {
-		buf = SV_REALLOC(*lineptr, _GETDELIM_GROWBY);
-		if (buf == NULL) {
-			/* ENOMEM */
-			return -1;
-		}
-		*n = _GETDELIM_GROWBY;
-		*lineptr = buf;
-	}
-
-	/* read characters until delimiter is found, end of file is reached, or an
-	   error occurs. */
-	bytes = 0;
-	pos = buf;
-	while ((c = gzgetc(stream)) != EOF) {
-		if (bytes + 1 >= (SIZE_MAX / 2)) {
-			errno = EOVERFLOW;
-			return -1;
-		}
-		bytes++;
-		if (bytes >= *n - 1) {
-			buf = SV_REALLOC(*lineptr, *n + _GETDELIM_GROWBY);
-			if (buf == NULL) {
-				/* ENOMEM */
-				return -1;
-			}
-			*n += _GETDELIM_GROWBY;
-			pos = buf + bytes - 1;
-			*lineptr = buf;
-		}
-
-		*pos++ = (char)c;
-		if (c == delimiter) {
-			break;
-		}
-	}
-
-	if (gzerror_dropin(stream) || (gzeof(stream) && (bytes == 0))) {
-		/* EOF, or an error from getc(). */
-		return -1;
-	}
-
-	*pos = '\0';
-	return bytes;
-}
-
-ssize_t gzgetline(char **RESTRICT_KEYWORD lineptr, size_t *RESTRICT_KEYWORD n, gzFile RESTRICT_KEYWORD stream) {
-	return gzgetdelim(lineptr, n, '\n', stream);
-}
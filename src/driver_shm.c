@@ -0,0 +1,218 @@
+// Publishes the latest pose, velocity and covariance of every object into a POSIX shared memory segment so that
+// other processes on the machine can read them without owning the devices. See survive_shm.h for the layout and a
+// reader.
+#include "survive_config.h"
+#include "survive_kalman_tracker.h"
+#include "survive_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <survive.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+STATIC_CONFIG_ITEM(SHM_ENABLE, "shm", 'i', "Publish object poses to shared memory", 0)
+STATIC_CONFIG_ITEM(SHM_NAME, "shm-name", 's', "Name of the shared memory segment to publish poses to",
+				   SURVIVE_SHM_DEFAULT_NAME)
+STATIC_CONFIG_ITEM(SHM_CAPACITY, "shm-capacity", 'i', "Number of objects the shared memory segment has room for", 32)
+
+typedef struct SurviveDriverShm {
+	SurviveContext *ctx;
+	char name[256];
+
+	SurviveShmHeader *header;
+	size_t size;
+
+	// Which slot each object was given, by position in ctx->objs
+	int *slots;
+	int slots_cnt;
+
+	pose_process_func prior_pose_fn;
+	velocity_process_func prior_velocity_fn;
+} SurviveDriverShm;
+
+static int shm_close(SurviveContext *ctx, void *_driver);
+
+static SurviveDriverShm *shm_driver(SurviveContext *ctx) {
+	return (SurviveDriverShm *)survive_get_driver_by_closefn(ctx, shm_close);
+}
+
+static SurviveShmObject *shm_slot(SurviveDriverShm *driver, SurviveObject *so) {
+	SurviveContext *ctx = driver->ctx;
+
+	int so_idx = -1;
+	for (int i = 0; i < ctx->objs_ct; i++) {
+		if (ctx->objs[i] == so) {
+			so_idx = i;
+			break;
+		}
+	}
+	if (so_idx < 0)
+		return 0;
+
+	if (so_idx >= driver->slots_cnt) {
+		driver->slots = SV_REALLOC(driver->slots, sizeof(int) * (so_idx + 1));
+		for (int i = driver->slots_cnt; i <= so_idx; i++)
+			driver->slots[i] = -1;
+		driver->slots_cnt = so_idx + 1;
+	}
+
+	if (driver->slots[so_idx] < 0) {
+		SurviveShmHeader *header = driver->header;
+		if (header->object_count >= header->capacity) {
+			SV_WARN("Shared memory segment %s is full; not publishing %s. Raise --shm-capacity to include it.",
+					driver->name, so->codename);
+			// Don't warn again for this object
+			driver->slots[so_idx] = (int)header->capacity;
+			return 0;
+		}
+
+		int slot = (int)header->object_count;
+		SurviveShmObject *obj = &survive_shm_objects(header)[slot];
+		snprintf(obj->codename, sizeof(obj->codename), "%s", so->codename);
+		snprintf(obj->serial_number, sizeof(obj->serial_number), "%s", so->serial_number);
+
+		// Readers only look at slots below object_count, so the name is visible before the slot is
+		survive_shm_store_release(&header->object_count, header->object_count + 1);
+		driver->slots[so_idx] = slot;
+	}
+
+	if (driver->slots[so_idx] >= (int)driver->header->capacity)
+		return 0;
+	return &survive_shm_objects(driver->header)[driver->slots[so_idx]];
+}
+
+static void shm_copy_covariance(double *out, const SurviveKalmanTracker *tracker, int offset, int n) {
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) {
+			out[i * n + j] = svMatrixGet(&tracker->model.P, offset + i, offset + j);
+		}
+	}
+}
+
+static void shm_pose_fn(SurviveObject *so, survive_long_timecode timecode, const SurvivePose *pose) {
+	SurviveDriverShm *driver = shm_driver(so->ctx);
+	driver->prior_pose_fn(so, timecode, pose);
+
+	SurviveShmObject *obj = shm_slot(driver, so);
+	if (obj == 0)
+		return;
+
+	const SurviveKalmanTracker *tracker = so->tracker;
+	bool has_cov = tracker && tracker->model.state_cnt >= 7;
+
+	survive_shm_write_begin(obj);
+	obj->pose_count++;
+	obj->pose_timecode = timecode;
+	obj->pose_time = survive_run_time(so->ctx);
+	for (int i = 0; i < 3; i++)
+		obj->pose[i] = pose->Pos[i];
+	for (int i = 0; i < 4; i++)
+		obj->pose[3 + i] = pose->Rot[i];
+	if (has_cov) {
+		shm_copy_covariance(obj->pose_covariance, tracker, 0, 7);
+		obj->flags |= SurviveShmObjectFlags_HasCovariance;
+	}
+	obj->flags |= SurviveShmObjectFlags_HasPose;
+	survive_shm_write_end(obj);
+}
+
+static void shm_velocity_fn(SurviveObject *so, survive_long_timecode timecode, const SurviveVelocity *velocity) {
+	SurviveDriverShm *driver = shm_driver(so->ctx);
+	driver->prior_velocity_fn(so, timecode, velocity);
+
+	SurviveShmObject *obj = shm_slot(driver, so);
+	if (obj == 0)
+		return;
+
+	const SurviveKalmanTracker *tracker = so->tracker;
+	bool has_cov = tracker && tracker->model.state_cnt >= 13;
+
+	survive_shm_write_begin(obj);
+	obj->velocity_count++;
+	obj->velocity_timecode = timecode;
+	obj->velocity_time = survive_run_time(so->ctx);
+	for (int i = 0; i < 3; i++) {
+		obj->velocity[i] = velocity->Pos[i];
+		obj->velocity[3 + i] = velocity->AxisAngleRot[i];
+	}
+	if (has_cov)
+		shm_copy_covariance(obj->velocity_covariance, tracker, 7, 6);
+	obj->flags |= SurviveShmObjectFlags_HasVelocity;
+	survive_shm_write_end(obj);
+}
+
+static int shm_close(SurviveContext *ctx, void *_driver) {
+	SurviveDriverShm *driver = _driver;
+
+	// Readers that still have the segment mapped keep their mapping; new readers will see that nobody is publishing
+	if (driver->header) {
+		munmap(driver->header, driver->size);
+		shm_unlink(driver->name);
+	}
+
+	free(driver->slots);
+	free(driver);
+	return 0;
+}
+
+int DriverRegShm(SurviveContext *ctx) {
+	SurviveDriverShm *driver = SV_CALLOC(sizeof(SurviveDriverShm));
+	driver->ctx = ctx;
+	snprintf(driver->name, sizeof(driver->name), "%s",
+			 survive_configs(ctx, "shm-name", SC_GET, SURVIVE_SHM_DEFAULT_NAME));
+
+	int capacity = survive_configi(ctx, "shm-capacity", SC_GET, 32);
+	if (capacity <= 0)
+		capacity = 1;
+	driver->size = survive_shm_segment_size(capacity);
+
+	// Start from a fresh segment so readers never see state left over from a previous run
+	shm_unlink(driver->name);
+	int fd = shm_open(driver->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0 || ftruncate(fd, (off_t)driver->size) != 0) {
+		SV_WARN("Could not create shared memory segment %s: %s", driver->name, strerror(errno));
+		if (fd >= 0) {
+			close(fd);
+			shm_unlink(driver->name);
+		}
+		free(driver);
+		return -1;
+	}
+
+	void *p = mmap(0, driver->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		SV_WARN("Could not map shared memory segment %s: %s", driver->name, strerror(errno));
+		shm_unlink(driver->name);
+		free(driver);
+		return -1;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	driver->header = p;
+	*driver->header = (SurviveShmHeader){
+		.version = SURVIVE_SHM_VERSION,
+		.header_size = (uint32_t)(driver->size - capacity * sizeof(SurviveShmObject)),
+		.object_size = sizeof(SurviveShmObject),
+		.capacity = (uint32_t)capacity,
+		.generation = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec,
+	};
+	// Readers reject the segment until the magic is set, so they never see a half initialized header
+	survive_shm_store_release(&driver->header->magic, SURVIVE_SHM_MAGIC);
+
+	driver->prior_pose_fn = survive_install_pose_fn(ctx, shm_pose_fn);
+	driver->prior_velocity_fn = survive_install_velocity_fn(ctx, shm_velocity_fn);
+
+	SV_INFO("Publishing poses for up to %d objects to shared memory segment %s", capacity, driver->name);
+	survive_add_driver(ctx, driver, 0, shm_close);
+	return SURVIVE_DRIVER_PASSIVE;
+}
+
+REGISTER_LINKTIME(DriverRegShm)
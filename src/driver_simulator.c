@@ -38,95 +38,171 @@ STATIC_CONFIG_ITEM(Simulator_INIT_TIME, "simulator-init-time", 'f', "Init time -
 STATIC_CONFIG_ITEM(Simulator_FCAL_NOISE, "simulator-fcal-noise", 'f', "Noise to apply to BSD fcal parameters", 0.)
 STATIC_CONFIG_ITEM(Simulator_LH_VERSION, "simulator-lh-gen", 'i', "Lighthouse generation", 2)
 
-typedef struct SurviveDriverSimulatorLHState {
-	FLT last_eval_time;
+STATIC_CONFIG_ITEM(Simulator_OBJECTS, "simulator-objects", 'i', "Number of objects to simulate", 1)
+STATIC_CONFIG_ITEM(Simulator_OBJ_SENSORS, "simulator-obj-sensors", 'i', "Number of sensors on each simulated object",
+				   20)
+STATIC_CONFIG_ITEM(Simulator_LIGHTHOUSES, "simulator-lighthouses", 'i',
+				   "Number of lighthouses to simulate when none are configured. 0 uses the default layout of 5.", 0)
+STATIC_CONFIG_ITEM(Simulator_REALTIME, "simulator-realtime", 'i',
+				   "Pace the simulation to the wall clock. 0 runs it as fast as possible on a virtual clock.", 1)
+STATIC_CONFIG_ITEM(Simulator_TIME_FACTOR, "time-factor", 'f',
+				   "Wall clock seconds per simulated second when the simulator runs in real time", 1.)
+
+// Codenames are three characters; SM0 - SM9 then S10 - S99
+#define SIMULATOR_MAX_OBJECTS 100
+// Virtual time covered by each call to poll
+#define SIMULATOR_POLL_STEP .001
+// Longest step the motion model is integrated over at once
+#define SIMULATOR_MAX_STEP .001
+#define SIMULATOR_SWEEP_BATCH (2 * SENSORS_PER_OBJECT)
+#define SIMULATOR_GEN1_PULSE_PERIOD 0.00833333333
 
+typedef struct SurviveDriverSimulatorLHState {
 	FLT period_s;
 	FLT start_time;
 } SurviveDriverSimulatorLHState;
 
 typedef SurviveVelocity SurviveAcceleration;
+struct SurviveDriverSimulator;
+
+typedef enum simulator_event_type {
+	SIMULATOR_EVENT_IMU,
+	SIMULATOR_EVENT_LIGHT_GEN1,
+	SIMULATOR_EVENT_SYNC,
+	SIMULATOR_EVENT_SWEEP,
+} simulator_event_type;
+
+typedef struct simulator_event {
+	FLT time;
+	// Sweeps are timed from the sync that started the rotation they belong to
+	FLT sync_time;
+	uint16_t obj;
+	uint8_t type;
+	uint8_t lh;
+	uint8_t sensor;
+	uint8_t axis;
+} simulator_event;
+
+typedef struct SurviveSimulatedObject {
+	struct SurviveDriverSimulator *driver;
+	SurviveObject *so;
+
+	SurvivePose position;
+	SurviveVelocity velocity;
+	SurviveAcceleration accel;
+
+	// Time the motion state above was propagated to
+	FLT time;
+	int acode;
+
+	// Sweeps go out as one batch until an event that has to come after them is sent to the object
+	SurviveSweepEvent sweeps[SIMULATOR_SWEEP_BATCH];
+	size_t sweep_cnt;
+
+	FLT gyro_bias[3];
+	char gt_name[16];
+
+	struct variance_measure pose_variance;
+
+	// Error of the reported poses against ground truth, for the report at the end of the run
+	uint64_t pose_cnt;
+	FLT pos_error_sum, pos_error_max;
+	FLT rot_error_sum, rot_error_max;
+} SurviveSimulatedObject;
+
 struct SurviveDriverSimulator {
 	int lh_version;
 	SurviveContext *ctx;
-	SurviveObject *so;
+
+	SurviveSimulatedObject *objs;
+	size_t obj_cnt;
 
 	SurviveDriverSimulatorLHState lhstates[NUM_GEN2_LIGHTHOUSES];
 	BaseStationData bsd[NUM_GEN2_LIGHTHOUSES];
 
-	SurvivePose position;
-	SurviveVelocity velocity;
-	SurviveAcceleration accel;
-
-	FLT time_last_imu;
-	FLT time_last_light;
-	FLT time_last_iterate;
+	// Pending events as a binary min heap on their time
+	simulator_event *events;
+	size_t event_cnt, event_size;
 
 	FLT sensor_var;
 	FLT sensor_droprate;
 	FLT init_time;
 
-	FLT timestart;
 	FLT current_timestamp;
-	int acode;
 
-	FLT gyro_bias[3];
 	FLT gyro_bias_scale;
 	FLT gyro_var;
 	FLT sensor_jitter;
 	FLT acc_var;
 	int show_gt_device_cfg;
+	size_t attractor_cnt;
 
-	struct variance_measure pose_variance;
+	int realtime;
+	FLT time_factor;
+	FLT run_time;
+
+	// Wall clock time, in seconds, of the first and of the last step
+	double wall_start, wall_last;
+
+	uint64_t light_event_cnt;
+	uint64_t imu_event_cnt;
 
 	pose_process_func pose_fn;
 	lighthouse_pose_process_func lh_fn;
 };
 typedef struct SurviveDriverSimulator SurviveDriverSimulator;
 
-static double timestamp_in_s() {
-	static double start_time_s = 0;
-	if (start_time_s == 0.)
-		start_time_s = OGGetAbsoluteTime();
-	return OGGetAbsoluteTime() - start_time_s;
-}
-
-static FLT lighthouse_lasttime_of_angle(SurviveDriverSimulator *driver, int lh, FLT timestamp, FLT angle) {
-	SurviveDriverSimulatorLHState *lhs = &driver->lhstates[lh];
-	return timestamp - fmod(timestamp - lhs->start_time, lhs->period_s) + angle / (2 * LINMATHPI) * lhs->period_s;
-}
-static FLT lighthouse_sync_time(SurviveDriverSimulator *driver, int lh, FLT timestamp) {
-	return lighthouse_lasttime_of_angle(driver, lh, timestamp, 0);
-}
 FLT lighthouse_angle(SurviveDriverSimulator *driver, int lh, FLT timestamp) {
 	SurviveDriverSimulatorLHState *lhs = &driver->lhstates[lh];
 
 	FLT angle = fmod(timestamp - lhs->start_time, lhs->period_s) / lhs->period_s * 2. * LINMATHPI;
 	return angle;
 }
-static bool lighthouse_sensor_angle(SurviveDriverSimulator *driver, int lh, size_t idx, SurviveAngleReading ang) {
-	SurviveContext *ctx = driver->ctx;
-	FLT *pt = driver->so->sensor_locations + idx * 3;
 
-	LinmathVec3d ptInWorld;
-	LinmathVec3d normalInWorld;
-	ApplyPoseToPoint(ptInWorld, &driver->position, pt);
-	SurvivePose world2lh = InvertPoseRtn(&driver->bsd[lh].Pose);
-	LinmathPoint3d ptInLh;
-	ApplyPoseToPoint(ptInLh, &world2lh, ptInWorld);
+static void push_event(SurviveDriverSimulator *driver, simulator_event event) {
+	if (driver->event_cnt == driver->event_size) {
+		driver->event_size = driver->event_size ? 2 * driver->event_size : 256;
+		driver->events = SV_REALLOC(driver->events, sizeof(simulator_event) * driver->event_size);
+	}
 
+	size_t i = driver->event_cnt++;
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (driver->events[parent].time <= event.time)
+			break;
+		driver->events[i] = driver->events[parent];
+		i = parent;
+	}
+	driver->events[i] = event;
+}
+
+static simulator_event pop_event(SurviveDriverSimulator *driver) {
+	simulator_event top = driver->events[0];
+	simulator_event last = driver->events[--driver->event_cnt];
+
+	size_t i = 0;
+	for (size_t child = 1; child < driver->event_cnt; child = 2 * i + 1) {
+		if (child + 1 < driver->event_cnt && driver->events[child + 1].time < driver->events[child].time)
+			child++;
+		if (last.time <= driver->events[child].time)
+			break;
+		driver->events[i] = driver->events[child];
+		i = child;
+	}
+	driver->events[i] = last;
+	return top;
+}
+
+// Angles a lighthouse sees a sensor at, given the sensor's position and normal in its frame. No noise or drop outs.
+static bool lighthouse_sensor_angle_in_lh(SurviveDriverSimulator *driver, int lh, const FLT *ptInLh,
+										  const FLT *normalInLh, SurviveAngleReading ang) {
 	if (ptInLh[2] < 0) {
 		LinmathVec3d dirLh;
 		normalize3d(dirLh, ptInLh);
 		scale3d(dirLh, dirLh, -1);
 
-		quatrotatevector(normalInWorld, driver->position.Rot, driver->so->sensor_normals + idx * 3);
-
-		LinmathVec3d normalInLh;
-		quatrotatevector(normalInLh, world2lh.Rot, normalInWorld);
-
 		FLT facingness = dot3d(normalInLh, dirLh);
-		if (facingness > 0 && linmath_rand(0, 1.) > driver->sensor_droprate) {
+		if (facingness > 0) {
 			if (driver->lh_version == 0) {
 				survive_reproject_xy(driver->bsd[lh].fcal, ptInLh, ang);
 			} else {
@@ -134,219 +210,196 @@ static bool lighthouse_sensor_angle(SurviveDriverSimulator *driver, int lh, size
 				ang[1] += 4 * LINMATHPI / 3.;
 				ang[0] += 2 * LINMATHPI / 3.;
 			}
-
-			for (int i = 0; i < 2; i++) {
-				ang[i] += linmath_normrand(0, driver->sensor_var);
-			}
 			return true;
 		}
 	}
 	return false;
 }
+static SurvivePose object_to_lighthouse(const SurviveSimulatedObject *obj, int lh) {
+	SurvivePose world2lh = InvertPoseRtn(&obj->driver->bsd[lh].Pose);
+	SurvivePose obj2lh;
+	ApplyPoseToPose(&obj2lh, &world2lh, &obj->position);
+	return obj2lh;
+}
+// Positions and normals of all of the object's sensors in the frame of the lighthouse
+static void sensors_in_lighthouse(const SurviveSimulatedObject *obj, int lh, FLT *ptsInLh, FLT *normalsInLh) {
+	SurvivePose obj2lh = object_to_lighthouse(obj, lh);
+	ApplyPoseToPoints(ptsInLh, &obj2lh, obj->so->sensor_locations, obj->so->sensor_ct);
+	quatrotatevectors(normalsInLh, obj2lh.Rot, obj->so->sensor_normals, obj->so->sensor_ct);
+}
+static bool apply_sensor_noise(SurviveDriverSimulator *driver, SurviveAngleReading ang) {
+	if (linmath_rand(0, 1.) <= driver->sensor_droprate) {
+		return false;
+	}
 
-struct lh_event {
-	FLT time;
-	uint8_t lh;
-	int idx;
-};
-
-static int event_compare(const void *p, const void *q) {
-	const struct lh_event *x = (const struct lh_event *)p;
-	const struct lh_event *y = (const struct lh_event *)q;
-
-	return x->time > y->time;
+	for (int i = 0; i < 2; i++) {
+		ang[i] += linmath_normrand(0, driver->sensor_var);
+	}
+	return true;
 }
-static size_t run_lighthouse_v2(SurviveDriverSimulator *driver, int lh, FLT timestamp, struct lh_event *events) {
-	SurviveContext *ctx = driver->ctx;
-	SurviveDriverSimulatorLHState *lhs = &driver->lhstates[lh];
+static bool lighthouse_sensor_angle(SurviveSimulatedObject *obj, int lh, size_t idx, SurviveAngleReading ang) {
+	SurvivePose obj2lh = object_to_lighthouse(obj, lh);
+	LinmathPoint3d ptInLh;
+	LinmathVec3d normalInLh;
+	ApplyPoseToPoint(ptInLh, &obj2lh, obj->so->sensor_locations + idx * 3);
+	quatrotatevector(normalInLh, obj2lh.Rot, obj->so->sensor_normals + idx * 3);
 
-	size_t evt_idx = 0;
+	return lighthouse_sensor_angle_in_lh(obj->driver, lh, ptInLh, normalInLh, ang) &&
+		   apply_sensor_noise(obj->driver, ang);
+}
 
-	FLT sync_time = lighthouse_sync_time(driver, lh, timestamp);
+static void flush_sweeps(SurviveSimulatedObject *obj) {
+	if (obj->sweep_cnt == 0) {
+		return;
+	}
 
-	if (sync_time >= lhs->last_eval_time && sync_time <= timestamp) {
-		// fprintf(stderr, "Sync %d %f %f\n", lh, sync_time, timestamp);
-		events[evt_idx].time = sync_time;
-		events[evt_idx].lh = lh;
-		events[evt_idx++].idx = -1;
+	// Sweeps are queued in the order they were predicted; the angles they are sent with can move them a few us
+	for (size_t i = 1; i < obj->sweep_cnt; i++) {
+		SurviveSweepEvent sweep = obj->sweeps[i];
+		size_t j = i;
+		for (; j > 0 && (int32_t)(obj->sweeps[j - 1].timecode - sweep.timecode) > 0; j--) {
+			obj->sweeps[j] = obj->sweeps[j - 1];
+		}
+		obj->sweeps[j] = sweep;
 	}
 
-	for (size_t idx = 0; idx < driver->so->sensor_ct; idx++) {
-		SurviveAngleReading ang;
+	SurviveContext *ctx = obj->driver->ctx;
+	SURVIVE_INVOKE_HOOK_SO(sweep_batch, obj->so, obj->sweeps, obj->sweep_cnt);
+	obj->sweep_cnt = 0;
+}
 
-		if (lighthouse_sensor_angle(driver, lh, idx, ang)) {
-			for (int axis = 0; axis < 2; axis++) {
-				FLT angle_time = lighthouse_lasttime_of_angle(driver, lh, timestamp, ang[axis]);
-				if (angle_time >= lhs->last_eval_time && angle_time <= timestamp) {
-					events[evt_idx].time = angle_time;
-					events[evt_idx].lh = lh;
-					events[evt_idx++].idx = idx;
-				}
-			}
-		}
+static void run_sweep(SurviveSimulatedObject *obj, const simulator_event *event) {
+	SurviveDriverSimulator *driver = obj->driver;
+	SurviveDriverSimulatorLHState *lhs = &driver->lhstates[event->lh];
+
+	// The object has moved since the sweep was scheduled, so the angle -- and with it the exact time -- is redone
+	SurviveAngleReading ang;
+	if (!lighthouse_sensor_angle(obj, event->lh, event->sensor, ang)) {
+		return;
 	}
 
-	lhs->last_eval_time = timestamp;
+	FLT time = event->sync_time + ang[event->axis] / (2 * LINMATHPI) * lhs->period_s;
+	if (obj->sweep_cnt == SIMULATOR_SWEEP_BATCH) {
+		flush_sweeps(obj);
+	}
 
-	return evt_idx;
+	driver->light_event_cnt++;
+	obj->sweeps[obj->sweep_cnt++] =
+		(SurviveSweepEvent){.channel = driver->bsd[event->lh].mode,
+							.sensor_id = event->sensor,
+							.timecode = (survive_timecode)round(time * 48000000.)};
 }
-static void run_lighthouse_v1(SurviveDriverSimulator *driver, int lh, FLT timestamp) {
+
+static void run_lighthouse_v1(SurviveSimulatedObject *obj, int lh, FLT timestamp) {
+	SurviveDriverSimulator *driver = obj->driver;
 	SurviveContext *ctx = driver->ctx;
 	survive_timecode timecode = (survive_timecode)round(timestamp * 48000000.);
 
 	if (lh >= ctx->activeLighthouses || driver->bsd[lh].PositionSet == false) {
-		driver->acode = (driver->acode + 1) % 4;
+		obj->acode = (obj->acode + 1) % 4;
 	} else {
-		for (int idx = 0; idx < driver->so->sensor_ct; idx++) {
+		LinmathPoint3d ptsInLh[SENSORS_PER_OBJECT];
+		LinmathVec3d normalsInLh[SENSORS_PER_OBJECT];
+		sensors_in_lighthouse(obj, lh, ptsInLh[0], normalsInLh[0]);
+
+		int acode = (lh << 2) + (obj->acode & 1);
+		for (int idx = 0; idx < obj->so->sensor_ct; idx++) {
 			SurviveAngleReading ang = {0};
-			if (lighthouse_sensor_angle(driver, lh, idx, ang)) {
-				if (driver->lh_version == 0) {
-					int acode = (lh << 2) + (driver->acode & 1);
-					SURVIVE_INVOKE_HOOK_SO(angle, driver->so, idx, acode, timecode, .006, ang[driver->acode & 1], lh);
-				} else {
-					SURVIVE_INVOKE_HOOK_SO(sweep_angle, driver->so, driver->bsd[lh].mode, idx, timecode,
-										   driver->acode & 1, ang[driver->acode & 1]);
-				}
+			if (lighthouse_sensor_angle_in_lh(driver, lh, ptsInLh[idx], normalsInLh[idx], ang) &&
+				apply_sensor_noise(driver, ang)) {
+				driver->light_event_cnt++;
+				SURVIVE_INVOKE_HOOK_SO(angle, obj->so, idx, acode, timecode, .006, ang[obj->acode & 1], lh);
 			}
 		}
 
-		if (driver->lh_version == 0) {
-			int acode = (lh << 2) + (driver->acode & 1);
-			SURVIVE_INVOKE_HOOK_SO(light, driver->so, -3, acode, 0, timecode, 100, lh);
-			driver->acode = (driver->acode + 1) % 4;
-		} else {
-			SURVIVE_INVOKE_HOOK_SO(sync, driver->so, driver->bsd[lh].mode, timecode, false, false);
-			driver->acode = (driver->acode + 1) % 4;
-		}
+		SURVIVE_INVOKE_HOOK_SO(light, obj->so, -3, acode, 0, timecode, 100, lh);
+		obj->acode = (obj->acode + 1) % 4;
 	}
 }
 
-static bool run_imu(struct SurviveContext *ctx, SurviveDriverSimulator *driver, double timestamp,
-					double time_between_imu, survive_long_timecode timecode) {
-	bool update_gt = false;
-	if (timestamp > time_between_imu + driver->time_last_imu) {
-		update_gt = true;
-		// ( SurviveObject * so, int mask, FLT * accelgyro, survive_timecode timecode, int id );
-		FLT accelgyro[9] = {0, 0, 0,  // Acc
-							0, 0, 0,  // Gyro
-							0, 0, 0}; // Mag
-
-		add3d(accelgyro, accelgyro, driver->accel.Pos);
-		scale3d(accelgyro, accelgyro, 1. / 9.80665);
-
-		SV_VERBOSE(200, "(Gt)Acc\t\t" Point3_format "\t%f", LINMATH_VEC3_EXPAND(accelgyro), norm3d(accelgyro));
-		accelgyro[2] += 1;
-
-		SurvivePose ip = InvertPoseRtn(&driver->position);
-		LinmathQuat q;
-		quatgetconjugate(q, driver->position.Rot);
-		quatrotatevector(accelgyro, q, accelgyro);
-		quatrotatevector(accelgyro + 3, q, driver->velocity.AxisAngleRot);
-		add3d(accelgyro + 3, accelgyro + 3, driver->gyro_bias);
-
-		for (int i = 0; i < 3; i++) {
-			accelgyro[i] += linmath_normrand(0, driver->acc_var);
-			accelgyro[i + 3] += linmath_normrand(0, driver->gyro_var);
-		}
+static void run_imu(struct SurviveContext *ctx, SurviveSimulatedObject *obj, double timestamp) {
+	SurviveDriverSimulator *driver = obj->driver;
+	survive_long_timecode timecode = (survive_long_timecode)round(timestamp * 48000000.);
 
-		SV_VERBOSE(200, "Ang: " Point3_format, LINMATH_VEC3_EXPAND(driver->velocity.AxisAngleRot));
-		SV_VERBOSE(200, "GT: " SurvivePose_format " %f", SURVIVE_POSE_EXPAND(driver->position),
-				   quatmagnitude(driver->position.Rot));
-		if (driver->show_gt_device_cfg != 2) {
-			SURVIVE_INVOKE_HOOK_SO(imu, driver->so, 3, accelgyro, timecode, 0);
-		}
+	// ( SurviveObject * so, int mask, FLT * accelgyro, survive_timecode timecode, int id );
+	FLT accelgyro[9] = {0, 0, 0,  // Acc
+						0, 0, 0,  // Gyro
+						0, 0, 0}; // Mag
 
-		for (int i = 0; i < 3; i++) {
-			driver->gyro_bias[i] += linmath_normrand(0, driver->gyro_bias_scale) * .001;
-		}
-		driver->time_last_imu = timestamp - 1e-10;
-	}
-	return update_gt;
-}
-bool run_light(const struct SurviveContext *ctx, SurviveDriverSimulator *driver, double timestamp,
-			   double time_between_pulses) {
-	bool update_gt = false;
-	if (driver->show_gt_device_cfg == 2) {
-		return false;
-	}
+	add3d(accelgyro, accelgyro, obj->accel.Pos);
+	scale3d(accelgyro, accelgyro, 1. / 9.80665);
 
-	if (driver->lh_version == 0) {
-		if (timestamp > time_between_pulses + driver->time_last_light) {
-			update_gt = true;
-			int lh = driver->acode >> 1;
+	SV_VERBOSE(200, "(Gt)Acc\t\t" Point3_format "\t%f", LINMATH_VEC3_EXPAND(accelgyro), norm3d(accelgyro));
+	accelgyro[2] += 1;
 
-			run_lighthouse_v1(driver, lh, timestamp);
-			driver->time_last_light = timestamp;
-		}
-	} else {
-		struct lh_event events[NUM_GEN2_LIGHTHOUSES * (SENSORS_PER_OBJECT + 1)];
-		size_t evt_idx = 0;
-		for (int i = 0; i < ctx->activeLighthouses; i++) {
-			evt_idx += run_lighthouse_v2(driver, i, timestamp, events + evt_idx);
-		}
+	LinmathQuat q;
+	quatgetconjugate(q, obj->position.Rot);
+	quatrotatevector(accelgyro, q, accelgyro);
+	quatrotatevector(accelgyro + 3, q, obj->velocity.AxisAngleRot);
+	add3d(accelgyro + 3, accelgyro + 3, obj->gyro_bias);
+
+	for (int i = 0; i < 3; i++) {
+		accelgyro[i] += linmath_normrand(0, driver->acc_var);
+		accelgyro[i + 3] += linmath_normrand(0, driver->gyro_var);
+	}
 
-		qsort(events, evt_idx, sizeof *events, event_compare);
+	SV_VERBOSE(200, "Ang: " Point3_format, LINMATH_VEC3_EXPAND(obj->velocity.AxisAngleRot));
+	SV_VERBOSE(200, "GT: " SurvivePose_format " %f", SURVIVE_POSE_EXPAND(obj->position),
+			   quatmagnitude(obj->position.Rot));
+	if (driver->show_gt_device_cfg != 2) {
+		flush_sweeps(obj);
+		driver->imu_event_cnt++;
+		SURVIVE_INVOKE_HOOK_SO(imu, obj->so, 3, accelgyro, timecode, 0);
+	}
 
-		for (size_t i = 0; i < evt_idx; i++) {
-			survive_timecode timecode = (survive_timecode)round(events[i].time * 48000000.);
-			uint8_t lh = events[i].lh;
-			if (events[i].idx == -1) {
-				SURVIVE_INVOKE_HOOK_SO(sync, driver->so, driver->bsd[lh].mode, timecode, 0, 0);
-			} else {
-				SURVIVE_INVOKE_HOOK_SO(sweep, driver->so, driver->bsd[lh].mode, events[i].idx, timecode, 0);
-			}
-		}
+	for (int i = 0; i < 3; i++) {
+		obj->gyro_bias[i] += linmath_normrand(0, driver->gyro_bias_scale) * .001;
 	}
-	return update_gt;
 }
-static void propagate_state(SurviveDriverSimulator *driver, double time_diff) {
+static void propagate_state(SurviveSimulatedObject *obj, double time_diff) {
 	SurviveVelocity velGain;
-	scale3d(velGain.Pos, driver->accel.Pos, time_diff);
-	scale3d(velGain.AxisAngleRot, driver->accel.AxisAngleRot, time_diff);
+	scale3d(velGain.Pos, obj->accel.Pos, time_diff);
+	scale3d(velGain.AxisAngleRot, obj->accel.AxisAngleRot, time_diff);
 
-	add3d(driver->velocity.Pos, driver->velocity.Pos, velGain.Pos);
-	add3d(driver->velocity.AxisAngleRot, velGain.AxisAngleRot, driver->velocity.AxisAngleRot);
+	add3d(obj->velocity.Pos, obj->velocity.Pos, velGain.Pos);
+	add3d(obj->velocity.AxisAngleRot, velGain.AxisAngleRot, obj->velocity.AxisAngleRot);
 
 	SurviveVelocity posGain;
-	scale3d(posGain.Pos, driver->velocity.Pos, time_diff);
-	add3d(driver->position.Pos, driver->position.Pos, posGain.Pos);
+	scale3d(posGain.Pos, obj->velocity.Pos, time_diff);
+	add3d(obj->position.Pos, obj->position.Pos, posGain.Pos);
 
-	survive_apply_ang_velocity(driver->position.Rot, driver->velocity.AxisAngleRot, time_diff, driver->position.Rot);
+	survive_apply_ang_velocity(obj->position.Rot, obj->velocity.AxisAngleRot, time_diff, obj->position.Rot);
 }
-static void update_gt_device(struct SurviveContext *ctx, const SurviveDriverSimulator *driver) {
-	if (driver->show_gt_device_cfg == 0)
+static void update_gt_device(struct SurviveContext *ctx, const SurviveSimulatedObject *obj) {
+	if (obj->driver->show_gt_device_cfg == 0)
 		return;
 
 	static int report_in_imu = -1;
 	if (report_in_imu == -1) {
-		survive_attach_configi(driver->so->ctx, "report-in-imu", &report_in_imu);
+		survive_attach_configi(obj->so->ctx, "report-in-imu", &report_in_imu);
 	}
 
-	SurvivePose head2world = driver->position;
+	SurvivePose head2world = obj->position;
 	if (!report_in_imu) {
-		ApplyPoseToPose(&head2world, &driver->position, &driver->so->head2imu);
+		ApplyPoseToPose(&head2world, &obj->position, &obj->so->head2imu);
 	}
 
-	survive_default_external_pose_process(ctx, "Sim_GT", &head2world);
-	survive_default_external_velocity_process(ctx, "Sim_GT", &driver->velocity);
+	survive_default_external_pose_process(ctx, obj->gt_name, &head2world);
+	survive_default_external_velocity_process(ctx, obj->gt_name, &obj->velocity);
 }
-void apply_attractors(struct SurviveContext *ctx, SurviveDriverSimulator *driver) {
+
+static LinmathVec3d attractors[] = {{1, 1, 1}, {-1, 0, 1}, {0, -1, .5}};
+
+void apply_attractors(struct SurviveContext *ctx, SurviveSimulatedObject *obj) {
 	SurviveVelocity accel = {0};
 
-	FLT time_since_init = driver->current_timestamp - driver->init_time;
 	FLT s = 1.;
 
-	LinmathVec3d attractors[] = {{1, 1, 1}, {-1, 0, 1}, {0, -1, .5}};
-	size_t attractor_cnt = survive_configi(ctx, "attractors", SC_GET, sizeof(attractors) / sizeof(LinmathVec3d));
-	if (attractor_cnt > sizeof(attractors) / sizeof(LinmathVec3d)) {
-		attractor_cnt = sizeof(attractors) / sizeof(LinmathVec3d);
-	}
-
 	static bool reported = false;
 
-	for (int i = 0; i < attractor_cnt; i++) {
+	for (int i = 0; i < obj->driver->attractor_cnt; i++) {
 		LinmathVec3d acc;
-		sub3d(acc, attractors[i], driver->position.Pos);
+		sub3d(acc, attractors[i], obj->position.Pos);
 		FLT r = norm3d(acc);
 		scale3d(acc, acc, s / r / r);
 		add3d(accel.Pos, accel.Pos, acc);
@@ -357,7 +410,7 @@ void apply_attractors(struct SurviveContext *ctx, SurviveDriverSimulator *driver
 	}
 	reported = true;
 
-	if (attractor_cnt == 0) {
+	if (obj->driver->attractor_cnt == 0) {
 		// accel.Pos[0] = 1 * cos(timestamp);
 	}
 
@@ -366,87 +419,184 @@ void apply_attractors(struct SurviveContext *ctx, SurviveDriverSimulator *driver
 		// accel.AxisAngleRot[i] = cos(timestamp);
 	}
 
-	memcpy(&driver->accel, &accel, sizeof(accel));
+	memcpy(&obj->accel, &accel, sizeof(accel));
 }
-static void apply_initial_position(SurviveDriverSimulator *driver) {
+static void apply_initial_position(SurviveSimulatedObject *obj, size_t idx, size_t obj_cnt) {
 	FLT up[] = {0, 0, 1};
 	FLT ones[] = {1, -1, 1};
-	quatfrom2vectors(driver->position.Rot, up, ones);
+	quatfrom2vectors(obj->position.Rot, up, ones);
 	for (int i = 0; i < 3; i++)
-		driver->position.Pos[i] = 0;
-}
+		obj->position.Pos[i] = 0;
 
-static void apply_initial_velocity(SurviveDriverSimulator *sp) {
-	SurviveContext *ctx = sp->ctx;
+	// Everything past the first object starts out on a ring around the origin so they don't all overlap
+	if (idx > 0) {
+		FLT theta = 2. * LINMATHPI * idx / obj_cnt;
+		obj->position.Pos[0] = .5 * cos(theta);
+		obj->position.Pos[1] = .5 * sin(theta);
+	}
+}
 
-	sp->velocity.AxisAngleRot[0] = sp->velocity.AxisAngleRot[1] = sp->velocity.AxisAngleRot[2] = 1.;
+static void apply_initial_velocity(SurviveSimulatedObject *obj) {
+	obj->velocity.AxisAngleRot[0] = obj->velocity.AxisAngleRot[1] = obj->velocity.AxisAngleRot[2] = 1.;
 
-	size_t attractor_cnt = survive_configi(ctx, "attractors", SC_GET, 1);
-	if (attractor_cnt) {
+	if (obj->driver->attractor_cnt) {
 		for (int i = 0; i < 3; i++)
-			sp->velocity.Pos[i] = 2. * rand() / RAND_MAX - 1.;
+			obj->velocity.Pos[i] = 2. * rand() / RAND_MAX - 1.;
 	}
 }
 
-static int Simulator_poll(struct SurviveContext *ctx, void *_driver) {
-	SurviveDriverSimulator *driver = _driver;
-	static FLT last_time = 0;
-	FLT realtime = timestamp_in_s();
-	
-	FLT timefactor = linmath_max(survive_configf(ctx, "time-factor", SC_GET, 1.), .00001);
-	// FLT timestamp = timestamp_in_s() / timefactor;
-	FLT timestep = .0001;
+static void advance_object(SurviveSimulatedObject *obj, FLT time) {
+	SurviveDriverSimulator *driver = obj->driver;
+	while (obj->time < time) {
+		bool wasIniting = obj->time < driver->init_time;
+		bool isIniting = wasIniting || driver->init_time < 0;
+
+		FLT next = linmath_min(time, obj->time + SIMULATOR_MAX_STEP);
+		if (wasIniting) {
+			next = linmath_min(next, driver->init_time);
+		} else if (!isIniting) {
+			apply_attractors(driver->ctx, obj);
+		}
+
+		propagate_state(obj, next - obj->time);
+		obj->time = next;
 
-	while (last_time != 0 && last_time + timefactor * timestep > realtime) {
-		survive_release_ctx_lock(ctx);
-		OGUSleep((timefactor * timestep + realtime - last_time) * 1e6);
-		survive_get_ctx_lock(ctx);
-		realtime = timestamp_in_s();
+		if (wasIniting && obj->time >= driver->init_time) {
+			apply_initial_velocity(obj);
+		}
 	}
-	last_time = realtime;
+}
 
-	bool wasIniting = driver->current_timestamp < driver->init_time;
-	FLT timestamp = (driver->current_timestamp += timestep);
-	FLT time_between_imu = 1. / driver->so->imu_freq;
-	FLT time_between_pulses = 0.00833333333;
-	FLT time_between_gt = time_between_imu;
-	bool isIniting = timestamp < driver->init_time || driver->init_time < 0;
+static void run_sync(SurviveDriverSimulator *driver, int lh, FLT sync_time) {
+	SurviveContext *ctx = driver->ctx;
+	SurviveDriverSimulatorLHState *lhs = &driver->lhstates[lh];
+	survive_timecode timecode = (survive_timecode)round(sync_time * 48000000.);
+
+	for (size_t i = 0; i < driver->obj_cnt && driver->show_gt_device_cfg != 2; i++) {
+		SurviveSimulatedObject *obj = &driver->objs[i];
+		advance_object(obj, sync_time);
+
+		flush_sweeps(obj);
+		SURVIVE_INVOKE_HOOK_SO(sync, obj->so, driver->bsd[lh].mode, timecode, 0, 0);
+
+		// Sweeps are scheduled from where the sensors are now and placed exactly once the rotor gets there
+		LinmathPoint3d ptsInLh[SENSORS_PER_OBJECT];
+		LinmathVec3d normalsInLh[SENSORS_PER_OBJECT];
+		sensors_in_lighthouse(obj, lh, ptsInLh[0], normalsInLh[0]);
+		for (size_t idx = 0; idx < obj->so->sensor_ct; idx++) {
+			SurviveAngleReading ang;
+			if (!lighthouse_sensor_angle_in_lh(driver, lh, ptsInLh[idx], normalsInLh[idx], ang)) {
+				continue;
+			}
+			for (int axis = 0; axis < 2; axis++) {
+				push_event(driver, (simulator_event){.type = SIMULATOR_EVENT_SWEEP,
+													 .time = sync_time + ang[axis] / (2 * LINMATHPI) * lhs->period_s,
+													 .sync_time = sync_time,
+													 .obj = i,
+													 .lh = lh,
+													 .sensor = idx,
+													 .axis = axis});
+			}
+		}
+	}
 
-	bool update_gt = false;
+	push_event(driver,
+			   (simulator_event){.type = SIMULATOR_EVENT_SYNC, .time = sync_time + lhs->period_s, .lh = lh});
+}
 
-	FLT t = (timestamp - driver->timestart);
+static void run_event(SurviveDriverSimulator *driver, const simulator_event *event) {
+	SurviveContext *ctx = driver->ctx;
+	if (event->type == SIMULATOR_EVENT_SYNC) {
+		run_sync(driver, event->lh, event->time);
+		return;
+	}
 
-	if (wasIniting == true && isIniting == false) {
-		apply_initial_velocity(driver);
+	SurviveSimulatedObject *obj = &driver->objs[event->obj];
+	advance_object(obj, event->time);
+
+	switch (event->type) {
+	case SIMULATOR_EVENT_SWEEP:
+		run_sweep(obj, event);
+		break;
+	case SIMULATOR_EVENT_IMU:
+		run_imu(ctx, obj, event->time);
+		update_gt_device(ctx, obj);
+		push_event(driver, (simulator_event){.type = SIMULATOR_EVENT_IMU,
+											 .time = event->time + 1. / obj->so->imu_freq,
+											 .obj = event->obj});
+		break;
+	case SIMULATOR_EVENT_LIGHT_GEN1:
+		if (driver->show_gt_device_cfg != 2) {
+			run_lighthouse_v1(obj, obj->acode >> 1, event->time);
+		}
+		update_gt_device(ctx, obj);
+		push_event(driver, (simulator_event){.type = SIMULATOR_EVENT_LIGHT_GEN1,
+											 .time = event->time + SIMULATOR_GEN1_PULSE_PERIOD,
+											 .obj = event->obj});
+		break;
 	}
+}
 
-	if (isIniting == false) {
-		apply_attractors(ctx, driver);
+static void schedule_initial_events(SurviveDriverSimulator *driver) {
+	SurviveContext *ctx = driver->ctx;
+	for (size_t i = 0; i < driver->obj_cnt; i++) {
+		SurviveObject *so = driver->objs[i].so;
+		push_event(driver, (simulator_event){.type = SIMULATOR_EVENT_IMU, .time = 1. / so->imu_freq, .obj = i});
+		if (driver->lh_version == 0) {
+			push_event(driver, (simulator_event){
+								   .type = SIMULATOR_EVENT_LIGHT_GEN1, .time = SIMULATOR_GEN1_PULSE_PERIOD, .obj = i});
+		}
 	}
 
-	survive_long_timecode timecode = (survive_long_timecode)round(timestamp * 48000000.);
+	for (int lh = 0; lh < ctx->activeLighthouses && driver->lh_version != 0; lh++) {
+		SurviveDriverSimulatorLHState *lhs = &driver->lhstates[lh];
+		push_event(driver, (simulator_event){.type = SIMULATOR_EVENT_SYNC,
+											 .time = fmod(lhs->start_time, lhs->period_s),
+											 .lh = lh});
+	}
+}
 
-	update_gt |= run_imu(ctx, driver, timestamp, time_between_imu, timecode);
-	update_gt |= run_light(ctx, driver, timestamp, time_between_pulses);
+static int Simulator_poll(struct SurviveContext *ctx, void *_driver) {
+	SurviveDriverSimulator *driver = _driver;
+	double realtime = OGGetAbsoluteTime();
+	FLT timestep = SIMULATOR_POLL_STEP;
 
-	if (update_gt) {
-		update_gt_device(ctx, driver);
+	if (driver->wall_start == 0) {
+		driver->wall_start = realtime;
 	}
 
-	if (driver->time_last_iterate == 0) {
-		driver->time_last_iterate = timestamp;
-		driver->timestart = timestamp;
-		return 0;
+	if (driver->realtime) {
+		FLT timefactor = linmath_max(driver->time_factor, .00001);
+		while (driver->wall_last != 0 && driver->wall_last + timefactor * timestep > realtime) {
+			survive_release_ctx_lock(ctx);
+			OGUSleep((timefactor * timestep + driver->wall_last - realtime) * 1e6);
+			survive_get_ctx_lock(ctx);
+			realtime = OGGetAbsoluteTime();
+		}
 	}
-	FLT time_diff = timestamp - driver->time_last_iterate;
-	// SV_INFO("%.013f", time_diff);
-	driver->time_last_iterate = timestamp;
+	driver->wall_last = realtime;
 
-	propagate_state(driver, time_diff);
+	FLT timestamp = driver->current_timestamp + timestep;
 
-	FLT time = survive_configf(ctx, "simulator-time", SC_GET, 0);
-	if (timestamp - driver->timestart > time && time > 0) {
-		SV_INFO("Simulation finished after %f seconds", realtime);
+	// Simulated data counts as received when it is generated
+	uint64_t data_received_us = OGGetAbsoluteTimeUS();
+	for (size_t i = 0; i < driver->obj_cnt; i++) {
+		driver->objs[i].so->latency.data_received_us = data_received_us;
+	}
+
+	// Jump straight from one event to the next; nothing is evaluated in between
+	while (driver->event_cnt > 0 && driver->events[0].time <= timestamp) {
+		simulator_event event = pop_event(driver);
+		run_event(driver, &event);
+	}
+
+	for (size_t i = 0; i < driver->obj_cnt; i++) {
+		flush_sweeps(&driver->objs[i]);
+	}
+	driver->current_timestamp = timestamp;
+
+	if (timestamp > driver->run_time && driver->run_time > 0) {
+		SV_INFO("Simulation finished after %f seconds", realtime - driver->wall_start);
 		return 1;
 	}
 
@@ -477,6 +627,23 @@ const BaseStationData simulated_bsd[5] = {
 	{.PositionSet = 1, .BaseStationID = 1, .Pose = {.Pos = {0, 0, 6}, .Rot = {1, 0, 0, 0}}, .mode = 4, .OOTXSet = 1},
 };
 
+// Lighthouses past the default layout go on a ring around the tracked volume, alternating in height and facing its
+// center
+static BaseStationData simulated_lighthouse(int idx) {
+	BaseStationData bsd = {.PositionSet = 1, .BaseStationID = idx, .mode = idx, .OOTXSet = 1};
+
+	FLT theta = 2. * LINMATHPI * idx / NUM_GEN2_LIGHTHOUSES + LINMATHPI / 8.;
+	bsd.Pose.Pos[0] = 4. * cos(theta);
+	bsd.Pose.Pos[1] = 4. * sin(theta);
+	bsd.Pose.Pos[2] = idx & 1 ? 2.5 : 1.;
+
+	// Lighthouses look down their -z axis
+	LinmathVec3d forward = {0, 0, -1}, center = {0, 0, .5}, dir;
+	sub3d(dir, center, bsd.Pose.Pos);
+	quatfrom2vectors(bsd.Pose.Rot, forward, dir);
+	return bsd;
+}
+
 static void simulation_lh_compare(SurviveContext *ctx, uint8_t lighthouse, const SurvivePose *lighthouse_pose) {
 	const SurviveDriverSimulator *driver = survive_get_driver(ctx, Simulator_poll);
 
@@ -490,24 +657,32 @@ static void simulation_lh_compare(SurviveContext *ctx, uint8_t lighthouse, const
 
 static void simulation_compare(SurviveObject *so, survive_long_timecode timecode, const SurvivePose *imupose) {
 	SurviveContext *ctx = so->ctx;
-	SurviveDriverSimulator *driver = so->driver;
-	SurvivePose p = InvertPoseRtn(&driver->position);
+	SurviveSimulatedObject *obj = so->driver;
+	SurvivePose p = InvertPoseRtn(&obj->position);
 	ApplyPoseToPose(&p, &p, &so->OutPoseIMU);
 
 	FLT error[7] = {0};
 	FLT verror[6] = {0};
-	subnd(error, driver->position.Pos, so->OutPoseIMU.Pos, 3);
+	subnd(error, obj->position.Pos, so->OutPoseIMU.Pos, 3);
 
 	for (int i = 0; i < 4; i++)
-		error[i + 3] = driver->position.Rot[i] * (driver->position.Rot[0] > 0 ? 1 : -1) -
+		error[i + 3] = obj->position.Rot[i] * (obj->position.Rot[0] > 0 ? 1 : -1) -
 					   so->OutPoseIMU.Rot[i] * (so->OutPoseIMU.Rot[0] > 0 ? 1 : -1);
 
-	subnd(verror, driver->velocity.Pos, so->velocity.Pos, 6);
+	subnd(verror, obj->velocity.Pos, so->velocity.Pos, 6);
 
-	variance_measure_add(&driver->pose_variance, error);
+	variance_measure_add(&obj->pose_variance, error);
+
+	FLT pos_error = norm3d(error);
+	FLT rot_error = 2. * acos(linmath_min(fabs(p.Rot[0]), 1.));
+	obj->pose_cnt++;
+	obj->pos_error_sum += pos_error;
+	obj->pos_error_max = linmath_max(obj->pos_error_max, pos_error);
+	obj->rot_error_sum += rot_error;
+	obj->rot_error_max = linmath_max(obj->rot_error_max, rot_error);
 
 	FLT var[7];
-	variance_measure_calc(&driver->pose_variance, var);
+	variance_measure_calc(&obj->pose_variance, var);
 	SV_VERBOSE(110, "\tSimulation pose error " Point7_format, LINMATH_VEC7_EXPAND(var));
 	SV_VERBOSE(110, "\tSimulation velocity error " Point6_format, LINMATH_VEC6_EXPAND(verror));
 	bool pos_unsync = norm3d(p.Pos) > .1 || norm3d(p.Rot + 1) > .2;
@@ -516,10 +691,10 @@ static void simulation_compare(SurviveObject *so, survive_long_timecode timecode
 		SV_VERBOSE(200, "Simulation diff:\t%+f\t%+f\t" SurvivePose_format, norm3d(p.Pos), norm3d(p.Rot + 1),
 				   SURVIVE_POSE_EXPAND(p));
 
-		SV_VERBOSE(200, "Simulation position " SurvivePose_format "\t", SURVIVE_POSE_EXPAND(driver->position));
-		SV_VERBOSE(200, "Simulation velocity " SurviveVel_format "\t", SURVIVE_VELOCITY_EXPAND(driver->velocity));
-		SV_VERBOSE(200, "Simulation acceleration " Point3_format "\t", LINMATH_VEC3_EXPAND(driver->accel.Pos));
-		SV_VERBOSE(200, "Simulation bias         " Point3_format "\t", LINMATH_VEC3_EXPAND(driver->gyro_bias));
+		SV_VERBOSE(200, "Simulation position " SurvivePose_format "\t", SURVIVE_POSE_EXPAND(obj->position));
+		SV_VERBOSE(200, "Simulation velocity " SurviveVel_format "\t", SURVIVE_VELOCITY_EXPAND(obj->velocity));
+		SV_VERBOSE(200, "Simulation acceleration " Point3_format "\t", LINMATH_VEC3_EXPAND(obj->accel.Pos));
+		SV_VERBOSE(200, "Simulation bias         " Point3_format "\t", LINMATH_VEC3_EXPAND(obj->gyro_bias));
 
 		SV_VERBOSE(200, "Object     position " SurvivePose_format "\t", SURVIVE_POSE_EXPAND(so->OutPoseIMU));
 		SV_VERBOSE(200, "Object     velocity " SurviveVel_format "\t", SURVIVE_VELOCITY_EXPAND(so->velocity));
@@ -528,17 +703,62 @@ static void simulation_compare(SurviveObject *so, survive_long_timecode timecode
 		}
 	}
 
-	survive_default_imupose_process(so, timecode, imupose);
+	obj->driver->pose_fn(so, timecode, imupose);
 }
 
 static int simulator_close(struct SurviveContext *ctx, void *_driver) {
 	SurviveDriverSimulator *driver = _driver;
 
-	FLT var[7];
-	variance_measure_calc(&driver->pose_variance, var);
-	SV_VERBOSE(5, "Simulation info");
-	SV_VERBOSE(5, "\tError         " Point7_format, LINMATH_VEC7_EXPAND(var));
-	SV_VERBOSE(5, "\tTracker bias  " Point3_format, LINMATH_VEC3_EXPAND(driver->gyro_bias));
+	double wall_time = driver->wall_last - driver->wall_start;
+	double sim_time = driver->current_timestamp;
+	if (wall_time <= 0) {
+		wall_time = 1e-9;
+	}
+
+	uint64_t pose_cnt = 0;
+	for (size_t i = 0; i < driver->obj_cnt; i++) {
+		pose_cnt += driver->objs[i].pose_cnt;
+	}
+
+	SV_INFO("Simulated %d objects and %d lighthouses for %.2fs in %.2fs of wall time (%.2fx real time)",
+			(int)driver->obj_cnt, ctx->activeLighthouses, sim_time, wall_time, sim_time / wall_time);
+	SV_INFO("\tGenerated %llu light and %llu IMU events (%.0f/s), tracked %llu poses (%.0f/s)",
+			(unsigned long long)driver->light_event_cnt, (unsigned long long)driver->imu_event_cnt,
+			(driver->light_event_cnt + driver->imu_event_cnt) / wall_time, (unsigned long long)pose_cnt,
+			pose_cnt / wall_time);
+
+	for (size_t i = 0; i < driver->obj_cnt; i++) {
+		SurviveSimulatedObject *obj = &driver->objs[i];
+
+		FLT var[7];
+		variance_measure_calc(&obj->pose_variance, var);
+		SV_VERBOSE(5, "Simulation info for %s", obj->so->codename);
+		SV_VERBOSE(5, "\tError         " Point7_format, LINMATH_VEC7_EXPAND(var));
+		SV_VERBOSE(5, "\tTracker bias  " Point3_format, LINMATH_VEC3_EXPAND(obj->gyro_bias));
+
+		if (obj->pose_cnt == 0) {
+			SV_INFO("\t%s: no poses", obj->so->codename);
+			continue;
+		}
+		SV_INFO("\t%s: %llu poses, position error mean %.4fm max %.4fm, rotation error mean %.3f max %.3f degrees",
+				obj->so->codename, (unsigned long long)obj->pose_cnt, obj->pos_error_sum / obj->pose_cnt,
+				obj->pos_error_max, obj->rot_error_sum / obj->pose_cnt / LINMATHPI * 180.,
+				obj->rot_error_max / LINMATHPI * 180.);
+	}
+
+	free(driver->events);
+	driver->events = 0;
+	driver->event_cnt = driver->event_size = 0;
+
+	// The objects outlive the driver, so stop comparing their poses against simulated state that is going away
+	survive_install_imupose_fn(ctx, driver->pose_fn);
+	survive_install_lighthouse_pose_fn(ctx, driver->lh_fn);
+	for (size_t i = 0; i < driver->obj_cnt; i++) {
+		driver->objs[i].so->driver = 0;
+	}
+	free(driver->objs);
+	driver->objs = 0;
+	driver->obj_cnt = 0;
 
 	return 0;
 }
@@ -608,6 +828,9 @@ SURVIVE_EXPORT SurviveObject *survive_create_simulation_device(SurviveContext *c
 															   const char *device_name) {
 	SurviveObject *device = survive_create_device(ctx, "SIM", driver, device_name, 0);
 	device->sensor_ct = survive_configi(ctx, "simulator-obj-sensors", SC_GET, 20);
+	if (device->sensor_ct > SENSORS_PER_OBJECT) {
+		device->sensor_ct = SENSORS_PER_OBJECT;
+	}
 
 	device->head2imu.Rot[0] = 1;
 	device->head2trackref.Rot[0] = 1;
@@ -626,13 +849,31 @@ SURVIVE_EXPORT SurviveObject *survive_create_simulation_device(SurviveContext *c
 	return device;
 }
 
+static void setup_simulated_object(SurviveDriverSimulator *sp, size_t idx) {
+	SurviveSimulatedObject *obj = &sp->objs[idx];
+	obj->driver = sp;
+	obj->pose_variance.size = 7;
+	apply_initial_position(obj, idx, sp->obj_cnt);
+
+	for (int i = 0; i < 3; i++)
+		obj->gyro_bias[i] = linmath_normrand(0, sp->gyro_bias_scale);
+
+	char name[8];
+	snprintf(name, sizeof(name), idx < 10 ? "SM%d" : "S%02d", (int)idx);
+	if (idx == 0) {
+		snprintf(obj->gt_name, sizeof(obj->gt_name), "Sim_GT");
+	} else {
+		snprintf(obj->gt_name, sizeof(obj->gt_name), "Sim_GT%d", (int)idx);
+	}
+
+	obj->so = survive_create_simulation_device(sp->ctx, obj, name);
+}
+
 int DriverRegSimulator(SurviveContext *ctx) {
 	SurviveDriverSimulator *sp = SV_CALLOC(sizeof(SurviveDriverSimulator));
 	sp->ctx = ctx;
 	ctx->poll_min_time_ms = 0;
 
-	apply_initial_position(sp);
-
 	SV_INFO("Setting up Simulator driver.");
 
 	survive_attach_configi(ctx, Simulator_SHOW_GT_DEVICE_TAG, &sp->show_gt_device_cfg);
@@ -642,17 +883,29 @@ int DriverRegSimulator(SurviveContext *ctx) {
 	survive_attach_configf(ctx, Simulator_ACC_NOISE_TAG, &sp->acc_var);
 	survive_attach_configf(ctx, Simulator_INIT_TIME_TAG, &sp->init_time);
 	survive_attach_configf(ctx, Simulator_SENSOR_DROPRATE_TAG, &sp->sensor_droprate);
+	survive_attach_configi(ctx, Simulator_REALTIME_TAG, &sp->realtime);
+	survive_attach_configf(ctx, Simulator_TIME_FACTOR_TAG, &sp->time_factor);
+	survive_attach_configf(ctx, Simulator_TIME_TAG, &sp->run_time);
+
+	sp->attractor_cnt = survive_configi(ctx, "attractors", SC_GET, sizeof(attractors) / sizeof(LinmathVec3d));
+	if (sp->attractor_cnt > sizeof(attractors) / sizeof(LinmathVec3d)) {
+		sp->attractor_cnt = sizeof(attractors) / sizeof(LinmathVec3d);
+	}
 
-	sp->pose_variance.size = 7;
+	int obj_cnt = survive_configi(ctx, Simulator_OBJECTS_TAG, SC_GET, 1);
+	if (obj_cnt < 1 || obj_cnt > SIMULATOR_MAX_OBJECTS) {
+		SV_WARN("Can't simulate %d objects; simulating %d", obj_cnt, obj_cnt < 1 ? 1 : SIMULATOR_MAX_OBJECTS);
+		obj_cnt = obj_cnt < 1 ? 1 : SIMULATOR_MAX_OBJECTS;
+	}
+	sp->objs = SV_CALLOC_N(obj_cnt, sizeof(SurviveSimulatedObject));
+	sp->obj_cnt = obj_cnt;
 
 	sp->gyro_bias_scale = survive_configf(ctx, Simulator_GYRO_BIAS_TAG, SC_GET, 0);
-	for (int i = 0; i < 3; i++)
-		sp->gyro_bias[i] = linmath_normrand(0, sp->gyro_bias_scale);
 
 	int use_lh2 = survive_configi(ctx, Simulator_LH_VERSION_TAG, SC_GET, 2) == 2;
 	int max_lighthouses = use_lh2 ? 16 : 2;
 	// Create a new SurviveObject...
-	SurviveObject *device = survive_create_simulation_device(ctx, sp, "SM0");
+	setup_simulated_object(sp, 0);
 
 	srand(42);
 
@@ -667,7 +920,8 @@ int DriverRegSimulator(SurviveContext *ctx) {
 	for (int i = 0; i < ctx->activeLighthouses; i++) {
 		sp->bsd[i] = ctx->bsd[i];
 		if (!ctx->bsd[i].PositionSet) {
-			sp->bsd[i].Pose = simulated_bsd[i].Pose;
+			sp->bsd[i].Pose = i < sizeof(simulated_bsd) / sizeof(simulated_bsd[0]) ? simulated_bsd[i].Pose
+																				   : simulated_lighthouse(i).Pose;
 		}
 
 		ctx->bsd_map[ctx->bsd[i].mode] = i;
@@ -688,8 +942,19 @@ int DriverRegSimulator(SurviveContext *ctx) {
 								.ogeemag = .25};
 
 	if (ctx->activeLighthouses == 0) {
-		for (int i = 0; i < sizeof(simulated_bsd) / sizeof(simulated_bsd[0]); i++) {
-			ctx->bsd[i] = simulated_bsd[i];
+		int lh_cnt = survive_configi(ctx, Simulator_LIGHTHOUSES_TAG, SC_GET, 0);
+		if (lh_cnt <= 0) {
+			lh_cnt = sizeof(simulated_bsd) / sizeof(simulated_bsd[0]);
+		} else if (lh_cnt > max_lighthouses) {
+			SV_WARN("Can't simulate %d gen%d lighthouses; simulating %d", lh_cnt, use_lh2 ? 2 : 1, max_lighthouses);
+			lh_cnt = max_lighthouses;
+		}
+
+		for (int i = 0; i < lh_cnt; i++) {
+			struct SurviveKalmanLighthouse *tracker = ctx->bsd[i].tracker;
+			ctx->bsd[i] = i < sizeof(simulated_bsd) / sizeof(simulated_bsd[0]) ? simulated_bsd[i]
+																			   : simulated_lighthouse(i);
+			ctx->bsd[i].tracker = tracker;
 
 			for (int axis = 0; axis < 2; axis++) {
 				for (int cal_idx = 0; cal_idx < sizeof(fcalNoise) / sizeof(FLT); cal_idx++) {
@@ -720,18 +985,32 @@ int DriverRegSimulator(SurviveContext *ctx) {
 	// ctx->bsd[0].Pose = sp->bsd[0].Pose;
 	// ctx->bsd[0].PositionSet = 1;
 
-	sp->so = device;
-	survive_add_object(ctx, device);
+	// The rest of the objects are set up after the lighthouses so a single object run sees the same random sequence
+	for (size_t i = 1; i < sp->obj_cnt; i++) {
+		setup_simulated_object(sp, i);
+	}
+	for (size_t i = 0; i < sp->obj_cnt; i++) {
+		survive_add_object(ctx, sp->objs[i].so);
+	}
+
 	sp->lh_version = use_lh2 ? 1 : 0;
 	ctx->lh_version = sp->lh_version;
 	ctx->lh_version_configed = ctx->lh_version;
 
+	SurviveObject *device = sp->objs[0].so;
 	if (use_lh2) {
 		survive_notify_gen2(device, "Simulator setup for lh2");
 	} else {
 		survive_notify_gen1(device, "Simulator setup for lh1");
 	}
 
+	if (!sp->realtime) {
+		SV_INFO("Simulating %d objects and %d lighthouses on a virtual clock", (int)sp->obj_cnt,
+				ctx->activeLighthouses);
+	}
+
+	schedule_initial_events(sp);
+
 	sp->pose_fn = survive_install_imupose_fn(ctx, simulation_compare);
 	sp->lh_fn = survive_install_lighthouse_pose_fn(ctx, simulation_lh_compare);
 	survive_add_driver(ctx, sp, Simulator_poll, simulator_close);
@@ -7,10 +7,14 @@
 #include "survive_config.h"
 #include "survive_default_devices.h"
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <survive.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "pcap/usb.h"
 #include <pcap.h>
@@ -27,6 +31,11 @@ STATIC_CONFIG_ITEM(USBMON_OUTPUT, "usbmon-output", 'i', "Whether or not to log a
 STATIC_CONFIG_ITEM(USBMON_ONLY_RECORD, "usbmon-only-record", 'i', "Record only; don't forward to libsurvive", 0)
 STATIC_CONFIG_ITEM(USBMON_ALLOW_FS_CONFIG, "usbmon-allow-fs-config", 'i',
 				   "If we dont see a config section; try to read it from filesystem -- could be very wrong", 0)
+STATIC_CONFIG_ITEM(USBMON_PLAYBACK_FAST, "usbmon-playback-fast", 'i',
+				   "Replay captures as fast as they can be processed instead of at capture speed", 0)
+
+// Fast playback reads in large blocks; the gzip stream and the FILE on top of it otherwise refill a few KB at a time
+#define USBMON_FAST_READ_BUFFER_SIZE (1 << 20)
 
 typedef struct vive_device_t {
 	uint16_t vid, pid;
@@ -81,6 +90,11 @@ typedef struct SurviveDriverUSBMon {
 	double time_now;
 	double run_time;
 
+	bool fast_playback;
+	// Uncompressed captures are mapped instead of read when playing back fast
+	void *playback_map;
+	size_t playback_map_size;
+
 	pcap_dumper_t *pcapDumper;
 	bool record_all;
 	bool record_only;
@@ -263,6 +277,9 @@ static int usbmon_close(struct SurviveContext *ctx, void *_driver) {
 		pcap_dump_close(driver->pcapDumper);
 	}
 	pcap_close(driver->pcap);
+	if (driver->playback_map) {
+		munmap(driver->playback_map, driver->playback_map_size);
+	}
 
 	for (int i = 0; i < driver->usb_devices_cnt; i++) {
 		vive_device_inst_t *dev = &driver->usb_devices[i];
@@ -601,15 +618,18 @@ void *pcap_thread_fn(void *_driver) {
 
 #define COLORIZED_ID_STR SURVIVE_COLORIZED_FORMAT("%016lx")
 #define COLORIZED_ID SURVIVE_COLORIZED_DATA(usbp->id)
-				char color_set[16] = "";
-
-				unsigned hash = ((usbp->id + (usbp->id >> 8) + (usbp->id >> 16) + (usbp->id >> 24)) & 0xFF) % 8;
-				sprintf(color_set, "\033[0;%dm", (int)(hash + 30));
-				const char *color_reset = "\033[0m";
 				driver->time_now = this_time;
 				if (this_time > driver->run_time && driver->run_time > 0)
 					*driver->keepRunning = false;
 
+				// About half of a capture is submissions and writes that only ever get printed; drop them before
+				// paying for the lock.
+				bool only_printed = usbp->setup_flag && usbp->id != dev->last_config_id &&
+									(!(usbp->endpoint_number & 0x80u) || usbp->status != 0);
+				if (only_printed && !driver->output_usb_stream) {
+					goto continue_loop;
+				}
+
 				survive_get_ctx_lock(ctx);
 				// Print setup flags, then just bail
 				if (!usbp->setup_flag) {
@@ -733,7 +753,7 @@ void *pcap_thread_fn(void *_driver) {
 					// memcpy(si.buffer, (u_char*)&usbp[1], usbp->data);
 
 					si.actual_len = usbp->data_len;
-					memset(si.buffer, 0xCA, sizeof(si.swap_buffer));
+					memset(si.buffer, 0xCA, sizeof(si.swap_buffer[0]));
 					memcpy(si.buffer, pktData, usbp->data_len);
 					uint64_t time = usbp->ts_sec * 1000000 + usbp->ts_usec;
 					survive_data_cb(time, &si);
@@ -774,6 +794,11 @@ void *pcap_thread_fn(void *_driver) {
 
 exit_loop:
 
+	if (driver->fast_playback) {
+		double elapsed = timestamp_in_s() - real_time_start;
+		SV_INFO("Replayed %zu packets covering %.2fs of capture in %.2fs (%.0f packets/s)", driver->packet_cnt,
+				driver->time_now, elapsed, driver->packet_cnt / (elapsed + 1e-9));
+	}
 	SV_VERBOSE(100, "Exiting usbmon thread");
 	return 0;
 }
@@ -802,6 +827,44 @@ static FILE *open_playback(const char *fn, const char *mode) {
 #endif
 }
 
+static FILE *open_playback_fast(SurviveDriverUSBMon *sp, const char *fn) {
+	size_t fn_len = strlen(fn);
+	bool compressed = fn_len >= 3 && strcmp(".gz", fn + fn_len - 3) == 0;
+
+	if (!compressed) {
+		int fd = open(fn, O_RDONLY);
+		struct stat st;
+		if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+			void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			FILE *f = map != MAP_FAILED ? fmemopen(map, st.st_size, "r") : 0;
+			if (f) {
+				madvise(map, st.st_size, MADV_SEQUENTIAL);
+				sp->playback_map = map;
+				sp->playback_map_size = st.st_size;
+				close(fd);
+				return f;
+			}
+			if (map != MAP_FAILED)
+				munmap(map, st.st_size);
+		}
+		if (fd >= 0)
+			close(fd);
+	}
+
+#if defined(HAVE_FOPENCOOKIE)
+	gzFile z = gzopen(fn, "r");
+	if (z == 0)
+		return 0;
+	gzbuffer(z, USBMON_FAST_READ_BUFFER_SIZE);
+	FILE *f = fopencookie(z, "r", gzip_cookie);
+#else
+	FILE *f = fopen(fn, "r");
+#endif
+	if (f)
+		setvbuf(f, 0, _IOFBF, USBMON_FAST_READ_BUFFER_SIZE);
+	return f;
+}
+
 static int DriverRegUSBMon_(SurviveContext *ctx, int driver_id) {
 	int enable = survive_configi(ctx, "usbmon", SC_GET, 0);
 	const char *usbmon_record = usbmon_record_file(ctx);
@@ -824,11 +887,21 @@ static int DriverRegUSBMon_(SurviveContext *ctx, int driver_id) {
 	if (isPlaybackMode) {
 		sp->playback_factor = survive_configf(ctx, "playback-factor", SC_GET, 1.0);
 		sp->run_time = survive_configf(ctx, "run-time", SC_GET, -1);
-
-		SV_INFO("Opening '%s' for usb playback for %4.2f seconds at time factor %f", usbmon_playback, sp->run_time,
-				sp->playback_factor);
-		FILE *pF = open_playback(usbmon_playback, "r");
-		sp->pcap = pcap_fopen_offline(pF, sp->errbuf);
+		sp->fast_playback = survive_configi(ctx, USBMON_PLAYBACK_FAST_TAG, SC_GET, 0);
+
+		FILE *pF = 0;
+		if (sp->fast_playback) {
+			// Time still comes from the capture, so runs are repeatable; there is just no waiting for it
+			sp->playback_factor = 0;
+			SV_INFO("Opening '%s' for usb playback for %4.2f seconds as fast as possible", usbmon_playback,
+					sp->run_time);
+			pF = open_playback_fast(sp, usbmon_playback);
+		} else {
+			SV_INFO("Opening '%s' for usb playback for %4.2f seconds at time factor %f", usbmon_playback,
+					sp->run_time, sp->playback_factor);
+			pF = open_playback(usbmon_playback, "r");
+		}
+		sp->pcap = pF ? pcap_fopen_offline(pF, sp->errbuf) : 0;
 
 #if !defined(HAVE_FOPENCOOKIE)
 		if (strcmp(".gz", usbmon_playback + strlen(usbmon_playback) - 3) == 0) {
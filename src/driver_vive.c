@@ -354,6 +354,9 @@ void survive_dump_buffer(SurviveContext *ctx, const uint8_t *data, size_t length
 	}
 }
 
+// A light data payload holds at most 8 pulses, and VIVE_REPORT_RF_WATCHMANx2 reports carry two payloads
+#define MAX_LIGHTCAPS_PER_PACKET 16
+
 struct SurviveUSBInfo {
 	USBHANDLE handle;
 	SurviveViveData *viveData;
@@ -380,6 +383,11 @@ struct SurviveUSBInfo {
 	size_t timeWithoutFlag;
 	size_t packetsSeenWaitingForV2;
 
+	// Light decoded from the USB packet being processed; handed to the disambiguator in one call once the packet is
+	// done, or earlier if an IMU sample has to go out first
+	LightcapElement pending_lightcaps[MAX_LIGHTCAPS_PER_PACKET];
+	size_t pending_lightcap_cnt;
+
 	size_t active_transfers;
 	FLT nextCfgSubmitTime;
 	void *cfg_user;
@@ -403,6 +411,12 @@ struct SurviveViveData {
 	bool requestPairing;
 #ifndef HIDAPI
 	libusb_hotplug_callback_handle callback_handle;
+	// Set once the devices present at startup are enumerated; hotplug callbacks after that take the context lock
+	bool hotplug_ready;
+
+	int transfers_per_interface;
+	og_thread_t usb_thread;
+	volatile bool usb_thread_running;
 #endif
 };
 
@@ -598,6 +612,14 @@ static int AttachInterface(SurviveViveData *sv, struct SurviveUSBInfo *usbObject
 	iface->hname = hname;
 	iface->cb = cb;
 
+	char labels[128];
+	snprintf(labels, sizeof(labels), "object=\"%s\",interface=\"%s\"", assocobj ? assocobj->codename : "", hname);
+	iface->packets_metric =
+		survive_metric(ctx, SURVIVE_METRIC_COUNTER, "survive_usb_packets_total", "USB packets received", labels);
+	iface->cb_time_violation_metric =
+		survive_metric(ctx, SURVIVE_METRIC_COUNTER, "survive_usb_slow_callbacks_total",
+					   "USB packets that took longer to process than the interval they arrive at", labels);
+
 #ifdef HIDAPI
 	// What do here?
 	iface->uh = usbObject->handle->interfaces[endpoint - usbObject->device_info->endpoints];
@@ -614,27 +636,32 @@ static int AttachInterface(SurviveViveData *sv, struct SurviveUSBInfo *usbObject
 	}
 #endif
 #else
-	struct libusb_transfer *tx = iface->transfer = libusb_alloc_transfer(0);
-	usbObject->active_transfers++;
-
 	// printf( "%p %d %p %p\n", iface, which_interface_am_i, tx, devh );
-	SV_VERBOSE(50, "Attaching %s(0x%x) for %s", hname, endpoint_num,
-			   survive_colorize(assocobj ? assocobj->codename : "(unknown)"));
+	SV_VERBOSE(50, "Attaching %s(0x%x) for %s with %d transfers", hname, endpoint_num,
+			   survive_colorize(assocobj ? assocobj->codename : "(unknown)"), sv->transfers_per_interface);
 
-	if (!iface->transfer) {
-		SV_ERROR(SURVIVE_ERROR_HARWARE_FAULT, "Error: failed on libusb_alloc_transfer for %s", hname);
-		return 4;
-	}
 	memset(iface->swap_buffer, 0xCA, sizeof(iface->swap_buffer));
-	libusb_fill_interrupt_transfer(tx, devh, endpoint_num, iface->swap_buffer[0], INTBUFFSIZE, handle_transfer, iface,
-								   0);
-
+	iface->buffer = iface->swap_buffer[sv->transfers_per_interface];
 	iface->last_submit_time = OGGetAbsoluteTimeUS();
-	int rc = libusb_submit_transfer(tx);
-	if (rc) {
-		SV_ERROR(SURVIVE_ERROR_HARWARE_FAULT, "Error: Could not submit transfer for %s 0x%02x (Code %d, %s)", hname,
-				 endpoint_num, rc, libusb_error_name(rc));
-		return 6;
+
+	for (int i = 0; i < sv->transfers_per_interface; i++) {
+		struct libusb_transfer *tx = libusb_alloc_transfer(0);
+		if (!tx) {
+			SV_ERROR(SURVIVE_ERROR_HARWARE_FAULT, "Error: failed on libusb_alloc_transfer for %s", hname);
+			return 4;
+		}
+		libusb_fill_interrupt_transfer(tx, devh, endpoint_num, iface->swap_buffer[i], INTBUFFSIZE, handle_transfer,
+									   iface, 0);
+
+		int rc = libusb_submit_transfer(tx);
+		if (rc) {
+			libusb_free_transfer(tx);
+			SV_ERROR(SURVIVE_ERROR_HARWARE_FAULT, "Error: Could not submit transfer for %s 0x%02x (Code %d, %s)",
+					 hname, endpoint_num, rc, libusb_error_name(rc));
+			return 6;
+		}
+		iface->transfers[iface->transfer_cnt++] = tx;
+		usbObject->active_transfers++;
 	}
 #endif
 	return 0;
@@ -758,6 +785,8 @@ int survive_usb_init(SurviveViveData *sv) {
 
 STATIC_CONFIG_ITEM(PAIR_DEVICE, "pair-device", 'i', "Turn on pairing mode", 0)
 STATIC_CONFIG_ITEM(SECONDS_PER_HZ_OUTPUT, "usb-hz-output", 'i', "Seconds between outputing usb stats", -1)
+STATIC_CONFIG_ITEM(USB_EVENT_THREAD, "usb-event-thread", 'i', "Handle USB events on their own thread", 1)
+STATIC_CONFIG_ITEM(USB_TRANSFERS, "usb-transfers", 'i', "Interrupt transfers kept in flight per USB interface", 4)
 void survive_vive_usb_close(SurviveViveData *sv) {
 	survive_release_ctx_lock(sv->ctx);
 	survive_usb_close(sv);
@@ -890,6 +919,10 @@ int survive_vive_usb_poll(SurviveContext *ctx, void *v) {
 	return 0;
 #endif
 #else
+	if (sv->usb_thread_running) {
+		return 0;
+	}
+
 	// int r = libusb_handle_events(sv->usbctx);
 	struct timeval tv = {.tv_usec = 10 * 1000};
 	survive_release_ctx_lock(ctx);
@@ -1505,10 +1538,8 @@ static int32_t read_light_data(SurviveObject *w, uint16_t time, uint8_t **readPt
 	size_t timeIndex = 0;
 	uint32_t times[16] = {0};
 	size_t maxTimeIndex = sizeof(times) / sizeof(times[0]);
-	size_t maxEvents = maxTimeIndex >> 1;
-	uint8_t *reportOrder = alloca(sizeof(uint8_t*) * maxTimeIndex);
-
-	struct sensorData* sensors = alloca(sizeof(struct sensorData) * maxEvents);
+	uint8_t reportOrder[16] = {0};
+	struct sensorData sensors[8];
 
 	uint8_t *idsPtr = payloadPtr;
 	uint8_t *eventPtr = payloadEndPtr;
@@ -1587,11 +1618,9 @@ exit_while:
 	}
 
 	// Step 2 - Convert events to pulses
-	LightcapElement* les = alloca(sizeof(LightcapElement) * maxEvents);
+	LightcapElement les[8] = {0};
 	size_t eventCount = (timeIndex + 1) >> 1; // timeIndex>>1 = There are always twice as many time events as sensors
 
-	memset(les, 0, maxEvents * sizeof(LightcapElement));
-	memset(reportOrder, 0, maxTimeIndex * sizeof(uint8_t));
 	timeIndex = -1;
 
 	for (int i = 0; i < eventCount; i++) {
@@ -1631,9 +1660,10 @@ exit_while:
 		// les[i].timestamp, les[i].timestamp + les[i].length, les[i].length, startTimeIndex, timeIndex);
 	}
 
-	// Output the events in ascending time order
+	// Output the events in ascending time order; times are indexed from the end of the packet backwards
 	uint8_t orderedIndex;
-	for (int i = 0; (i < maxTimeIndex) && output_cnt > 0; i++) {
+	int32_t written = 0;
+	for (int i = maxTimeIndex - 1; (i >= 0) && written < output_cnt; i--) {
 		if ((orderedIndex = reportOrder[i]) != 0) {
 			LightcapElement *ol = &les[orderedIndex - 1];
 
@@ -1641,14 +1671,23 @@ exit_while:
 				return -6;
 			}
 
-			*(output++) = *ol;
-			output_cnt--;
+			output[written++] = *ol;
 			SV_VERBOSE(750, "Light Event [Ordered]: %i [%2i] %u -> %u (%4hu)", i, ol->sensor_id, ol->timestamp,
 					   ol->timestamp + ol->length, ol->length);
 		}
 	}
 
-	return eventCount;
+	return written;
+}
+
+static void flush_lightcaps(SurviveObject *w) {
+	struct SurviveUSBInfo *driverInfo = w->driver;
+	if (driverInfo->pending_lightcap_cnt == 0) {
+		return;
+	}
+
+	handle_lightcaps(w, driverInfo->pending_lightcaps, driverInfo->pending_lightcap_cnt);
+	driverInfo->pending_lightcap_cnt = 0;
 }
 
 static bool read_imu_data(SurviveObject *w, uint64_t time_in_us, uint16_t time, uint8_t **readPtr,
@@ -1671,6 +1710,9 @@ static bool read_imu_data(SurviveObject *w, uint64_t time_in_us, uint16_t time,
 
 	FLT agm[9] = {aX, aY, aZ, rX, rY, rZ};
 
+	// Light from earlier in the packet has to reach the disambiguator before this sample does
+	flush_lightcaps(w);
+
 	SV_VERBOSE(750, "%s IMU: %d " Point3_format " " Point3_format " From: %s", w->codename, timeLSB,
 			   LINMATH_VEC3_EXPAND(agm), LINMATH_VEC3_EXPAND(agm + 3), packetToHex(*readPtr, payloadPtr));
 	SURVIVE_INVOKE_HOOK_SO(raw_imu, w, 3, agm, ((uint32_t)time << 16) | (timeLSB << 8), 0);
@@ -1875,14 +1917,21 @@ static bool read_event(SurviveObject *w, uint64_t time_in_us, uint16_t time, uin
 	UPDATE_PTR_AND_RETURN
 }
 
+// Decodes the light data straight onto the end of the pending batch; see flush_lightcaps
 static inline void parse_and_process_lightcap(SurviveObject *w, uint16_t time, uint8_t *payloadPtr,
 											  uint8_t *payloadEndPtr) {
-	LightcapElement les[10] = {0};
+	struct SurviveUSBInfo *driverInfo = w->driver;
+	if (driverInfo->pending_lightcap_cnt + 8 > MAX_LIGHTCAPS_PER_PACKET) {
+		flush_lightcaps(w);
+	}
+
+	LightcapElement *les = driverInfo->pending_lightcaps + driverInfo->pending_lightcap_cnt;
 	uint8_t *payloadPtrStart = payloadPtr;
-	int32_t cnt = read_light_data(w, time, &payloadPtr, payloadEndPtr, les, 10);
+	int32_t cnt = read_light_data(w, time, &payloadPtr, payloadEndPtr, les,
+								  MAX_LIGHTCAPS_PER_PACKET - driverInfo->pending_lightcap_cnt);
 	SurviveContext *ctx = w->ctx;
 #ifndef NDEBUG
-	for (int i = (int)cnt - 1; i >= 0; i--) {
+	for (int i = 0; i < cnt; i++) {
 		uint8_t sensor = survive_map_sensor_id(w, les[i].sensor_id);
 		if (sensor == 255) {
 			cnt = -255;
@@ -1900,19 +1949,20 @@ static inline void parse_and_process_lightcap(SurviveObject *w, uint16_t time, u
 #ifdef VERIFY_LIGHTCAP
 		LightcapElement les_old[10] = {0};
 		int les_old_cnt = parse_watchman_lightcap(w->ctx, w->codename, time >> 8, w->activations.last_imu, payloadPtr,
-												  payloadEndPtr - payloadPtr, les, 10);
+												  payloadEndPtr - payloadPtr, les_old, 10);
 
 		assert(cnt == les_old_cnt);
 #endif
-		for (int i = (int)cnt - 1; i >= 0; i--) {
+		for (int i = 0; i < cnt; i++) {
 #ifdef DEBUG_WATCHMAN
 			printf("%d: %u [%u]\n", les[i].sensor_id, les[i].length, les[i].timestamp);
 #endif
 #ifdef VERIFY_LIGHTCAP
-			assert(memcmp(&les[i], &les_old[i], sizeof(LightcapElement)) == 0);
+			// The old parser outputs the newest pulse first
+			assert(memcmp(&les[i], &les_old[cnt - 1 - i], sizeof(LightcapElement)) == 0);
 #endif
-			handle_lightcap(w, &les[i]);
 		}
+		driverInfo->pending_lightcap_cnt += cnt;
 	}
 }
 
@@ -1923,6 +1973,10 @@ static int parse_and_process_raw1_lightcap(SurviveObject *obj, uint16_t time, ui
 	SurviveContext *ctx = obj->ctx;
 	bool dump_binary = false;
 
+	// Sweeps go out together, but a sync has to be seen before the sweeps that come after it
+	SurviveSweepEvent sweeps[16];
+	size_t sweep_cnt = 0;
+
 	while (idx < length) {
 		uint8_t data = packet[idx];
 
@@ -1976,6 +2030,10 @@ static int parse_and_process_raw1_lightcap(SurviveObject *obj, uint16_t time, ui
 					dump_binary = true;
 					// has_errors = true;
 				} else {
+					if (sweep_cnt > 0) {
+						SURVIVE_INVOKE_HOOK_SO(sweep_batch, obj, sweeps, sweep_cnt);
+						sweep_cnt = 0;
+					}
 					SURVIVE_INVOKE_HOOK_SO(sync, obj, channel, timecode, ootx, g);
 				}
 			} else {
@@ -1995,8 +2053,14 @@ static int parse_and_process_raw1_lightcap(SurviveObject *obj, uint16_t time, ui
 					dump_binary = true;
 					// has_errors = true;
 				} else {
-					SURVIVE_INVOKE_HOOK_SO(sweep, obj, channel, survive_map_sensor_id(obj, sensor), timecode,
-										   half_clock_flag);
+					if (sweep_cnt == sizeof(sweeps) / sizeof(sweeps[0])) {
+						SURVIVE_INVOKE_HOOK_SO(sweep_batch, obj, sweeps, sweep_cnt);
+						sweep_cnt = 0;
+					}
+					sweeps[sweep_cnt++] = (SurviveSweepEvent){.channel = channel,
+															  .sensor_id = survive_map_sensor_id(obj, sensor),
+															  .timecode = timecode,
+															  .half_clock_flag = half_clock_flag};
 				}
 			}
 
@@ -2010,6 +2074,9 @@ static int parse_and_process_raw1_lightcap(SurviveObject *obj, uint16_t time, ui
 	}
 
 exit_loop:
+	if (sweep_cnt > 0) {
+		SURVIVE_INVOKE_HOOK_SO(sweep_batch, obj, sweeps, sweep_cnt);
+	}
 
 	if (dump_binary) {
 		for (int i = 0; i < length; i++) {
@@ -2378,32 +2445,7 @@ static void handle_watchman(SurviveObject *w, uint64_t time_in_us, uint8_t *read
 
 	// Any remaining data after events (if any) have been read off is light data
 	if (payloadPtr < payloadEndPtr) {
-		LightcapElement les[10] = {0};
-		int32_t cnt = read_light_data(w, time, &payloadPtr, payloadEndPtr, les, 10);
-
-		if (cnt < 0) {
-			SV_WARN("Read light data error %d   [Time:%04hX] [Payload: %s]", (int)cnt, time,
-					packetToHex(payloadPtr, payloadEndPtr));
-
-		} else {
-
-#ifdef VERIFY_LIGHTCAP
-			LightcapElement les_old[10] = {0};
-			int les_old_cnt = parse_watchman_lightcap(w->ctx, w->codename, time >> 8, w->activations.last_imu,
-													  payloadPtr, payloadEndPtr - payloadPtr, les, 10);
-
-			assert(cnt == les_old_cnt);
-#endif
-			for (int i = (int)cnt - 1; i >= 0; i--) {
-#ifdef DEBUG_WATCHMAN
-				printf("%d: %u [%u]\n", les[i].sensor_id, les[i].length, les[i].timestamp);
-#endif
-#ifdef VERIFY_LIGHTCAP
-				assert(memcmp(&les[i], &les_old[i], sizeof(LightcapElement)) == 0);
-#endif
-				handle_lightcap(w, &les[i]);
-			}
-		}
+		parse_and_process_lightcap(w, time, payloadPtr, payloadEndPtr);
 	}
 }
 #define DEBUG_WATCHMAN_PRINTF(...)                                                                                     \
@@ -2727,6 +2769,9 @@ void survive_data_cb_locked(uint64_t time_received_us, SurviveUSBInterface *si)
 		return;
 	}
 
+	// Stamped here rather than taken from time_received_us, which is the capture time for usbmon replays
+	obj->latency.data_received_us = OGGetAbsoluteTimeUS();
+
 	if (obj->conf == 0 || (si->usbInfo && si->usbInfo->cfg_user)) {
 		if (si->usbInfo) {
 				//si->usbInfo->tryConfigLoad = 1;
@@ -2768,6 +2813,8 @@ void survive_data_cb_locked(uint64_t time_received_us, SurviveUSBInterface *si)
 	case USB_IF_TRACKER0_IMU:
 	case USB_IF_TRACKER1_IMU: {
 		int i;
+		SurviveImuEvent samples[3];
+		size_t sample_cnt = 0;
 		// printf( "%d -> ", size );
 		for (i = 0; i < 3; i++) {
 			struct unaligned_16_t *acceldata = (struct unaligned_16_t *)readdata;
@@ -2781,22 +2828,21 @@ void survive_data_cb_locked(uint64_t time_received_us, SurviveUSBInterface *si)
 				obj->oldcode = code;
 
 				// XXX XXX BIG TODO!!! Actually recal gyro data.
-				FLT agm[9] = {acceldata[0].v,
-							  acceldata[1].v,
-							  acceldata[2].v,
-							  acceldata[3].v,
-							  acceldata[4].v,
-							  acceldata[5].v,
-							  0,
-							  0,
-							  0};
+				SurviveImuEvent *sample = &samples[sample_cnt++];
+				*sample = (SurviveImuEvent){.mask = 3, .timecode = timecode, .id = code};
+				for (int j = 0; j < 6; j++) {
+					sample->accelgyromag[j] = acceldata[j].v;
+				}
 
 				// assert(timecode <= obj->timebase_hz);
-				SURVIVE_INVOKE_HOOK_SO(raw_imu, obj, 3, agm, timecode, code);
-				SurviveSensorActivations_register_runtime(&obj->activations, obj->activations.last_imu,
-														  time_received_us);
 			}
 		}
+
+		if (sample_cnt > 0) {
+			SURVIVE_INVOKE_HOOK_SO(raw_imu_batch, obj, samples, sample_cnt);
+			SurviveSensorActivations_register_runtime(&obj->activations, obj->activations.last_imu,
+													  time_received_us);
+		}
 		// DONE OK.
 		break;
 	}
@@ -2813,6 +2859,7 @@ void survive_data_cb_locked(uint64_t time_received_us, SurviveUSBInterface *si)
 		} else if (id != 0) {
 			SV_WARN("Unknown watchman code %d", id);
 		}
+		flush_lightcaps(w);
 		break;
 	}
 	case USB_IF_HMD_LIGHTCAP:
@@ -3069,6 +3116,11 @@ void survive_data_cb_locked(uint64_t time_received_us, SurviveUSBInterface *si)
 int survive_vive_close(SurviveContext *ctx, void *driver) {
 	SurviveViveData *sv = driver;
 #ifndef HIDAPI
+	// The rest of the shutdown handles the remaining events itself
+	survive_release_ctx_lock(ctx);
+	survive_usb_stop_event_thread(sv);
+	survive_get_ctx_lock(ctx);
+
 	libusb_hotplug_deregister_callback(sv->usbctx, sv->callback_handle);
 #endif
 	for (int i = 0; i < sv->udev_cnt; i++) {
@@ -3098,6 +3150,10 @@ int DriverRegHTCVive(SurviveContext *ctx) {
 
 	survive_attach_configi(ctx, SECONDS_PER_HZ_OUTPUT_TAG, &sv->seconds_per_hz_output);
 	sv->requestPairing = survive_configi(ctx, PAIR_DEVICE_TAG, SC_GET, 0);
+#ifndef HIDAPI
+	sv->transfers_per_interface = linmath_imax(
+		1, linmath_imin(MAX_TRANSFERS_PER_INTERFACE, survive_configi(ctx, USB_TRANSFERS_TAG, SC_GET, 4)));
+#endif
 
 	if(sv->seconds_per_hz_output > 0) {
 	  SV_INFO("Reporting usb hz in %d second intervals", sv->seconds_per_hz_output);
@@ -3126,6 +3182,11 @@ int DriverRegHTCVive(SurviveContext *ctx) {
 
 	if (sv->udev_cnt || hasHotplug) {
 		survive_add_driver(ctx, sv, survive_vive_usb_poll, survive_vive_close);
+#ifndef HIDAPI
+		if (survive_configi(ctx, USB_EVENT_THREAD_TAG, SC_GET, 1)) {
+			survive_usb_start_event_thread(sv);
+		}
+#endif
 	} else {
 		SV_INFO("No USB devices detected");
 		goto fail_gracefully;
@@ -3145,7 +3206,10 @@ int DriverRegHTCVive(SurviveContext *ctx) {
 */
 #endif
 	// Note: don't sleep for HTCVive, the handle_events call can block
-	ctx->poll_min_time_ms = 0;
+#ifndef HIDAPI
+	if (!sv->usb_thread_running)
+#endif
+		ctx->poll_min_time_ms = 0;
 
 	return 0;
 fail_gracefully:
@@ -20,6 +20,8 @@
 #include "os_generic.h"
 
 #define MAX_USB_DEVS 32
+// Upper bound on the 'usb-transfers' option
+#define MAX_TRANSFERS_PER_INTERFACE 8
 
 enum USB_DEV_t {
 	USB_DEV_HMD = 0,
@@ -87,7 +89,9 @@ typedef struct SurviveUSBInterface {
 	og_thread_t servicethread;
 #endif
 #else
-	struct libusb_transfer *transfer;
+	// Interrupt transfers kept in flight so there is no gap while one of them is being handled
+	struct libusb_transfer *transfers[MAX_TRANSFERS_PER_INTERFACE];
+	size_t transfer_cnt;
 #endif
 	struct SurviveUSBInfo *usbInfo;
 	SurviveObject *assoc_obj;
@@ -95,9 +99,10 @@ typedef struct SurviveUSBInterface {
 #ifdef HIDAPI
 	uint8_t buffer[INTBUFFSIZE];
 #else
+	// One buffer per transfer plus the one 'buffer' points at, which holds the packet being handled. A completed
+	// transfer trades its buffer for that one before it is resubmitted.
 	uint8_t *buffer;
-	uint8_t swap_buffer[2][INTBUFFSIZE];
-	uint8_t swap_buffer_idx;
+	uint8_t swap_buffer[MAX_TRANSFERS_PER_INTERFACE + 1][INTBUFFSIZE];
 #endif
 	usb_callback cb;
 	int which_interface_am_i; // for indexing into uiface
@@ -107,6 +112,7 @@ typedef struct SurviveUSBInterface {
 	uint32_t time_constraint;
 	uint64_t last_submit_time, sum_submit_cb_time, sum_cb_time;
 	uint32_t max_submit_time, max_cb_time, cb_time_violation;
+	struct SurviveMetric *packets_metric, *cb_time_violation_metric;
 	bool shutdown;
 } SurviveUSBInterface;
 
@@ -78,6 +78,11 @@ int libusb_hotplug(libusb_context *usbctx, libusb_device *device, libusb_hotplug
 	SurviveViveData *sv = user_data;
 	SurviveContext *ctx = sv->ctx;
 
+	// Events are handled without the context lock held, but the initial enumeration runs inside of driver startup
+	bool lock = sv->hotplug_ready;
+	if (lock)
+		survive_get_ctx_lock(ctx);
+
 	if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED) {
 		SV_VERBOSE(100, "Device added %p", device);
 		survive_vive_add_usb_device(sv, device);
@@ -85,6 +90,8 @@ int libusb_hotplug(libusb_context *usbctx, libusb_device *device, libusb_hotplug
 		SV_VERBOSE(100, "Device removed %p", device);
 	}
 
+	if (lock)
+		survive_release_ctx_lock(ctx);
 	return 0;
 }
 static bool setup_hotplug(SurviveViveData *sv) {
@@ -98,9 +105,46 @@ static bool setup_hotplug(SurviveViveData *sv) {
 		SV_WARN("Could not register hotplug callback err: %d", rc);
 		return rc;
 	}
+	sv->hotplug_ready = true;
 	return LIBUSB_SUCCESS;
 }
 
+static void *usb_event_thread(void *_sv) {
+	SurviveViveData *sv = _sv;
+	SurviveContext *ctx = sv->ctx;
+
+	while (sv->usb_thread_running) {
+		struct timeval tv = {.tv_usec = 100 * 1000};
+		int r = libusb_handle_events_timeout_completed(sv->usbctx, &tv, 0);
+		if (r && r != LIBUSB_ERROR_INTERRUPTED) {
+			SV_WARN("Libusb event handling failed. %d (%s)", r, libusb_error_name(r));
+			OGUSleep(10000);
+		}
+	}
+	return 0;
+}
+
+/*
+ * Moves libusb event handling -- and so the USB callbacks -- from the poll loop onto its own thread, so that packets
+ * are picked up as soon as they arrive instead of whenever the poll loop gets around to it.
+ */
+static void survive_usb_start_event_thread(SurviveViveData *sv) {
+	SurviveContext *ctx = sv->ctx;
+	sv->usb_thread_running = true;
+	sv->usb_thread = OGCreateThread(usb_event_thread, "usb events", sv);
+	SV_VERBOSE(10, "Handling USB events on their own thread");
+}
+
+// Must be called without the context lock held
+static void survive_usb_stop_event_thread(SurviveViveData *sv) {
+	if (!sv->usb_thread_running)
+		return;
+
+	sv->usb_thread_running = false;
+	OGJoinThread(sv->usb_thread);
+	sv->usb_thread = 0;
+}
+
 static int survive_get_ids(survive_usb_device_t d, uint16_t *idVendor, uint16_t *idProduct, uint8_t *class_id) {
 	struct libusb_device_descriptor desc;
 
@@ -168,12 +212,10 @@ static void survive_disconnect_device(SurviveUSBInterface *iface) {
 	iface->ctx = 0;
 	survive_close_usb_device(iface->usbInfo);
 }
-static void handle_transfer(struct libusb_transfer *transfer) {
-	uint64_t time = OGGetAbsoluteTimeUS();
-
+// Called with the context lock held. Every transfer of an interface ends up here once, whatever stopped it.
+static void handle_transfer_stopped(struct libusb_transfer *transfer) {
 	SurviveUSBInterface *iface = transfer->user_data;
 	SurviveContext *ctx = iface->ctx;
-	bool attemptReconnect = false;
 	if (!iface->shutdown && transfer->status == LIBUSB_TRANSFER_TIMED_OUT) {
 		SV_WARN("%f %s Device turned off: %d", survive_run_time(ctx), survive_colorize_codename(iface->assoc_obj),
 				transfer->status);
@@ -186,14 +228,47 @@ static void handle_transfer(struct libusb_transfer *transfer) {
 		goto disconnect;
 	}
 
-	if (iface->shutdown) {
-		goto shutdown;
+	goto shutdown;
+
+object_turned_off:
+	iface->usbInfo->request_reopen = true;
+disconnect:
+	survive_disconnect_device(iface);
+shutdown:
+	ctx = iface->sv->ctx;
+	for (size_t i = 0; i < iface->transfer_cnt; i++) {
+		if (iface->transfers[i] == transfer)
+			iface->transfers[i] = iface->transfers[--iface->transfer_cnt];
 	}
+	libusb_free_transfer(transfer);
 
-	iface->actual_len = transfer->actual_length;
-	iface->buffer = iface->swap_buffer[iface->swap_buffer_idx++ % 2];
+	// Each transfer of the interface comes through here on its own; the last one out releases it
+	if (iface->transfer_cnt == 0) {
+		SV_VERBOSE(200, "Cleaning up transfers on %d %s", iface->which_interface_am_i, survive_colorize(iface->hname));
+		iface->ctx = 0;
+		libusb_release_interface(iface->usbInfo->handle, iface->which_interface_am_i);
+	}
+
+	iface->usbInfo->active_transfers--;
+	if (iface->usbInfo->active_transfers == 0) {
+		iface->usbInfo->request_close = true;
+		SV_VERBOSE(100, "Requesting close for %s", survive_colorize_codename(iface->assoc_obj));
+	}
+}
 
-	transfer->buffer = iface->swap_buffer[iface->swap_buffer_idx % 2];
+static void handle_transfer(struct libusb_transfer *transfer) {
+	uint64_t time = OGGetAbsoluteTimeUS();
+
+	SurviveUSBInterface *iface = transfer->user_data;
+	if (iface->shutdown || transfer->status != LIBUSB_TRANSFER_COMPLETED) {
+		goto stopped;
+	}
+
+	// Callbacks for an interface never overlap, so the buffer of the previous packet is free to receive into again
+	iface->actual_len = transfer->actual_length;
+	uint8_t *received = transfer->buffer;
+	transfer->buffer = iface->buffer;
+	iface->buffer = received;
 
 	uint64_t submit_cb_time = OGGetAbsoluteTimeUS() - iface->last_submit_time;
 
@@ -202,42 +277,36 @@ static void handle_transfer(struct libusb_transfer *transfer) {
 	// If we get at least one packet; start applying a timeout
 	// transfer->timeout = 1000;
 	if (libusb_submit_transfer(transfer)) {
-		goto shutdown;
+		goto stopped;
 	}
 
 	if (iface->max_submit_time < submit_cb_time)
 		iface->max_submit_time = submit_cb_time;
 	uint64_t cb_start = OGGetAbsoluteTimeUS();
 	iface->sum_submit_cb_time += submit_cb_time;
+	SV_TRACE_BEGIN("usb callback");
 	iface->cb(time, iface);
+	SV_TRACE_END("usb callback");
 	uint64_t cb_end = OGGetAbsoluteTimeUS();
 	uint64_t cb_time = cb_end - cb_start;
 	if (iface->max_cb_time < cb_time)
 		iface->max_cb_time = cb_time;
-	if (iface->time_constraint && cb_time > iface->time_constraint)
+	if (iface->time_constraint && cb_time > iface->time_constraint) {
 		iface->cb_time_violation++;
+		survive_metric_add(iface->cb_time_violation_metric, 1);
+	}
 
 	iface->sum_cb_time += cb_time;
 	iface->packet_count++;
+	survive_metric_add(iface->packets_metric, 1);
 
 	return;
-object_turned_off:
-	iface->usbInfo->request_reopen = true;
-disconnect:
-	survive_disconnect_device(iface);
-shutdown:
-	SV_VERBOSE(200, "Cleaning up transfer on %d %s", iface->which_interface_am_i, survive_colorize(iface->hname));
-	iface->ctx = 0;
-
-	libusb_release_interface(iface->usbInfo->handle, iface->which_interface_am_i);
-	libusb_free_transfer(iface->transfer);
-	iface->transfer = 0;
-
-	iface->usbInfo->active_transfers--;
-	if (iface->usbInfo->active_transfers == 0) {
-		iface->usbInfo->request_close = true;
-		SV_VERBOSE(100, "Requesting close for %s", survive_colorize_codename(iface->assoc_obj));
-	}
+stopped:
+	// Data callbacks lock for themselves; tearing an interface down touches the device, its transfers and its object,
+	// all of which the poll loop uses too, so that always happens under the context lock
+	survive_get_ctx_lock(iface->sv->ctx);
+	handle_transfer_stopped(transfer);
+	survive_release_ctx_lock(iface->sv->ctx);
 }
 
 struct survive_config_packet {
@@ -296,11 +365,11 @@ static inline void survive_close_usb_device(struct SurviveUSBInfo *usbInfo) {
 	}
 	for (int j = 0; j < usbInfo->interface_cnt; j++) {
 		SurviveUSBInterface *iface = &usbInfo->interfaces[j];
-		SV_VERBOSE(100, "Cleaning up interface on %d %s %s (%p)", iface->which_interface_am_i,
-				   survive_colorize_codename(iface->usbInfo->so), survive_colorize(iface->hname),
-				   usbInfo->interfaces[j].transfer);
-		if (usbInfo->interfaces[j].transfer)
-			libusb_cancel_transfer(usbInfo->interfaces[j].transfer);
+		SV_VERBOSE(100, "Cleaning up interface on %d %s %s (%zu transfers)", iface->which_interface_am_i,
+				   survive_colorize_codename(iface->usbInfo->so), survive_colorize(iface->hname), iface->transfer_cnt);
+		for (size_t k = 0; k < iface->transfer_cnt; k++) {
+			libusb_cancel_transfer(iface->transfers[k]);
+		}
 	}
 
 }
@@ -356,10 +425,20 @@ static inline void setup_packet_state(struct survive_config_packet *packet) {
 	}
 	libusb_fill_control_transfer(packet->tx, packet->usbInfo->handle, packet->buffer, handle_config_tx, packet, 1000);
 }
+static void handle_config_tx_locked(struct libusb_transfer *transfer);
 void handle_config_tx(struct libusb_transfer *transfer) {
 	struct survive_config_packet *packet = transfer->user_data;
 	SurviveContext *ctx = packet->ctx;
 
+	// This creates and configures objects, so it can't race the poll loop
+	survive_get_ctx_lock(ctx);
+	handle_config_tx_locked(transfer);
+	survive_release_ctx_lock(ctx);
+}
+static void handle_config_tx_locked(struct libusb_transfer *transfer) {
+	struct survive_config_packet *packet = transfer->user_data;
+	SurviveContext *ctx = packet->ctx;
+
 	SurviveObject *so = packet->usbInfo->so;
 	uint8_t cmd = transfer->buffer[8];
 
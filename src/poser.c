@@ -337,7 +337,9 @@ SURVIVE_EXPORT FLT survive_adjust_confidence(SurviveObject *so, FLT delta) {
 
 void survive_poser_invoke(SurviveObject *so, PoserData *poserData, size_t poserDataSize) {
 	if (so->ctx->PoserFn) {
+		SV_TRACE_BEGIN_SO("poser", so);
 		so->ctx->PoserFn(so, &so->PoserFnData, poserData);
+		SV_TRACE_END("poser");
 	}
 }
 
@@ -368,7 +370,9 @@ void *survive_threaded_poser_thread_fn(void *_poser) {
 			OGUnlockMutex(self->data_available_lock);
 
 			survive_get_ctx_lock(self->so->ctx);
+			SV_TRACE_BEGIN_SO("threaded poser", so);
 			self->innerPoser(so, &self->innerPoserData, &self->PoserData.pd);
+			SV_TRACE_END("threaded poser");
 			survive_release_ctx_lock(self->so->ctx);
 			self->run_count++;
 
@@ -11,62 +11,86 @@
 
 #pragma GCC diagnostic ignored "-Wpedantic"
 
-typedef struct {
+typedef struct PoserDataSVD {
 	SurviveObject *so;
 	uint32_t required_meas;
 
 	FLT max_error_obj;
 	FLT max_error_cal;
 
+	// Control points and barycentric coordinates only depend on the object's sensor locations, so they are set up once
+	// here and every solver below shares them. 'model_locations' notes which locations they were made for.
 	bc_svd bc;
+	const FLT *model_locations;
+	size_t model_sensor_ct;
+
+	// One solver per lighthouse so that their correspondences can be gathered up front and solved concurrently
+	bc_svd lh_bc[NUM_GEN2_LIGHTHOUSES];
+	SurvivePose lh_solution[NUM_GEN2_LIGHTHOUSES];
 } PoserDataSVD;
 
-static void survive_fill_m(void *user, FLT *eq, int axis, FLT angle) {
-	SurviveObject *so = user;
-
-	FLT sv = sin(angle), cv = cos(angle);
-	switch (so->ctx->lh_version) {
-	case 0: {
-		switch (axis) {
-		case 0:
-			eq[0] = cv;
-			eq[1] = 0;
-			eq[2] = -sv;
-			break;
-		case 1:
-			eq[0] = 0;
-			eq[1] = cv;
-			eq[2] = -sv;
-			break;
-		}
+static void PoserDataSVD_free_model(PoserDataSVD *dd) {
+	if (dd->model_locations == 0)
+		return;
 
-	} break;
-	case 1: {
-		FLT tan30 = 0.57735026919;
-		switch (axis) {
-		case 0:
-			eq[0] = cv;
-			eq[1] = -tan30;
-			eq[2] = -sv;
-			break;
-		case 1:
-			eq[0] = cv;
-			eq[1] = tan30;
-			eq[2] = -sv;
-			break;
-		}
-	} break;
-	case 3: {
-		eq[0] = eq[1] = eq[2] = 0;
-		break;
-	}
-	default:
-		assert(false);
+	for (int lh = 0; lh < NUM_GEN2_LIGHTHOUSES; lh++) {
+		if (dd->lh_bc[lh].setup.alphas)
+			bc_svd_dtor(&dd->lh_bc[lh]);
+		dd->lh_bc[lh] = (bc_svd){0};
 	}
+	bc_svd_dtor(&dd->bc);
+	dd->bc = (bc_svd){0};
+	dd->model_locations = 0;
+}
+
+// Sets up the shared model if it isn't already, or if the sensor locations were reloaded since it was
+static void PoserDataSVD_update_model(PoserDataSVD *dd) {
+	SurviveObject *so = dd->so;
+	if (dd->model_locations == so->sensor_locations && dd->model_sensor_ct == so->sensor_ct)
+		return;
+
+	PoserDataSVD_free_model(dd);
+	bc_svd_bc_svd(&dd->bc, so, bc_svd_survive_fill_m, (LinmathPoint3d *)so->sensor_locations, so->sensor_ct);
+	dd->model_locations = so->sensor_locations;
+	dd->model_sensor_ct = so->sensor_ct;
+}
+
+static bc_svd *PoserDataSVD_lh_bc(PoserDataSVD *dd, int lh) {
+	bc_svd *bc = &dd->lh_bc[lh];
+	if (bc->setup.alphas == 0)
+		bc_svd_bc_svd_shared(bc, &dd->bc);
+	return bc;
+}
+
+static SurvivePose solve_correspondence(PoserDataSVD *dd, bc_svd *bc, bool cameraToWorld);
+
+// A batch of per lighthouse solves handed to the context's thread pool
+struct solve_lighthouses_batch {
+	PoserDataSVD *dd;
+	const int *lhs;
+	bool cameraToWorld;
+};
+
+static void solve_lighthouse(void *arg, int i) {
+	struct solve_lighthouses_batch *batch = arg;
+	PoserDataSVD *dd = batch->dd;
+	int lh = batch->lhs[i];
+	dd->lh_solution[lh] = solve_correspondence(dd, &dd->lh_bc[lh], batch->cameraToWorld);
+}
+
+/*
+ * Solves each of the given lighthouses' solvers into lh_solution. The solves are independent -- their correspondences
+ * are already gathered and the model is only read -- so they are split across the context's worker threads, if it has
+ * any, and the calling thread.
+ */
+static void solve_lighthouses(PoserDataSVD *dd, const int *lhs, int lh_cnt, bool cameraToWorld) {
+	struct solve_lighthouses_batch batch = {.dd = dd, .lhs = lhs, .cameraToWorld = cameraToWorld};
+	survive_thread_pool_parallel_for(lh_cnt < 2 ? 0 : survive_get_thread_pool(dd->so->ctx), lh_cnt, solve_lighthouse,
+									 &batch);
 }
 
 static void PoserDataSVD_destroy(PoserDataSVD *dd) {
-	bc_svd_dtor(&dd->bc);
+	PoserDataSVD_free_model(dd);
 	survive_detach_config(dd->so->ctx, "max-error", &dd->max_error_obj);
 	survive_detach_config(dd->so->ctx, "max-cal-error", &dd->max_error_cal);
 	free(dd);
@@ -80,24 +104,22 @@ static PoserDataSVD *PoserDataSVD_new(SurviveObject *so) {
 	survive_attach_configf(so->ctx, "max-error", &rtn->max_error_obj);
 	survive_attach_configf(so->ctx, "max-cal-error", &rtn->max_error_cal);
 
-	bc_svd_bc_svd(&rtn->bc, so, survive_fill_m, (LinmathPoint3d *)so->sensor_locations, so->sensor_ct);
-
 	return rtn;
 }
 
-static SurvivePose solve_correspondence(PoserDataSVD *dd, bool cameraToWorld) {
+static SurvivePose solve_correspondence(PoserDataSVD *dd, bc_svd *bc, bool cameraToWorld) {
 	SurviveObject *so = dd->so;
 	SurvivePose rtn = {0};
 	SurviveContext *ctx = so->ctx;
 	// std::cerr << "Solving for " << cal_imagePoints.size() << " correspondents" << std::endl;
-	if (dd->bc.meas_cnt < 2) {
-		SV_WARN("Can't solve for only %u points", (int)dd->bc.meas_cnt);
+	if (bc->meas_cnt < 2) {
+		SV_WARN("Can't solve for only %u points", (int)bc->meas_cnt);
 		return rtn;
 	}
 
 	FLT r[3][3];
 
-	FLT err = bc_svd_compute_pose(&dd->bc, r, rtn.Pos);
+	FLT err = bc_svd_compute_pose(bc, r, rtn.Pos);
 	if (err < 0) {
 		return rtn;
 	}
@@ -109,7 +131,7 @@ static SurvivePose solve_correspondence(PoserDataSVD *dd, bool cameraToWorld) {
 
 	// Super degenerate inputs will project us basically right in the camera. Detect and reject
 	if (err > 1 || magnitude3d(rtn.Pos) < 0.25 || magnitude3d(rtn.Pos) > 25) {
-		SV_VERBOSE(200, "pose is degenerate %d %f %f", (int)dd->bc.meas_cnt, err, magnitude3d(rtn.Pos));
+		SV_VERBOSE(200, "pose is degenerate %d %f %f", (int)bc->meas_cnt, err, magnitude3d(rtn.Pos));
 		return rtn;
 	}
 
@@ -119,7 +141,7 @@ static SurvivePose solve_correspondence(PoserDataSVD *dd, bool cameraToWorld) {
 	FLT allowable_error = (cameraToWorld ? (dd->max_error_cal) : dd->max_error_obj) * 100.0;
 	if (allowable_error < err) {
 		if (cameraToWorld) {
-			SV_WARN("Camera reprojection error was too high: %f for %d meas", err, (int)dd->bc.meas_cnt);
+			SV_WARN("Camera reprojection error was too high: %f for %d meas", err, (int)bc->meas_cnt);
 		}
 		goto cleanup;
 	}
@@ -190,6 +212,7 @@ void solve_global_scene(struct SurviveObject *so, PoserDataSVD *dd, PoserDataGlo
 	struct PoserDataGlobalScene *scene = gss->scenes;
 
 	bool needsObject = quatiszero(scene->pose.Rot);
+	PoserDataSVD_update_model(dd);
 
 	for (int lh = 0; lh < ctx->activeLighthouses; lh++) {
 
@@ -201,7 +224,7 @@ void solve_global_scene(struct SurviveObject *so, PoserDataSVD *dd, PoserDataGlo
 		if (!needsObject && !needsLH)
 			continue;
 
-		bc_svd *bc = &dd->bc;
+		bc_svd *bc = PoserDataSVD_lh_bc(dd, lh);
 		bc_svd_reset_correspondences(bc);
 
 		const BaseStationCal *cal = ctx->bsd[lh].fcal;
@@ -211,8 +234,8 @@ void solve_global_scene(struct SurviveObject *so, PoserDataSVD *dd, PoserDataGlo
 												 scene->meas[m].value + cal[scene->meas[m].axis].phase);
 		}
 
-		if (dd->bc.meas_cnt >= dd->required_meas) {
-			SurvivePose lh2obj = solve_correspondence(dd, true);
+		if (bc->meas_cnt >= dd->required_meas) {
+			SurvivePose lh2obj = solve_correspondence(dd, bc, true);
 			if (quatmagnitude(lh2obj.Rot) != 0) {
 				if (needsLH) {
 					SurvivePose obj2world = scene->pose;
@@ -260,6 +283,7 @@ int PoserBaryCentricSVD(SurviveObject *so, void **user, PoserData *pd) {
 
 		PoserDataLight *lightData = (PoserDataLight *)pd;
 		SurviveContext *ctx = so->ctx;
+		PoserDataSVD_update_model(dd);
 
 		SurvivePose obj2world = { 0 };
 		bool allowSolveLH = !lightData->no_lighthouse_solve;
@@ -269,26 +293,34 @@ int PoserBaryCentricSVD(SurviveObject *so, void **user, PoserData *pd) {
 			int meas[NUM_GEN2_LIGHTHOUSES] = {0};
 			bool hasLighthousePoses = false;
 			bool hasUnsolvedLighthousePoses = false;
+
+			int lhs[NUM_GEN2_LIGHTHOUSES];
+			int lh_cnt = 0;
 			for (int lh = 0; lh < so->ctx->activeLighthouses; lh++) {
 				if (so->ctx->bsd[lh].PositionSet) {
 					hasLighthousePoses = true;
-					add_correspondences(so, &dd->bc, lightData->hdr.timecode, lh);
+					bc_svd *bc = PoserDataSVD_lh_bc(dd, lh);
+					add_correspondences(so, bc, lightData->hdr.timecode, lh);
 
-					if (dd->bc.meas_cnt >= dd->required_meas) {
+					if (bc->meas_cnt >= dd->required_meas)
+						lhs[lh_cnt++] = lh;
+				} else {
+					hasUnsolvedLighthousePoses = true;
+				}
+			}
 
-						survive_release_ctx_lock(so->ctx);
-						SurvivePose obj2Lh = solve_correspondence(dd, false);
-						survive_get_ctx_lock(so->ctx);
+			survive_release_ctx_lock(so->ctx);
+			solve_lighthouses(dd, lhs, lh_cnt, false);
+			survive_get_ctx_lock(so->ctx);
 
-						if (quatmagnitude(obj2Lh.Rot) != 0) {
-							SurvivePose *lh2world = &so->ctx->bsd[lh].Pose;
+			for (int i = 0; i < lh_cnt; i++) {
+				int lh = lhs[i];
+				SurvivePose *obj2Lh = &dd->lh_solution[lh];
+				if (quatmagnitude(obj2Lh->Rot) != 0) {
+					SurvivePose *lh2world = &so->ctx->bsd[lh].Pose;
 
-							ApplyPoseToPose(&objs2world[lh], lh2world, &obj2Lh);
-							meas[lh] = dd->bc.meas_cnt;
-						}
-					}
-				} else {
-					hasUnsolvedLighthousePoses = true;
+					ApplyPoseToPose(&objs2world[lh], lh2world, obj2Lh);
+					meas[lh] = dd->lh_bc[lh].meas_cnt;
 				}
 			}
 
@@ -320,48 +352,58 @@ int PoserBaryCentricSVD(SurviveObject *so, void **user, PoserData *pd) {
 		if (allowSolveLH && SurviveSensorActivations_stationary_time(&so->activations) > so->timebase_hz) {
 			SurvivePose lh2world[NUM_GEN2_LIGHTHOUSES] = { 0 };
 			int solved = 0;
+
+			int lhs[NUM_GEN2_LIGHTHOUSES];
+			int lh_cnt = 0;
 			for (int lh = 0; lh < ctx->activeLighthouses; lh++) {
 				if (!so->ctx->bsd[lh].PositionSet && so->ctx->bsd[lh].OOTXSet) {
-					add_correspondences(so, &dd->bc, lightData->hdr.timecode, lh);
-
-					if (dd->bc.meas_cnt >= dd->required_meas) {
-						SurvivePose lh2obj = solve_correspondence(dd, true);
-						if (quatmagnitude(lh2obj.Rot) != 0) {
-							LinmathPoint3d up = {ctx->bsd[lh].accel[0], ctx->bsd[lh].accel[1], ctx->bsd[lh].accel[2]};
-							FLT err = 0;
-
-							// Some older replays don't have the accel
-							if (norm3d(up) > 0) {
-								normalize3d(up, up);
-								LinmathPoint3d lhUpInObj;
-								quatrotatevector(lhUpInObj, lh2obj.Rot, up);
-
-								LinmathPoint3d objUp;
-								normalize3d(objUp, so->activations.accel);
-
-								LinmathQuat err_q;
-								quatfind_between_vectors(err_q, objUp, lhUpInObj);
-								err = 1. - err_q[0];
-							}
-
-							if (err < .25) {
-								solved++;
-								if (quatiszero(obj2world.Rot))
-									lh2world[lh] = lh2obj;
-								else
-									ApplyPoseToPose(&lh2world[lh], &obj2world, &lh2obj);
-
-								SV_VERBOSE(
-									10,
-									"Possible SVD solution for lighthouse %d, from object %s at " SurvivePose_format
-									"; accel error is %6.5f",
-									lh, so->codename, SURVIVE_POSE_EXPAND(lh2world[lh]), err);
-							} else {
-								SV_VERBOSE(5, "Discarding SVD solution; up vectors seemed wrong %f", err);
-							}
-						}
+					bc_svd *bc = PoserDataSVD_lh_bc(dd, lh);
+					add_correspondences(so, bc, lightData->hdr.timecode, lh);
+
+					if (bc->meas_cnt >= dd->required_meas) {
+						lhs[lh_cnt++] = lh;
+					} else {
+						SV_WARN("Couldn't solve for LH %d with %d measures", lh, (int)bc->meas_cnt);
+					}
+				}
+			}
+
+			solve_lighthouses(dd, lhs, lh_cnt, true);
+
+			for (int i = 0; i < lh_cnt; i++) {
+				int lh = lhs[i];
+				SurvivePose lh2obj = dd->lh_solution[lh];
+				if (quatmagnitude(lh2obj.Rot) != 0) {
+					LinmathPoint3d up = {ctx->bsd[lh].accel[0], ctx->bsd[lh].accel[1], ctx->bsd[lh].accel[2]};
+					FLT err = 0;
+
+					// Some older replays don't have the accel
+					if (norm3d(up) > 0) {
+						normalize3d(up, up);
+						LinmathPoint3d lhUpInObj;
+						quatrotatevector(lhUpInObj, lh2obj.Rot, up);
+
+						LinmathPoint3d objUp;
+						normalize3d(objUp, so->activations.accel);
+
+						LinmathQuat err_q;
+						quatfind_between_vectors(err_q, objUp, lhUpInObj);
+						err = 1. - err_q[0];
+					}
+
+					if (err < .25) {
+						solved++;
+						if (quatiszero(obj2world.Rot))
+							lh2world[lh] = lh2obj;
+						else
+							ApplyPoseToPose(&lh2world[lh], &obj2world, &lh2obj);
+
+						SV_VERBOSE(10,
+								   "Possible SVD solution for lighthouse %d, from object %s at " SurvivePose_format
+								   "; accel error is %6.5f",
+								   lh, so->codename, SURVIVE_POSE_EXPAND(lh2world[lh]), err);
 					} else {
-						SV_WARN("Couldn't solve for LH %d with %d measures", lh, (int)dd->bc.meas_cnt);
+						SV_VERBOSE(5, "Discarding SVD solution; up vectors seemed wrong %f", err);
 					}
 				}
 			}
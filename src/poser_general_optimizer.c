@@ -1,6 +1,8 @@
 #include "poser_general_optimizer.h"
 #include "string.h"
 #include "survive_internal.h"
+#include "survive_kalman_tracker.h"
+#include "survive_reproject.h"
 
 #include <assert.h>
 #if !defined(__FreeBSD__) && !defined(__APPLE__)
@@ -22,6 +24,15 @@ STATIC_CONFIG_ITEM(CONFIG_TIME_WINDOW, "time-window", 'i',
 				   "The length, in ticks, between sensor inputs to treat them as one snapshot",
 				   (int)SurviveSensorActivations_default_tolerance * 2)
 
+STATIC_CONFIG_ITEM(CONFIG_SEED_CACHE_TIME, "seed-cache-time", 'f',
+				   "Seconds a good pose is tried as a seed, ahead of the seed poser, after tracking drops out. Set to 0 "
+				   "to always use the seed poser.",
+				   .5)
+STATIC_CONFIG_ITEM(CONFIG_SEED_CACHE_MAX_ERROR, "seed-cache-max-error", 'f',
+				   "Mean reprojection error, in radians, a cached pose can have against the current light and still be "
+				   "used as the seed.",
+				   .01)
+
 void general_optimizer_data_init(GeneralOptimizerData *d, SurviveObject *so) {
 	memset(d, 0, sizeof(*d));
 	d->so = so;
@@ -31,6 +42,10 @@ void general_optimizer_data_init(GeneralOptimizerData *d, SurviveObject *so) {
 	survive_attach_configf( ctx, "max-error", &d->max_error );
 	survive_attach_configi( ctx, "failures-to-reset", &d->failures_to_reset );
 	survive_attach_configi( ctx, "successes-to-reset", &d->successes_to_reset );
+	survive_attach_configf(ctx, "seed-cache-time", &d->seed_cache_time);
+	survive_attach_configf(ctx, "seed-cache-max-error", &d->seed_cache_max_error);
+	survive_attach_configi(ctx, "time-window", &d->time_window);
+	survive_attach_configi(ctx, "required-meas", &d->required_meas);
 
 	const char *subposer = survive_configs(ctx, "seed-poser", SC_GET, "BaryCentricSVD");
 	d->seed_poser = (PoserCB)GetDriverWithPrefix("Poser", subposer);
@@ -40,6 +55,7 @@ void general_optimizer_data_init(GeneralOptimizerData *d, SurviveObject *so) {
 	SV_VERBOSE(100, "\tsuccesses-to-reset: %d", d->successes_to_reset);
 	SV_VERBOSE(100, "\tfailures-to-reset: %d", d->failures_to_reset);
 	SV_VERBOSE(100, "\tseed-poser: %s", subposer);
+	SV_VERBOSE(100, "\tseed-cache-time: %f", d->seed_cache_time);
 }
 void general_optimizer_data_record_failure(GeneralOptimizerData *d) {
 	d->stats.error_failures++;
@@ -52,8 +68,10 @@ bool general_optimizer_data_record_success(GeneralOptimizerData *d, FLT error, c
 	if (d->max_error <= 0 || d->max_error > error) {
 		if (d->successes_to_reset_cntr > 0)
 			d->successes_to_reset_cntr--;
-		if (pose)
+		if (pose) {
 			d->lastSuccess = *pose;
+			d->lastSuccessTime = d->so->activations.last_light;
+		}
 		d->failures_to_reset_cntr = d->failures_to_reset;
 		d->failures_since_success = 0;
 		d->stats.successes++;
@@ -118,13 +136,94 @@ bool general_optimizer_data_record_current_lhs(GeneralOptimizerData *d, PoserDat
 	}
 	return false;
 }
+// Mean reprojection error of the pose against the light in the current snapshot, or -1 if there isn't enough light
+static FLT seed_cache_error(GeneralOptimizerData *d, const SurvivePose *obj2world) {
+	SurviveObject *so = d->so;
+	SurviveContext *ctx = so->ctx;
+	const survive_reproject_model_t *model = survive_reproject_model(ctx);
+
+	FLT error = 0;
+	size_t meas_cnt = 0;
+	for (int lh = 0; lh < ctx->activeLighthouses; lh++) {
+		if (!ctx->bsd[lh].PositionSet)
+			continue;
+
+		SurvivePose world2lh = InvertPoseRtn(&ctx->bsd[lh].Pose);
+		for (int sensor = 0; sensor < so->sensor_ct; sensor++) {
+			for (int axis = 0; axis < 2; axis++) {
+				if (!SurviveSensorActivations_is_reading_valid(&so->activations, d->time_window, sensor, lh, axis))
+					continue;
+
+				FLT angle = model->reprojectAxisFullFn[axis](obj2world, so->sensor_locations + sensor * 3, &world2lh,
+															 ctx->bsd[lh].fcal);
+				error += fabs(angle - so->activations.angles[sensor][lh][axis]);
+				meas_cnt++;
+			}
+		}
+	}
+
+	return meas_cnt < d->required_meas ? -1 : error / meas_cnt;
+}
+
+/*
+ * After a short drop out -- an occlusion, or a few bad solves in a row -- the object is usually close to where it was.
+ * Rather than throw that away and run the seed poser, try the tracker's prediction and then the last good pose, and
+ * take the first that agrees with the light we have now.
+ */
+static bool seed_from_cache(GeneralOptimizerData *d, PoserDataLight *l, SurvivePose *soLocation) {
+	SurviveObject *so = d->so;
+	SurviveContext *ctx = so->ctx;
+	if (d->seed_cache_time <= 0 || d->seed_cache_max_error <= 0 || so->sensor_locations == 0)
+		return false;
+
+	SurvivePose candidates[2];
+	size_t candidate_cnt = 0;
+
+	// The tracker coasts through drop outs on the IMU, so as long as it is as sure of itself as it needs to be to take
+	// raw light, its prediction is closer than where the object was last seen. It is reset when tracking is lost.
+	SurviveKalmanTracker *tracker = so->tracker;
+	if (tracker && tracker->model.t != 0) {
+		FLT var_diag[7];
+		for (int i = 0; i < 7; i++)
+			var_diag[i] = svMatrixGet(&tracker->model.P, i, i);
+
+		if (tracker->light_threshold_var <= 0 || normnd2(var_diag, 7) <= tracker->light_threshold_var) {
+			FLT t = l->hdr.timecode / (FLT)so->timebase_hz;
+			survive_kalman_tracker_predict(tracker, t < tracker->model.t ? tracker->model.t : t,
+										   &candidates[candidate_cnt++]);
+		}
+	}
+
+	FLT age = ((FLT)l->hdr.timecode - (FLT)d->lastSuccessTime) / so->timebase_hz;
+	if (!quatiszero(d->lastSuccess.Rot) && age <= d->seed_cache_time)
+		candidates[candidate_cnt++] = d->lastSuccess;
+
+	for (size_t i = 0; i < candidate_cnt; i++) {
+		FLT error = seed_cache_error(d, &candidates[i]);
+		SV_VERBOSE(200, "Seed cache candidate %d for %s has error %f", (int)i, survive_colorize_codename(so), error);
+		if (error >= 0 && error < d->seed_cache_max_error) {
+			*soLocation = candidates[i];
+			return true;
+		}
+	}
+	return false;
+}
+
 bool general_optimizer_data_record_current_pose(GeneralOptimizerData *d, PoserDataLight *l, SurvivePose *soLocation) {
 	*soLocation = *survive_object_last_imu2world(d->so);
 	bool currentPositionValid = quatmagnitude(soLocation->Rot) != 0;
 	SurviveContext *ctx = d->so->ctx;
 
 	static bool seed_warning = false;
-	if (d->successes_to_reset_cntr == 0 || d->failures_to_reset_cntr == 0 || currentPositionValid == 0) {
+	bool periodicReset = d->successes_to_reset_cntr == 0;
+	if (periodicReset || d->failures_to_reset_cntr == 0 || currentPositionValid == 0) {
+		// Periodic resets are there to get an independent solution, so those always go to the seed poser
+		if (!periodicReset && seed_from_cache(d, l, soLocation)) {
+			d->stats.seed_cache_hits++;
+			d->failures_to_reset_cntr = d->failures_to_reset;
+			return true;
+		}
+
 		PoserCB driver = d->seed_poser;
 		if (driver) {
 			size_t len_hdr = PoserData_size(&l->hdr);
@@ -172,6 +271,10 @@ void general_optimizer_data_dtor(GeneralOptimizerData *d) {
 	survive_detach_config(ctx, "max-error", &d->max_error);
 	survive_detach_config(ctx, "failures-to-reset", &d->failures_to_reset);
 	survive_detach_config(ctx, "successes-to-reset", &d->successes_to_reset);
+	survive_detach_config(ctx, "seed-cache-time", &d->seed_cache_time);
+	survive_detach_config(ctx, "seed-cache-max-error", &d->seed_cache_max_error);
+	survive_detach_config(ctx, "time-window", &d->time_window);
+	survive_detach_config(ctx, "required-meas", &d->required_meas);
 
 	if (d->seed_poser) {
 		PoserData pd;
@@ -180,5 +283,6 @@ void general_optimizer_data_dtor(GeneralOptimizerData *d) {
 		d->seed_poser(d->so, &d->seed_poser_data, &pd);
 	}
 	SV_INFO("\tseed runs         %d / %d", d->stats.poser_seed_runs, d->stats.runs);
+	SV_INFO("\tseed cache hits   %d", d->stats.seed_cache_hits);
 	SV_INFO("\terror failures    %d", d->stats.error_failures);
 }
@@ -13,6 +13,7 @@ typedef struct GeneralOptimizerData {
 	struct {
 		int runs;
 		int poser_seed_runs;
+		int seed_cache_hits;
 		int32_t successes;
 		int error_failures;
 	} stats;
@@ -22,6 +23,12 @@ typedef struct GeneralOptimizerData {
 	SurviveObject *so;
 
 	SurvivePose lastSuccess;
+	survive_long_timecode lastSuccessTime;
+
+	FLT seed_cache_time;
+	FLT seed_cache_max_error;
+	int time_window;
+	int required_meas;
 } GeneralOptimizerData;
 
 SURVIVE_EXPORT void general_optimizer_data_init(GeneralOptimizerData *d, SurviveObject *so);
@@ -29,6 +29,8 @@
 #endif
 
 STATIC_CONFIG_ITEM(SERIALIZE_SOLVE, "serialize-lh-mpfit", 's', "Serialize MPFIT formulization", 0)
+STATIC_CONFIG_ITEM(SERIALIZE_SOLVE_PERIOD, "serialize-lh-mpfit-period", 'i',
+				   "Only serialize every Nth MPFIT formulization", 1)
 STATIC_CONFIG_ITEM(USE_JACOBIAN_FUNCTION, "use-jacobian-function", 'i',
 				   "If set to false, a slower numerical approximation of the jacobian is used", 1)
 STATIC_CONFIG_ITEM(SENSOR_VARIANCE_PER_SEC, "sensor-variance-per-sec", 'f',
@@ -58,6 +60,10 @@ typedef struct MPFITStats {
 	uint32_t total_lh_cnt;
 	uint32_t dropped_meas_cnt;
 	uint32_t dropped_lh_cnt;
+
+	uint32_t weighted_meas_cnt;
+	uint32_t downweighted_meas_cnt;
+	FLT weight_sum;
 } MPFITStats;
 
 typedef struct MPFITGlobalData {
@@ -89,12 +95,20 @@ typedef struct MPFITData {
 
   bool useStationaryWindow;
   const char *serialize_prefix;
+  int serialize_period;
+  bool serialized_config;
   MPFITStats stats;
+  struct {
+    SurviveMetric *runs, *status_failures, *error_failures, *meas_failures;
+    SurviveMetric *iterations, *fevs, *measurements, *dropped_measurements, *downweighted_measurements;
+    SurviveMetric *solve_seconds;
+  } metrics;
 
   int record_reprojection_error;
   FLT current_bias;
   bool globalDataAvailable;
   struct survive_async_optimizer *async_optimizer;
+  struct survive_optimizer_ransac *ransac;
 } MPFITData;
 
 STRUCT_CONFIG_SECTION(MPFITData)
@@ -233,6 +247,7 @@ static bool invalid_starting_condition(MPFITData *d, size_t meas_size, const siz
 		}
 		if (meas_size_known_lh < d->required_meas || axis_known_lh < 2) {
 			d->stats.meas_failures++;
+			survive_metric_add(d->metrics.meas_failures, 1);
 		}
 		return true;
 	}
@@ -240,8 +255,38 @@ static bool invalid_starting_condition(MPFITData *d, size_t meas_size, const siz
 	return false;
 }
 
+/*
+ * Serialized problems need the device config to be loaded again, so the first time a problem is written for an object
+ * its config goes next to it as '<codename>_config.json', which is where survive_optimizer_load looks for it.
+ */
+static void serialize_mpfit_config(MPFITData *d) {
+	SurviveObject *so = d->opt.so;
+	SurviveContext *ctx = so->ctx;
+	d->serialized_config = true;
+	if (so->conf == 0)
+		return;
+
+	const char *slash = strrchr(d->serialize_prefix, '/');
+	int dir_len = slash ? (int)(slash - d->serialize_prefix + 1) : 0;
+	char path[512] = {0};
+	snprintf(path, sizeof(path), "%.*s%s_config.json", dir_len, d->serialize_prefix, so->codename);
+
+	FILE *f = fopen(path, "w");
+	if (f == 0) {
+		SV_WARN("Could not write device config to %s", path);
+		return;
+	}
+	fwrite(so->conf, so->conf_cnt, 1, f);
+	fclose(f);
+}
+
 static inline void serialize_mpfit(MPFITData *d, survive_optimizer *mpfitctx) {
 	if (d->serialize_prefix) {
+		if (d->serialize_period > 1 && d->stats.total_runs % d->serialize_period != 0)
+			return;
+		if (!d->serialized_config)
+			serialize_mpfit_config(d);
+
 		char path[1024] = {0};
 		snprintf(path, 1023, "%s_%s_%d.opt", d->serialize_prefix, d->opt.so->codename, d->stats.total_runs);
 		survive_optimizer_serialize(mpfitctx, path);
@@ -431,6 +476,11 @@ static int setup_optimizer(struct async_optimizer_user *user, survive_optimizer
 
 	mpfitctx->measurementsCnt = meas_size;
 
+	// Reflections otherwise get in as measurements that pull every iteration off until the filter catches them
+	if (worldEstablished && !canPossiblySolveLHS && d->ransac) {
+		survive_optimizer_ransac_run(d->ransac, mpfitctx);
+	}
+
 	/*
 	if ((d->useKalman || d->useIMU)) {
 		survive_long_timecode tc = so->activations.last_light;
@@ -477,8 +527,16 @@ static FLT handle_optimizer_results(survive_optimizer *mpfitctx, int res, const
 	FLT meas_f = mpfitctx->measurementsCnt;
 	SV_DATA_LOG("mpfit_measurement_cnt", &meas_f, 1);
 
+	survive_metric_add(d->metrics.runs, 1);
+	survive_metric_add(d->metrics.iterations, result->niter);
+	survive_metric_add(d->metrics.fevs, result->nfev);
+	survive_metric_add(d->metrics.measurements, mpfitctx->stats.total_meas_cnt);
+	survive_metric_add(d->metrics.dropped_measurements, mpfitctx->stats.dropped_meas_cnt);
+	survive_metric_add(d->metrics.downweighted_measurements, mpfitctx->stats.downweighted_meas_cnt);
+
 	bool status_failure = res <= 0;
 	if (status_failure) {
+		survive_metric_add(d->metrics.status_failures, 1);
 		SV_WARN("MPFIT status failure %s %f/%f (%d measurements, %d)", survive_colorize(so->codename), result->orignorm,
 				result->bestnorm, (int)meas_size, res);
 
@@ -487,6 +545,8 @@ static FLT handle_optimizer_results(survive_optimizer *mpfitctx, int res, const
 	}
 
 	bool error_failure = !general_optimizer_data_record_success(&d->opt, result->bestnorm, soLocation);
+	if (error_failure)
+		survive_metric_add(d->metrics.error_failures, 1);
 	if (!status_failure && !error_failure) {
 		quatnormalize(soLocation->Rot, soLocation->Rot);
 
@@ -578,6 +638,9 @@ static FLT handle_optimizer_results(survive_optimizer *mpfitctx, int res, const
 	d->stats.dropped_lh_cnt += mpfitctx->stats.dropped_lh_cnt;
 	d->stats.total_meas_cnt += mpfitctx->stats.total_meas_cnt;
 	d->stats.total_lh_cnt += mpfitctx->stats.total_lh_cnt;
+	d->stats.weighted_meas_cnt += mpfitctx->stats.weighted_meas_cnt;
+	d->stats.downweighted_meas_cnt += mpfitctx->stats.downweighted_meas_cnt;
+	d->stats.weight_sum += mpfitctx->stats.weight_sum;
 	d->stats.total_fev += result->nfev;
 	d->stats.total_iterations += result->niter;
 	d->stats.total_runs++;
@@ -635,12 +698,44 @@ static FLT run_mpfit_find_3d_structure(MPFITData *d, PoserDataLight *pdl, Surviv
 	mp_result result = {0};
 
 	survive_release_ctx_lock(ctx);
+	uint64_t start_us = OGGetAbsoluteTimeUS();
 	int res = survive_optimizer_run(&mpfitctx, &result);
+	survive_metric_observe(d->metrics.solve_seconds, (OGGetAbsoluteTimeUS() - start_us) * 1e-6);
 	survive_get_ctx_lock(ctx);
 
 	return handle_optimizer_results(&mpfitctx, res, &result, &user_data, out);
 }
 
+static void init_metrics(MPFITData *d) {
+	SurviveObject *so = d->opt.so;
+	d->metrics.runs = survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_mpfit_runs_total", "MPFIT solves");
+	d->metrics.iterations =
+		survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_mpfit_iterations_total", "MPFIT solver iterations");
+	d->metrics.fevs = survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_mpfit_function_evaluations_total",
+											"MPFIT residual function evaluations");
+	d->metrics.measurements = survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_mpfit_measurements_total",
+													"Measurements given to MPFIT solves");
+	d->metrics.dropped_measurements =
+		survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_mpfit_dropped_measurements_total",
+							  "Measurements dropped from MPFIT solves as too noisy");
+	d->metrics.downweighted_measurements =
+		survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_mpfit_downweighted_measurements_total",
+							  "Measurements past the robust loss scale at the end of MPFIT solves");
+	d->metrics.meas_failures = survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_mpfit_meas_failures_total",
+													 "MPFIT solves skipped for lack of measurements");
+	d->metrics.solve_seconds =
+		survive_object_metric(so, SURVIVE_METRIC_HISTOGRAM, "survive_mpfit_solve_seconds", "Time spent in MPFIT solves");
+
+	const char *failures_help = "MPFIT solves that failed to converge or whose result was rejected";
+	char labels[64];
+	snprintf(labels, sizeof(labels), "object=\"%s\",reason=\"status\"", so->codename);
+	d->metrics.status_failures =
+		survive_metric(so->ctx, SURVIVE_METRIC_COUNTER, "survive_mpfit_failures_total", failures_help, labels);
+	snprintf(labels, sizeof(labels), "object=\"%s\",reason=\"error\"", so->codename);
+	d->metrics.error_failures =
+		survive_metric(so->ctx, SURVIVE_METRIC_COUNTER, "survive_mpfit_failures_total", failures_help, labels);
+}
+
 static inline void print_stats(SurviveContext *ctx, MPFITStats *stats) {
 	// if (stats->total_iterations == 0)
 	//		return;
@@ -664,6 +759,11 @@ static inline void print_stats(SurviveContext *ctx, MPFITStats *stats) {
 		SV_INFO("\tdropped lh cnt    %7d / %8d (%4.2f%%)", stats->dropped_lh_cnt, stats->total_lh_cnt,
 				100. * (stats->dropped_lh_cnt / (FLT)stats->total_lh_cnt));
 
+	if (stats->weighted_meas_cnt)
+		SV_INFO("\tdownweighted cnt  %7d / %8d (%4.2f%%, avg weight %f)", stats->downweighted_meas_cnt,
+				stats->weighted_meas_cnt, 100. * (stats->downweighted_meas_cnt / (FLT)stats->weighted_meas_cnt),
+				stats->weight_sum / stats->weighted_meas_cnt);
+
 	for (int i = 0; i < sizeof(stats->status_cnts) / sizeof(int); i++) {
 		SV_INFO("\tStatus %10s %d", survive_optimizer_error(i + 1), stats->status_cnts[i]);
 	}
@@ -951,6 +1051,7 @@ int PoserMPFIT(SurviveObject *so, void **user, PoserData *pd) {
 		MPFITData *d = *user;
 
 		general_optimizer_data_init(&d->opt, so);
+		init_metrics(d);
 
 		d->alwaysPrecise = (bool)survive_configi(ctx, "precise", SC_GET, 0);
 		d->useStationaryWindow = (bool)survive_configi(ctx, USE_STATIONARY_SENSOR_WINDOW_TAG, SC_GET, 1);
@@ -967,6 +1068,7 @@ int PoserMPFIT(SurviveObject *so, void **user, PoserData *pd) {
 					"all to debug.");
 		}
 		d->serialize_prefix = survive_configs(ctx, "serialize-lh-mpfit", SC_GET, 0);
+		d->serialize_period = survive_configi(ctx, "serialize-lh-mpfit-period", SC_GET, 1);
 		survive_attach_configi(ctx, "disable-lighthouse", &d->disable_lighthouse);
 		survive_attach_configf(ctx, "sensor-variance-per-sec", &d->sensor_variance_per_second);
 		survive_attach_configf(ctx, "sensor-variance", &d->sensor_variance);
@@ -975,6 +1077,8 @@ int PoserMPFIT(SurviveObject *so, void **user, PoserData *pd) {
 		feenableexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW);
 #endif
 		MPFITData_attach_config(ctx, d);
+		if (survive_configi(ctx, "optimizer-ransac-hypotheses", SC_GET, 0) > 0)
+			d->ransac = survive_optimizer_ransac_create(so);
 		SV_VERBOSE(110, "Initializing MPFIT:");
 		SV_VERBOSE(110, "\trequired-meas: %d", d->required_meas);
 		SV_VERBOSE(110, "\ttime-window: %d", d->sensor_time_window);
@@ -1025,6 +1129,9 @@ int PoserMPFIT(SurviveObject *so, void **user, PoserData *pd) {
 		g.stats.dropped_lh_cnt += d->stats.dropped_lh_cnt;
 		g.stats.total_meas_cnt += d->stats.total_meas_cnt;
 		g.stats.dropped_meas_cnt += d->stats.dropped_meas_cnt;
+		g.stats.weighted_meas_cnt += d->stats.weighted_meas_cnt;
+		g.stats.downweighted_meas_cnt += d->stats.downweighted_meas_cnt;
+		g.stats.weight_sum += d->stats.weight_sum;
 		g.stats.total_fev += d->stats.total_fev;
 		g.stats.total_runs += d->stats.total_runs;
 		g.stats.sum_errors += d->stats.sum_errors;
@@ -1048,6 +1155,7 @@ int PoserMPFIT(SurviveObject *so, void **user, PoserData *pd) {
 		survive_detach_config(ctx, "sensor-variance-per-sec", &d->sensor_variance_per_second);
 		survive_detach_config(ctx, "sensor-variance", &d->sensor_variance);
 		survive_async_free(d->async_optimizer);
+		survive_optimizer_ransac_free(d->ransac);
 		*user = 0;
 		free(d);
 		return 0;
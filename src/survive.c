@@ -42,6 +42,8 @@ STATIC_CONFIG_ITEM(LIGHTHOUSE_GEN, "lighthouse-gen", 'i',
 				   "Which lighthouse gen to use -- 1 for LH1, 2 for LH2, 0 (default) for auto-detect", 0)
 STATIC_CONFIG_ITEM(OUTPUT_CALLBACK_STATS, "output-callback-stats", 'f',
 				   "Print cb stats every given number of seconds. 0 disables this output.", 0.);
+STATIC_CONFIG_ITEM(OUTPUT_LATENCY_STATS, "output-latency-stats", 'f',
+				   "Print pose latency stats every given number of seconds. 0 disables this output.", 0.);
 STATIC_CONFIG_ITEM(THREADED_POSERS, "threaded-posers", 'i', "Whether or not to run each poser in their own thread.", 0)
 
 const char *survive_config_file_name(struct SurviveContext *ctx) {
@@ -249,6 +251,11 @@ struct SurviveContext_private {
 
 	double callbackStatsTimeBetween;
 	double lastCallbackStats;
+
+	double latencyStatsTimeBetween;
+	double lastLatencyStats;
+
+	struct survive_thread_pool *thread_pool;
 };
 
 void survive_get_ctx_lock(SurviveContext *ctx) {
@@ -264,6 +271,18 @@ void survive_release_ctx_lock(SurviveContext *ctx) {
 	// SV_VERBOSE(100, "Signaled on %lx", pthread_self());
 }
 
+struct survive_thread_pool *survive_get_thread_pool(SurviveContext *ctx) {
+	struct SurviveContext_private *pctx = ctx->private_members;
+	return pctx->thread_pool;
+}
+
+struct survive_thread_pool *survive_install_thread_pool(SurviveContext *ctx, struct survive_thread_pool *pool) {
+	struct SurviveContext_private *pctx = ctx->private_members;
+	struct survive_thread_pool *prior = pctx->thread_pool;
+	pctx->thread_pool = pool;
+	return prior;
+}
+
 static inline bool find_correct_config_file(struct SurviveContext *ctx, const char **config_prefix_fields) {
 	for (const char **name = config_prefix_fields; *name; name++) {
 		if (survive_config_is_set(ctx, *name)) {
@@ -312,6 +331,7 @@ SurviveContext *survive_init_internal(int argc, char *const *argv, void *userDat
 	struct SurviveContext_private *pctx = ctx->private_members = SV_CALLOC(sizeof(struct SurviveContext_private));
 
 	pctx->poll_sema = OGCreateSema();
+	ctx->metrics = survive_metrics_create();
 
 	for (int i = 0; i < NUM_GEN2_LIGHTHOUSES; i++) {
 		ctx->bsd[i].mode = -1;
@@ -446,6 +466,17 @@ SurviveContext *survive_init_internal(int argc, char *const *argv, void *userDat
 		config_save(ctx);
 	}
 
+	const char *trace_path = survive_configs(ctx, "trace", SC_GET, 0);
+	if (trace_path && *trace_path) {
+		if (survive_trace_start(survive_configi(ctx, "trace-buffer-size", SC_GET, 1 << 16))) {
+			SV_INFO("Tracing to %s", trace_path);
+		} else {
+			SV_WARN("Tracing is already running; not tracing to %s", trace_path);
+		}
+	}
+
+	pctx->thread_pool = survive_thread_pool_create(ctx, -1);
+
 	ctx->lh_version = -1;
 	ctx->lh_version_configed = survive_configi(ctx, "configed-lighthouse-gen", SC_GET, 0) - 1;
 	ctx->lh_version_forced = survive_configi(ctx, "lighthouse-gen", SC_GET, 0) - 1;
@@ -453,6 +484,7 @@ SurviveContext *survive_init_internal(int argc, char *const *argv, void *userDat
 	ctx->activeLighthouses = 0;
 
 	pctx->callbackStatsTimeBetween = survive_configf(ctx, "output-callback-stats", SC_GET, 0.0);
+	pctx->latencyStatsTimeBetween = survive_configf(ctx, "output-latency-stats", SC_GET, 0.0);
 
 	for (int i = 0; i < NUM_GEN2_LIGHTHOUSES; i++) {
 		if (config_read_lighthouse(ctx->lh_config, &(ctx->bsd[i]), i)) {
@@ -531,6 +563,19 @@ survive_timecode survive_timecode_difference(survive_timecode most_recent, survi
 	return diff;
 }
 
+// Disambiguators can register a 'LightcapBatch<name>' variant that takes all the pulses of a packet at once
+static lightcap_batch_process_func find_lightcap_batch_fn(lightcap_process_func disambiguator) {
+	const char *DriverName;
+	for (int i = 0; disambiguator && (DriverName = GetDriverNameMatching("Disambiguator", i)); i++) {
+		if (GetDriver(DriverName) == (survive_driver_fn)disambiguator) {
+			char batch_name[256];
+			snprintf(batch_name, sizeof(batch_name), "LightcapBatch%s", DriverName + strlen("Disambiguator"));
+			return (lightcap_batch_process_func)GetDriver(batch_name);
+		}
+	}
+	return 0;
+}
+
 survive_driver_fn GetDriverByConfig(SurviveContext *ctx, const char *name, const char *configname,
 									const char *configdef) {
 	const char *Preferred = survive_configs(ctx, configname, SC_SETCONFIG, configdef);
@@ -592,6 +637,9 @@ int survive_startup(SurviveContext *ctx) {
 
 	PoserCB PreferredPoserCB = (PoserCB)GetDriverByConfig(ctx, "Poser", "poser", "MPFIT");
 	ctx->lightcapproc = GetDriverByConfig(ctx, "Disambiguator", "disambiguator", "StateBased");
+	lightcap_batch_process_func lightcap_batch = find_lightcap_batch_fn(ctx->lightcapproc);
+	if (lightcap_batch)
+		ctx->lightcap_batchproc = lightcap_batch;
 
 	const char *DriverName;
 
@@ -880,6 +928,19 @@ int survive_haptic(SurviveObject *so, FLT freq, FLT amp, FLT duration) {
 	return so->haptic(so, freq, amp, duration);
 }
 
+static void survive_output_latency_stats(SurviveContext *ctx) {
+	for (int i = 0; i < ctx->objs_ct; i++) {
+		const SurviveObject *so = ctx->objs[i];
+		if (so->latency.sample_cnt == 0)
+			continue;
+
+		SV_INFO("%s pose latency p50: %.3fms p90: %.3fms p99: %.3fms max: %.3fms (%lu poses)",
+				survive_colorize_codename(so), survive_object_latency_percentile(so, 50) / 1000.,
+				survive_object_latency_percentile(so, 90) / 1000., survive_object_latency_percentile(so, 99) / 1000.,
+				so->latency.max_us / 1000., (unsigned long)so->latency.sample_cnt);
+	}
+}
+
 void survive_output_callback_stats(SurviveContext *ctx) {
 	SV_VERBOSE(10, "Callback statistics:");
 #define SURVIVE_HOOK_PROCESS_DEF(hook)                                                                                 \
@@ -932,6 +993,11 @@ void survive_close(SurviveContext *ctx) {
 	}
 	ctx->PoserFn = 0;
 
+	struct SurviveContext_private *pctx = ctx->private_members;
+	if (pctx->latencyStatsTimeBetween != 0. || ctx->log_level >= 10) {
+		survive_output_latency_stats(ctx);
+	}
+
 	config_save(ctx);
 
 	while (ctx->objs_ct) {
@@ -946,6 +1012,18 @@ void survive_close(SurviveContext *ctx) {
 		ctx->bsd[i].tracker = 0;
 	}
 
+	// Written once the devices and drivers are gone, so no thread is still adding to it
+	const char *trace_path = survive_configs(ctx, "trace", SC_GET, 0);
+	if (trace_path && *trace_path && survive_trace_running()) {
+		int cnt = survive_trace_export(trace_path);
+		if (cnt < 0) {
+			SV_WARN("Could not write trace to %s", trace_path);
+		} else {
+			SV_INFO("Wrote %d trace events to %s", cnt, trace_path);
+		}
+		survive_trace_stop();
+	}
+
 	survive_output_callback_stats(ctx);
 
 	survive_destroy_recording(ctx);
@@ -962,7 +1040,7 @@ void survive_close(SurviveContext *ctx) {
 		destroy_config_group(ctx->lh_config + lh);
 	}
 
-	struct SurviveContext_private *pctx = ctx->private_members;
+	survive_thread_pool_free(pctx->thread_pool);
 	OGDeleteSema(pctx->poll_sema);
 	free(pctx);
 
@@ -974,6 +1052,7 @@ void survive_close(SurviveContext *ctx) {
 	free(ctx->temporary_config_values);
 	free(ctx->lh_config);
 	free(ctx->recptr);
+	survive_metrics_free(ctx->metrics);
 
 	free(ctx);
 }
@@ -1023,6 +1102,13 @@ int survive_poll(struct SurviveContext *ctx) {
 			pctx->lastCallbackStats = now;
 		}
 	}
+	if (pctx->latencyStatsTimeBetween != 0.) {
+		FLT now = OGRelativeTime();
+		if (pctx->lastLatencyStats + pctx->latencyStatsTimeBetween < now) {
+			survive_output_latency_stats(ctx);
+			pctx->lastLatencyStats = now;
+		}
+	}
 	survive_get_ctx_lock(ctx);
 
 	return 0;
@@ -1100,6 +1186,44 @@ bool survive_object_charging(SurviveObject *so) { return so->charging; }
 
 const SurvivePose *survive_object_pose(SurviveObject *so) { return &so->OutPose; }
 
+void survive_object_record_latency(SurviveObject *so) {
+	SurviveObjectLatency *latency = &so->latency;
+	if (latency->data_received_us == 0)
+		return;
+
+	uint64_t now = OGGetAbsoluteTimeUS();
+	uint32_t age = now > latency->data_received_us ? (uint32_t)(now - latency->data_received_us) : 0;
+	if (latency->samples_us == 0)
+		latency->samples_us = SV_CALLOC(sizeof(uint32_t) * SURVIVE_LATENCY_SAMPLES);
+	latency->samples_us[latency->sample_cnt++ % SURVIVE_LATENCY_SAMPLES] = age;
+	if (age > latency->max_us)
+		latency->max_us = age;
+
+	if (latency->metric == 0) {
+		latency->metric = survive_object_metric(so, SURVIVE_METRIC_HISTOGRAM, "survive_pose_latency_seconds",
+												"Time from receiving light or IMU data to publishing its pose");
+	}
+	survive_metric_observe(latency->metric, age * 1e-6);
+}
+
+static int compare_uint32(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+FLT survive_object_latency_percentile(const SurviveObject *so, FLT percentile) {
+	size_t cnt = so->latency.sample_cnt < SURVIVE_LATENCY_SAMPLES ? so->latency.sample_cnt : SURVIVE_LATENCY_SAMPLES;
+	if (cnt == 0)
+		return -1;
+
+	uint32_t sorted[SURVIVE_LATENCY_SAMPLES];
+	memcpy(sorted, so->latency.samples_us, sizeof(uint32_t) * cnt);
+	qsort(sorted, cnt, sizeof(uint32_t), compare_uint32);
+
+	percentile = percentile < 0 ? 0 : (percentile > 100 ? 100 : percentile);
+	return sorted[(size_t)(percentile / 100. * (cnt - 1) + .5)];
+}
+
 int8_t survive_object_sensor_ct(SurviveObject *so) { return so->sensor_ct; }
 const FLT *survive_object_sensor_locations(SurviveObject *so) { return so->sensor_locations; }
 const FLT *survive_object_sensor_normals(SurviveObject *so) { return so->sensor_normals; }
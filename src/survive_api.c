@@ -454,6 +454,17 @@ FLT survive_simple_object_get_latest_pose(const SurviveSimpleObject *sao, Surviv
 	return timecode;
 }
 
+FLT survive_simple_object_get_latency(const SurviveSimpleObject *sao, FLT percentile) {
+	const SurviveObject *so = survive_simple_get_survive_object(sao);
+	if (so == 0)
+		return -1;
+
+	OGLockMutex(sao->actx->poll_mutex);
+	FLT latency_us = survive_object_latency_percentile(so, percentile);
+	OGUnlockMutex(sao->actx->poll_mutex);
+	return latency_us < 0 ? -1 : latency_us * 1e-6;
+}
+
 SURVIVE_EXPORT bool survive_simple_object_charging(const SurviveSimpleObject *sao) {
 	switch (sao->type) {
 	case SurviveSimpleObject_LIGHTHOUSE: {
@@ -403,9 +403,9 @@ int survive_load_htc_config_format(SurviveObject *so, char *ct0conf, int len) {
 		if (scratch.sensor_scale != 0.0) {
 			scale3d(&so->sensor_locations[i * 3], &so->sensor_locations[i * 3], scratch.sensor_scale);
 		}
-		ApplyPoseToPoint(&so->sensor_locations[i * 3], &trackref2imu, &so->sensor_locations[i * 3]);
-		quatrotatevector(&so->sensor_normals[i * 3], trackref2imu.Rot, &so->sensor_normals[i * 3]);
 	}
+	ApplyPoseToPoints(so->sensor_locations, &trackref2imu, so->sensor_locations, so->sensor_ct);
+	quatrotatevectors(so->sensor_normals, trackref2imu.Rot, so->sensor_normals, so->sensor_ct);
 
 	so->has_sensor_locations = !sensorsAreZero;
 
@@ -659,5 +659,6 @@ void survive_destroy_device(SurviveObject *so) {
 	free(so->sensor_normals);
 	free(so->conf);
 	free(so->channel_map);
+	free(so->latency.samples_us);
 	free(so);
 }
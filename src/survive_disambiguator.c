@@ -92,3 +92,35 @@ bool handle_lightcap(SurviveObject *so, const LightcapElement *_le) {
 
 	return true;
 }
+
+size_t handle_lightcaps(SurviveObject *so, const LightcapElement *les, size_t cnt) {
+	SurviveContext *ctx = so->ctx;
+	size_t handled = 0;
+
+	// Until the lighthouse version is known pulses only feed the detection; that can change partway through a batch
+	size_t i = 0;
+	for (; i < cnt && ctx->lh_version == -1; i++) {
+		handle_lightcap(so, &les[i]);
+	}
+
+	LightcapElement mapped[32];
+	while (i < cnt) {
+		size_t mapped_cnt = 0;
+		for (; i < cnt && mapped_cnt < sizeof(mapped) / sizeof(mapped[0]); i++) {
+			LightcapElement le = les[i];
+			survive_recording_lightcap(so, &le);
+
+			le.sensor_id = survive_map_sensor_id(so, le.sensor_id);
+			if (le.sensor_id != (uint8_t)-1) {
+				mapped[mapped_cnt++] = le;
+			}
+		}
+
+		if (mapped_cnt > 0) {
+			SURVIVE_INVOKE_HOOK_SO(lightcap_batch, so, mapped, mapped_cnt);
+		}
+		handled += mapped_cnt;
+	}
+
+	return handled;
+}
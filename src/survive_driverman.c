@@ -12,6 +12,10 @@ static const char *DriverNames[MAX_DRIVERS];
 static int NrDrivers;
 
 void RegisterDriver(const char *element, survive_driver_fn data) {
+	if (NrDrivers >= MAX_DRIVERS) {
+		fprintf(stderr, "Could not register %s; too many drivers (%d)\n", element, MAX_DRIVERS);
+		return;
+	}
 	Drivers[NrDrivers] = data;
 	DriverNames[NrDrivers] = element;
 	NrDrivers++;
@@ -2,6 +2,7 @@
 #ifdef NOZLIB
 #define gzFile FILE *
 #define gzopen fopen
+#define gzdopen fdopen
 #define gzprintf fprintf
 #define gzclose fclose
 #define gzvprintf vfprintf
@@ -10,6 +11,9 @@
 #define gzeof feof
 #define gzseek fseek
 #define gzgetc fgetc
+#define gzgets(file, buf, len) fgets(buf, len, file)
+#define gzread(file, buf, len) fread(buf, 1, len, file)
+#define gzrewind rewind
 #else
 #include <zlib.h>
 static inline int gzerror_dropin(gzFile f) {
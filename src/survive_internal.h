@@ -11,7 +11,7 @@
 
 
 //Driver registration
-#define MAX_DRIVERS 32
+#define MAX_DRIVERS 128
 
 SURVIVE_EXPORT const char *survive_config_file_name(struct SurviveContext *ctx);
 SURVIVE_EXPORT const char *survive_config_file_path(struct SurviveContext *ctx, char *path);
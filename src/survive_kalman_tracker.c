@@ -243,12 +243,13 @@ void survive_kalman_tracker_integrate_saved_light(SurviveKalmanTracker *tracker,
 		SV_DATA_LOG("res_error_light_", &rtn, 1);
 		SV_DATA_LOG("res_error_light_avg", &tracker->light_residuals_all, 1);
 		tracker->stats.lightcap_count++;
+		survive_metric_add(tracker->metrics.light, 1);
 
 		survive_kalman_tracker_report_state(pd, tracker);
 	}
 }
 
-void survive_kalman_tracker_integrate_light(SurviveKalmanTracker *tracker, PoserDataLight *data) {
+static void integrate_light(SurviveKalmanTracker *tracker, PoserDataLight *data) {
 	survive_kalman_lighthouse_integrate_light(tracker->so->ctx->bsd[data->lh].tracker, tracker->so, data);
 
 	bool isSync = data->hdr.pt == POSERDATA_SYNC || data->hdr.pt == POSERDATA_SYNC_GEN2;
@@ -274,6 +275,12 @@ void survive_kalman_tracker_integrate_light(SurviveKalmanTracker *tracker, Poser
 	}
 }
 
+void survive_kalman_tracker_integrate_light(SurviveKalmanTracker *tracker, PoserDataLight *data) {
+	SV_TRACE_BEGIN_SO("kalman light", tracker->so);
+	integrate_light(tracker, data);
+	SV_TRACE_END("kalman light");
+}
+
 struct map_imu_data_ctx {
 	bool use_gyro, use_accel;
 	SurviveKalmanTracker *tracker;
@@ -346,7 +353,7 @@ static void tracker_datalog(survive_kalman_state_t* state, const char *desc, con
 	SV_DATA_LOG("%s_%s", v, length, desc, tracker->datalog_tag);
 }
 
-void survive_kalman_tracker_integrate_imu(SurviveKalmanTracker *tracker, PoserDataIMU *data) {
+static void integrate_imu(SurviveKalmanTracker *tracker, PoserDataIMU *data) {
 	SurviveContext *ctx = tracker->so->ctx;
 	SurviveObject *so = tracker->so;
 
@@ -398,6 +405,7 @@ void survive_kalman_tracker_integrate_imu(SurviveKalmanTracker *tracker, PoserDa
 	if (time_diff < -.01) {
 		// SV_WARN("Processing imu data from the past %fs", time - tracker->rot.t);
 		tracker->stats.late_imu_dropped++;
+		survive_metric_add(tracker->metrics.late_imu_dropped, 1);
 		return;
 	}
 
@@ -478,6 +486,7 @@ void survive_kalman_tracker_integrate_imu(SurviveKalmanTracker *tracker, PoserDa
 		tracker->imu_residuals += .1 * err;
 
 		tracker->stats.imu_count++;
+		survive_metric_add(tracker->metrics.imu, 1);
 		if (tracker->first_imu_time == 0) {
 		  tracker->first_imu_time = time;
 		}
@@ -491,6 +500,12 @@ void survive_kalman_tracker_integrate_imu(SurviveKalmanTracker *tracker, PoserDa
 	survive_kalman_tracker_report_state(&data->hdr, tracker);
 }
 
+void survive_kalman_tracker_integrate_imu(SurviveKalmanTracker *tracker, PoserDataIMU *data) {
+	SV_TRACE_BEGIN_SO("kalman imu", tracker->so);
+	integrate_imu(tracker, data);
+	SV_TRACE_END("kalman imu");
+}
+
 void survive_kalman_tracker_predict(const SurviveKalmanTracker *tracker, FLT t, SurvivePose *out) {
 	// if (tracker->model.info.P[0] > 100 || tracker->model.info.P[0] > 100 || tracker->model.t == 0)
 	//	return;
@@ -658,8 +673,8 @@ static FLT integrate_pose(SurviveKalmanTracker *tracker, FLT time, const Survive
 	return rtn;
 }
 
-void survive_kalman_tracker_integrate_observation(PoserData *pd, SurviveKalmanTracker *tracker, const SurvivePose *pose,
-												  const FLT *oR) {
+static void integrate_observation(PoserData *pd, SurviveKalmanTracker *tracker, const SurvivePose *pose,
+								  const FLT *oR) {
 	SurviveObject *so = tracker->so;
 	SurviveContext *ctx = so->ctx;
 
@@ -670,6 +685,7 @@ void survive_kalman_tracker_integrate_observation(PoserData *pd, SurviveKalmanTr
 	}
 
 	if (tracker->use_raw_obs) {
+		survive_object_record_latency(so);
 		SURVIVE_INVOKE_HOOK_SO(imupose, so, pd->timecode, pose);
 		return;
 	}
@@ -700,6 +716,7 @@ void survive_kalman_tracker_integrate_observation(PoserData *pd, SurviveKalmanTr
 		} else {
 			// SV_WARN("Processing light data from the past %fs", time - tracker->model.t );
 			tracker->stats.late_light_dropped++;
+			survive_metric_add(tracker->metrics.late_light_dropped, 1);
 			return;
 		}
 	}
@@ -710,6 +727,7 @@ void survive_kalman_tracker_integrate_observation(PoserData *pd, SurviveKalmanTr
 		FLT obs_error = integrate_pose(tracker, time, pose, tracker->adaptive_obs ? 0 : R);
 		tracker->stats.obs_total_error += obs_error;
 		tracker->stats.obs_count++;
+		survive_metric_add(tracker->metrics.observations, 1);
 
 		SurviveObject *so = tracker->so;
 		SV_DATA_LOG("res_err_obs", &obs_error, 1);
@@ -718,6 +736,13 @@ void survive_kalman_tracker_integrate_observation(PoserData *pd, SurviveKalmanTr
 	}
 }
 
+void survive_kalman_tracker_integrate_observation(PoserData *pd, SurviveKalmanTracker *tracker, const SurvivePose *pose,
+												  const FLT *oR) {
+	SV_TRACE_BEGIN_SO("kalman observation", tracker->so);
+	integrate_observation(pd, tracker, pose, oR);
+	SV_TRACE_END("kalman observation");
+}
+
 typedef void (*survive_attach_detach_fn)(SurviveContext *ctx, const char *tag, FLT *var);
 
 void survive_kalman_tracker_reinit(SurviveKalmanTracker *tracker) {
@@ -753,11 +778,37 @@ void survive_kalman_tracker_reinit(SurviveKalmanTracker *tracker) {
 	SV_DATA_LOG("tracker_P", var_diag, tracker->model.state_cnt);
 }
 
+static void init_metrics(SurviveKalmanTracker *tracker) {
+	SurviveObject *so = tracker->so;
+	tracker->metrics.imu = survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_kalman_imu_total",
+												 "IMU measurements integrated by the kalman tracker");
+	tracker->metrics.light = survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_kalman_light_total",
+												   "Light measurements integrated by the kalman tracker");
+	tracker->metrics.observations =
+		survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_kalman_observations_total",
+							  "Poser observations integrated by the kalman tracker");
+	tracker->metrics.reported_poses = survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_kalman_poses_total",
+															"Poses reported by the kalman tracker");
+	tracker->metrics.dropped_poses =
+		survive_object_metric(so, SURVIVE_METRIC_COUNTER, "survive_kalman_dropped_poses_total",
+							  "Poses not reported because the tracker state was invalid or too uncertain");
+
+	const char *dropped_help = "Measurements dropped by the kalman tracker for arriving too late";
+	char labels[64];
+	snprintf(labels, sizeof(labels), "object=\"%s\",kind=\"imu\"", so->codename);
+	tracker->metrics.late_imu_dropped =
+		survive_metric(so->ctx, SURVIVE_METRIC_COUNTER, "survive_kalman_late_dropped_total", dropped_help, labels);
+	snprintf(labels, sizeof(labels), "object=\"%s\",kind=\"light\"", so->codename);
+	tracker->metrics.late_light_dropped =
+		survive_metric(so->ctx, SURVIVE_METRIC_COUNTER, "survive_kalman_late_dropped_total", dropped_help, labels);
+}
+
 void survive_kalman_tracker_init(SurviveKalmanTracker *tracker, SurviveObject *so) {
 	memset(tracker, 0, sizeof(*tracker));
 
 	tracker->acc_scale = NAN;
 	tracker->so = so;
+	init_metrics(tracker);
 
 	struct SurviveContext *ctx = tracker->so->ctx;
 	SV_VERBOSE(110, "Initializing Filter:");
@@ -973,6 +1024,7 @@ void survive_kalman_tracker_report_state(PoserData *pd, SurviveKalmanTracker *tr
 
 	if (!survive_kalman_tracker_check_valid(tracker)) {
 		tracker->stats.dropped_poses++;
+		survive_metric_add(tracker->metrics.dropped_poses, 1);
 		return;
 	}
 
@@ -987,6 +1039,7 @@ void survive_kalman_tracker_report_state(PoserData *pd, SurviveKalmanTracker *tr
 	if ((tracker->report_threshold_var > 0 && p_threshold >= tracker->report_threshold_var) ||
 		(tracker->report_ignore_start > tracker->report_ignore_start_cnt)) {
 		tracker->stats.dropped_poses++;
+		survive_metric_add(tracker->metrics.dropped_poses, 1);
 		addnd(tracker->stats.dropped_var, var_diag, tracker->stats.dropped_var, state_cnt);
 		tracker->report_ignore_start_cnt++;
 
@@ -1003,6 +1056,7 @@ void survive_kalman_tracker_report_state(PoserData *pd, SurviveKalmanTracker *tr
 			   SURVIVE_POSE_EXPAND(pose));
 
 	tracker->stats.reported_poses++;
+	survive_metric_add(tracker->metrics.reported_poses, 1);
 
 	SurviveVelocity velocity = survive_kalman_tracker_velocity(tracker);
 
@@ -1014,6 +1068,7 @@ void survive_kalman_tracker_report_state(PoserData *pd, SurviveKalmanTracker *tr
 	tracker->so->poseConfidence = 1. / p_threshold;
 	SV_VERBOSE(110, "%s confidence %7.7f", survive_colorize_codename(so), 1. / p_threshold);
 	if (so->OutPose_timecode < pd->timecode) {
+		survive_object_record_latency(so);
 		SURVIVE_INVOKE_HOOK_SO(imupose, so, pd->timecode, &pose);
 	}
 	SURVIVE_INVOKE_HOOK_SO(velocity, so, pd->timecode, &velocity);
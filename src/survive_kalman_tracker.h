@@ -100,6 +100,13 @@ typedef struct SurviveKalmanTracker {
 		FLT reported_var[19];
 	} stats;
 
+	// Live counterparts of some of the stats above, which unlike them are never reset
+	struct {
+		struct SurviveMetric *imu, *light, *observations;
+		struct SurviveMetric *late_imu_dropped, *late_light_dropped;
+		struct SurviveMetric *reported_poses, *dropped_poses;
+	} metrics;
+
 	FLT imu_residuals;
 	FLT light_residuals_all;
 	FLT light_residuals[NUM_GEN2_LIGHTHOUSES];
@@ -0,0 +1,241 @@
+#include "survive_metrics.h"
+#include "os_generic.h"
+#include "survive_internal.h"
+#include "survive_str.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const double default_bounds[] = {1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, .1, .25, .5, 1};
+
+struct SurviveMetric {
+	SurviveMetrics *registry;
+	struct SurviveMetric *next;
+
+	SurviveMetricType type;
+	char *name;
+	char *help;
+	char *labels;
+
+	// Counter and gauge value; the sum of the observations for histograms
+	double value;
+
+	uint64_t count;
+	double *bounds;
+	size_t bounds_cnt;
+	// Non cumulative counts for each bound, followed by the +Inf bucket
+	uint64_t *buckets;
+};
+
+struct SurviveMetrics {
+	// Updates can come from threads that don't hold the context lock -- async posers, USB callbacks -- so everything
+	// goes through this. It is only ever held for a handful of instructions outside of formatting.
+	og_mutex_t lock;
+	SurviveMetric *head, *tail;
+};
+
+SurviveMetrics *survive_metrics_create() {
+	SurviveMetrics *metrics = calloc(1, sizeof(SurviveMetrics));
+	metrics->lock = OGCreateMutex();
+	return metrics;
+}
+
+void survive_metrics_free(SurviveMetrics *metrics) {
+	if (metrics == 0)
+		return;
+
+	for (SurviveMetric *metric = metrics->head; metric;) {
+		SurviveMetric *next = metric->next;
+		free(metric->name);
+		free(metric->help);
+		free(metric->labels);
+		free(metric->bounds);
+		free(metric->buckets);
+		free(metric);
+		metric = next;
+	}
+	OGDeleteMutex(metrics->lock);
+	free(metrics);
+}
+
+static void set_buckets(SurviveMetric *metric, const double *bounds, size_t bounds_cnt) {
+	free(metric->bounds);
+	free(metric->buckets);
+	metric->bounds = malloc(sizeof(double) * bounds_cnt);
+	memcpy(metric->bounds, bounds, sizeof(double) * bounds_cnt);
+	metric->bounds_cnt = bounds_cnt;
+	metric->buckets = calloc(bounds_cnt + 1, sizeof(uint64_t));
+}
+
+SurviveMetric *survive_metric(SurviveContext *ctx, SurviveMetricType type, const char *name, const char *help,
+							  const char *labels) {
+	if (ctx == 0 || ctx->metrics == 0)
+		return 0;
+
+	SurviveMetrics *metrics = ctx->metrics;
+	if (labels == 0)
+		labels = "";
+
+	OGLockMutex(metrics->lock);
+	SurviveMetric *metric = metrics->head;
+	for (; metric; metric = metric->next) {
+		if (strcmp(metric->name, name) == 0 && strcmp(metric->labels, labels) == 0)
+			break;
+	}
+
+	if (metric && metric->type != type) {
+		SV_WARN("Metric %s{%s} was already registered with a different type", name, labels);
+		metric = 0;
+	} else if (metric == 0) {
+		metric = calloc(1, sizeof(SurviveMetric));
+		metric->registry = metrics;
+		metric->type = type;
+		metric->name = strdup(name);
+		metric->help = strdup(help ? help : "");
+		metric->labels = strdup(labels);
+		if (type == SURVIVE_METRIC_HISTOGRAM)
+			set_buckets(metric, default_bounds, sizeof(default_bounds) / sizeof(default_bounds[0]));
+
+		if (metrics->tail)
+			metrics->tail->next = metric;
+		else
+			metrics->head = metric;
+		metrics->tail = metric;
+	}
+	OGUnlockMutex(metrics->lock);
+	return metric;
+}
+
+SurviveMetric *survive_object_metric(SurviveObject *so, SurviveMetricType type, const char *name, const char *help) {
+	if (so == 0)
+		return 0;
+
+	char labels[32];
+	snprintf(labels, sizeof(labels), "object=\"%s\"", so->codename);
+	return survive_metric(so->ctx, type, name, help, labels);
+}
+
+void survive_metric_set_buckets(SurviveMetric *metric, const double *bounds, size_t bounds_cnt) {
+	if (metric == 0 || metric->type != SURVIVE_METRIC_HISTOGRAM)
+		return;
+
+	OGLockMutex(metric->registry->lock);
+	if (metric->count == 0)
+		set_buckets(metric, bounds, bounds_cnt);
+	OGUnlockMutex(metric->registry->lock);
+}
+
+void survive_metric_add(SurviveMetric *metric, double v) {
+	if (metric == 0)
+		return;
+
+	OGLockMutex(metric->registry->lock);
+	metric->value += v;
+	OGUnlockMutex(metric->registry->lock);
+}
+
+void survive_metric_set(SurviveMetric *metric, double v) {
+	if (metric == 0)
+		return;
+
+	OGLockMutex(metric->registry->lock);
+	metric->value = v;
+	OGUnlockMutex(metric->registry->lock);
+}
+
+void survive_metric_observe(SurviveMetric *metric, double v) {
+	if (metric == 0 || metric->type != SURVIVE_METRIC_HISTOGRAM)
+		return;
+
+	OGLockMutex(metric->registry->lock);
+	// The bounds can be replaced by survive_metric_set_buckets until the first observation, so search them locked
+	size_t bucket = 0;
+	while (bucket < metric->bounds_cnt && v > metric->bounds[bucket])
+		bucket++;
+
+	metric->buckets[bucket]++;
+	metric->count++;
+	metric->value += v;
+	OGUnlockMutex(metric->registry->lock);
+}
+
+double survive_metric_value(const SurviveMetric *metric) {
+	if (metric == 0)
+		return 0;
+	return metric->type == SURVIVE_METRIC_HISTOGRAM ? (double)metric->count : metric->value;
+}
+
+static void append_number(cstring *out, double v) {
+	if (isnan(v))
+		str_append(out, "NaN");
+	else if (isinf(v))
+		str_append(out, v > 0 ? "+Inf" : "-Inf");
+	else
+		str_append_printf(out, "%.15g", v);
+}
+
+// Writes 'name{labels,extra}' leaving out the braces when there are no labels
+static void append_series(cstring *out, const char *name, const char *suffix, const char *labels, const char *extra) {
+	str_append_printf(out, "%s%s", name, suffix);
+	if (*labels || *extra)
+		str_append_printf(out, "{%s%s%s}", labels, *labels && *extra ? "," : "", extra);
+	str_append(out, " ");
+}
+
+static void append_metric(cstring *out, const SurviveMetric *metric) {
+	if (metric->type != SURVIVE_METRIC_HISTOGRAM) {
+		append_series(out, metric->name, "", metric->labels, "");
+		append_number(out, metric->value);
+		str_append(out, "\n");
+		return;
+	}
+
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i <= metric->bounds_cnt; i++) {
+		char le[64];
+		if (i < metric->bounds_cnt)
+			snprintf(le, sizeof(le), "le=\"%.15g\"", metric->bounds[i]);
+		else
+			snprintf(le, sizeof(le), "le=\"+Inf\"");
+		cumulative += metric->buckets[i];
+		append_series(out, metric->name, "_bucket", metric->labels, le);
+		str_append_printf(out, "%llu\n", (unsigned long long)cumulative);
+	}
+	append_series(out, metric->name, "_sum", metric->labels, "");
+	append_number(out, metric->value);
+	str_append(out, "\n");
+	append_series(out, metric->name, "_count", metric->labels, "");
+	str_append_printf(out, "%llu\n", (unsigned long long)metric->count);
+}
+
+char *survive_metrics_prometheus(SurviveContext *ctx) {
+	if (ctx == 0 || ctx->metrics == 0)
+		return 0;
+
+	static const char *type_names[] = {"counter", "gauge", "histogram"};
+	SurviveMetrics *metrics = ctx->metrics;
+	cstring out = {0};
+	str_ensure_size(&out, 1);
+
+	OGLockMutex(metrics->lock);
+	// The format wants every series of a metric grouped under one HELP / TYPE header
+	for (SurviveMetric *metric = metrics->head; metric; metric = metric->next) {
+		bool seen = false;
+		for (SurviveMetric *prior = metrics->head; prior != metric && !seen; prior = prior->next)
+			seen = strcmp(prior->name, metric->name) == 0;
+		if (seen)
+			continue;
+
+		if (*metric->help)
+			str_append_printf(&out, "# HELP %s %s\n", metric->name, metric->help);
+		str_append_printf(&out, "# TYPE %s %s\n", metric->name, type_names[metric->type]);
+		for (SurviveMetric *series = metric; series; series = series->next) {
+			if (strcmp(series->name, metric->name) == 0)
+				append_metric(&out, series);
+		}
+	}
+	OGUnlockMutex(metrics->lock);
+
+	return out.d;
+}
@@ -29,6 +29,10 @@ STATIC_CONFIG_ITEM(OPTIMIZER_MAXITER, "optimizer-maxiter", 'i', "Maximum iterati
 STATIC_CONFIG_ITEM(OPTIMIZER_MAXFEV, "optimizer-maxfev", 'i', "Maximum function evals", 0)
 STATIC_CONFIG_ITEM(OPTIMIZER_NORMTOL, "optimizer-normtol", 'f', "Convergence for norm", 0.00005)
 STATIC_CONFIG_ITEM(OPTIMIZER_NPRINT, "optimizer-nprint", 'i', "", 0)
+STATIC_CONFIG_ITEM(OPTIMIZER_ROBUST_LOSS, "optimizer-robust-loss", 'i',
+				   "Loss for light measurements; 1 is squared, 2 Huber and 3 Cauchy", 1)
+STATIC_CONFIG_ITEM(OPTIMIZER_ROBUST_SCALE, "optimizer-robust-scale", 'f',
+				   "Deviate past which the robust losses start down weighting a measurement", .01)
 
 static char *object_parameter_names[] = {"Pose x",	 "Pose y",	 "Pose z",	"Pose Rot w",
 										 "Pose Rot x", "Pose Rot y", "Pose Rot z"};
@@ -410,11 +414,94 @@ static void filter_measurements(survive_optimizer *optimizer, FLT *deviates) {
 
 	optimizer->needsFiltering = false;
 }
-static int mpfunc(int m, int n, FLT *p, FLT *deviates, FLT **derivs, void *private) {
-	survive_optimizer *mpfunc_ctx = private;
+// rho'(r) / r; what iteratively reweighted least squares would weigh the measurement by. Only used for the stats.
+static inline FLT robust_loss_weight(enum survive_optimizer_loss loss, FLT scale, FLT deviate) {
+	FLT r = fabs(deviate) / scale;
+	switch (loss) {
+	case SURVIVE_OPTIMIZER_LOSS_HUBER:
+		return r <= 1 ? 1 : 1 / r;
+	case SURVIVE_OPTIMIZER_LOSS_CAUCHY:
+		return 1 / (1 + r * r);
+	default:
+		return 1;
+	}
+}
+
+SURVIVE_EXPORT FLT survive_optimizer_robust_deviate(enum survive_optimizer_loss loss, FLT scale, FLT deviate,
+													FLT *d_deviate) {
+	FLT r = fabs(deviate);
+	FLT rho, d_rho;
+	switch (loss) {
+	case SURVIVE_OPTIMIZER_LOSS_HUBER:
+		if (r <= scale) {
+			*d_deviate = 1;
+			return deviate;
+		}
+		rho = scale * r - scale * scale / 2;
+		d_rho = scale;
+		break;
+	case SURVIVE_OPTIMIZER_LOSS_CAUCHY: {
+		if (r == 0) {
+			*d_deviate = 1;
+			return deviate;
+		}
+		FLT u = r / scale;
+		rho = scale * scale / 2 * log1p(u * u);
+		d_rho = r / (1 + u * u);
+		break;
+	}
+	default:
+		*d_deviate = 1;
+		return deviate;
+	}
+
+	// d/dr sign(r) sqrt(2 rho(r)) = |rho'(r)| / sqrt(2 rho(r))
+	FLT f = sqrt(2 * rho);
+	*d_deviate = d_rho / f;
+	return deviate < 0 ? -f : f;
+}
+
+// The weights are added to the stats of 'record' if it's set
+static void apply_robust_loss(const survive_optimizer *optimizer, int light_meas, int n, FLT *deviates, FLT **derivs,
+							  survive_optimizer *record) {
+	if (optimizer->loss <= SURVIVE_OPTIMIZER_LOSS_SQUARED)
+		return;
+
+	for (int i = 0; i < light_meas; i++) {
+		if (optimizer->measurements[i].invalid)
+			continue;
+
+		FLT w = robust_loss_weight(optimizer->loss, optimizer->loss_scale, deviates[i]);
+		if (record) {
+			record->stats.weighted_meas_cnt++;
+			record->stats.weight_sum += w;
+			record->stats.downweighted_meas_cnt += fabs(deviates[i]) > optimizer->loss_scale;
+		}
+
+		FLT d;
+		deviates[i] = survive_optimizer_robust_deviate(optimizer->loss, optimizer->loss_scale, deviates[i], &d);
+		if (d == 1)
+			continue;
+
+		for (int j = 0; derivs && j < n; j++) {
+			if (derivs[j])
+				derivs[j][i] *= d;
+		}
+	}
+}
+
+/*
+ * mpfit may evaluate jacobian columns concurrently, each with its own 'p', so this works on a copy of the optimizer
+ * that points at them rather than changing the optimizer itself. The one exception is filtering, which only happens on
+ * the first evaluation of a run and so never on one of those.
+ */
+static int evaluate(survive_optimizer *optimizer, int m, int n, FLT *p, FLT *deviates, FLT **derivs,
+					bool record_weights) {
+	survive_optimizer view = *optimizer;
+	view.parameters = p;
+	survive_optimizer *mpfunc_ctx = &view;
 
 	const survive_reproject_model_t *reprojectModel = mpfunc_ctx->reprojectModel;
-	mpfunc_ctx->parameters = p;
 
 	SurvivePose *cameras = survive_optimizer_get_camera(mpfunc_ctx);
 
@@ -531,10 +618,11 @@ static int mpfunc(int m, int n, FLT *p, FLT *deviates, FLT **derivs, void *priva
 			derivs[deriv_idx + i][m_idx] = bias * deriv[i];
 		}
 	}
-	if (mpfunc_ctx->needsFiltering) {
+	if (optimizer->needsFiltering) {
 		assert(derivs == 0);
-		filter_measurements(mpfunc_ctx, deviates);
+		filter_measurements(optimizer, deviates);
 	}
+	apply_robust_loss(mpfunc_ctx, light_meas, n, deviates, derivs, record_weights ? optimizer : 0);
 
 	if (mpfunc_ctx->iteration_cb) {
 		mpfunc_ctx->iteration_cb(mpfunc_ctx, m, n, p, deviates, derivs);
@@ -542,6 +630,10 @@ static int mpfunc(int m, int n, FLT *p, FLT *deviates, FLT **derivs, void *priva
 	return 0;
 }
 
+static int mpfunc(int m, int n, FLT *p, FLT *deviates, FLT **derivs, void *private) {
+	return evaluate(private, m, n, p, deviates, derivs, false);
+}
+
 const char *survive_optimizer_error(int status) {
 #define CASE(x)                                                                                                        \
 	case x:                                                                                                            \
@@ -607,6 +699,13 @@ int survive_optimizer_run(survive_optimizer *optimizer, struct mp_result_struct
 	if (cfg == 0)
 		cfg = survive_optimizer_get_cfg(ctx);
 
+	if (ctx && optimizer->loss == SURVIVE_OPTIMIZER_LOSS_DEFAULT)
+		optimizer->loss = survive_configi(ctx, OPTIMIZER_ROBUST_LOSS_TAG, SC_GET, 0);
+	if (ctx && optimizer->loss_scale <= 0)
+		optimizer->loss_scale = survive_configf(ctx, OPTIMIZER_ROBUST_SCALE_TAG, SC_GET, 0);
+	if (optimizer->loss == SURVIVE_OPTIMIZER_LOSS_DEFAULT || optimizer->loss_scale <= 0)
+		optimizer->loss = SURVIVE_OPTIMIZER_LOSS_SQUARED;
+
 	SurvivePose *poses = survive_optimizer_get_pose(optimizer);
 	for (int i = 0; i < optimizer->poseLength + optimizer->cameraLength; i++) {
 		quattoaxisanglemag(poses[i].Rot, poses[i].Rot);
@@ -630,13 +729,31 @@ int survive_optimizer_run(survive_optimizer *optimizer, struct mp_result_struct
 	}
 #endif
 
-	// MPFit runs on temporary storage; so parameters is manipulated in mpfunc. Save it and restore it here.
-	FLT *params = optimizer->parameters;
+	// Numerical jacobians take one evaluation of every measurement per free parameter, so for solves without
+	// analytical jacobians -- use-jacobian-function and use-jacobian-function-lh set to 0 -- this is where nearly all
+	// of the time goes
+	struct survive_thread_pool *pool = ctx && optimizer->iteration_cb == 0 ? survive_get_thread_pool(ctx) : 0;
+	mp_config pooled_cfg;
+	if (pool) {
+		pooled_cfg = *cfg;
+		pooled_cfg.parallel_for = survive_thread_pool_parallel_for;
+		pooled_cfg.parallel_for_data = pool;
+		cfg = &pooled_cfg;
+	}
+
 	optimizer->needsFiltering = !optimizer->nofilter;
-	size_t extra_meas = optimizer->upVectorBias > 0 ? (optimizer->cameraLength + optimizer->poseLength) : 0;
-	int rtn = mpfit(mpfunc, optimizer->measurementsCnt + extra_meas, survive_optimizer_get_parameters_count(optimizer),
-					optimizer->parameters, optimizer->parameters_info, cfg, optimizer, result);
-	optimizer->parameters = params;
+	int m = optimizer->measurementsCnt +
+			(optimizer->upVectorBias > 0 ? (optimizer->cameraLength + optimizer->poseLength) : 0);
+	int npar = survive_optimizer_get_parameters_count(optimizer);
+	SV_TRACE_BEGIN("optimizer run");
+	int rtn = mpfit(mpfunc, m, npar, optimizer->parameters, optimizer->parameters_info, cfg, optimizer, result);
+	SV_TRACE_END("optimizer run");
+
+	// mpfit doesn't say which of its evaluations was the final one, so take the weights for the stats from a fresh one
+	if (optimizer->loss > SURVIVE_OPTIMIZER_LOSS_SQUARED && rtn > 0) {
+		FLT *deviates = alloca(sizeof(FLT) * m);
+		evaluate(optimizer, m, npar, optimizer->parameters, deviates, 0, true);
+	}
 
 	for (int i = 0; i < optimizer->poseLength + optimizer->cameraLength; i++) {
 		quatfromaxisangle(poses[i].Rot, poses[i].Rot, norm3d(poses[i].Rot));
@@ -768,9 +885,19 @@ survive_optimizer *survive_optimizer_load(const char *fn) {
 	fclose(f);
 
 	SurviveObject *so = survive_create_device(0, "SLV", opt, "SV0", 0);
+
+	// The device config is looked for next to the problem first, and then in the working directory
 	char filename[FILENAME_MAX] = {0};
-	snprintf(filename, FILENAME_MAX, "%s_config.json", device_name);
-	FILE *fp = fopen(filename, "r");
+	const char *slash = strrchr(fn, '/');
+	FILE *fp = 0;
+	if (slash) {
+		snprintf(filename, FILENAME_MAX, "%.*s%s_config.json", (int)(slash - fn + 1), fn, device_name);
+		fp = fopen(filename, "r");
+	}
+	if (fp == 0) {
+		snprintf(filename, FILENAME_MAX, "%s_config.json", device_name);
+		fp = fopen(filename, "r");
+	}
 	if (fp) {
 		fseek(fp, 0L, SEEK_END);
 		int len = ftell(fp);
@@ -0,0 +1,375 @@
+#include "barycentric_svd/barycentric_svd.h"
+#include "survive_optimizer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+STATIC_CONFIG_ITEM(OPTIMIZER_RANSAC_HYPOTHESES, "optimizer-ransac-hypotheses", 'i',
+				   "Pose hypotheses tried to find outliers before each MPFIT solve. Set to 0 to disable.", 0)
+STATIC_CONFIG_ITEM(OPTIMIZER_RANSAC_THRESHOLD, "optimizer-ransac-threshold", 'f',
+				   "Reprojection error, in radians, under which a measurement supports a pose hypothesis", .02)
+
+// Sensors, with both axes, that each hypothesis is solved from. Fewer than this and the solver's system has no
+// unique solution.
+#define RANSAC_SAMPLE_SENSORS 6
+// How sure hypotheses stop being made at that one of them was drawn only from inliers
+#define RANSAC_CONFIDENCE .99
+
+typedef struct ransac_pair {
+	uint8_t sensor_idx;
+	FLT angles[2];
+} ransac_pair;
+
+typedef struct ransac_hypothesis {
+	SurvivePose obj2world;
+	size_t inliers;
+	FLT error;
+} ransac_hypothesis;
+
+// Everything one hypothesis needs while it is made and scored; a round runs one hypothesis per slot
+typedef struct ransac_slot {
+	bc_svd bc;
+	FLT *pts_in_lh;
+	ransac_pair *sample;
+} ransac_slot;
+
+struct survive_optimizer_ransac {
+	SurviveObject *so;
+	int hypotheses_cnt;
+	FLT threshold;
+	uint32_t run_cnt;
+
+	// Control points and barycentric coordinates for the object's sensors, shared by the solver in every slot
+	bc_svd model;
+	const FLT *model_locations;
+	size_t model_sensor_ct;
+
+	ransac_slot *slots;
+	int slot_cnt;
+	// [hypotheses_cnt + 1]; the first is the optimizer's starting pose
+	ransac_hypothesis *hypotheses;
+
+	// The current run; read only while hypotheses are being made
+	survive_optimizer *optimizer;
+	size_t meas_cnt, usable_cnt;
+	ransac_pair *pairs[NUM_GEN2_LIGHTHOUSES];
+	size_t pair_cnt[NUM_GEN2_LIGHTHOUSES];
+	int lhs[NUM_GEN2_LIGHTHOUSES];
+	int lh_cnt;
+
+	// Hypotheses made so far, and how many to make; 'batch_cnt' comes down as hypotheses find more support, see
+	// ransac_update_batch_cnt
+	int next, batch_cnt;
+};
+
+static uint32_t ransac_rand(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static void ransac_free_model(struct survive_optimizer_ransac *ransac) {
+	if (ransac->model_locations == 0)
+		return;
+
+	for (int i = 0; i < ransac->slot_cnt; i++) {
+		ransac_slot *slot = &ransac->slots[i];
+		bc_svd_dtor(&slot->bc);
+		free(slot->pts_in_lh);
+		free(slot->sample);
+	}
+	free(ransac->slots);
+	ransac->slots = 0;
+	ransac->slot_cnt = 0;
+	for (int lh = 0; lh < NUM_GEN2_LIGHTHOUSES; lh++) {
+		free(ransac->pairs[lh]);
+		ransac->pairs[lh] = 0;
+	}
+	bc_svd_dtor(&ransac->model);
+	ransac->model_locations = 0;
+}
+
+/*
+ * Sets up the model and everything sized by the sensor count, if the sensor locations or the number of slots changed
+ * since the last run
+ */
+static void ransac_update_model(struct survive_optimizer_ransac *ransac, int slot_cnt) {
+	SurviveObject *so = ransac->so;
+	if (ransac->model_locations == so->sensor_locations && ransac->model_sensor_ct == so->sensor_ct &&
+		ransac->slot_cnt == slot_cnt)
+		return;
+
+	ransac_free_model(ransac);
+	bc_svd_bc_svd(&ransac->model, so, bc_svd_survive_fill_m, (LinmathPoint3d *)so->sensor_locations, so->sensor_ct);
+	ransac->slots = SV_CALLOC(sizeof(ransac_slot) * slot_cnt);
+	ransac->slot_cnt = slot_cnt;
+	for (int i = 0; i < slot_cnt; i++) {
+		ransac_slot *slot = &ransac->slots[i];
+		bc_svd_bc_svd_shared(&slot->bc, &ransac->model);
+		slot->pts_in_lh = SV_CALLOC(sizeof(FLT) * 3 * so->sensor_ct);
+		slot->sample = SV_CALLOC(sizeof(ransac_pair) * so->sensor_ct);
+	}
+	for (int lh = 0; lh < NUM_GEN2_LIGHTHOUSES; lh++)
+		ransac->pairs[lh] = SV_CALLOC(sizeof(ransac_pair) * so->sensor_ct);
+
+	ransac->model_locations = so->sensor_locations;
+	ransac->model_sensor_ct = so->sensor_ct;
+}
+
+// Solves for the object from RANSAC_SAMPLE_SENSORS random sensors of one lighthouse. False if that was degenerate.
+static bool ransac_sample(struct survive_optimizer_ransac *ransac, ransac_slot *slot, uint32_t *rng,
+						  SurvivePose *obj2world) {
+	int lh = ransac->lhs[ransac_rand(rng) % ransac->lh_cnt];
+	size_t pair_cnt = ransac->pair_cnt[lh];
+	memcpy(slot->sample, ransac->pairs[lh], sizeof(ransac_pair) * pair_cnt);
+
+	bc_svd_reset_correspondences(&slot->bc);
+	for (size_t i = 0; i < RANSAC_SAMPLE_SENSORS; i++) {
+		size_t j = i + ransac_rand(rng) % (pair_cnt - i);
+		ransac_pair picked = slot->sample[j];
+		slot->sample[j] = slot->sample[i];
+		slot->sample[i] = picked;
+		bc_svd_add_correspondence(&slot->bc, picked.sensor_idx, picked.angles[0], picked.angles[1]);
+	}
+
+	FLT R[3][3];
+	SurvivePose obj2lh = {0};
+	FLT err = bc_svd_compute_pose(&slot->bc, R, obj2lh.Pos);
+	FLT dist = magnitude3d(obj2lh.Pos);
+	if (err < 0 || err > 1 || !isfinite(dist) || dist < .25 || dist > 25)
+		return false;
+
+	// Camera to vive lighthouse convention; see solve_correspondence in the barycentric SVD poser
+	LinmathQuat camera_rot;
+	const LinmathQuat rt = {0, 0, 1, 0};
+	quatfrommatrix33(camera_rot, (const FLT *)R);
+	quatrotateabout(obj2lh.Rot, rt, camera_rot);
+	quatnormalize(obj2lh.Rot, obj2lh.Rot);
+	obj2lh.Pos[0] = -obj2lh.Pos[0];
+	obj2lh.Pos[2] = -obj2lh.Pos[2];
+
+	SurvivePose lh2world = InvertPoseRtn(&survive_optimizer_get_camera(ransac->optimizer)[lh]);
+	ApplyPoseToPose(obj2world, &lh2world, &obj2lh);
+	return true;
+}
+
+/*
+ * Reprojection error of one measurement for the object at 'obj2world'. The sensors are moved into the measurement's
+ * lighthouse frame all at once; measurements come grouped by lighthouse, so that normally happens once per
+ * lighthouse. 'transformed_lh' tracks which frame the slot holds and starts at -1.
+ */
+static FLT ransac_meas_error(struct survive_optimizer_ransac *ransac, ransac_slot *slot, const SurvivePose *obj2world,
+							 const survive_optimizer_measurement *meas, int *transformed_lh) {
+	survive_optimizer *optimizer = ransac->optimizer;
+	if (meas->lh != *transformed_lh) {
+		SurvivePose obj2lh;
+		ApplyPoseToPose(&obj2lh, &survive_optimizer_get_camera(optimizer)[meas->lh], obj2world);
+		ApplyPoseToPoints(slot->pts_in_lh, &obj2lh, survive_optimizer_get_sensors(optimizer, 0),
+						  ransac->model_sensor_ct);
+		*transformed_lh = meas->lh;
+	}
+
+	const BaseStationCal *cal = survive_optimizer_get_calibration(optimizer, meas->lh);
+	return fabs(optimizer->reprojectModel->reprojectAxisFn[meas->axis](cal, slot->pts_in_lh + meas->sensor_idx * 3) -
+				meas->value);
+}
+
+static bool ransac_meas_usable(const struct survive_optimizer_ransac *ransac,
+							   const survive_optimizer_measurement *meas) {
+	return !meas->invalid && meas->lh < ransac->optimizer->cameraLength && meas->sensor_idx < ransac->model_sensor_ct;
+}
+
+// Counts the measurements the pose reprojects to within the threshold, and their total error
+static void ransac_score(struct survive_optimizer_ransac *ransac, ransac_slot *slot, ransac_hypothesis *h) {
+	int transformed_lh = -1;
+	for (size_t i = 0; i < ransac->meas_cnt; i++) {
+		const survive_optimizer_measurement *meas = &ransac->optimizer->measurements[i];
+		if (!ransac_meas_usable(ransac, meas))
+			continue;
+
+		FLT err = ransac_meas_error(ransac, slot, &h->obj2world, meas, &transformed_lh);
+		if (err < ransac->threshold) {
+			h->inliers++;
+			h->error += err;
+		}
+	}
+}
+
+static void ransac_hypothesis_run(struct survive_optimizer_ransac *ransac, ransac_slot *slot, int idx) {
+	ransac_hypothesis *h = &ransac->hypotheses[idx];
+	*h = (ransac_hypothesis){0};
+
+	if (idx == 0) {
+		h->obj2world = *survive_optimizer_get_pose(ransac->optimizer);
+		if (quatiszero(h->obj2world.Rot))
+			return;
+	} else {
+		// Seeded by the run and hypothesis rather than the slot, so a hypothesis is the same whichever thread makes it
+		uint32_t rng = (ransac->run_cnt * 2654435761u) ^ (idx * 40503u) ^ 0x9e3779b9u;
+		if (rng == 0)
+			rng = 1;
+		if (!ransac_sample(ransac, slot, &rng, &h->obj2world))
+			return;
+	}
+
+	ransac_score(ransac, slot, h);
+}
+
+/*
+ * The usual adaptive stop: with a fraction 'w' of the measurements supporting the best hypothesis so far, a sample is
+ * all inliers with probability w^n, and log(1 - confidence) / log(1 - w^n) samples are enough to have drawn one. When
+ * the starting pose already agrees with every measurement, that is none at all.
+ */
+static void ransac_update_batch_cnt(struct survive_optimizer_ransac *ransac, const ransac_hypothesis *h) {
+	FLT all_inliers = pow(h->inliers / (FLT)ransac->usable_cnt, RANSAC_SAMPLE_SENSORS);
+	if (all_inliers <= 0)
+		return;
+
+	int needed = 1;
+	if (all_inliers < 1)
+		needed += (int)ceil(log(1 - RANSAC_CONFIDENCE) / log(1 - all_inliers));
+	if (needed < ransac->batch_cnt)
+		ransac->batch_cnt = needed;
+}
+
+// Runs hypothesis 'next + i' in slot 'i'
+static void ransac_round_run(void *_ransac, int i) {
+	struct survive_optimizer_ransac *ransac = _ransac;
+	ransac_hypothesis_run(ransac, &ransac->slots[i], ransac->next + i);
+}
+
+struct survive_optimizer_ransac *survive_optimizer_ransac_create(SurviveObject *so) {
+	SurviveContext *ctx = so->ctx;
+	struct survive_optimizer_ransac *ransac = SV_CALLOC(sizeof(struct survive_optimizer_ransac));
+	ransac->so = so;
+	ransac->hypotheses_cnt = survive_configi(ctx, OPTIMIZER_RANSAC_HYPOTHESES_TAG, SC_GET, 0);
+	ransac->threshold = survive_configf(ctx, OPTIMIZER_RANSAC_THRESHOLD_TAG, SC_GET, .02);
+	if (ransac->hypotheses_cnt < 0)
+		ransac->hypotheses_cnt = 0;
+	ransac->hypotheses = SV_CALLOC(sizeof(ransac_hypothesis) * (ransac->hypotheses_cnt + 1));
+
+	SV_VERBOSE(110, "RANSAC for %s: %d hypotheses, threshold %f", so->codename, ransac->hypotheses_cnt,
+			   ransac->threshold);
+	return ransac;
+}
+
+void survive_optimizer_ransac_free(struct survive_optimizer_ransac *ransac) {
+	if (ransac == 0)
+		return;
+
+	ransac_free_model(ransac);
+	free(ransac->hypotheses);
+	free(ransac);
+}
+
+// Gathers the sensors each lighthouse saw on both axes, with the angles calibrated the way the SVD solver wants
+static void ransac_gather_pairs(struct survive_optimizer_ransac *ransac) {
+	survive_optimizer *optimizer = ransac->optimizer;
+	memset(ransac->pair_cnt, 0, sizeof(ransac->pair_cnt));
+	ransac->lh_cnt = 0;
+	ransac->usable_cnt = 0;
+	for (size_t i = 0; i < ransac->meas_cnt; i++)
+		ransac->usable_cnt += ransac_meas_usable(ransac, &optimizer->measurements[i]);
+
+	for (size_t i = 0; i + 1 < ransac->meas_cnt; i++) {
+		const survive_optimizer_measurement *meas = &optimizer->measurements[i];
+		if (!ransac_meas_usable(ransac, &meas[0]) || !ransac_meas_usable(ransac, &meas[1]) || meas[0].axis != 0 ||
+			meas[1].axis != 1 || meas[0].lh != meas[1].lh || meas[0].sensor_idx != meas[1].sensor_idx)
+			continue;
+
+		const BaseStationCal *cal = survive_optimizer_get_calibration(optimizer, meas->lh);
+		ransac_pair *pair = &ransac->pairs[meas->lh][ransac->pair_cnt[meas->lh]++];
+		pair->sensor_idx = meas->sensor_idx;
+		for (int axis = 0; axis < 2; axis++)
+			pair->angles[axis] = meas[axis].value + cal[axis].phase;
+		i++;
+	}
+
+	for (int lh = 0; lh < optimizer->cameraLength; lh++) {
+		if (ransac->pair_cnt[lh] >= RANSAC_SAMPLE_SENSORS)
+			ransac->lhs[ransac->lh_cnt++] = lh;
+	}
+}
+
+int survive_optimizer_ransac_run(struct survive_optimizer_ransac *ransac, survive_optimizer *optimizer) {
+	SurviveObject *so = ransac->so;
+	SurviveContext *ctx = so->ctx;
+	if (ransac->hypotheses_cnt == 0 || optimizer->poseLength != 1 || optimizer->cameraLength == 0 ||
+		so->sensor_locations == 0)
+		return -1;
+
+	// Hypotheses are made against the lighthouses as they are, so this doesn't apply to calibration solves
+	int camera_start = survive_optimizer_get_camera_index(optimizer);
+	for (int lh = 0; lh < optimizer->cameraLength; lh++) {
+		if (!optimizer->parameters_info[camera_start + 7 * lh].fixed)
+			return -1;
+	}
+
+	// Each round makes one hypothesis per thread, on the pool's threads and this one
+	struct survive_thread_pool *pool = survive_get_thread_pool(ctx);
+	ransac_update_model(ransac, survive_thread_pool_thread_cnt(pool) + 1);
+	ransac->optimizer = optimizer;
+	ransac->meas_cnt = optimizer->measurementsCnt - (optimizer->current_bias > 0 ? 7 : 0);
+	ransac->run_cnt++;
+	ransac_gather_pairs(ransac);
+	if (ransac->lh_cnt == 0) {
+		ransac->optimizer = 0;
+		return -1;
+	}
+
+	ransac->batch_cnt = ransac->hypotheses_cnt + 1;
+	for (ransac->next = 0; ransac->next < ransac->batch_cnt;) {
+		int round_cnt = ransac->batch_cnt - ransac->next;
+		if (round_cnt > ransac->slot_cnt)
+			round_cnt = ransac->slot_cnt;
+		survive_thread_pool_parallel_for(pool, round_cnt, ransac_round_run, ransac);
+
+		for (int i = 0; i < round_cnt; i++)
+			ransac_update_batch_cnt(ransac, &ransac->hypotheses[ransac->next + i]);
+		ransac->next += round_cnt;
+	}
+	int hypotheses_run = ransac->next;
+
+	// Most support wins; ties go to the lower total error, and then to the earlier hypothesis
+	int best = 0;
+	for (int i = 1; i < hypotheses_run; i++) {
+		const ransac_hypothesis *h = &ransac->hypotheses[i], *b = &ransac->hypotheses[best];
+		if (h->inliers > b->inliers || (h->inliers == b->inliers && h->error < b->error))
+			best = i;
+	}
+
+	const ransac_hypothesis *consensus = &ransac->hypotheses[best];
+	if (consensus->inliers < RANSAC_SAMPLE_SENSORS * 2) {
+		ransac->optimizer = 0;
+		return -1;
+	}
+
+	// Measurements outside of the winner's consensus are the ones to drop
+	int rejected = 0, transformed_lh = -1;
+	for (size_t i = 0; i < ransac->meas_cnt; i++) {
+		survive_optimizer_measurement *meas = &optimizer->measurements[i];
+		if (!ransac_meas_usable(ransac, meas))
+			continue;
+
+		FLT err = ransac_meas_error(ransac, &ransac->slots[0], &consensus->obj2world, meas, &transformed_lh);
+		if (!(err < ransac->threshold)) {
+			SV_VERBOSE(105, "RANSAC rejected lh %d sensor %d axis %d for %s (%f)", meas->lh, meas->sensor_idx,
+					   meas->axis, so->codename, err);
+			meas->invalid = true;
+			rejected++;
+		}
+	}
+	optimizer->stats.dropped_meas_cnt += rejected;
+
+	if (best != 0) {
+		SV_VERBOSE(105, "RANSAC replaced the starting pose for %s with hypothesis %d (%d/%d inliers)", so->codename,
+				   best, (int)consensus->inliers, (int)ransac->hypotheses[0].inliers);
+		*survive_optimizer_get_pose(optimizer) = consensus->obj2world;
+	}
+
+	ransac->optimizer = 0;
+	return rejected;
+}
@@ -186,6 +186,44 @@ void survive_default_raw_imu_process(SurviveObject *so, int mask, const FLT *acc
 	SURVIVE_INVOKE_HOOK_SO(imu, so, 3, agm, timecode, id);
 }
 
+void survive_default_raw_imu_batch_process(SurviveObject *so, const SurviveImuEvent *events, size_t cnt) {
+	SurviveContext *ctx = so->ctx;
+
+	// Someone else wants each raw sample; otherwise do what the default raw hook does and pass the batch along
+	if (ctx->raw_imuproc != survive_default_raw_imu_process) {
+		for (size_t i = 0; i < cnt; i++) {
+			const SurviveImuEvent *e = &events[i];
+			SURVIVE_INVOKE_HOOK_SO(raw_imu, so, e->mask, e->accelgyromag, e->timecode, e->id);
+		}
+		return;
+	}
+
+	SurviveImuEvent calibrated[8];
+	while (cnt > 0) {
+		size_t batch_cnt = cnt < 8 ? cnt : 8;
+		for (size_t i = 0; i < batch_cnt; i++) {
+			calibrated[i] = events[i];
+			// The default raw hook always hands on all of accel and gyro, whatever the raw mask was
+			calibrated[i].mask = 3;
+			calibrate_acc(so, calibrated[i].accelgyromag);
+			calibrate_gyro(so, calibrated[i].accelgyromag + 3);
+
+			survive_recording_raw_imu_process(so, events[i].mask, events[i].accelgyromag, events[i].timecode,
+											  events[i].id);
+		}
+
+		SURVIVE_INVOKE_HOOK_SO(imu_batch, so, calibrated, batch_cnt);
+		events += batch_cnt;
+		cnt -= batch_cnt;
+	}
+}
+
+void survive_default_imu_batch_process(SurviveObject *so, const SurviveImuEvent *events, size_t cnt) {
+	for (size_t i = 0; i < cnt; i++) {
+		SURVIVE_INVOKE_HOOK_SO(imu, so, events[i].mask, events[i].accelgyromag, events[i].timecode, events[i].id);
+	}
+}
+
 void survive_default_imu_process(SurviveObject *so, int mask, const FLT *accelgyromag, uint32_t timecode, int id) {
 	survive_long_timecode longTimecode = SurviveSensorActivations_long_timecode_imu(&so->activations, timecode);
 	PoserDataIMU imu = {
@@ -90,6 +90,12 @@ void survive_default_lightcap_process(SurviveObject *so, const LightcapElement *
 	survive_notify_gen1(so, "Lightcap called");
 }
 
+void survive_default_lightcap_batch_process(SurviveObject *so, const LightcapElement *les, size_t cnt) {
+	for (size_t i = 0; i < cnt; i++) {
+		SURVIVE_INVOKE_HOOK_SO(lightcap, so, &les[i]);
+	}
+}
+
 void survive_default_angle_process(SurviveObject *so, int sensor_id, int acode, uint32_t timecode, FLT length,
 								   FLT angle, uint32_t lh) {
 	survive_notify_gen1(so, "Default angle called");
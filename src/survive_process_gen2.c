@@ -412,6 +412,22 @@ SURVIVE_EXPORT void survive_default_sweep_angle_process(SurviveObject *so, survi
 	SURVIVE_POSER_INVOKE(so, &l);
 }
 
+SURVIVE_EXPORT void survive_default_sweep_batch_process(SurviveObject *so, const SurviveSweepEvent *events,
+														size_t cnt) {
+	for (size_t i = 0; i < cnt; i++) {
+		const SurviveSweepEvent *e = &events[i];
+		SURVIVE_INVOKE_HOOK_SO(sweep, so, e->channel, e->sensor_id, e->timecode, e->half_clock_flag);
+	}
+}
+
+SURVIVE_EXPORT void survive_default_sweep_angle_batch_process(SurviveObject *so, const SurviveSweepAngleEvent *events,
+															  size_t cnt) {
+	for (size_t i = 0; i < cnt; i++) {
+		const SurviveSweepAngleEvent *e = &events[i];
+		SURVIVE_INVOKE_HOOK_SO(sweep_angle, so, e->channel, e->sensor_id, e->timecode, e->plane, e->angle);
+	}
+}
+
 SURVIVE_EXPORT void survive_default_gen_detected_process(SurviveObject *so, int lh_version) {
 	SurviveContext *ctx = so->ctx;
 
@@ -14,7 +14,16 @@
 #include <errno.h>
 #include <string.h>
 
+#include <fcntl.h>
 #include <inttypes.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 #include "survive_recording.h"
 
@@ -26,6 +35,7 @@
 #include "stdarg.h"
 
 #include "survive_gz.h"
+#include "survive_str.h"
 
 STATIC_CONFIG_ITEM(PLAYBACK_RECORD_RAWLIGHT, "record-rawlight", 'i', "Whether or not to output raw light data", 1)
 STATIC_CONFIG_ITEM(PLAYBACK_RECORD_IMU, "record-imu", 'i', "Whether or not to output imu data", 1)
@@ -35,7 +45,9 @@ STATIC_CONFIG_ITEM(PLAYBACK_RECORD_ANGLE, "record-angle", 'i', "Whether or not t
 
 STATIC_CONFIG_ITEM(RECORD, "record", 's', "File to record to if you wish to make a recording.", "")
 STATIC_CONFIG_ITEM(RECORD_STDOUT, "record-stdout", 'i', "Whether or not to dump recording data to stdout", 0)
-  
+STATIC_CONFIG_ITEM(RECORD_INDEX_INTERVAL, "record-index-interval", 'f',
+				   "Seconds between seek points written to the recording's .idx file. 0 disables the index.", 1.)
+
 typedef struct SurviveRecordingData {
 	SurviveContext *ctx;
 	bool alwaysWriteStdOut;
@@ -44,11 +56,25 @@ typedef struct SurviveRecordingData {
 		bool writeCalIMU;
 		bool writeAngle;
 		gzFile output_file;
+
+		/*
+		 * When indexing, the file is written as a series of independent chunks -- concatenated gzip members for
+		 * compressed recordings -- and the index records the time and file offset each one starts at. Any chunk can
+		 * then be decoded without the data before it.
+		 */
+		int fd;
+		const char *mode;
+		FILE *index_file;
+		FLT index_interval;
+		double next_index_time;
+		int64_t chunk_offset;
+		size_t chunk_bytes;
 } SurviveRecordingData;
 
 static void write_to_output_raw(SurviveRecordingData *recordingData, const char *string, int len) {
 	if (recordingData->output_file) {
 		gzwrite(recordingData->output_file, string, len);
+		recordingData->chunk_bytes += len;
 	}
 
 	if (recordingData->alwaysWriteStdOut) {
@@ -56,24 +82,125 @@ static void write_to_output_raw(SurviveRecordingData *recordingData, const char
 	}
 }
 
+// Ends the current chunk and notes where the next one starts in the index. 'type' is 'T' for a regular seek point or
+// 'C' for a chunk holding a single device config line.
+static void recording_start_chunk(SurviveRecordingData *recordingData, char type, double ts) {
+	if (recordingData->index_file == 0)
+		return;
+
+	if (recordingData->chunk_bytes > 0) {
+		gzclose(recordingData->output_file);
+		recordingData->chunk_offset = lseek(recordingData->fd, 0, SEEK_CUR);
+		recordingData->output_file = gzdopen(dup(recordingData->fd), recordingData->mode);
+		recordingData->chunk_bytes = 0;
+	}
+
+	fprintf(recordingData->index_file, "%c %0.6f %" PRId64 "\n", type, ts, recordingData->chunk_offset);
+	fflush(recordingData->index_file);
+}
+
+static inline void recording_index_line(SurviveRecordingData *recordingData, double ts) {
+	if (recordingData->index_file && ts >= recordingData->next_index_time) {
+		recording_start_chunk(recordingData, 'T', ts);
+		recordingData->next_index_time = ts + recordingData->index_interval;
+	}
+}
+
 #ifdef SURVIVE_HEX_FLOATS
 #define FLT_PRINTF "%0.6a "
 #else
 #define FLT_PRINTF "%0.6f "
 #endif
 
+/*
+ * Formatting dominates the cost of text recordings, so the high rate events build their lines with the allocation free
+ * str_format_* functions instead of going through printf. The output is byte for byte what the printf formats above
+ * produce.
+ */
+typedef struct recording_line {
+	SurviveRecordingData *recordingData;
+	size_t length;
+	char d[4 * STR_FORMAT_BUFFER_SIZE];
+} recording_line;
+
+static inline void recording_line_flush(recording_line *line) {
+	write_to_output_raw(line->recordingData, line->d, (int)line->length);
+	line->length = 0;
+}
+
+static inline char *recording_line_reserve(recording_line *line, size_t len) {
+	if (line->length + len >= sizeof(line->d))
+		recording_line_flush(line);
+	return line->d + line->length;
+}
+
+static inline void recording_line_str(recording_line *line, const char *str) {
+	for (; *str; str++) {
+		*recording_line_reserve(line, 1) = *str;
+		line->length++;
+	}
+}
+
+static inline void recording_line_uint(recording_line *line, uint32_t v) {
+	line->length += str_format_uint(recording_line_reserve(line, STR_FORMAT_BUFFER_SIZE), v);
+}
+
+static inline void recording_line_int(recording_line *line, int32_t v) {
+	line->length += str_format_int(recording_line_reserve(line, STR_FORMAT_BUFFER_SIZE), v);
+}
+
+// Equivalent of FLT_PRINTF, including the trailing space
+static inline void recording_line_flt(recording_line *line, double v) {
+	char *p = recording_line_reserve(line, STR_FORMAT_BUFFER_SIZE);
+#ifdef SURVIVE_HEX_FLOATS
+	int len = snprintf(p, STR_FORMAT_BUFFER_SIZE, "%0.6a", v);
+#else
+	int len = str_format_fixed(p, v, 6);
+#endif
+	p[len] = ' ';
+	line->length += len + 1;
+}
+
+// Equivalent of FLT_format
+static inline void recording_line_flt_exp(recording_line *line, double v) {
+	line->length += str_format_exp(recording_line_reserve(line, STR_FORMAT_BUFFER_SIZE), v, 6, true);
+}
+
+static inline void recording_line_flts(recording_line *line, const FLT *v, size_t cnt) {
+	for (size_t i = 0; i < cnt; i++)
+		recording_line_flt(line, v[i]);
+}
+
+static inline void recording_line_start(recording_line *line, SurviveRecordingData *recordingData, double ts,
+										const char *dev) {
+	line->recordingData = recordingData;
+	line->length = 0;
+	recording_line_flt(line, ts);
+	recording_line_str(line, dev);
+}
+
+// Starts a line with the timestamp and the given device name
+static inline void recording_line_begin(recording_line *line, SurviveRecordingData *recordingData, const char *dev) {
+	double ts = survive_run_time(recordingData->ctx);
+	recording_index_line(recordingData, ts);
+	recording_line_start(line, recordingData, ts, dev);
+}
+
 void survive_recording_write_to_output(struct SurviveRecordingData *recordingData, const char *format, ...) {
 	if (!recordingData) {
 		return;
 	}
 
 	double ts = survive_run_time(recordingData->ctx);
+	recording_index_line(recordingData, ts);
 
 	if (recordingData->output_file) {
 		va_list args;
 		va_start(args, format);
-		gzprintf(recordingData->output_file, FLT_PRINTF, ts);
-		gzvprintf(recordingData->output_file, format, args);
+		int written = gzprintf(recordingData->output_file, FLT_PRINTF, ts);
+		written += gzvprintf(recordingData->output_file, format, args);
+		if (written > 0)
+			recordingData->chunk_bytes += written;
 
 		va_end(args);
 	}
@@ -103,10 +230,18 @@ void survive_recording_config_process(SurviveObject *so, char *ct0conf, int len)
 		if (buffer[i] == '\n' || buffer[i] == '\r')
 			buffer[i] = ' ';
 
-	survive_recording_write_to_output(recordingData, "%s CONFIG ", so->codename);
+	// Configs get a chunk to themselves so seeking playback can create devices without replaying the data around them
+	double ts = survive_run_time(recordingData->ctx);
+	recording_start_chunk(recordingData, 'C', ts);
+
+	recording_line line;
+	recording_line_start(&line, recordingData, ts, so->codename);
+	recording_line_str(&line, " CONFIG ");
+	recording_line_flush(&line);
 	write_to_output_raw(recordingData, buffer, len);
 
 	write_to_output_raw(recordingData, "\r\n", 2);
+	recordingData->next_index_time = 0;
 
 	free(buffer);
 }
@@ -117,30 +252,40 @@ void survive_recording_lighthouse_process(SurviveContext *ctx, uint8_t lighthous
 		return;
 
 	int8_t mode = ctx->bsd[lighthouse].mode;
-	survive_recording_write_to_output(
-		recordingData,
-		"%d LH_POSE " FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF "\r\n", mode,
-		lh_pose->Pos[0], lh_pose->Pos[1], lh_pose->Pos[2], lh_pose->Rot[0], lh_pose->Rot[1], lh_pose->Rot[2],
-		lh_pose->Rot[3]);
+	recording_line line;
+	recording_line_begin(&line, recordingData, "");
+	recording_line_int(&line, mode);
+	recording_line_str(&line, " LH_POSE ");
+	recording_line_flts(&line, lh_pose->Pos, 3);
+	recording_line_flts(&line, lh_pose->Rot, 4);
+	recording_line_str(&line, "\r\n");
+	recording_line_flush(&line);
 }
 void survive_recording_velocity_process(SurviveObject *so, uint8_t lighthouse, const SurviveVelocity *pose) {
 	SurviveRecordingData *recordingData = so->ctx->recptr;
 	if (recordingData == 0)
 		return;
 
-	survive_recording_write_to_output(
-		recordingData, "%s VELOCITY " FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF "\r\n",
-		so->codename, pose->Pos[0], pose->Pos[1], pose->Pos[2], pose->AxisAngleRot[0], pose->AxisAngleRot[1],
-		pose->AxisAngleRot[2]);
+	recording_line line;
+	recording_line_begin(&line, recordingData, so->codename);
+	recording_line_str(&line, " VELOCITY ");
+	recording_line_flts(&line, pose->Pos, 3);
+	recording_line_flts(&line, pose->AxisAngleRot, 3);
+	recording_line_str(&line, "\r\n");
+	recording_line_flush(&line);
 }
 void survive_recording_raw_pose_process(SurviveObject *so, uint8_t lighthouse, const SurvivePose *pose) {
 	SurviveRecordingData *recordingData = so->ctx->recptr;
 	if (recordingData == 0)
 		return;
 
-	survive_recording_write_to_output(
-		recordingData, "%s POSE " FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF "\r\n",
-		so->codename, pose->Pos[0], pose->Pos[1], pose->Pos[2], pose->Rot[0], pose->Rot[1], pose->Rot[2], pose->Rot[3]);
+	recording_line line;
+	recording_line_begin(&line, recordingData, so->codename);
+	recording_line_str(&line, " POSE ");
+	recording_line_flts(&line, pose->Pos, 3);
+	recording_line_flts(&line, pose->Rot, 4);
+	recording_line_str(&line, "\r\n");
+	recording_line_flush(&line);
 }
 
 void survive_recording_external_velocity_process(SurviveContext *ctx, const char *name, const SurviveVelocity *pose) {
@@ -148,10 +293,13 @@ void survive_recording_external_velocity_process(SurviveContext *ctx, const char
 	if (recordingData == 0)
 		return;
 
-	survive_recording_write_to_output(
-		recordingData, "%s EXTERNAL_VELOCITY " FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF "\r\n",
-		name, pose->Pos[0], pose->Pos[1], pose->Pos[2], pose->AxisAngleRot[0], pose->AxisAngleRot[1],
-		pose->AxisAngleRot[2]);
+	recording_line line;
+	recording_line_begin(&line, recordingData, name);
+	recording_line_str(&line, " EXTERNAL_VELOCITY ");
+	recording_line_flts(&line, pose->Pos, 3);
+	recording_line_flts(&line, pose->AxisAngleRot, 3);
+	recording_line_str(&line, "\r\n");
+	recording_line_flush(&line);
 }
 
 void survive_recording_external_pose_process(SurviveContext *ctx, const char *name, const SurvivePose *pose) {
@@ -159,10 +307,13 @@ void survive_recording_external_pose_process(SurviveContext *ctx, const char *na
 	if (recordingData == 0)
 		return;
 
-	survive_recording_write_to_output(
-		recordingData,
-		"%s EXTERNAL_POSE " FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF "\n", name,
-		pose->Pos[0], pose->Pos[1], pose->Pos[2], pose->Rot[0], pose->Rot[1], pose->Rot[2], pose->Rot[3]);
+	recording_line line;
+	recording_line_begin(&line, recordingData, name);
+	recording_line_str(&line, " EXTERNAL_POSE ");
+	recording_line_flts(&line, pose->Pos, 3);
+	recording_line_flts(&line, pose->Rot, 4);
+	recording_line_str(&line, "\n");
+	recording_line_flush(&line);
 }
 
 void survive_recording_info_process(SurviveContext *ctx, const char *fault) {
@@ -182,7 +333,15 @@ void survive_recording_sync_process(SurviveObject *so, survive_channel channel,
 		return;
 	}
 
-	survive_recording_write_to_output(recordingData, SYNC_PRINTF, SYNC_PRINTF_ARGS);
+	recording_line line;
+	recording_line_begin(&line, recordingData, dev);
+	recording_line_str(&line, " Y ");
+	recording_line_uint(&line, channel);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, timecode);
+	recording_line_str(&line, ootx ? " 1 " : " 0 ");
+	recording_line_str(&line, gen ? "1\n" : "0\n");
+	recording_line_flush(&line);
 }
 
 void survive_recording_sweep_angle_process(SurviveObject *so, survive_channel channel, int sensor_id,
@@ -193,7 +352,20 @@ void survive_recording_sweep_angle_process(SurviveObject *so, survive_channel ch
 	}
 
 	const char *dev = so->codename;
-	survive_recording_write_to_output(recordingData, SWEEP_ANGLE_PRINTF, SWEEP_ANGLE_PRINTF_ARGS);
+	recording_line line;
+	recording_line_begin(&line, recordingData, dev);
+	recording_line_str(&line, " B ");
+	recording_line_uint(&line, channel);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, (uint32_t)sensor_id);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, timecode);
+	recording_line_str(&line, " ");
+	recording_line_int(&line, plane);
+	recording_line_str(&line, " ");
+	recording_line_flt_exp(&line, angle);
+	recording_line_str(&line, "\n");
+	recording_line_flush(&line);
 }
 
 void survive_recording_sweep_process(SurviveObject *so, survive_channel channel, int sensor_id,
@@ -208,7 +380,16 @@ void survive_recording_sweep_process(SurviveObject *so, survive_channel channel,
 		return;
 
 	const char *dev = so->codename;
-	survive_recording_write_to_output(recordingData, SWEEP_PRINTF, SWEEP_PRINTF_ARGS);
+	recording_line line;
+	recording_line_begin(&line, recordingData, dev);
+	recording_line_str(&line, " W ");
+	recording_line_uint(&line, channel);
+	recording_line_str(&line, " ");
+	recording_line_int(&line, sensor_id);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, timecode);
+	recording_line_str(&line, flag ? " 1\n" : " 0\n");
+	recording_line_flush(&line);
 }
 
 void survive_recording_button_process(SurviveObject *so, enum SurviveInputEvent eventType, enum SurviveButton buttonId,
@@ -220,7 +401,14 @@ void survive_recording_button_process(SurviveObject *so, enum SurviveInputEvent
 	}
 
 	const char *dev = so->codename;
-	survive_recording_write_to_output(recordingData, "%s BUTTON %u %u\r\n", dev, eventType, buttonId);
+	recording_line line;
+	recording_line_begin(&line, recordingData, dev);
+	recording_line_str(&line, " BUTTON ");
+	recording_line_uint(&line, eventType);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, buttonId);
+	recording_line_str(&line, "\r\n");
+	recording_line_flush(&line);
 }
 void survive_recording_angle_process(struct SurviveObject *so, int sensor_id, int acode, uint32_t timecode, FLT length,
 									 FLT angle, uint32_t lh) {
@@ -229,8 +417,20 @@ void survive_recording_angle_process(struct SurviveObject *so, int sensor_id, in
 		return;
 	}
 
-	survive_recording_write_to_output(recordingData, "%s A %d %d %u " FLT_PRINTF FLT_PRINTF "%u\r\n", so->codename,
-									  sensor_id, acode, timecode, length, angle, lh);
+	recording_line line;
+	recording_line_begin(&line, recordingData, so->codename);
+	recording_line_str(&line, " A ");
+	recording_line_int(&line, sensor_id);
+	recording_line_str(&line, " ");
+	recording_line_int(&line, acode);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, timecode);
+	recording_line_str(&line, " ");
+	recording_line_flt(&line, length);
+	recording_line_flt(&line, angle);
+	recording_line_uint(&line, lh);
+	recording_line_str(&line, "\r\n");
+	recording_line_flush(&line);
 }
 
 void survive_recording_lightcap(SurviveObject *so, LightcapElement *le) {
@@ -239,8 +439,16 @@ void survive_recording_lightcap(SurviveObject *so, LightcapElement *le) {
 		return;
 
 	if (recordingData->writeRawLight) {
-		survive_recording_write_to_output(recordingData, "%s C %d %u %u\r\n", so->codename, le->sensor_id,
-										  le->timestamp, le->length);
+		recording_line line;
+		recording_line_begin(&line, recordingData, so->codename);
+		recording_line_str(&line, " C ");
+		recording_line_int(&line, le->sensor_id);
+		recording_line_str(&line, " ");
+		recording_line_uint(&line, le->timestamp);
+		recording_line_str(&line, " ");
+		recording_line_uint(&line, le->length);
+		recording_line_str(&line, "\r\n");
+		recording_line_flush(&line);
 	}
 }
 
@@ -254,11 +462,8 @@ void survive_recording_light_process(struct SurviveObject *so, int sensor_id, in
 	  return;
 	}
 	
-	if (acode == -1) {
-		survive_recording_write_to_output(recordingData, "%s S %d %d %d %u %u %u\r\n", so->codename, sensor_id, acode,
-										  timeinsweep, timecode, length, lh);
-		return;
-	}
+	recording_line line;
+	recording_line_begin(&line, recordingData, so->codename);
 
 	const char *LH_ID = 0;
 	const char *LH_Axis = 0;
@@ -286,8 +491,45 @@ void survive_recording_light_process(struct SurviveObject *so, int sensor_id, in
 		break;
 	}
 
-	survive_recording_write_to_output(recordingData, "%s %s %s %d %d %d %u %u %u\r\n", so->codename, LH_ID, LH_Axis,
-									  sensor_id, acode, timeinsweep, timecode, length, lh);
+	if (acode == -1) {
+		recording_line_str(&line, " S ");
+	} else {
+		recording_line_str(&line, " ");
+		recording_line_str(&line, LH_ID ? LH_ID : "(null)");
+		recording_line_str(&line, " ");
+		recording_line_str(&line, LH_Axis ? LH_Axis : "(null)");
+		recording_line_str(&line, " ");
+	}
+	recording_line_int(&line, sensor_id);
+	recording_line_str(&line, " ");
+	recording_line_int(&line, acode);
+	recording_line_str(&line, " ");
+	recording_line_int(&line, timeinsweep);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, timecode);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, length);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, lh);
+	recording_line_str(&line, "\r\n");
+	recording_line_flush(&line);
+}
+
+static void recording_imu_line(SurviveRecordingData *recordingData, const char *dev, const char *type, int mask,
+							   const FLT *accelgyro, uint32_t timecode, int id) {
+	recording_line line;
+	recording_line_begin(&line, recordingData, dev);
+	recording_line_str(&line, type);
+	recording_line_int(&line, mask);
+	recording_line_str(&line, " ");
+	recording_line_uint(&line, timecode);
+	recording_line_str(&line, " ");
+	recording_line_flts(&line, accelgyro, 6);
+	recording_line_str(&line, " ");
+	recording_line_flts(&line, accelgyro + 6, 3);
+	recording_line_int(&line, id);
+	recording_line_str(&line, "\r\n");
+	recording_line_flush(&line);
 }
 
 void survive_recording_imu_process(struct SurviveObject *so, int mask, const FLT *accelgyro, uint32_t timecode,
@@ -300,12 +542,7 @@ void survive_recording_imu_process(struct SurviveObject *so, int mask, const FLT
 		return;
 	}
 
-	survive_recording_write_to_output(recordingData,
-									  "%s I %d %u " FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF
-									  " " FLT_PRINTF FLT_PRINTF FLT_PRINTF "%d\r\n",
-									  so->codename, mask, timecode, accelgyro[0], accelgyro[1], accelgyro[2],
-									  accelgyro[3], accelgyro[4], accelgyro[5], accelgyro[6], accelgyro[7],
-									  accelgyro[8], id);
+	recording_imu_line(recordingData, so->codename, " I ", mask, accelgyro, timecode, id);
 }
 
 void survive_recording_raw_imu_process(struct SurviveObject *so, int mask, const FLT *accelgyro, uint32_t timecode,
@@ -318,17 +555,16 @@ void survive_recording_raw_imu_process(struct SurviveObject *so, int mask, const
 		return;
 	}
 
-	survive_recording_write_to_output(recordingData,
-									  "%s i %d %u " FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF
-									  " " FLT_PRINTF FLT_PRINTF FLT_PRINTF "%d\r\n",
-									  so->codename, mask, timecode, accelgyro[0], accelgyro[1], accelgyro[2],
-									  accelgyro[3], accelgyro[4], accelgyro[5], accelgyro[6], accelgyro[7],
-									  accelgyro[8], id);
+	recording_imu_line(recordingData, so->codename, " i ", mask, accelgyro, timecode, id);
 }
 
 void survive_destroy_recording(SurviveContext *ctx) {
 	if (ctx->recptr) {
 		gzclose(ctx->recptr->output_file);
+		if (ctx->recptr->index_file)
+			fclose(ctx->recptr->index_file);
+		if (ctx->recptr->index_interval > 0)
+			close(ctx->recptr->fd);
 		free(ctx->recptr);
 		ctx->recptr = 0;
 	}
@@ -360,14 +596,34 @@ void survive_install_recording(SurviveContext *ctx) {
 			} else {
 
 				bool useCompression = strncmp(dataout_file + strlen(dataout_file) - 3, ".gz", 3) == 0;
+				ctx->recptr->mode = useCompression ? "w6F" : "wT";
+				ctx->recptr->index_interval = survive_configf(ctx, RECORD_INDEX_INTERVAL_TAG, SC_GET, 1.);
+
+				if (ctx->recptr->index_interval > 0) {
+					ctx->recptr->fd = open(dataout_file, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+					ctx->recptr->output_file =
+						ctx->recptr->fd >= 0 ? gzdopen(dup(ctx->recptr->fd), ctx->recptr->mode) : 0;
+				} else {
+					ctx->recptr->output_file = gzopen(dataout_file, ctx->recptr->mode);
+				}
 
-				ctx->recptr->output_file = gzopen(dataout_file, useCompression ? "w6F" : "wT");
 				if (ctx->recptr->output_file == 0) {
 					SV_INFO("Could not open %s for writing", dataout_file);
+					if (ctx->recptr->index_interval > 0 && ctx->recptr->fd >= 0)
+						close(ctx->recptr->fd);
 					free(ctx->recptr);
 					ctx->recptr = 0;
 					return;
 				}
+
+				if (ctx->recptr->index_interval > 0) {
+					char index_path[1024];
+					snprintf(index_path, sizeof(index_path), "%s.idx", dataout_file);
+					ctx->recptr->index_file = fopen(index_path, "w");
+					if (ctx->recptr->index_file == 0) {
+						SV_WARN("Could not open %s.idx for writing; recording will not be seekable", dataout_file);
+					}
+				}
 				SV_INFO("Recording to '%s' Compression: %d", dataout_file, useCompression);
 			}
 		}
@@ -89,7 +89,7 @@ uint64_t SurviveSensorActivations_runtime(SurviveSensorActivations *self, surviv
 	return self->runtime_offset + (uint64_t)(tc * 0.0208333333);
 }
 
-void SurviveSensorActivations_add_imu(SurviveSensorActivations *self, struct PoserDataIMU *imuData) {
+static void add_imu(SurviveSensorActivations *self, struct PoserDataIMU *imuData) {
 	self->last_imu = imuData->hdr.timecode;
 	// fprintf(stderr, "imu tc: %f\n", self->last_imu/ 48000000.);
 	if (self->imu_init_cnt > 0) {
@@ -121,6 +121,12 @@ void SurviveSensorActivations_add_imu(SurviveSensorActivations *self, struct Pos
 	}
 }
 
+void SurviveSensorActivations_add_imu(SurviveSensorActivations *self, struct PoserDataIMU *imuData) {
+	SV_TRACE_BEGIN("activations imu");
+	add_imu(self, imuData);
+	SV_TRACE_END("activations imu");
+}
+
 static inline void SurviveSensorActivations_update_center(SurviveSensorActivations *self, FLT alpha, int lh, int axis,
 														  FLT oldval, FLT angle) {
 	FLT *mean_sum = &self->angles_center_x[lh][axis];
@@ -222,7 +228,7 @@ SURVIVE_EXPORT void SurviveSensorActivations_valid_counts(SurviveSensorActivatio
 		}
 	}
 }
-bool SurviveSensorActivations_add_gen2(SurviveSensorActivations *self, struct PoserDataLightGen2 *lightData) {
+static bool add_gen2(SurviveSensorActivations *self, struct PoserDataLightGen2 *lightData) {
 	self->lh_gen = 1;
 	if (lightData->common.hdr.pt == POSERDATA_SYNC_GEN2) {
 		SurviveSensorActivations_add_sync(self, &lightData->common);
@@ -262,6 +268,13 @@ bool SurviveSensorActivations_add_gen2(SurviveSensorActivations *self, struct Po
 	return true;
 }
 
+bool SurviveSensorActivations_add_gen2(SurviveSensorActivations *self, struct PoserDataLightGen2 *lightData) {
+	SV_TRACE_BEGIN("activations light");
+	bool rtn = add_gen2(self, lightData);
+	SV_TRACE_END("activations light");
+	return rtn;
+}
+
 SURVIVE_EXPORT void SurviveSensorActivations_reset(SurviveSensorActivations *self) {
 	struct SurviveObject *so = self->so;
 	struct SurviveSensorActivations_params p = self->params;
@@ -356,7 +369,7 @@ void SurviveSensorActivations_add_sync(SurviveSensorActivations *self, struct Po
 	}
 }
 
-bool SurviveSensorActivations_add(SurviveSensorActivations *self, struct PoserDataLightGen1 *_lightData) {
+static bool add_gen1(SurviveSensorActivations *self, struct PoserDataLightGen1 *_lightData) {
 	self->lh_gen = 0;
 
 	int axis = (_lightData->acode & 1);
@@ -408,6 +421,13 @@ bool SurviveSensorActivations_add(SurviveSensorActivations *self, struct PoserDa
 	// fprintf(stderr, "lightcap tc: %f\n", lightData->hdr.timecode/ 48000000.);
 }
 
+bool SurviveSensorActivations_add(SurviveSensorActivations *self, struct PoserDataLightGen1 *_lightData) {
+	SV_TRACE_BEGIN("activations light");
+	bool rtn = add_gen1(self, _lightData);
+	SV_TRACE_END("activations light");
+	return rtn;
+}
+
 static inline survive_long_timecode make_long_timecode(survive_long_timecode prev, survive_timecode current) {
 	survive_long_timecode rtn = current | (prev & 0xFFFFFFFF00000000);
 
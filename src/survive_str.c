@@ -1,7 +1,10 @@
 #include "survive_str.h"
 #include "string.h"
 #include <assert.h>
+#include <float.h>
+#include <math.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include <survive.h>
 
 void str_ensure_size(cstring *str, size_t s) {
@@ -51,4 +54,298 @@ void str_clear(cstring *str) {
 	str->length = 0;
 	if (str->size > 0)
 		str->d[0] = 0;
-}
\ No newline at end of file
+}
+
+static const double str_pow10[] = {1e0,	 1e1,  1e2,	 1e3,  1e4,	 1e5,  1e6,	 1e7,  1e8,	 1e9,  1e10, 1e11,
+								   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+#define STR_POW10_MAX ((int)(sizeof(str_pow10) / sizeof(str_pow10[0])) - 1)
+
+// Writes exactly 'width' digits of v, zero padded
+static inline void str_write_digits(char *buf, uint64_t v, int width) {
+	for (int i = width - 1; i >= 0; i--) {
+		buf[i] = '0' + (char)(v % 10);
+		v /= 10;
+	}
+}
+
+static inline int str_digit_count(uint64_t v) {
+	int rtn = 1;
+	while (v >= 10) {
+		v /= 10;
+		rtn++;
+	}
+	return rtn;
+}
+
+int str_format_uint(char *buf, uint64_t v) {
+	int len = str_digit_count(v);
+	str_write_digits(buf, v, len);
+	buf[len] = 0;
+	return len;
+}
+
+int str_format_int(char *buf, int64_t v) {
+	if (v < 0) {
+		buf[0] = '-';
+		return 1 + str_format_uint(buf + 1, (uint64_t)0 - (uint64_t)v);
+	}
+	return str_format_uint(buf, (uint64_t)v);
+}
+
+/*
+ * Rounds a scaled value to the nearest integer the same way printf rounds the exact decimal expansion. 'scaled' is the
+ * result of a single rounded multiply or divide, so it is within half an ulp of the true value; if that leaves any
+ * doubt about which side of a .5 boundary the true value lies on -- including exact ties, which printf breaks by the
+ * current rounding mode -- this returns false and the caller falls back to snprintf.
+ */
+static inline bool str_round_scaled(double scaled, uint64_t *out) {
+	if (!(scaled < 9007199254740992.)) // 2^53
+		return false;
+
+	double whole = floor(scaled);
+	double frac = scaled - whole;
+	if (fabs(frac - .5) <= scaled * DBL_EPSILON)
+		return false;
+
+	*out = (uint64_t)whole + (frac > .5);
+	return true;
+}
+
+int str_format_fixed(char *buf, double v, int precision) {
+	uint64_t digits;
+	if (precision < 0 || precision > 9 || !isfinite(v) || !str_round_scaled(fabs(v) * str_pow10[precision], &digits)) {
+		return snprintf(buf, STR_FORMAT_BUFFER_SIZE, "%.*f", precision, v);
+	}
+
+	char *p = buf;
+	if (signbit(v))
+		*p++ = '-';
+
+	uint64_t scale = (uint64_t)str_pow10[precision];
+	p += str_format_uint(p, digits / scale);
+	if (precision > 0) {
+		*p++ = '.';
+		str_write_digits(p, digits % scale, precision);
+		p += precision;
+	}
+	*p = 0;
+	return (int)(p - buf);
+}
+
+int str_format_exp(char *buf, double v, int precision, bool force_sign) {
+	if (precision < 0 || precision > 9 || !isfinite(v)) {
+		return snprintf(buf, STR_FORMAT_BUFFER_SIZE, force_sign ? "%+.*e" : "%.*e", precision, v);
+	}
+
+	double av = fabs(v);
+	int e10 = 0;
+	uint64_t digits = 0;
+
+	if (av != 0) {
+		// (e2 - 1) * log10(2) never overshoots floor(log10(av)); it can be one too low, which is fixed up below
+		int e2;
+		frexp(av, &e2);
+		e10 = (int)floor((e2 - 1) * 0.30102999566398119521);
+
+		for (int attempt = 0;; attempt++) {
+			int k = precision - e10;
+			if (attempt > 1 || k > STR_POW10_MAX || k < -STR_POW10_MAX) {
+				return snprintf(buf, STR_FORMAT_BUFFER_SIZE, force_sign ? "%+.*e" : "%.*e", precision, v);
+			}
+
+			double scaled = k >= 0 ? av * str_pow10[k] : av / str_pow10[-k];
+			if (scaled >= str_pow10[precision + 1]) {
+				e10++;
+				continue;
+			}
+
+			if (!str_round_scaled(scaled, &digits)) {
+				return snprintf(buf, STR_FORMAT_BUFFER_SIZE, force_sign ? "%+.*e" : "%.*e", precision, v);
+			}
+			break;
+		}
+
+		// Rounding up can carry into a new leading digit; ie 9.9999996 -> 1.000000e+01
+		if (digits >= (uint64_t)str_pow10[precision + 1]) {
+			digits /= 10;
+			e10++;
+		}
+	}
+
+	char *p = buf;
+	if (signbit(v))
+		*p++ = '-';
+	else if (force_sign)
+		*p++ = '+';
+
+	uint64_t scale = (uint64_t)str_pow10[precision];
+	*p++ = '0' + (char)(digits / scale);
+	if (precision > 0) {
+		*p++ = '.';
+		str_write_digits(p, digits % scale, precision);
+		p += precision;
+	}
+
+	*p++ = 'e';
+	*p++ = e10 < 0 ? '-' : '+';
+	int ae10 = abs(e10);
+	int exp_width = ae10 < 10 ? 2 : str_digit_count(ae10);
+	str_write_digits(p, ae10, exp_width);
+	p += exp_width;
+	*p = 0;
+	return (int)(p - buf);
+}
+
+char *str_next_token(char **cursor) {
+	char *p = *cursor;
+	while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\v' || *p == '\f')
+		p++;
+
+	if (*p == 0) {
+		*cursor = p;
+		return 0;
+	}
+
+	char *token = p;
+	while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '\v' && *p != '\f')
+		p++;
+
+	if (*p)
+		*p++ = 0;
+	*cursor = p;
+	return token;
+}
+
+/*
+ * Reads a plain decimal number with at most 19 significant digits and returns it as mantissa * 10^exp10. Anything else
+ * -- hex floats, inf/nan, trailing characters -- returns false so the caller can defer to libc.
+ */
+static bool str_parse_decimal(const char *str, bool *negative, uint64_t *mantissa, int *exp10) {
+	const char *p = str;
+	*negative = *p == '-';
+	if (*p == '-' || *p == '+')
+		p++;
+
+	uint64_t m = 0;
+	int significant = 0, e = 0;
+	bool any_digits = false;
+
+	for (; *p >= '0' && *p <= '9'; p++) {
+		any_digits = true;
+		if (m == 0 && *p == '0')
+			continue;
+		if (++significant > 19)
+			return false;
+		m = m * 10 + (*p - '0');
+	}
+
+	if (*p == '.') {
+		for (p++; *p >= '0' && *p <= '9'; p++) {
+			any_digits = true;
+			e--;
+			if (m == 0 && *p == '0')
+				continue;
+			if (++significant > 19)
+				return false;
+			m = m * 10 + (*p - '0');
+		}
+	}
+
+	if (!any_digits)
+		return false;
+
+	if (*p == 'e' || *p == 'E') {
+		p++;
+		bool negative_exp = *p == '-';
+		if (*p == '-' || *p == '+')
+			p++;
+
+		int exp_digits = 0, exp = 0;
+		for (; *p >= '0' && *p <= '9'; p++) {
+			if (++exp_digits > 4)
+				return false;
+			exp = exp * 10 + (*p - '0');
+		}
+		if (exp_digits == 0)
+			return false;
+		e += negative_exp ? -exp : exp;
+	}
+
+	if (*p != 0)
+		return false;
+
+	*mantissa = m;
+	*exp10 = e;
+	return true;
+}
+
+/*
+ * When both the mantissa and the power of ten are exactly representable, a single multiply or divide is correctly
+ * rounded and so matches strtod exactly.
+ */
+static bool str_parse_double_fast(const char *str, double *out) {
+	bool negative;
+	uint64_t mantissa;
+	int exp10;
+	if (!str_parse_decimal(str, &negative, &mantissa, &exp10))
+		return false;
+
+	if (mantissa > (1ull << 53) || exp10 > STR_POW10_MAX || exp10 < -STR_POW10_MAX)
+		return false;
+
+	double v = (double)mantissa;
+	v = exp10 < 0 ? v / str_pow10[-exp10] : v * str_pow10[exp10];
+	*out = negative ? -v : v;
+	return true;
+}
+
+bool str_parse_double(const char *str, double *out) {
+	if (str_parse_double_fast(str, out))
+		return true;
+
+	char *end = 0;
+	*out = strtod(str, &end);
+	return end != str;
+}
+
+bool str_parse_float(const char *str, float *out) {
+	double d;
+	if (str_parse_double_fast(str, &d)) {
+		// Rounding to double and then to float only differs from rounding straight to float when the double landed
+		// exactly halfway between two floats.
+		float f = (float)d;
+		if ((double)f == d || isinf(f) ||
+			(double)f + ((double)nextafterf(f, d > f ? INFINITY : -INFINITY) - (double)f) / 2. != d) {
+			*out = f;
+			return true;
+		}
+	}
+
+	char *end = 0;
+	*out = strtof(str, &end);
+	return end != str;
+}
+
+bool str_parse_int(const char *str, int64_t *out) {
+	const char *p = str;
+	bool negative = *p == '-';
+	if (*p == '-' || *p == '+')
+		p++;
+
+	uint64_t v = 0;
+	const char *digits = p;
+	for (; *p >= '0' && *p <= '9' && p - digits < 18; p++)
+		v = v * 10 + (*p - '0');
+
+	if (p == digits)
+		return false;
+
+	if (*p >= '0' && *p <= '9') {
+		char *end = 0;
+		*out = strtoll(str, &end, 10);
+		return end != str;
+	}
+
+	*out = negative ? -(int64_t)v : (int64_t)v;
+	return true;
+}
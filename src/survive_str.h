@@ -1,6 +1,7 @@
 #ifndef SURVIVE_STR_H
 #define SURVIVE_STR_H
 #include "survive_types.h"
+#include <stdbool.h>
 #include <stdlib.h>
 
 typedef struct cstring {
@@ -9,11 +10,47 @@ typedef struct cstring {
 	size_t size;
 } cstring;
 
-void str_ensure_size(cstring *str, size_t s);
-char *str_increase_by(cstring *str, size_t len);
+SURVIVE_EXPORT void str_ensure_size(cstring *str, size_t s);
+SURVIVE_EXPORT char *str_increase_by(cstring *str, size_t len);
 SURVIVE_EXPORT void str_append(cstring *str, const char *add);
 SURVIVE_EXPORT int str_append_printf(cstring *str, const char *format, ...);
 SURVIVE_EXPORT void str_free(cstring *str);
 SURVIVE_EXPORT void str_clear(cstring *str);
 SURVIVE_EXPORT void str_append_n(cstring* cstr, const char* buffer, size_t len);
+
+/**
+ * Allocation free number formatters. Each writes into buf, which must hold at least STR_FORMAT_BUFFER_SIZE bytes,
+ * null terminates it and returns the number of characters written. The output is byte for byte what the printf family
+ * would produce for the equivalent format; inputs the fast path can't prove it rounds correctly are handed to snprintf.
+ */
+#define STR_FORMAT_BUFFER_SIZE 384
+
+// Equivalent to "%.<precision>f"; precision must be in [0, 9]
+SURVIVE_EXPORT int str_format_fixed(char *buf, double v, int precision);
+// Equivalent to "%.<precision>e", or "%+.<precision>e" if force_sign is set; precision must be in [0, 9]
+SURVIVE_EXPORT int str_format_exp(char *buf, double v, int precision, bool force_sign);
+// Equivalent to "%" PRIu64
+SURVIVE_EXPORT int str_format_uint(char *buf, uint64_t v);
+// Equivalent to "%" PRId64
+SURVIVE_EXPORT int str_format_int(char *buf, int64_t v);
+
+/**
+ * In place, allocation free tokenizer for whitespace delimited text. Returns the next token, null terminated, and moves
+ * the cursor past the single delimiter following it. Returns 0 once the input is exhausted.
+ */
+SURVIVE_EXPORT char *str_next_token(char **cursor);
+
+/**
+ * Number parsers with the same results as strtod / strtof / strtoll; common short decimal inputs are converted exactly
+ * without calling into libc. Each returns false if no number could be read from the start of str.
+ */
+SURVIVE_EXPORT bool str_parse_double(const char *str, double *out);
+SURVIVE_EXPORT bool str_parse_float(const char *str, float *out);
+SURVIVE_EXPORT bool str_parse_int(const char *str, int64_t *out);
+
+#ifdef USE_FLOAT
+#define str_parse_flt str_parse_float
+#else
+#define str_parse_flt str_parse_double
+#endif
 #endif
\ No newline at end of file
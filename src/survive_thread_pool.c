@@ -0,0 +1,127 @@
+#include "os_generic.h"
+#include "survive.h"
+
+#include <stdlib.h>
+
+STATIC_CONFIG_ITEM(WORKER_THREADS, "worker-threads", 'i',
+				   "Extra threads the solvers share to split up their work, such as MPFIT's numerical jacobian "
+				   "columns, the barycentric SVD poser's per lighthouse solves and RANSAC's pose hypotheses. Set to 0 "
+				   "to do all of it on the calling thread.",
+				   0)
+
+struct survive_thread_pool {
+	og_mutex_t lock;
+	og_cv_t job_available, job_done;
+	og_thread_t *threads;
+	int thread_cnt;
+	bool quit;
+
+	// The job being run; 'next' is the next index to hand out and 'busy' is set while a caller waits on it
+	void (*fn)(void *arg, int i);
+	void *arg;
+	int cnt, next, done;
+	bool busy;
+};
+
+// Runs indices of the current job until there are none left to hand out; called with the lock held
+static void pool_run_job(struct survive_thread_pool *pool) {
+	while (pool->next < pool->cnt) {
+		int i = pool->next++;
+		void (*fn)(void *arg, int i) = pool->fn;
+		void *arg = pool->arg;
+		OGUnlockMutex(pool->lock);
+
+		fn(arg, i);
+
+		OGLockMutex(pool->lock);
+		if (++pool->done == pool->cnt)
+			OGSignalCond(pool->job_done);
+	}
+}
+
+static void *pool_thread(void *_pool) {
+	struct survive_thread_pool *pool = _pool;
+
+	OGLockMutex(pool->lock);
+	while (!pool->quit) {
+		pool_run_job(pool);
+		OGWaitCond(pool->job_available, pool->lock);
+	}
+	OGUnlockMutex(pool->lock);
+	return 0;
+}
+
+void survive_thread_pool_parallel_for(void *data, int cnt, void (*fn)(void *arg, int i), void *arg) {
+	struct survive_thread_pool *pool = data;
+
+	if (pool == 0) {
+		for (int i = 0; i < cnt; i++)
+			fn(arg, i);
+		return;
+	}
+
+	OGLockMutex(pool->lock);
+	// One job at a time; a job that comes in while another is using the threads -- from another solver, or from
+	// inside a job -- just runs on its own thread
+	if (pool->busy) {
+		OGUnlockMutex(pool->lock);
+		for (int i = 0; i < cnt; i++)
+			fn(arg, i);
+		return;
+	}
+
+	pool->busy = true;
+	pool->fn = fn;
+	pool->arg = arg;
+	pool->cnt = cnt;
+	pool->next = pool->done = 0;
+	OGBroadcastCond(pool->job_available);
+
+	pool_run_job(pool);
+	while (pool->done < pool->cnt)
+		OGWaitCond(pool->job_done, pool->lock);
+
+	pool->cnt = pool->next = pool->done = 0;
+	pool->busy = false;
+	OGUnlockMutex(pool->lock);
+}
+
+int survive_thread_pool_thread_cnt(const struct survive_thread_pool *pool) { return pool ? pool->thread_cnt : 0; }
+
+struct survive_thread_pool *survive_thread_pool_create(SurviveContext *ctx, int thread_cnt) {
+	if (thread_cnt < 0)
+		thread_cnt = survive_configi(ctx, WORKER_THREADS_TAG, SC_GET, 0);
+	if (thread_cnt <= 0)
+		return 0;
+
+	struct survive_thread_pool *pool = SV_CALLOC(sizeof(struct survive_thread_pool));
+	pool->lock = OGCreateMutex();
+	pool->job_available = OGCreateConditionVariable();
+	pool->job_done = OGCreateConditionVariable();
+	pool->thread_cnt = thread_cnt;
+	pool->threads = SV_CALLOC(sizeof(og_thread_t) * thread_cnt);
+	for (int i = 0; i < thread_cnt; i++)
+		pool->threads[i] = OGCreateThread(pool_thread, "worker", pool);
+
+	SV_VERBOSE(110, "Started %d worker threads", thread_cnt);
+	return pool;
+}
+
+void survive_thread_pool_free(struct survive_thread_pool *pool) {
+	if (pool == 0)
+		return;
+
+	OGLockMutex(pool->lock);
+	pool->quit = true;
+	OGBroadcastCond(pool->job_available);
+	OGUnlockMutex(pool->lock);
+
+	for (int i = 0; i < pool->thread_cnt; i++)
+		OGJoinThread(pool->threads[i]);
+
+	OGDeleteConditionVariable(pool->job_available);
+	OGDeleteConditionVariable(pool->job_done);
+	OGDeleteMutex(pool->lock);
+	free(pool->threads);
+	free(pool);
+}
@@ -0,0 +1,207 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "survive_trace.h"
+#include "os_generic.h"
+#include "survive_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+STATIC_CONFIG_ITEM(TRACE, "trace", 's', "Record a trace of the hot paths and write it to this file on close", 0)
+STATIC_CONFIG_ITEM(TRACE_BUFFER_SIZE, "trace-buffer-size", 'i', "Number of trace events kept per thread", 1 << 16)
+
+#ifdef _MSC_VER
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#define TRACE_LOAD_ACQUIRE(p) (*(volatile uint64_t *)(p))
+#define TRACE_STORE_RELEASE(p, v) (*(volatile uint64_t *)(p) = (v))
+#define TRACE_LOAD_SESSION(p) (*(volatile uint32_t *)(p))
+#define TRACE_STORE_SESSION(p, v) (*(volatile uint32_t *)(p) = (v))
+#else
+#define TRACE_THREAD_LOCAL __thread
+#define TRACE_LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define TRACE_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define TRACE_LOAD_SESSION(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define TRACE_STORE_SESSION(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#endif
+
+typedef struct trace_event {
+	uint64_t time_ns;
+	const char *name;
+	char object[7];
+	char phase;
+} trace_event;
+
+typedef struct trace_buffer {
+	struct trace_buffer *next;
+	int tid;
+	char thread_name[32];
+	// Trace session the buffer is recording for; buffers left over from earlier sessions aren't exported
+	uint32_t session;
+
+	// Only the owning thread writes; 'head' is the total number of events ever written to it
+	uint64_t head;
+	uint64_t mask;
+	trace_event events[];
+} trace_buffer;
+
+// The running session, or 0 while not tracing. This is the only thing writers check before recording.
+static uint32_t trace_session;
+static uint32_t trace_last_session;
+static size_t trace_buffer_size;
+static uint64_t trace_start_ns;
+
+/*
+ * Buffers are never freed: a thread can be in the middle of writing an event when tracing stops, and there is no
+ * cheap way to know when it is done. A thread reuses its own buffer in later sessions when the size allows, so
+ * memory only grows with the number of threads that ever recorded.
+ */
+static og_mutex_t trace_lock;
+static trace_buffer *trace_buffers;
+static int trace_thread_cnt;
+
+static TRACE_THREAD_LOCAL trace_buffer *thread_buffer;
+
+static uint64_t trace_now_ns() {
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER counter;
+	if (freq.QuadPart == 0)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)((double)counter.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static trace_buffer *register_thread(trace_buffer *buffer, uint32_t session) {
+	OGLockMutex(trace_lock);
+	if (buffer == 0 || buffer->mask != trace_buffer_size - 1) {
+		buffer = calloc(1, sizeof(trace_buffer) + sizeof(trace_event) * trace_buffer_size);
+		buffer->mask = trace_buffer_size - 1;
+#if defined(__GLIBC__)
+		pthread_getname_np(pthread_self(), buffer->thread_name, sizeof(buffer->thread_name));
+#endif
+		buffer->tid = ++trace_thread_cnt;
+		if (buffer->thread_name[0] == 0)
+			snprintf(buffer->thread_name, sizeof(buffer->thread_name), "thread %d", buffer->tid);
+		buffer->next = trace_buffers;
+		trace_buffers = buffer;
+	}
+	buffer->head = 0;
+	buffer->session = session;
+	OGUnlockMutex(trace_lock);
+
+	thread_buffer = buffer;
+	return buffer;
+}
+
+static inline void trace_record(char phase, const char *name, const char *object) {
+	uint32_t session = TRACE_LOAD_SESSION(&trace_session);
+	if (session == 0)
+		return;
+
+	trace_buffer *buffer = thread_buffer;
+	if (buffer == 0 || buffer->session != session)
+		buffer = register_thread(buffer, session);
+
+	uint64_t idx = buffer->head;
+	trace_event *event = &buffer->events[idx & buffer->mask];
+	event->time_ns = trace_now_ns();
+	event->name = name;
+	event->phase = phase;
+	if (object) {
+		strncpy(event->object, object, sizeof(event->object));
+	} else {
+		event->object[0] = 0;
+	}
+	TRACE_STORE_RELEASE(&buffer->head, idx + 1);
+}
+
+void survive_trace_begin(const char *name, const char *object) { trace_record('B', name, object); }
+void survive_trace_end(const char *name) { trace_record('E', name, 0); }
+
+bool survive_trace_start(size_t events_per_thread) {
+	if (trace_lock == 0)
+		trace_lock = OGCreateMutex();
+
+	OGLockMutex(trace_lock);
+	if (TRACE_LOAD_SESSION(&trace_session) != 0) {
+		OGUnlockMutex(trace_lock);
+		return false;
+	}
+
+	// Rounded up to a power of two so the ring index is a mask
+	trace_buffer_size = 1;
+	while (trace_buffer_size < events_per_thread)
+		trace_buffer_size <<= 1;
+
+	trace_start_ns = trace_now_ns();
+	if (++trace_last_session == 0)
+		trace_last_session = 1;
+	TRACE_STORE_SESSION(&trace_session, trace_last_session);
+	OGUnlockMutex(trace_lock);
+	return true;
+}
+
+void survive_trace_stop() { TRACE_STORE_SESSION(&trace_session, 0); }
+
+bool survive_trace_running() { return TRACE_LOAD_SESSION(&trace_session) != 0; }
+
+int survive_trace_export(const char *path) {
+	if (trace_lock == 0)
+		return 0;
+
+	FILE *f = fopen(path, "w");
+	if (f == 0)
+		return -1;
+
+	int cnt = 0;
+	fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+	fprintf(f, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"libsurvive\"}}");
+
+	OGLockMutex(trace_lock);
+	for (trace_buffer *buffer = trace_buffers; buffer; buffer = buffer->next) {
+		if (buffer->session != trace_last_session)
+			continue;
+
+		fprintf(f, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, ", buffer->tid);
+		fprintf(f, "\"args\": {\"name\": \"%s\"}}", buffer->thread_name);
+
+		uint64_t head = TRACE_LOAD_ACQUIRE(&buffer->head);
+		uint64_t start = head > trace_buffer_size ? head - trace_buffer_size : 0;
+
+		// Once the ring has wrapped it can start in the middle of a scope; ends without a begin are dropped
+		int depth = 0;
+		for (uint64_t i = start; i < head; i++) {
+			const trace_event *event = &buffer->events[i & buffer->mask];
+			if (event->phase == 'E' && depth == 0)
+				continue;
+			depth += event->phase == 'B' ? 1 : -1;
+
+			fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d", event->name,
+					event->phase, (double)(int64_t)(event->time_ns - trace_start_ns) / 1000., buffer->tid);
+			if (event->object[0])
+				fprintf(f, ", \"args\": {\"object\": \"%.7s\"}", event->object);
+			fprintf(f, "}");
+			cnt++;
+		}
+	}
+	OGUnlockMutex(trace_lock);
+
+	fprintf(f, "\n]}\n");
+	fclose(f);
+	return cnt;
+}
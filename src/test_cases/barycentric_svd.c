@@ -124,3 +124,50 @@ TEST(BarycentricSVD, Basic) {
 	bc_svd_dtor(&bc);
 	return 0;
 }
+
+TEST(BarycentricSVD, SharedSetup) {
+	LinmathPoint3d pts[] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1},
+							{0, 0, 0}, {1, 1, 1}, {1, 1, 0}, {.5, .2, .8}};
+	const size_t pts_cnt = sizeof(pts) / sizeof(pts[0]);
+
+	BaseStationCal bsd_cal[2] = {0};
+	SurvivePose poses[2] = {{.Pos = {.25, -.33, -2.}, .Rot = {1, .1, .2, .3}},
+							{.Pos = {-.5, .1, -3.}, .Rot = {.3, -.4, 1, .1}}};
+
+	bc_svd model = {0};
+	bc_svd_bc_svd(&model, 0, fill_m, pts, pts_cnt);
+
+	// Solvers sharing the model have to come up with what the model itself does, for any set of measurements
+	for (int p = 0; p < 2; p++) {
+		quatnormalize(poses[p].Rot, poses[p].Rot);
+
+		bc_svd shared = {0};
+		bc_svd_bc_svd_shared(&shared, &model);
+		assert(shared.setup.alphas == model.setup.alphas);
+
+		bc_svd_reset_correspondences(&model);
+		for (int i = 0; i < pts_cnt; i++) {
+			LinmathPoint3d ptInLH;
+			FLT meas[2];
+			ApplyPoseToPoint(ptInLH, &poses[p], pts[i]);
+			survive_reproject_xy(bsd_cal, ptInLH, meas);
+			bc_svd_add_correspondence(&model, i, meas[0], meas[1]);
+			bc_svd_add_correspondence(&shared, i, meas[0], meas[1]);
+		}
+
+		FLT R[3][3], t[3], R_shared[3][3], t_shared[3];
+		FLT err = bc_svd_compute_pose(&model, R, t);
+		FLT err_shared = bc_svd_compute_pose(&shared, R_shared, t_shared);
+		assert(err >= 0 && err == err_shared);
+		for (int i = 0; i < 3; i++) {
+			assert(t[i] == t_shared[i]);
+			for (int j = 0; j < 3; j++)
+				assert(R[i][j] == R_shared[i][j]);
+		}
+
+		bc_svd_dtor(&shared);
+	}
+
+	bc_svd_dtor(&model);
+	return 0;
+}
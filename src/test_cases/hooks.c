@@ -0,0 +1,68 @@
+#include "../survive_default_devices.h"
+#include "test_case.h"
+
+static SurviveSweepAngleEvent seen_angles[4];
+static size_t seen_angle_cnt;
+static void record_sweep_angle(SurviveObject *so, survive_channel channel, int sensor_id, survive_timecode timecode,
+							   int8_t plane, FLT angle) {
+	seen_angles[seen_angle_cnt++] = (SurviveSweepAngleEvent){channel, sensor_id, timecode, plane, angle};
+}
+
+static survive_timecode seen_raw_imu[4];
+static size_t seen_raw_imu_cnt;
+static void record_raw_imu(SurviveObject *so, int mask, const FLT *accelgyro, survive_timecode timecode, int id) {
+	seen_raw_imu[seen_raw_imu_cnt++] = timecode;
+}
+
+static int seen_imu_masks[4];
+static size_t seen_imu_cnt;
+static void record_imu(SurviveObject *so, int mask, const FLT *accelgyro, survive_timecode timecode, int id) {
+	seen_imu_masks[seen_imu_cnt++] = mask;
+}
+
+// Without an override the batch hooks hand every event, in order, to the single event hooks
+TEST(Hooks, BatchDefaults) {
+	SurviveContext *ctx = SV_CALLOC(sizeof(SurviveContext));
+#define SURVIVE_HOOK_PROCESS_DEF(hook) survive_install_##hook##_fn(ctx, 0);
+#define SURVIVE_HOOK_FEEDBACK_DEF(hook) survive_install_##hook##_fn(ctx, 0);
+#include "survive_hooks.h"
+	ctx->log_target = stderr;
+
+	SurviveObject *so = survive_create_device(ctx, "TST", 0, "TS0", 0);
+	survive_install_sweep_angle_fn(ctx, record_sweep_angle);
+	survive_install_raw_imu_fn(ctx, record_raw_imu);
+
+	SurviveSweepAngleEvent angles[] = {{.channel = 1, .sensor_id = 3, .timecode = 100, .plane = 0, .angle = .5},
+									   {.channel = 1, .sensor_id = 7, .timecode = 110, .plane = 0, .angle = -.25},
+									   {.channel = 2, .sensor_id = 3, .timecode = 120, .plane = 1, .angle = .125}};
+	SURVIVE_INVOKE_HOOK_SO(sweep_angle_batch, so, angles, 3);
+	ASSERT_EQ(seen_angle_cnt, 3);
+	// Each event goes through the hook machinery, so it shows up in the hook stats
+	ASSERT_EQ(ctx->sweep_angle_call_cnt, 3);
+	for (int i = 0; i < 3; i++) {
+		ASSERT_EQ(seen_angles[i].channel, angles[i].channel);
+		ASSERT_EQ(seen_angles[i].sensor_id, angles[i].sensor_id);
+		ASSERT_EQ(seen_angles[i].timecode, angles[i].timecode);
+		ASSERT_EQ(seen_angles[i].plane, angles[i].plane);
+		ASSERT_EQ(seen_angles[i].angle, angles[i].angle);
+	}
+
+	SurviveImuEvent samples[] = {{.mask = 3, .timecode = 200}, {.mask = 3, .timecode = 210}};
+	SURVIVE_INVOKE_HOOK_SO(raw_imu_batch, so, samples, 2);
+	ASSERT_EQ(seen_raw_imu_cnt, 2);
+	ASSERT_EQ(seen_raw_imu[0], 200);
+	ASSERT_EQ(seen_raw_imu[1], 210);
+
+	// Like the single sample default, the default raw batch hook passes calibrated accel and gyro on with mask 3
+	survive_install_raw_imu_fn(ctx, 0);
+	survive_install_imu_fn(ctx, record_imu);
+	SurviveImuEvent partial[] = {{.mask = 1, .timecode = 220}, {.mask = 2, .timecode = 230}};
+	SURVIVE_INVOKE_HOOK_SO(raw_imu_batch, so, partial, 2);
+	ASSERT_EQ(seen_imu_cnt, 2);
+	ASSERT_EQ(seen_imu_masks[0], 3);
+	ASSERT_EQ(seen_imu_masks[1], 3);
+
+	survive_destroy_device(so);
+	free(ctx);
+	return 0;
+}
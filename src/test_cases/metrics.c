@@ -0,0 +1,57 @@
+#include "test_case.h"
+#include <string.h>
+
+TEST(Metrics, Prometheus) {
+	SurviveContext ctx = {.metrics = survive_metrics_create()};
+
+	SurviveMetric *counter = survive_metric(&ctx, SURVIVE_METRIC_COUNTER, "test_events_total", "Events", 0);
+	ASSERT_EQ((survive_metric(&ctx, SURVIVE_METRIC_COUNTER, "test_events_total", "Events", 0) == counter), true);
+	SurviveMetric *labelled =
+		survive_metric(&ctx, SURVIVE_METRIC_COUNTER, "test_events_total", "Events", "object=\"HMD\"");
+	ASSERT_EQ((labelled != counter), true);
+	survive_metric_add(counter, 2);
+	survive_metric_add(labelled, 1);
+	survive_metric_add(labelled, 1);
+	ASSERT_EQ(survive_metric_value(counter), 2);
+
+	SurviveMetric *gauge = survive_metric(&ctx, SURVIVE_METRIC_GAUGE, "test_level", 0, 0);
+	survive_metric_set(gauge, 5);
+	survive_metric_set(gauge, 3);
+	ASSERT_EQ(survive_metric_value(gauge), 3);
+
+	SurviveMetric *histogram = survive_metric(&ctx, SURVIVE_METRIC_HISTOGRAM, "test_seconds", "Durations", 0);
+	const double bounds[] = {.1, 1};
+	survive_metric_set_buckets(histogram, bounds, 2);
+	survive_metric_observe(histogram, .05);
+	survive_metric_observe(histogram, .1);
+	survive_metric_observe(histogram, .5);
+	survive_metric_observe(histogram, 5);
+	ASSERT_EQ(survive_metric_value(histogram), 4);
+
+	// Null metrics are ignored
+	survive_metric_add(0, 1);
+	ASSERT_EQ((survive_metric(&ctx, SURVIVE_METRIC_GAUGE, "test_events_total", 0, 0) == 0), true);
+
+	char *text = survive_metrics_prometheus(&ctx);
+	const char *expected = "# HELP test_events_total Events\n"
+						   "# TYPE test_events_total counter\n"
+						   "test_events_total 2\n"
+						   "test_events_total{object=\"HMD\"} 2\n"
+						   "# TYPE test_level gauge\n"
+						   "test_level 3\n"
+						   "# HELP test_seconds Durations\n"
+						   "# TYPE test_seconds histogram\n"
+						   "test_seconds_bucket{le=\"0.1\"} 2\n"
+						   "test_seconds_bucket{le=\"1\"} 3\n"
+						   "test_seconds_bucket{le=\"+Inf\"} 4\n"
+						   "test_seconds_sum 5.65\n"
+						   "test_seconds_count 4\n";
+	if (strcmp(text, expected) != 0) {
+		fprintf(stderr, "Unexpected output:\n%s\n", text);
+		return survive_test_assert();
+	}
+
+	free(text);
+	survive_metrics_free(ctx.metrics);
+	return 0;
+}
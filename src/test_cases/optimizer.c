@@ -0,0 +1,310 @@
+#include "../poser_general_optimizer.h"
+#include "../survive_default_devices.h"
+#include "../survive_kalman_tracker.h"
+#include "test_case.h"
+#include <survive_optimizer.h>
+#include <survive_reproject.h>
+
+static FLT robust_rho(enum survive_optimizer_loss loss, FLT s, FLT r) {
+	r = fabs(r);
+	if (loss == SURVIVE_OPTIMIZER_LOSS_HUBER)
+		return r <= s ? r * r / 2 : s * r - s * s / 2;
+	return s * s / 2 * log(1 + (r / s) * (r / s));
+}
+
+/*
+ * The jacobian rows the optimizer hands to MPFIT are the measurement's rows scaled by the derivative of the robust
+ * deviate, so that derivative has to match a numerical one for every loss, on both sides of the scale. The squares of
+ * the deviates also have to add up to the loss itself.
+ */
+TEST(Optimizer, RobustLossJacobian) {
+	enum survive_optimizer_loss losses[] = {SURVIVE_OPTIMIZER_LOSS_HUBER, SURVIVE_OPTIMIZER_LOSS_CAUCHY};
+	FLT scale = .01;
+	FLT deviates[] = {1e-5, .003, -.007, .0125, -.02, .05, -.3, 2};
+
+	for (int l = 0; l < sizeof(losses) / sizeof(losses[0]); l++) {
+		for (int i = 0; i < sizeof(deviates) / sizeof(deviates[0]); i++) {
+			FLT r = deviates[i];
+			FLT analytic;
+			FLT f = survive_optimizer_robust_deviate(losses[l], scale, r, &analytic);
+
+			FLT h = 1e-6 * fabs(r), d;
+			FLT numeric = (survive_optimizer_robust_deviate(losses[l], scale, r + h, &d) -
+						   survive_optimizer_robust_deviate(losses[l], scale, r - h, &d)) /
+						  (2 * h);
+			ASSERT_DOUBLE_EQ(analytic, numeric);
+			ASSERT_DOUBLE_EQ(f * f / 2, robust_rho(losses[l], scale, r));
+			ASSERT_EQ((f < 0), (r < 0));
+		}
+	}
+
+	FLT d;
+	ASSERT_DOUBLE_EQ(survive_optimizer_robust_deviate(SURVIVE_OPTIMIZER_LOSS_SQUARED, scale, .3, &d), .3);
+	ASSERT_DOUBLE_EQ(d, 1.);
+	return 0;
+}
+
+#define RANSAC_LIGHTHOUSES 4
+#define RANSAC_SENSORS 24
+
+static const SurvivePose ransac_lighthouses[RANSAC_LIGHTHOUSES] = {
+	{.Pos = {-3, 0, 1}, .Rot = {-0.70710678118, 0, 0.70710678118, 0}},
+	{.Pos = {3, 0, 1}, .Rot = {0.70710678118, 0, 0.70710678118, 0}},
+	{.Pos = {0, 3, 1}, .Rot = {0.70710678118, -0.70710678118, 0, 0}},
+	{.Pos = {0, -3, 1}, .Rot = {0.70710678118, 0.70710678118, 0, 0}},
+};
+
+// Measurements replaced as if the sweep had bounced off something; one of them only on one axis
+static bool ransac_is_reflection(int lh, int sensor, int axis) {
+	return (lh == 0 && (sensor == 2 || sensor == 5)) || (lh == 2 && sensor == 9) ||
+		   (lh == 3 && sensor == 11 && axis == 1);
+}
+
+// Runs RANSAC on a scene with planted reflections and checks that exactly those measurements are dropped
+static int check_ransac_reflections(SurviveContext *ctx, SurviveObject *so, const SurvivePose *obj2world) {
+	survive_optimizer opt = {
+		.reprojectModel = survive_reproject_model(ctx), .poseLength = 1, .cameraLength = RANSAC_LIGHTHOUSES};
+	SURVIVE_OPTIMIZER_SETUP_HEAP_BUFFERS(opt, so);
+	survive_optimizer_setup_cameras(&opt, ctx, true, 1);
+
+	SurvivePose start = *obj2world;
+	start.Pos[0] += .03;
+	start.Pos[2] -= .02;
+	survive_optimizer_setup_pose(&opt, &start, false, 1);
+
+	int reflection_cnt = 0;
+	BaseStationCal cal[2] = {0};
+	for (int lh = 0; lh < RANSAC_LIGHTHOUSES; lh++) {
+		SurvivePose world2lh = InvertPoseRtn(&ransac_lighthouses[lh]);
+		for (int sensor = 0; sensor < RANSAC_SENSORS; sensor++) {
+			LinmathPoint3d in_world, in_lh;
+			FLT angles[2];
+			ApplyPoseToPoint(in_world, obj2world, so->sensor_locations + sensor * 3);
+			ApplyPoseToPoint(in_lh, &world2lh, in_world);
+			survive_reproject_xy(cal, in_lh, angles);
+			for (int axis = 0; axis < 2; axis++) {
+				FLT value = angles[axis];
+				if (ransac_is_reflection(lh, sensor, axis)) {
+					value += .1 * (axis ? -1 : 1);
+					reflection_cnt++;
+				}
+				opt.measurements[opt.measurementsCnt++] = (survive_optimizer_measurement){
+					.value = value, .variance = 1, .lh = lh, .sensor_idx = sensor, .axis = axis};
+			}
+		}
+	}
+
+	struct survive_optimizer_ransac *ransac = survive_optimizer_ransac_create(so);
+	int rejected = survive_optimizer_ransac_run(ransac, &opt);
+	survive_optimizer_ransac_free(ransac);
+
+	ASSERT_EQ(rejected, reflection_cnt);
+	ASSERT_EQ(opt.stats.dropped_meas_cnt, reflection_cnt);
+	for (size_t i = 0; i < opt.measurementsCnt; i++) {
+		const survive_optimizer_measurement *meas = &opt.measurements[i];
+		ASSERT_EQ(meas->invalid, ransac_is_reflection(meas->lh, meas->sensor_idx, meas->axis));
+	}
+
+	free(opt.sos);
+	SURVIVE_OPTIMIZER_CLEANUP_HEAP_BUFFERS(opt);
+	return 0;
+}
+
+// Puts the lighthouses in place and creates an object with sensors spread evenly over a sphere around its origin
+static SurviveObject *create_ransac_scene(SurviveContext *ctx) {
+	ctx->lh_version = 0;
+	ctx->activeLighthouses = RANSAC_LIGHTHOUSES;
+	for (int lh = 0; lh < RANSAC_LIGHTHOUSES; lh++) {
+		ctx->bsd[lh].PositionSet = ctx->bsd[lh].OOTXSet = 1;
+		ctx->bsd[lh].Pose = ransac_lighthouses[lh];
+	}
+
+	SurviveObject *so = survive_create_device(ctx, "TST", 0, "TS0", 0);
+	so->sensor_ct = RANSAC_SENSORS;
+	so->sensor_locations = SV_CALLOC_N(RANSAC_SENSORS * 3, sizeof(FLT));
+	for (int i = 0; i < RANSAC_SENSORS; i++) {
+		FLT z = 1 - (2 * i + 1) / (FLT)RANSAC_SENSORS, r = sqrt(1 - z * z), theta = 2.39996322972865332 * i;
+		LinmathVec3d dir = {r * cos(theta), r * sin(theta), z};
+		scale3d(so->sensor_locations + i * 3, dir, .08);
+	}
+	return so;
+}
+
+static SurvivePose ransac_object_pose() {
+	SurvivePose obj2world = {.Pos = {.1, -.2, 1.1}, .Rot = {1, .1, -.2, .05}};
+	quatnormalize(obj2world.Rot, obj2world.Rot);
+	return obj2world;
+}
+
+TEST(Optimizer, RansacRejectsReflections) {
+	char *const args[] = {"test-optimizer", "--configfile", "test_optimizer.json", "--optimizer-ransac-hypotheses", "32",
+						  0};
+	SurviveContext *ctx = survive_init(5, args);
+	SurviveObject *so = create_ransac_scene(ctx);
+	SurvivePose obj2world = ransac_object_pose();
+
+	ASSERT_SUCCESS(check_ransac_reflections(ctx, so, &obj2world));
+
+	// Splitting the hypotheses across threads doesn't change which measurements are dropped
+	struct survive_thread_pool *pool = survive_thread_pool_create(ctx, 2);
+	struct survive_thread_pool *ctx_pool = survive_install_thread_pool(ctx, pool);
+	ASSERT_SUCCESS(check_ransac_reflections(ctx, so, &obj2world));
+	survive_install_thread_pool(ctx, ctx_pool);
+	survive_thread_pool_free(pool);
+
+	// survive_close is only for started contexts
+	free(so->sensor_locations);
+	free(so);
+	return 0;
+}
+
+#define SEED_TIMECODE 48000000
+
+// Stands in for the seed poser, so the test can tell its poses apart from cached ones
+static SurvivePose stub_seed_pose;
+static int stub_seed_poser(SurviveObject *so, void **user, PoserData *pd) {
+	if (pd->pt != POSERDATA_DISASSOCIATE)
+		PoserData_poser_pose_func(pd, so, &stub_seed_pose, 0);
+	return 0;
+}
+
+// Runs the general optimizer's seeding at 'seconds' after the light and checks which of the seeds was used
+static int check_seed(GeneralOptimizerData *d, FLT seconds, const SurvivePose *expected, int seed_runs,
+					  int cache_hits) {
+	PoserDataLight pd = {.hdr = {.pt = POSERDATA_SYNC, .timecode = SEED_TIMECODE + seconds * d->so->timebase_hz}};
+	SurvivePose seed = {0};
+	ASSERT_EQ(general_optimizer_data_record_current_pose(d, &pd, &seed), true);
+	ASSERT_DOUBLE_ARRAY_EQ(3, seed.Pos, expected->Pos);
+	ASSERT_EQ(d->stats.poser_seed_runs, seed_runs);
+	ASSERT_EQ(d->stats.seed_cache_hits, cache_hits);
+	return 0;
+}
+
+/*
+ * After a drop out the seed comes from the tracker's prediction or, failing that, the last good pose while it is recent
+ * enough. Either only counts if it agrees with the current light; otherwise the seed poser runs.
+ */
+TEST(Optimizer, SeedCache) {
+	char *const args[] = {"test-optimizer", "--configfile", "test_optimizer.json", "--seed-cache-time", ".5", 0};
+	SurviveContext *ctx = survive_init(5, args);
+	SurviveObject *so = create_ransac_scene(ctx);
+	SurvivePose obj2world = ransac_object_pose();
+
+	// Every sensor seen by every lighthouse right now, with exact angles
+	BaseStationCal cal[2] = {0};
+	so->activations.lh_gen = 0;
+	so->activations.last_light = SEED_TIMECODE;
+	for (int lh = 0; lh < RANSAC_LIGHTHOUSES; lh++) {
+		SurvivePose world2lh = InvertPoseRtn(&ransac_lighthouses[lh]);
+		for (int sensor = 0; sensor < RANSAC_SENSORS; sensor++) {
+			LinmathPoint3d in_world, in_lh;
+			ApplyPoseToPoint(in_world, &obj2world, so->sensor_locations + sensor * 3);
+			ApplyPoseToPoint(in_lh, &world2lh, in_world);
+			survive_reproject_xy(cal, in_lh, so->activations.angles[sensor][lh]);
+			for (int axis = 0; axis < 2; axis++) {
+				so->activations.timecode[sensor][lh][axis] = SEED_TIMECODE;
+				so->activations.lengths[sensor][lh][axis] = 1000;
+			}
+		}
+	}
+
+	GeneralOptimizerData d;
+	general_optimizer_data_init(&d, so);
+	d.seed_poser = stub_seed_poser;
+	stub_seed_pose = obj2world;
+	stub_seed_pose.Pos[2] += .5;
+
+	// Nothing to go on yet
+	ASSERT_SUCCESS(check_seed(&d, 0, &stub_seed_pose, 1, 0));
+
+	// A confident tracker a millimeter off is close enough, and is preferred to the last good pose
+	SurvivePose predicted = obj2world;
+	predicted.Pos[0] += .001;
+	so->tracker->state.Pose = predicted;
+	so->tracker->model.t = SEED_TIMECODE / (FLT)so->timebase_hz;
+	for (int i = 0; i < 7; i++)
+		svMatrixSet(&so->tracker->model.P, i, i, 1e-6);
+	general_optimizer_data_record_success(&d, 0, &obj2world);
+	ASSERT_SUCCESS(check_seed(&d, .1, &predicted, 1, 1));
+
+	// Without the tracker, the last good pose is used until it is older than seed-cache-time
+	so->tracker->model.t = 0;
+	ASSERT_SUCCESS(check_seed(&d, .4, &obj2world, 1, 2));
+	ASSERT_SUCCESS(check_seed(&d, .6, &stub_seed_pose, 2, 2));
+
+	// A recent pose twenty centimeters away doesn't match the light
+	SurvivePose moved = obj2world;
+	moved.Pos[1] += .2;
+	general_optimizer_data_record_success(&d, 0, &moved);
+	ASSERT_SUCCESS(check_seed(&d, .1, &stub_seed_pose, 3, 2));
+
+	d.seed_poser = 0;
+	general_optimizer_data_dtor(&d);
+
+	// survive_close is only for started contexts
+	free(so->sensor_locations);
+	free(so);
+	return 0;
+}
+
+#define NUMERIC_FIT_POINTS 48
+#define NUMERIC_FIT_PARAMS 5
+
+static FLT numeric_fit_model(const FLT *p, FLT t) { return p[0] * exp(-p[1] * t) + p[2] * sin(p[3] * t) + p[4] * t; }
+
+// Only a and d of y = a * exp(-b * t) + c * sin(d * t) + e * t have analytic derivatives
+static int numeric_fit_residuals(int m, int n, FLT *p, FLT *deviates, FLT **derivs, void *private_data) {
+	const FLT *y = private_data;
+	for (int i = 0; i < m; i++) {
+		FLT t = i * .125;
+		deviates[i] = numeric_fit_model(p, t) - y[i];
+		if (derivs && derivs[0])
+			derivs[0][i] = exp(-p[1] * t);
+		if (derivs && derivs[3])
+			derivs[3][i] = p[2] * t * cos(p[3] * t);
+	}
+	return 0;
+}
+
+static int numeric_fit_solve(const FLT *y, struct survive_thread_pool *pool, FLT *p, mp_result *result) {
+	static const FLT start[NUMERIC_FIT_PARAMS] = {1.5, .4, .5, 1.2, .1};
+	mp_par pars[NUMERIC_FIT_PARAMS] = {{.side = 3}, {.side = 2}, {.side = 0}, {.side = 3}, {.side = -1}};
+	mp_config cfg = {0};
+	if (pool) {
+		cfg.parallel_for = survive_thread_pool_parallel_for;
+		cfg.parallel_for_data = pool;
+	}
+
+	memcpy(p, start, sizeof(start));
+	return mpfit(numeric_fit_residuals, NUMERIC_FIT_POINTS, NUMERIC_FIT_PARAMS, p, pars, &cfg, (void *)y, result);
+}
+
+/*
+ * Numeric jacobian columns evaluated on the thread pool each get their own copy of the parameters, so the fit has to
+ * come out bit for bit the same as evaluating them in turn, for one and two sided columns mixed with analytic ones.
+ */
+TEST(Optimizer, ParallelNumericJacobian) {
+	static const FLT truth[NUMERIC_FIT_PARAMS] = {2, .7, .8, 1.5, -.05};
+	FLT y[NUMERIC_FIT_POINTS];
+	for (int i = 0; i < NUMERIC_FIT_POINTS; i++)
+		y[i] = numeric_fit_model(truth, i * .125);
+
+	FLT serial[NUMERIC_FIT_PARAMS], parallel[NUMERIC_FIT_PARAMS];
+	mp_result serial_result = {0}, parallel_result = {0};
+	int serial_status = numeric_fit_solve(y, 0, serial, &serial_result);
+	ASSERT_GT((FLT)serial_status, 0.);
+	ASSERT_DOUBLE_ARRAY_EQ(NUMERIC_FIT_PARAMS, serial, truth);
+
+	SurviveContext *ctx = SV_CALLOC(sizeof(SurviveContext));
+	struct survive_thread_pool *pool = survive_thread_pool_create(ctx, 2);
+	int parallel_status = numeric_fit_solve(y, pool, parallel, &parallel_result);
+	survive_thread_pool_free(pool);
+	free(ctx);
+
+	ASSERT_EQ(parallel_status, serial_status);
+	ASSERT_EQ(parallel_result.niter, serial_result.niter);
+	ASSERT_EQ(parallel_result.nfev, serial_result.nfev);
+	ASSERT_EQ(memcmp(parallel, serial, sizeof(serial)), 0);
+	ASSERT_EQ(memcmp(&parallel_result.bestnorm, &serial_result.bestnorm, sizeof(FLT)), 0);
+	return 0;
+}
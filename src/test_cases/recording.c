@@ -0,0 +1,95 @@
+#include "test_case.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RECORDING_SOURCE "test_recording_source.rec"
+#define RECORDING_OUTPUT "test_recording.rec.gz"
+#define RECORDING_LINES 24
+
+static char first_pose_name[32];
+static size_t pose_cnt;
+static void record_external_pose(SurviveContext *ctx, const char *name, const SurvivePose *pose) {
+	if (pose_cnt++ == 0)
+		snprintf(first_pose_name, sizeof(first_pose_name), "%s", name);
+}
+
+static bool seeked_with_index;
+static void check_seek_log(SurviveContext *ctx, SurviveLogLevel logLevel, const char *fault) {
+	if (strstr(fault, "using its index"))
+		seeked_with_index = true;
+}
+
+static int run_playback(char *const *args, int argc, bool replace_external_pose) {
+	SurviveContext *ctx = survive_init_with_logger(argc, args, 0, check_seek_log);
+	if (ctx == 0)
+		return -1;
+	if (replace_external_pose)
+		survive_install_external_pose_fn(ctx, record_external_pose);
+
+	while (survive_poll(ctx) == 0) {
+	}
+	survive_close(ctx);
+	return 0;
+}
+
+/*
+ * Replays a hand written file into a recording with a seek point every quarter second, then plays that recording back
+ * from the middle. The seek has to go through the index and land on the first line at or after the start time.
+ */
+TEST(Recording, SeekWithIndex) {
+	FILE *f = fopen(RECORDING_SOURCE, "w");
+	for (int i = 1; i <= RECORDING_LINES; i++)
+		fprintf(f, "%f P%d EXTERNAL_POSE %d 0 0 1 0 0 0\n", i * .125, i, i);
+	fclose(f);
+
+	char *const record_args[] = {"test-recording",
+								 "--configfile",
+								 "test_recording.json",
+								 "--playback",
+								 RECORDING_SOURCE,
+								 "--playback-factor",
+								 "0",
+								 "--playback-replay-external-pose",
+								 "1",
+								 "--record",
+								 RECORDING_OUTPUT,
+								 "--record-index-interval",
+								 ".25",
+								 0};
+	ASSERT_SUCCESS(run_playback(record_args, sizeof(record_args) / sizeof(record_args[0]) - 1, false));
+
+	// 0.125s and every quarter second after it
+	int seek_points = 0;
+	char entry[128];
+	f = fopen(RECORDING_OUTPUT ".idx", "r");
+	if (f == 0)
+		return survive_test_assert();
+	while (fgets(entry, sizeof(entry), f))
+		seek_points += entry[0] == 'T';
+	fclose(f);
+	ASSERT_EQ(seek_points, RECORDING_LINES / 2);
+
+	// The last seek point before 1.3s is at 1.125s; the lines at 1.125s and 1.25s are skipped
+	char *const seek_args[] = {"test-recording",
+							   "--configfile",
+							   "test_recording.json",
+							   "--playback",
+							   RECORDING_OUTPUT,
+							   "--playback-factor",
+							   "0",
+							   "--playback-replay-external-pose",
+							   "1",
+							   "--playback-start",
+							   "1.3",
+							   0};
+	ASSERT_SUCCESS(run_playback(seek_args, sizeof(seek_args) / sizeof(seek_args[0]) - 1, true));
+
+	ASSERT_EQ(seeked_with_index, true);
+	ASSERT_EQ(strcmp(first_pose_name, "P11"), 0);
+	ASSERT_EQ(pose_cnt, RECORDING_LINES - 10);
+
+	remove(RECORDING_SOURCE);
+	remove(RECORDING_OUTPUT);
+	remove(RECORDING_OUTPUT ".idx");
+	return 0;
+}
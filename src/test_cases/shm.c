@@ -0,0 +1,85 @@
+#include "test_case.h"
+#include <os_generic.h>
+#include <survive_shm.h>
+
+#define SHM_TEST_OBJECTS 2
+#define SHM_TEST_WRITES 200000
+
+static _Alignas(64) char shm_test_segment[4096];
+
+static SurviveShmHeader *shm_test_header() {
+	SurviveShmHeader *header = (SurviveShmHeader *)shm_test_segment;
+	*header = (SurviveShmHeader){.magic = SURVIVE_SHM_MAGIC,
+								 .version = SURVIVE_SHM_VERSION,
+								 .header_size = (uint32_t)(survive_shm_segment_size(0)),
+								 .object_size = sizeof(SurviveShmObject),
+								 .capacity = SHM_TEST_OBJECTS};
+	return header;
+}
+
+static void *shm_test_writer(void *user) {
+	SurviveShmHeader *header = user;
+	SurviveShmObject *obj = &survive_shm_objects(header)[1];
+	for (uint64_t i = 1; i <= SHM_TEST_WRITES; i++) {
+		survive_shm_write_begin(obj);
+		obj->pose_count = i;
+		for (int j = 0; j < 7; j++)
+			obj->pose[j] = (double)i;
+		for (int j = 0; j < 49; j++)
+			obj->pose_covariance[j] = (double)i;
+		survive_shm_write_end(obj);
+	}
+	return 0;
+}
+
+TEST(Shm, FindObject) {
+	ASSERT_GE((double)sizeof(shm_test_segment), (double)survive_shm_segment_size(SHM_TEST_OBJECTS));
+
+	SurviveShmHeader *header = shm_test_header();
+	SurviveShmObject *objs = survive_shm_objects(header);
+	strcpy(objs[0].codename, "HMD");
+	strcpy(objs[1].codename, "T20");
+	header->object_count = 1;
+
+	ASSERT_EQ(survive_shm_find_object(header, "HMD"), 0);
+	// Slots past object_count aren't published yet
+	ASSERT_EQ(survive_shm_find_object(header, "T20"), -1);
+
+	header->object_count = 2;
+	ASSERT_EQ(survive_shm_find_object(header, "T20"), 1);
+
+	SurviveShmObject out;
+	ASSERT_EQ(survive_shm_read_object(header, 2, &out), false);
+	ASSERT_EQ(survive_shm_read_object(header, 1, &out), true);
+	ASSERT_EQ(strcmp(out.codename, "T20"), 0);
+	return 0;
+}
+
+TEST(Shm, ConsistentSnapshots) {
+	SurviveShmHeader *header = shm_test_header();
+	header->object_count = SHM_TEST_OBJECTS;
+
+	og_thread_t writer = OGCreateThread(shm_test_writer, "shm writer", header);
+
+	uint64_t last = 0, reads = 0;
+	while (last < SHM_TEST_WRITES) {
+		SurviveShmObject out;
+		if (!survive_shm_read_object(header, 1, &out))
+			continue;
+
+		// A torn read would mix values from two different writes
+		for (int j = 0; j < 7; j++)
+			ASSERT_EQ(out.pose[j], (double)out.pose_count);
+		for (int j = 0; j < 49; j++)
+			ASSERT_EQ(out.pose_covariance[j], (double)out.pose_count);
+		ASSERT_EQ(out.seq & 1, 0);
+
+		ASSERT_GE((double)out.pose_count, (double)last);
+		last = out.pose_count;
+		reads++;
+	}
+
+	OGJoinThread(writer);
+	ASSERT_GT((double)reads, 0.);
+	return 0;
+}
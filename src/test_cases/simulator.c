@@ -0,0 +1,101 @@
+#include "test_case.h"
+#include <stdio.h>
+
+#define SIMULATOR_OBJECTS 3
+
+static int pose_cnts[SIMULATOR_OBJECTS];
+static void record_imupose(SurviveObject *so, survive_long_timecode timecode, const SurvivePose *imu2world) {
+	int idx = -1;
+	if (sscanf(so->codename, "SM%d", &idx) == 1 && idx >= 0 && idx < SIMULATOR_OBJECTS)
+		pose_cnts[idx]++;
+	survive_default_imupose_process(so, timecode, imu2world);
+}
+
+// Time stamps of the events the simulator hands over as it pops them, across all the objects
+static survive_timecode last_event_timecode;
+static size_t event_cnt, out_of_order_cnt;
+static void record_event_time(survive_timecode timecode) {
+	if (event_cnt++ > 0 && (int32_t)(timecode - last_event_timecode) < 0)
+		out_of_order_cnt++;
+	last_event_timecode = timecode;
+}
+
+static void record_imu(SurviveObject *so, int mask, const FLT *accelgyro, survive_timecode timecode, int id) {
+	record_event_time(timecode);
+	survive_default_imu_process(so, mask, accelgyro, timecode, id);
+}
+
+static void record_light(SurviveObject *so, int sensor_id, int acode, int timeinsweep, survive_timecode timecode,
+						 survive_timecode length, uint32_t lh) {
+	if (sensor_id < 0)
+		record_event_time(timecode);
+	survive_default_light_process(so, sensor_id, acode, timeinsweep, timecode, length, lh);
+}
+
+static void record_sync(SurviveObject *so, survive_channel channel, survive_timecode timecode, bool ootx, bool gen) {
+	record_event_time(timecode);
+	survive_default_sync_process(so, channel, timecode, ootx, gen);
+}
+
+// Sweeps are held back and handed over per object, but each batch is in time order
+static size_t unsorted_sweep_batch_cnt;
+static void record_sweep_batch(SurviveObject *so, const SurviveSweepEvent *events, size_t cnt) {
+	for (size_t i = 1; i < cnt; i++) {
+		if ((int32_t)(events[i].timecode - events[i - 1].timecode) < 0) {
+			unsorted_sweep_batch_cnt++;
+			break;
+		}
+	}
+	survive_default_sweep_batch_process(so, events, cnt);
+}
+
+/*
+ * Runs a few simulated seconds of several objects. The syncs and IMU readings the simulator hands over, which it
+ * generates as it pops them from its schedule, have to come in time order across all the objects, and every object has
+ * to end up with poses.
+ */
+static int run_simulator(const char *lh_gen) {
+	char *const args[] = {"test-simulator",
+						  "--configfile",
+						  "test_simulator.json",
+						  "--simulator",
+						  "--simulator-objects",
+						  "3",
+						  "--simulator-time",
+						  "1.5",
+						  "--simulator-realtime",
+						  "0",
+						  "--simulator-lh-gen",
+						  (char *)lh_gen,
+						  0};
+	// Start from a fresh config so the lighthouses saved by another run don't carry over
+	remove("test_simulator.json");
+	memset(pose_cnts, 0, sizeof(pose_cnts));
+	event_cnt = out_of_order_cnt = unsorted_sweep_batch_cnt = 0;
+
+	SurviveContext *ctx = survive_init(sizeof(args) / sizeof(args[0]) - 1, args);
+	if (ctx == 0)
+		return -1;
+	survive_install_imupose_fn(ctx, record_imupose);
+	survive_install_imu_fn(ctx, record_imu);
+	survive_install_light_fn(ctx, record_light);
+	survive_install_sync_fn(ctx, record_sync);
+	survive_install_sweep_batch_fn(ctx, record_sweep_batch);
+
+	while (survive_poll(ctx) == 0) {
+	}
+	survive_close(ctx);
+	remove("test_simulator.json");
+
+	ASSERT_GT((FLT)event_cnt, 0.);
+	ASSERT_EQ(out_of_order_cnt, 0);
+	ASSERT_EQ(unsorted_sweep_batch_cnt, 0);
+	for (int i = 0; i < SIMULATOR_OBJECTS; i++) {
+		ASSERT_GT((FLT)pose_cnts[i], 0.);
+	}
+	return 0;
+}
+
+TEST(Simulator, Gen1MultipleObjects) { return run_simulator("1"); }
+
+TEST(Simulator, Gen2MultipleObjects) { return run_simulator("2"); }
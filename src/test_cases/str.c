@@ -1,5 +1,7 @@
 #include "../survive_str.h"
 #include "test_case.h"
+#include <stdio.h>
+#include <string.h>
 
 TEST(SurviveUtils, Str) {
 	cstring test = {0};
@@ -18,4 +20,99 @@ TEST(SurviveUtils, Str) {
 
 	str_free(&test);
 	return 0;
-}
\ No newline at end of file
+}
+#define ASSERT_STR_EQ(expected, actual)                                                                                \
+	if (strcmp((expected), (actual)) != 0) {                                                                           \
+		fprintf(stderr, "Assert failed: " #expected " == " #actual ": '%s' != '%s'\n", (expected), (actual));           \
+		return survive_test_assert();                                                                                  \
+	}
+
+TEST(SurviveUtils, StrFormat) {
+	char expected[STR_FORMAT_BUFFER_SIZE], actual[STR_FORMAT_BUFFER_SIZE];
+
+	const double special[] = {0.,	  -0.,	  1.,	   -1.,	   .5,		 0.0078125, -1e-9,	 9.9999995, 9.99999949999,
+							  999999.9999996, 1e300, -1e-300, 123456789.123, 1e15, 2.5e-7, 1.5e-6, NAN,		  INFINITY,
+							  -INFINITY};
+	uint64_t seed = 0x12345678;
+	for (int i = 0; i < 200000; i++) {
+		double v;
+		if (i < sizeof(special) / sizeof(special[0])) {
+			v = special[i];
+		} else {
+			seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+			// Mix plain uniform values with values spread across many magnitudes
+			v = ((double)(seed >> 11) / 9007199254740992. - .5) * (i & 1 ? 20. : pow(10, (int)(seed % 40) - 20));
+		}
+
+		for (int precision = 0; precision <= 9; precision += 3) {
+			snprintf(expected, sizeof(expected), "%.*f", precision, v);
+			ASSERT_EQ(str_format_fixed(actual, v, precision), strlen(expected));
+			ASSERT_STR_EQ(expected, actual);
+
+			snprintf(expected, sizeof(expected), "%+.*e", precision, v);
+			ASSERT_EQ(str_format_exp(actual, v, precision, true), strlen(expected));
+			ASSERT_STR_EQ(expected, actual);
+
+			snprintf(expected, sizeof(expected), "%.*e", precision, v);
+			ASSERT_EQ(str_format_exp(actual, v, precision, false), strlen(expected));
+			ASSERT_STR_EQ(expected, actual);
+		}
+
+		int64_t iv = (int64_t)seed >> (seed % 64);
+		snprintf(expected, sizeof(expected), "%" PRId64, iv);
+		str_format_int(actual, iv);
+		ASSERT_STR_EQ(expected, actual);
+
+		snprintf(expected, sizeof(expected), "%" PRIu64, (uint64_t)iv);
+		str_format_uint(actual, (uint64_t)iv);
+		ASSERT_STR_EQ(expected, actual);
+	}
+
+	return 0;
+}
+
+TEST(SurviveUtils, StrParse) {
+	char buffer[STR_FORMAT_BUFFER_SIZE];
+	const char *special[] = {"0",	  "-0.000000", "1.5e-3", "+2.",	  ".25",		   "1e22",	 "1e23",	"0x1.8p+1",
+							 "inf",	  "-nan",	   "12abc",	 "1e-400", "3.4028235e38", "1.17549435e-38",
+							 "16777217", "0.1000000000000000055511151231257827021181583404541015625"};
+
+	uint64_t seed = 0x87654321;
+	for (int i = 0; i < 200000; i++) {
+		if (i < sizeof(special) / sizeof(special[0])) {
+			strcpy(buffer, special[i]);
+		} else {
+			seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+			double v = ((double)(seed >> 11) / 9007199254740992. - .5) * pow(10, (int)(seed % 20) - 10);
+			snprintf(buffer, sizeof(buffer), (seed >> 8) % 3 == 0 ? "%.6f" : (seed >> 8) % 3 == 1 ? "%+e" : "%.17g", v);
+		}
+
+		double d = 0, expected_d = strtod(buffer, 0);
+		ASSERT_EQ(str_parse_double(buffer, &d), 1);
+		ASSERT_EQ((memcmp(&d, &expected_d, sizeof(d)) == 0 || (isnan(d) && isnan(expected_d))), 1);
+
+		float f = 0, expected_f = strtof(buffer, 0);
+		ASSERT_EQ(str_parse_float(buffer, &f), 1);
+		ASSERT_EQ((memcmp(&f, &expected_f, sizeof(f)) == 0 || (isnan(f) && isnan(expected_f))), 1);
+	}
+
+	int64_t v;
+	ASSERT_EQ(str_parse_double("abc", (double *)&v), 0);
+	ASSERT_EQ(str_parse_int("", &v), 0);
+	ASSERT_EQ(str_parse_int("-", &v), 0);
+	ASSERT_EQ(str_parse_int("-42", &v), 1);
+	ASSERT_EQ(v, -42);
+	ASSERT_EQ(str_parse_int("4294967295", &v), 1);
+	ASSERT_EQ(v, 4294967295ll);
+	ASSERT_EQ(str_parse_int("12.5", &v), 1);
+	ASSERT_EQ(v, 12);
+
+	char line[] = "1.5 SM0  W\t3\r\n";
+	char *cursor = line;
+	ASSERT_STR_EQ(str_next_token(&cursor), "1.5");
+	ASSERT_STR_EQ(str_next_token(&cursor), "SM0");
+	ASSERT_STR_EQ(str_next_token(&cursor), "W");
+	ASSERT_STR_EQ(str_next_token(&cursor), "3");
+	ASSERT_EQ(str_next_token(&cursor), 0);
+	return 0;
+}
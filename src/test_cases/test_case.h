@@ -7,8 +7,8 @@ static inline int survive_test_assert() { return -1; }
 #define ASSERT_SUCCESS(x)                                                                                              \
 	{                                                                                                                  \
 		int error = (x);                                                                                               \
-		if (x < 0)                                                                                                     \
-			return x;                                                                                                  \
+		if (error < 0)                                                                                                 \
+			return error;                                                                                              \
 	}
 
 #define ASSERT_DOUBLE_EQ(val1, val2)                                                                                   \
@@ -0,0 +1,61 @@
+#include "test_case.h"
+#include <os_generic.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TRACE_TEST_FILE "trace_test.json"
+
+static int count_occurrences(const char *path, const char *needle) {
+	FILE *f = fopen(path, "r");
+	if (f == 0)
+		return -1;
+
+	int cnt = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		if (strstr(line, needle))
+			cnt++;
+	}
+	fclose(f);
+	return cnt;
+}
+
+static void *trace_test_thread(void *user) {
+	SV_TRACE_BEGIN("outer");
+	for (int i = 0; i < 4; i++) {
+		SV_TRACE_BEGIN("inner");
+		SV_TRACE_END("inner");
+	}
+	SV_TRACE_END("outer");
+	return 0;
+}
+
+TEST(Trace, Export) {
+	ASSERT_EQ(survive_trace_running(), false);
+	SV_TRACE_BEGIN("not recorded");
+	SV_TRACE_END("not recorded");
+
+	// Rounded up to 8 events per thread
+	ASSERT_EQ(survive_trace_start(5), true);
+	ASSERT_EQ(survive_trace_start(5), false);
+
+	og_thread_t thread = OGCreateThread(trace_test_thread, "trace test", 0);
+	OGJoinThread(thread);
+
+	survive_trace_begin("object", "HMD");
+	survive_trace_end("object");
+
+	// The other thread wrapped and lost its first 2 events, so the ends of the first inner scope and of the outer scope
+	// have no begin and are left out
+	int cnt = survive_trace_export(TRACE_TEST_FILE);
+	survive_trace_stop();
+	ASSERT_EQ(cnt, 2 + 6);
+
+	ASSERT_EQ(count_occurrences(TRACE_TEST_FILE, "not recorded"), 0);
+	ASSERT_EQ(count_occurrences(TRACE_TEST_FILE, "\"object\": \"HMD\""), 1);
+	ASSERT_EQ(count_occurrences(TRACE_TEST_FILE, "\"ph\": \"B\""), 4);
+	ASSERT_EQ(count_occurrences(TRACE_TEST_FILE, "\"ph\": \"E\""), 4);
+	ASSERT_EQ(count_occurrences(TRACE_TEST_FILE, "thread_name"), 2);
+	remove(TRACE_TEST_FILE);
+	return 0;
+}
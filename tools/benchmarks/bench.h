@@ -0,0 +1,83 @@
+#pragma once
+
+#include <os_generic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <survive.h>
+
+/*
+ * survive-bench: microbenchmarks for the tracking hot paths.
+ *
+ * A benchmark is a function that runs 'b->iterations' operations. Anything done before survive_bench_start is setup
+ * and isn't measured:
+ *
+ *   BENCHMARK(Suite, Name) {
+ *       ...setup...
+ *       survive_bench_start(b);
+ *       for (uint64_t i = 0; i < b->iterations; i++) { ...one op... }
+ *       survive_bench_stop(b);
+ *       return 0;
+ *   }
+ *
+ * The runner calls it with growing iteration counts until a run takes at least --min-time, and reports the time and
+ * heap allocations per operation of that run. rand() is reseeded before every call so inputs are reproducible.
+ * Returning SURVIVE_BENCH_SKIP marks the benchmark as not runnable with the given inputs.
+ */
+
+#define SURVIVE_BENCH_SKIP 1
+#define SURVIVE_BENCH_MAX_COUNTERS 8
+
+typedef struct survive_bench {
+	uint64_t iterations;
+
+	double start_time, elapsed;
+	uint64_t start_allocs, allocs;
+	uint64_t start_alloc_bytes, alloc_bytes;
+
+	// Optional note shown next to the result, e.g. why it was skipped
+	char note[128];
+
+	// Extra figures reported alongside the timing, see survive_bench_counter
+	struct {
+		const char *name;
+		double value;
+	} counters[SURVIVE_BENCH_MAX_COUNTERS];
+	int counters_cnt;
+} survive_bench;
+
+typedef int (*survive_bench_fn)(survive_bench *b);
+
+#define BENCHMARK(suite, name)                                                                                         \
+	int Bench##suite##_##name(survive_bench *b);                                                                       \
+	REGISTER_LINKTIME(Bench##suite##_##name)                                                                           \
+	int Bench##suite##_##name(survive_bench *b)
+
+void survive_bench_start(survive_bench *b);
+void survive_bench_stop(survive_bench *b);
+
+// Reports a named figure for the run, e.g. solver iterations per op; 'name' must outlive the benchmark
+void survive_bench_counter(survive_bench *b, const char *name, double value);
+
+// Number of heap allocations made so far by the whole process, or 0 if they can't be counted on this platform
+uint64_t survive_bench_alloc_count();
+uint64_t survive_bench_alloc_bytes();
+
+// A context shared by the benchmarks that need one; created on first use without any drivers running
+SurviveContext *survive_bench_context();
+
+// Serialized optimizer problems given with --optimizer-problem or found in an --optimizer-corpus directory
+int survive_bench_optimizer_problem_count();
+const char *survive_bench_optimizer_problem(int idx);
+
+// Recording given with --lightcap-recording for the Disambiguator benchmarks, or 0
+const char *survive_bench_lightcap_recording();
+
+// Keeps the compiler from optimizing out the computation of a result nobody reads
+static inline void survive_bench_use(const void *p) {
+#if defined(__GNUC__)
+	__asm__ volatile("" : : "g"(p) : "memory");
+#else
+	static volatile const void *sink;
+	sink = p;
+#endif
+}
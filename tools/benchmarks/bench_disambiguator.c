@@ -0,0 +1,417 @@
+#include "bench.h"
+
+#include <linmath.h>
+#include <string.h>
+
+#include "../../src/survive_default_devices.h"
+#include "../../src/survive_gz.h"
+#include "../../src/survive_internal.h"
+
+#define SENSOR_CNT 16
+#define FRAME_TICKS 400000
+#define CYCLE_FRAMES 4
+#define SYNC_SENSORS 4
+#define SWEEP_SENSORS 8
+#define ELEMENTS_PER_FRAME (2 * SYNC_SENSORS + SWEEP_SENSORS)
+#define ELEMENTS_PER_CYCLE (CYCLE_FRAMES * ELEMENTS_PER_FRAME)
+
+// Sync pulse lengths for each acode; see ACODE_TIMING in disambiguator_statebased.c
+#define ACODE_LENGTH(acode) (3000 + ((acode)&1) * 500 + (((acode) >> 1) & 1) * 1000 + (((acode) >> 2) & 1) * 2000 - 100)
+
+/*
+ * One cycle of a two lighthouse gen1 setup: each frame has a sync flash from each lighthouse followed by a sweep from
+ * one of them, with the lighthouse and axis sweeping rotating through the four frames. The acodes follow the pattern
+ * the state based disambiguator expects.
+ */
+static LightcapElement cycle[ELEMENTS_PER_CYCLE];
+
+static void setup_cycle() {
+	static const int sync_acodes[CYCLE_FRAMES][2] = {{4, 0}, {5, 1}, {0, 4}, {1, 5}};
+
+	LightcapElement *le = cycle;
+	for (int frame = 0; frame < CYCLE_FRAMES; frame++) {
+		uint32_t frame_start = frame * FRAME_TICKS;
+		for (int lh = 0; lh < 2; lh++) {
+			for (int s = 0; s < SYNC_SENSORS; s++) {
+				*le++ = (LightcapElement){.sensor_id = s,
+										  .length = ACODE_LENGTH(sync_acodes[frame][lh]) + rand() % 50,
+										  .timestamp = frame_start + lh * 20000 + rand() % 20};
+			}
+		}
+
+		for (int s = 0; s < SWEEP_SENSORS; s++) {
+			*le++ = (LightcapElement){.sensor_id = s * 2,
+									  .length = 300 + rand() % 200,
+									  .timestamp = frame_start + 150000 + s * 4000 + rand() % 1000};
+		}
+	}
+}
+
+// Only the disambiguator itself is measured; what it reports is just counted, so runs can be checked against each other
+static uint64_t lights_reported;
+static void count_light(SurviveObject *so, int sensor_id, int acode, int timeinsweep, survive_timecode timecode,
+						survive_timecode length, uint32_t lighthouse) {
+	lights_reported++;
+}
+
+static lightcap_process_func disambiguator;
+static lightcap_batch_process_func disambiguator_batch;
+
+static bool setup_disambiguator(survive_bench *b) {
+	if (disambiguator == 0) {
+		disambiguator = (lightcap_process_func)GetDriver("DisambiguatorStateBased");
+		disambiguator_batch = (lightcap_batch_process_func)GetDriver("LightcapBatchStateBased");
+	}
+	if (disambiguator == 0 || disambiguator_batch == 0) {
+		snprintf(b->note, sizeof(b->note), "disambiguator_statebased plugin not found");
+		return false;
+	}
+	survive_install_light_fn(survive_bench_context(), count_light);
+	return true;
+}
+
+typedef struct light_event {
+	int sensor_id, acode, timeinsweep;
+	survive_timecode timecode, length;
+	uint32_t lighthouse;
+} light_event;
+
+static light_event *light_events;
+static size_t light_events_cnt, light_events_size;
+static void record_light(SurviveObject *so, int sensor_id, int acode, int timeinsweep, survive_timecode timecode,
+						 survive_timecode length, uint32_t lighthouse) {
+	if (light_events_cnt == light_events_size) {
+		light_events_size = light_events_size ? light_events_size * 2 : 1024;
+		light_events = realloc(light_events, sizeof(light_event) * light_events_size);
+	}
+	light_events[light_events_cnt++] = (light_event){sensor_id, acode, timeinsweep, timecode, length, lighthouse};
+}
+
+// Runs 'frames' frames of the cycle through a fresh object and returns what came out of the light hook
+static light_event *run_frames(const char *codename, bool batched, size_t frames, size_t *cnt) {
+	SurviveContext *ctx = survive_bench_context();
+	SurviveObject *so = survive_create_device(ctx, "BENCH", 0, codename, 0);
+	so->sensor_ct = SENSOR_CNT;
+
+	light_events = 0;
+	light_events_cnt = light_events_size = 0;
+	survive_install_light_fn(ctx, record_light);
+	for (size_t frame = 0; frame < frames; frame++) {
+		LightcapElement les[ELEMENTS_PER_FRAME];
+		for (size_t i = 0; i < ELEMENTS_PER_FRAME; i++) {
+			size_t idx = frame * ELEMENTS_PER_FRAME + i;
+			les[i] = cycle[idx % ELEMENTS_PER_CYCLE];
+			les[i].timestamp += (uint32_t)(idx / ELEMENTS_PER_CYCLE) * (CYCLE_FRAMES * FRAME_TICKS);
+		}
+		if (batched) {
+			disambiguator_batch(so, les, ELEMENTS_PER_FRAME);
+		} else {
+			for (size_t i = 0; i < ELEMENTS_PER_FRAME; i++)
+				disambiguator(so, &les[i]);
+		}
+	}
+	survive_install_light_fn(ctx, count_light);
+	survive_destroy_device(so);
+
+	*cnt = light_events_cnt;
+	return light_events;
+}
+
+// Only worth timing if the batch reports exactly what handing over the pulses one at a time does
+static bool batch_matches_single() {
+	const size_t frames = 400;
+	size_t single_cnt = 0, batch_cnt = 0;
+	light_event *single = run_frames("BV0", false, frames, &single_cnt);
+	light_event *batch = run_frames("BV1", true, frames, &batch_cnt);
+
+	bool matches = single_cnt > 0 && single_cnt == batch_cnt &&
+				   memcmp(single, batch, sizeof(light_event) * single_cnt) == 0;
+	free(single);
+	free(batch);
+	return matches;
+}
+
+static int bench_statebased(survive_bench *b, bool batched) {
+	static SurviveObject *objects[2];
+	static uint64_t elements_sent[2];
+
+	SurviveContext *ctx = survive_bench_context();
+	if (!setup_disambiguator(b))
+		return SURVIVE_BENCH_SKIP;
+
+	// The batch only goes to the disambiguator if it is the lightcap hook
+	lightcap_process_func prior_fn = ctx->lightcapproc;
+	ctx->lightcapproc = disambiguator;
+
+	SurviveObject **so = &objects[batched];
+	if (*so == 0) {
+		setup_cycle();
+		if (batched && !batch_matches_single()) {
+			ctx->lightcapproc = prior_fn;
+			snprintf(b->note, sizeof(b->note), "batch output differs from single element output");
+			return -1;
+		}
+
+		*so = survive_create_device(ctx, "BENCH", 0, batched ? "BN2" : "BN0", 0);
+		(*so)->sensor_ct = SENSOR_CNT;
+	}
+	uint64_t prior_lights = lights_reported;
+
+	uint64_t *sent = &elements_sent[batched];
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations;) {
+		// Repeat the cycle with time moving forward, a frame -- about what one USB packet holds -- at a time
+		LightcapElement les[ELEMENTS_PER_FRAME];
+		size_t cnt = 0;
+		do {
+			les[cnt] = cycle[*sent % ELEMENTS_PER_CYCLE];
+			les[cnt].timestamp += (uint32_t)(*sent / ELEMENTS_PER_CYCLE) * (CYCLE_FRAMES * FRAME_TICKS);
+			cnt++, i++, (*sent)++;
+		} while (i < b->iterations && cnt < ELEMENTS_PER_FRAME && *sent % ELEMENTS_PER_FRAME != 0);
+
+		if (batched) {
+			disambiguator_batch(*so, les, cnt);
+		} else {
+			for (size_t j = 0; j < cnt; j++)
+				disambiguator(*so, &les[j]);
+		}
+	}
+	survive_bench_stop(b);
+
+	ctx->lightcapproc = prior_fn;
+	survive_bench_counter(b, "lights", (double)(lights_reported - prior_lights) / b->iterations);
+	return 0;
+}
+
+BENCHMARK(Disambiguator, StateBased) { return bench_statebased(b, false); }
+BENCHMARK(Disambiguator, StateBasedBatch) { return bench_statebased(b, true); }
+
+#define ACQUIRE_FRAMES 40
+
+// Finding the state from scratch, which is what every object goes through when it turns on or loses track; one op is
+// ACQUIRE_FRAMES frames of pulses given to a fresh object
+BENCHMARK(Disambiguator, Acquire) {
+	static SurviveObject *so;
+
+	SurviveContext *ctx = survive_bench_context();
+	if (!setup_disambiguator(b))
+		return SURVIVE_BENCH_SKIP;
+	if (so == 0) {
+		so = survive_create_device(ctx, "BENCH", 0, "BN3", 0);
+		so->sensor_ct = SENSOR_CNT;
+		setup_cycle();
+	}
+	uint64_t prior_lights = lights_reported;
+
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++) {
+		free(so->disambiguator_data);
+		so->disambiguator_data = 0;
+
+		for (size_t idx = 0; idx < ACQUIRE_FRAMES * ELEMENTS_PER_FRAME; idx++) {
+			LightcapElement le = cycle[idx % ELEMENTS_PER_CYCLE];
+			le.timestamp += (uint32_t)(idx / ELEMENTS_PER_CYCLE) * (CYCLE_FRAMES * FRAME_TICKS);
+			disambiguator(so, &le);
+		}
+	}
+	survive_bench_stop(b);
+
+	// Shows whether it locked on within the frames given
+	survive_bench_counter(b, "lights", (double)(lights_reported - prior_lights) / b->iterations);
+	return 0;
+}
+
+#define RECORDING_MAX_OBJECTS 16
+
+/*
+ * Raw light ('C' lines) from the recording given with --lightcap-recording. Consecutive lines for the same object are
+ * kept together as a run, which is how the pulses of one USB packet end up in a recording.
+ */
+typedef struct recorded_run {
+	int object;
+	size_t start, cnt;
+} recorded_run;
+
+static struct {
+	bool loaded;
+	LightcapElement *les;
+	size_t les_cnt;
+	recorded_run *runs;
+	size_t runs_cnt;
+
+	char codenames[RECORDING_MAX_OBJECTS][16];
+	// Time added every time the recording repeats; a whole number of sweep cycles so the phase is kept
+	uint32_t loop_ticks[RECORDING_MAX_OBJECTS];
+	int objects_cnt;
+} recording;
+
+static int recording_object(const char *codename) {
+	for (int i = 0; i < recording.objects_cnt; i++) {
+		if (strcmp(recording.codenames[i], codename) == 0)
+			return i;
+	}
+	if (recording.objects_cnt == RECORDING_MAX_OBJECTS)
+		return -1;
+	snprintf(recording.codenames[recording.objects_cnt], sizeof(recording.codenames[0]), "%s", codename);
+	return recording.objects_cnt++;
+}
+
+static bool load_recording(const char *path) {
+	gzFile f = gzopen(path, "r");
+	if (f == 0)
+		return false;
+
+	uint32_t first[RECORDING_MAX_OBJECTS] = {0}, last[RECORDING_MAX_OBJECTS] = {0};
+	size_t les_size = 0, runs_size = 0;
+	char line[512];
+	while (gzgets(f, line, sizeof(line))) {
+		double time;
+		char codename[16], op[16];
+		int sensor_id;
+		uint32_t timestamp, length;
+		if (sscanf(line, "%lf %15s %15s %d %u %u", &time, codename, op, &sensor_id, &timestamp, &length) != 6 ||
+			strcmp(op, "C") != 0)
+			continue;
+
+		int object = recording_object(codename);
+		if (object < 0)
+			continue;
+
+		if (recording.les_cnt == les_size) {
+			les_size = les_size ? les_size * 2 : 4096;
+			recording.les = realloc(recording.les, sizeof(LightcapElement) * les_size);
+		}
+		size_t idx = recording.les_cnt++;
+		recording.les[idx] =
+			(LightcapElement){.sensor_id = (uint8_t)sensor_id, .timestamp = timestamp, .length = (uint16_t)length};
+
+		recorded_run *run = recording.runs_cnt ? &recording.runs[recording.runs_cnt - 1] : 0;
+		if (run == 0 || run->object != object || run->cnt == ELEMENTS_PER_FRAME) {
+			if (recording.runs_cnt == runs_size) {
+				runs_size = runs_size ? runs_size * 2 : 1024;
+				recording.runs = realloc(recording.runs, sizeof(recorded_run) * runs_size);
+			}
+			run = &recording.runs[recording.runs_cnt++];
+			*run = (recorded_run){.object = object, .start = idx};
+		}
+		run->cnt++;
+
+		if (first[object] == 0)
+			first[object] = timestamp;
+		last[object] = timestamp;
+	}
+	gzclose(f);
+
+	const uint32_t cycle_ticks = CYCLE_FRAMES * FRAME_TICKS;
+	for (int i = 0; i < recording.objects_cnt; i++) {
+		recording.loop_ticks[i] = ((last[i] - first[i]) / cycle_ticks + 1) * cycle_ticks;
+	}
+	return recording.les_cnt > 0;
+}
+
+static int bench_recording(survive_bench *b, bool batched) {
+	static SurviveObject *objects[2][RECORDING_MAX_OBJECTS];
+	static uint64_t runs_sent[2];
+
+	const char *path = survive_bench_lightcap_recording();
+	if (path == 0) {
+		snprintf(b->note, sizeof(b->note), "needs a recording with raw light, see --lightcap-recording");
+		return SURVIVE_BENCH_SKIP;
+	}
+	if (!recording.loaded) {
+		if (!load_recording(path)) {
+			snprintf(b->note, sizeof(b->note), "no raw light found in %s", path);
+			return SURVIVE_BENCH_SKIP;
+		}
+		recording.loaded = true;
+	}
+
+	SurviveContext *ctx = survive_bench_context();
+	if (!setup_disambiguator(b))
+		return SURVIVE_BENCH_SKIP;
+
+	// Each variant gets its own objects so that they both start from scratch
+	for (int i = 0; i < recording.objects_cnt; i++) {
+		if (objects[batched][i] == 0) {
+			char codename[8];
+			snprintf(codename, sizeof(codename), "%c%02d", batched ? 'Q' : 'R', i);
+			objects[batched][i] = survive_create_device(ctx, "BENCH", 0, codename, 0);
+			objects[batched][i]->sensor_ct = 32;
+		}
+	}
+
+	lightcap_process_func prior_fn = ctx->lightcapproc;
+	ctx->lightcapproc = disambiguator;
+	uint64_t prior_lights = lights_reported;
+
+	uint64_t *sent = &runs_sent[batched];
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; (*sent)++) {
+		const recorded_run *run = &recording.runs[*sent % recording.runs_cnt];
+		uint32_t time_offset = (uint32_t)(*sent / recording.runs_cnt) * recording.loop_ticks[run->object];
+
+		LightcapElement les[ELEMENTS_PER_FRAME];
+		size_t cnt = 0;
+		for (; cnt < run->cnt && i < b->iterations; cnt++, i++) {
+			les[cnt] = recording.les[run->start + cnt];
+			les[cnt].timestamp += time_offset;
+		}
+
+		SurviveObject *so = objects[batched][run->object];
+		if (batched) {
+			disambiguator_batch(so, les, cnt);
+		} else {
+			for (size_t j = 0; j < cnt; j++)
+				disambiguator(so, &les[j]);
+		}
+	}
+	survive_bench_stop(b);
+
+	ctx->lightcapproc = prior_fn;
+	survive_bench_counter(b, "lights", (double)(lights_reported - prior_lights) / b->iterations);
+	return 0;
+}
+
+// Elements per op, as with the synthetic ones
+BENCHMARK(Disambiguator, Recording) { return bench_recording(b, false); }
+BENCHMARK(Disambiguator, RecordingBatch) { return bench_recording(b, true); }
+
+static void noop_lightcap(SurviveObject *so, const LightcapElement *le) {}
+
+// The cost of getting one packet's worth of pulses to the lightcap hook, one element at a time or as a batch
+static int bench_lightcap_dispatch(survive_bench *b, bool batched) {
+	static SurviveObject *so;
+
+	SurviveContext *ctx = survive_bench_context();
+	if (so == 0) {
+		so = survive_create_device(ctx, "BENCH", 0, "BN1", 0);
+		so->sensor_ct = SENSOR_CNT;
+		setup_cycle();
+	}
+
+	// The bench context is shared, so the hook and lighthouse version are put back afterwards
+	lightcap_process_func prior_fn = ctx->lightcapproc;
+	int prior_lh_version = ctx->lh_version;
+	ctx->lightcapproc = noop_lightcap;
+	ctx->lh_version = 0;
+
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++) {
+		if (batched) {
+			handle_lightcaps(so, cycle, ELEMENTS_PER_FRAME);
+		} else {
+			for (int j = 0; j < ELEMENTS_PER_FRAME; j++) {
+				handle_lightcap(so, &cycle[j]);
+			}
+		}
+	}
+	survive_bench_stop(b);
+
+	ctx->lightcapproc = prior_fn;
+	ctx->lh_version = prior_lh_version;
+	survive_bench_counter(b, "elements", ELEMENTS_PER_FRAME);
+	return 0;
+}
+
+BENCHMARK(Lightcap, Dispatch) { return bench_lightcap_dispatch(b, false); }
+BENCHMARK(Lightcap, DispatchBatch) { return bench_lightcap_dispatch(b, true); }
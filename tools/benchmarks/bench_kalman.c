@@ -0,0 +1,49 @@
+#include "bench.h"
+
+#include <linmath.h>
+#include <string.h>
+
+#include "../../src/survive_default_devices.h"
+#include "../../src/survive_kalman_tracker.h"
+
+#define IMU_SAMPLES 64
+
+/*
+ * IMU samples from a stationary object run through its tracker, which is one predict and update of the full tracker
+ * model per sample. The tracker ignores IMU data until it has seen some pose observations, so it is seeded with those
+ * first; the object persists between runs so the filter stays in its steady state.
+ */
+BENCHMARK(Kalman, ImuIntegrate) {
+	static SurviveObject *so;
+	static uint64_t samples;
+	static FLT accelgyro[IMU_SAMPLES][6];
+
+	if (so == 0) {
+		so = survive_create_device(survive_bench_context(), "BENCH", 0, "BK0", 0);
+		for (int i = 0; i < IMU_SAMPLES; i++) {
+			for (int j = 0; j < 6; j++)
+				accelgyro[i][j] = linmath_normrand(0, j < 3 ? .01 : .001);
+			accelgyro[i][2] += 1;
+		}
+	}
+
+	survive_long_timecode ticks_per_sample = so->timebase_hz / so->imu_freq;
+	if (samples == 0) {
+		SurvivePose pose = {.Pos = {0, 0, 1}, .Rot = {1}};
+		for (; samples < 16; samples++) {
+			PoserData pd = {.pt = POSERDATA_LIGHT, .timecode = (samples + 1) * ticks_per_sample};
+			survive_kalman_tracker_integrate_observation(&pd, so->tracker, &pose, 0);
+		}
+	}
+
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++, samples++) {
+		PoserDataIMU imu = {.hdr = {.pt = POSERDATA_IMU, .timecode = (samples + 1) * ticks_per_sample},
+							.datamask = 3};
+		memcpy(imu.accel, accelgyro[samples % IMU_SAMPLES], sizeof(FLT) * 3);
+		memcpy(imu.gyro, accelgyro[samples % IMU_SAMPLES] + 3, sizeof(FLT) * 3);
+		survive_kalman_tracker_integrate_imu(so->tracker, &imu);
+	}
+	survive_bench_stop(b);
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include "bench.h"
+
+#include <linmath.h>
+#include <math.h>
+#include <string.h>
+
+// One object's worth of sensors, and a pose per lighthouse channel
+#define LINMATH_POINTS SENSORS_PER_OBJECT
+#define LINMATH_POSES NUM_GEN2_LIGHTHOUSES
+
+static LinmathPoint3d points[LINMATH_POINTS];
+static LinmathPose poses[LINMATH_POSES];
+
+static void setup_inputs() {
+	for (int i = 0; i < LINMATH_POINTS; i++) {
+		for (int j = 0; j < 3; j++)
+			points[i][j] = linmath_normrand(0, .05);
+	}
+	for (int i = 0; i < LINMATH_POSES; i++) {
+		LinmathEulerAngle euler = {linmath_normrand(0, 1), linmath_normrand(0, 1), linmath_normrand(0, 1)};
+		for (int j = 0; j < 3; j++)
+			poses[i].Pos[j] = linmath_normrand(0, 2);
+		quatfromeuler(poses[i].Rot, euler);
+	}
+}
+
+static bool close_to(const FLT *a, const FLT *b, size_t cnt) {
+	for (size_t i = 0; i < cnt; i++) {
+		if (fabs(a[i] - b[i]) > 1e-9)
+			return false;
+	}
+	return true;
+}
+
+// The batch versions have to agree with the single point ones before their timings mean anything
+static bool batch_matches_single() {
+	LinmathPoint3d single[LINMATH_POINTS], batch[LINMATH_POINTS];
+	for (int p = 0; p < LINMATH_POSES; p++) {
+		for (int i = 0; i < LINMATH_POINTS; i++)
+			ApplyPoseToPoint(single[i], &poses[p], points[i]);
+		ApplyPoseToPoints(batch[0], &poses[p], points[0], LINMATH_POINTS);
+		if (!close_to(single[0], batch[0], 3 * LINMATH_POINTS))
+			return false;
+	}
+
+	LinmathPoint3d single_poses[LINMATH_POSES], batch_poses[LINMATH_POSES];
+	for (int p = 0; p < LINMATH_POSES; p++)
+		ApplyPoseToPoint(single_poses[p], &poses[p], points[0]);
+	ApplyPosesToPoint(batch_poses[0], poses, LINMATH_POSES, points[0]);
+	return close_to(single_poses[0], batch_poses[0], 3 * LINMATH_POSES);
+}
+
+#define LINMATH_BENCH(body)                                                                                            \
+	setup_inputs();                                                                                                    \
+	if (!batch_matches_single()) {                                                                                     \
+		snprintf(b->note, sizeof(b->note), "batch and single point results differ");                                  \
+		return -1;                                                                                                     \
+	}                                                                                                                  \
+	survive_bench_start(b);                                                                                            \
+	for (uint64_t i = 0; i < b->iterations; i++) {                                                                     \
+		const LinmathPose *pose = &poses[i % LINMATH_POSES];                                                           \
+		body;                                                                                                          \
+	}                                                                                                                  \
+	survive_bench_stop(b);                                                                                             \
+	return 0;
+
+// All the sensors of one object into the frame of one lighthouse, a point at a time
+BENCHMARK(Linmath, ApplyPoseToPoint) {
+	LinmathPoint3d out[LINMATH_POINTS];
+	LINMATH_BENCH({
+		for (int j = 0; j < LINMATH_POINTS; j++)
+			ApplyPoseToPoint(out[j], pose, points[j]);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Linmath, ApplyPoseToPoints) {
+	LinmathPoint3d out[LINMATH_POINTS];
+	LINMATH_BENCH({
+		ApplyPoseToPoints(out[0], pose, points[0], LINMATH_POINTS);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Linmath, QuatRotateVector) {
+	LinmathVec3d out[LINMATH_POINTS];
+	LINMATH_BENCH({
+		for (int j = 0; j < LINMATH_POINTS; j++)
+			quatrotatevector(out[j], pose->Rot, points[j]);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Linmath, QuatRotateVectors) {
+	LinmathVec3d out[LINMATH_POINTS];
+	LINMATH_BENCH({
+		quatrotatevectors(out[0], pose->Rot, points[0], LINMATH_POINTS);
+		survive_bench_use(out);
+	});
+}
+
+// One point through every lighthouse pose
+BENCHMARK(Linmath, ApplyPoseToPointPerPose) {
+	LinmathPoint3d out[LINMATH_POSES];
+	LINMATH_BENCH({
+		for (int j = 0; j < LINMATH_POSES; j++)
+			ApplyPoseToPoint(out[j], &poses[j], points[i % LINMATH_POINTS]);
+		survive_bench_use(out);
+		(void)pose;
+	});
+}
+
+BENCHMARK(Linmath, ApplyPosesToPoint) {
+	LinmathPoint3d out[LINMATH_POSES];
+	LINMATH_BENCH({
+		ApplyPosesToPoint(out[0], poses, LINMATH_POSES, points[i % LINMATH_POINTS]);
+		survive_bench_use(out);
+		(void)pose;
+	});
+}
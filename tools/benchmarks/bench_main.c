@@ -0,0 +1,305 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/survive_internal.h"
+
+#ifdef _WIN32
+#include "dirent.windows.h"
+#else
+#include <dirent.h>
+#endif
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define SURVIVE_BENCH_COUNT_ALLOCS 1
+
+// Interpose the allocator so allocations made inside libsurvive and its plugins are counted too
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static uint64_t alloc_count, alloc_bytes;
+
+static inline void count_alloc(size_t size) {
+	__atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&alloc_bytes, size, __ATOMIC_RELAXED);
+}
+
+SURVIVE_EXPORT void *malloc(size_t size) {
+	count_alloc(size);
+	return __libc_malloc(size);
+}
+
+SURVIVE_EXPORT void *calloc(size_t n, size_t size) {
+	count_alloc(n * size);
+	return __libc_calloc(n, size);
+}
+
+SURVIVE_EXPORT void *realloc(void *ptr, size_t size) {
+	count_alloc(size);
+	return __libc_realloc(ptr, size);
+}
+
+uint64_t survive_bench_alloc_count() { return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED); }
+uint64_t survive_bench_alloc_bytes() { return __atomic_load_n(&alloc_bytes, __ATOMIC_RELAXED); }
+#else
+#define SURVIVE_BENCH_COUNT_ALLOCS 0
+uint64_t survive_bench_alloc_count() { return 0; }
+uint64_t survive_bench_alloc_bytes() { return 0; }
+#endif
+
+void survive_bench_start(survive_bench *b) {
+	b->start_allocs = survive_bench_alloc_count();
+	b->start_alloc_bytes = survive_bench_alloc_bytes();
+	b->start_time = OGGetAbsoluteTime();
+}
+
+void survive_bench_stop(survive_bench *b) {
+	b->elapsed = OGGetAbsoluteTime() - b->start_time;
+	b->allocs = survive_bench_alloc_count() - b->start_allocs;
+	b->alloc_bytes = survive_bench_alloc_bytes() - b->start_alloc_bytes;
+}
+
+void survive_bench_counter(survive_bench *b, const char *name, double value) {
+	if (b->counters_cnt < SURVIVE_BENCH_MAX_COUNTERS) {
+		b->counters[b->counters_cnt].name = name;
+		b->counters[b->counters_cnt].value = value;
+		b->counters_cnt++;
+	}
+}
+
+static char **optimizer_problems;
+static int optimizer_problems_cnt;
+
+static void add_optimizer_problem(const char *path) {
+	optimizer_problems = realloc(optimizer_problems, sizeof(char *) * (optimizer_problems_cnt + 1));
+	optimizer_problems[optimizer_problems_cnt++] = strdup(path);
+}
+
+static int compare_strings(const void *a, const void *b) { return strcmp(*(char *const *)a, *(char *const *)b); }
+
+// Adds every .opt file in 'dir', in name order so runs over the same corpus are comparable
+static bool add_optimizer_corpus(const char *dir) {
+	DIR *dir_handle = opendir(dir);
+	if (dir_handle == 0)
+		return false;
+
+	int start = optimizer_problems_cnt;
+	struct dirent *dir_entry = 0;
+	while ((dir_entry = readdir(dir_handle))) {
+		size_t len = strlen(dir_entry->d_name);
+		if (len > 4 && strcmp(dir_entry->d_name + len - 4, ".opt") == 0) {
+			char path[FILENAME_MAX] = {0};
+			snprintf(path, sizeof(path), "%s/%s", dir, dir_entry->d_name);
+			add_optimizer_problem(path);
+		}
+	}
+	closedir(dir_handle);
+
+	qsort(optimizer_problems + start, optimizer_problems_cnt - start, sizeof(char *), compare_strings);
+	return true;
+}
+
+int survive_bench_optimizer_problem_count() { return optimizer_problems_cnt; }
+const char *survive_bench_optimizer_problem(int idx) { return optimizer_problems[idx]; }
+
+static const char *lightcap_recording;
+const char *survive_bench_lightcap_recording() { return lightcap_recording; }
+
+// Info level logs from the code being measured would only break up the results table
+static void bench_log(SurviveContext *ctx, SurviveLogLevel logLevel, const char *fault) {
+	if (logLevel != SURVIVE_LOG_LEVEL_INFO)
+		fprintf(stderr, "%s", fault);
+}
+
+// Arguments after '--' on the command line, passed on to the context; e.g. '--optimizer-xtol 1e-6'
+static char **survive_args;
+static int survive_args_cnt;
+
+static SurviveContext *bench_ctx;
+SurviveContext *survive_bench_context() {
+	if (bench_ctx == 0) {
+#ifdef _WIN32
+		const char *null_config = "NUL";
+#else
+		const char *null_config = "/dev/null";
+#endif
+		char *argv[64] = {"survive-bench", "--configfile", (char *)null_config, "--v", "0"};
+		int argc = 5;
+		for (int i = 0; i < survive_args_cnt && argc < sizeof(argv) / sizeof(argv[0]); i++)
+			argv[argc++] = survive_args[i];
+		bench_ctx = survive_init_internal(argc, argv, 0, bench_log);
+	}
+	return bench_ctx;
+}
+
+typedef struct bench_result {
+	const char *name;
+	int status;
+	survive_bench b;
+} bench_result;
+
+static int run_benchmark(survive_bench_fn fn, double min_time, survive_bench *out) {
+	uint64_t iterations = 1;
+	for (;;) {
+		survive_bench b = {.iterations = iterations};
+		srand(42);
+		int r = fn(&b);
+		if (r != 0) {
+			*out = b;
+			return r;
+		}
+
+		if (b.elapsed >= min_time || iterations >= (1ull << 40)) {
+			*out = b;
+			return 0;
+		}
+
+		// Aim a little past min_time so the final run usually is the one that crosses it
+		double per_op = b.elapsed / iterations;
+		uint64_t next = per_op > 0 ? (uint64_t)(min_time * 1.2 / per_op) : iterations * 100;
+		if (next > iterations * 100)
+			next = iterations * 100;
+		if (next <= iterations)
+			next = iterations * 2;
+		iterations = next;
+	}
+}
+
+static void write_json(FILE *f, const bench_result *results, int cnt, double min_time) {
+	fprintf(f, "{\n");
+	fprintf(f, "  \"version\": \"%s\",\n", survive_build_tag());
+	fprintf(f, "  \"flt_size\": %d,\n", (int)sizeof(FLT));
+	fprintf(f, "  \"min_time_s\": %g,\n", min_time);
+	fprintf(f, "  \"allocations_counted\": %s,\n", SURVIVE_BENCH_COUNT_ALLOCS ? "true" : "false");
+	fprintf(f, "  \"benchmarks\": [");
+	for (int i = 0; i < cnt; i++) {
+		const bench_result *r = &results[i];
+		const survive_bench *b = &r->b;
+		fprintf(f, "%s\n    {\"name\": \"%s\", ", i ? "," : "", r->name);
+		if (r->status != 0) {
+			fprintf(f, "\"skipped\": true, \"note\": \"%s\"}", b->note);
+			continue;
+		}
+		fprintf(f, "\"iterations\": %llu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.4f, \"alloc_bytes_per_op\": %.2f",
+				(unsigned long long)b->iterations, b->elapsed / b->iterations * 1e9, (double)b->allocs / b->iterations,
+				(double)b->alloc_bytes / b->iterations);
+		if (b->counters_cnt) {
+			fprintf(f, ", \"counters\": {");
+			for (int j = 0; j < b->counters_cnt; j++)
+				fprintf(f, "%s\"%s\": %.9g", j ? ", " : "", b->counters[j].name, b->counters[j].value);
+			fprintf(f, "}");
+		}
+		fprintf(f, "}");
+	}
+	fprintf(f, "\n  ]\n}\n");
+}
+
+static void usage(const char *name) {
+	fprintf(stderr,
+			"Usage: %s [options] [filter...]\n"
+			"Runs the benchmarks whose name contains any of the filters, or all of them.\n\n"
+			"  --list                      List the benchmarks and exit\n"
+			"  --min-time <s>              Minimum time to run each benchmark for (default .25)\n"
+			"  --json <file>               Also write the results as JSON; '-' writes to stdout\n"
+			"  --optimizer-problem <file>  Serialized optimizer problem (.opt) for the Optimizer benchmarks;\n"
+			"                              repeatable\n"
+			"  --optimizer-corpus <dir>    Adds every .opt file in a directory, as written by --serialize-lh-mpfit\n"
+			"  --lightcap-recording <file> Recording with raw gen1 light (--record-rawlight) for the Disambiguator\n"
+			"                              benchmarks\n"
+			"  -- <survive args>           Everything after this is passed to the library, e.g. optimizer settings\n",
+			name);
+}
+
+int main(int argc, char **argv) {
+	double min_time = .25;
+	const char *json_path = 0;
+	bool list = false;
+	const char *filters[64];
+	int filters_cnt = 0;
+
+	for (int i = 1; i < argc; i++) {
+		bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--list") == 0) {
+			list = true;
+		} else if (strcmp(argv[i], "--min-time") == 0 && has_value) {
+			min_time = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--json") == 0 && has_value) {
+			json_path = argv[++i];
+		} else if (strcmp(argv[i], "--optimizer-problem") == 0 && has_value) {
+			add_optimizer_problem(argv[++i]);
+		} else if (strcmp(argv[i], "--optimizer-corpus") == 0 && has_value) {
+			if (!add_optimizer_corpus(argv[++i])) {
+				fprintf(stderr, "Could not open optimizer corpus %s\n", argv[i]);
+				return -1;
+			}
+		} else if (strcmp(argv[i], "--lightcap-recording") == 0 && has_value) {
+			lightcap_recording = argv[++i];
+		} else if (strcmp(argv[i], "--") == 0) {
+			survive_args = argv + i + 1;
+			survive_args_cnt = argc - i - 1;
+			break;
+		} else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return -1;
+		} else if (filters_cnt < sizeof(filters) / sizeof(filters[0])) {
+			filters[filters_cnt++] = argv[i];
+		}
+	}
+
+	bench_result results[256];
+	int results_cnt = 0;
+
+	// json on stdout has to stay parseable, so the table goes to stderr then
+	FILE *table = json_path && strcmp(json_path, "-") == 0 ? stderr : stdout;
+	if (!list)
+		fprintf(table, "%-40s %14s %12s %12s %14s\n", "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op");
+
+	const char *BenchName;
+	for (int i = 0; (BenchName = GetDriverNameMatching("Bench", i)) && results_cnt < 256; i++) {
+		const char *name = BenchName + strlen("Bench");
+		bool selected = filters_cnt == 0;
+		for (int j = 0; j < filters_cnt && !selected; j++)
+			selected = strstr(name, filters[j]) != 0;
+		if (!selected)
+			continue;
+
+		if (list) {
+			fprintf(table, "%s\n", name);
+			continue;
+		}
+
+		bench_result *r = &results[results_cnt++];
+		r->name = name;
+		r->status = run_benchmark((survive_bench_fn)GetDriver(BenchName), min_time, &r->b);
+
+		const survive_bench *b = &r->b;
+		if (r->status != 0) {
+			fprintf(table, "%-40s %14s %s\n", name, "skipped", b->note);
+		} else {
+			fprintf(table, "%-40s %14llu %12.1f %12.3f %14.1f %s", name, (unsigned long long)b->iterations,
+					b->elapsed / b->iterations * 1e9, (double)b->allocs / b->iterations,
+					(double)b->alloc_bytes / b->iterations, b->note);
+			for (int j = 0; j < b->counters_cnt; j++)
+				fprintf(table, " %s=%.4g", b->counters[j].name, b->counters[j].value);
+			fprintf(table, "\n");
+		}
+		fflush(table);
+	}
+
+	if (json_path && !list) {
+		FILE *f = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+		if (f == 0) {
+			fprintf(stderr, "Could not open %s\n", json_path);
+			return -1;
+		}
+		write_json(f, results, results_cnt, min_time);
+		if (f != stdout)
+			fclose(f);
+	}
+
+	// The context was never started, so it isn't in a state survive_close can tear down; the process exiting does it
+	return 0;
+}
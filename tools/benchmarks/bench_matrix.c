@@ -0,0 +1,250 @@
+#include "bench.h"
+
+#include <linmath.h>
+#include <math.h>
+#include <string.h>
+#include <sv_matrix.h>
+#include <sv_matrix.small.h>
+
+/*
+ * The sv_matrix operations at the sizes the trackers use them: 3x3 rotations, the covariance update of the 19 state
+ * kalman model against a 7 row pose measurement, and the solves and decompositions of the barycentric solver.
+ *
+ * The plain benchmarks go through whichever backend sv_matrix was built with (USE_SMALL_MATRIX, USE_EIGEN or blas),
+ * so comparing backends means running this from each build. The 'Small' ones call the inline kernels of
+ * sv_matrix.small.h directly with their sizes spelled out, which is available in every build.
+ */
+
+#define KALMAN_STATE 19
+#define KALMAN_MEAS 7
+
+static FLT rot_a[9], rot_b[9];
+static FLT P[KALMAN_STATE * KALMAN_STATE], H[KALMAN_MEAS * KALMAN_STATE], R[KALMAN_MEAS * KALMAN_MEAS];
+// A copy of P, for products of P with itself; svGEMM's sources may not alias each other
+static FLT P_copy[KALMAN_STATE * KALMAN_STATE];
+static FLT S7[KALMAN_MEAS * KALMAN_MEAS];
+static FLT L6x4[6 * 4], rho6[6];
+static FLT M12[12 * 12];
+
+static void fill_random(FLT *m, int cnt) {
+	for (int i = 0; i < cnt; i++)
+		m[i] = linmath_normrand(0, 1);
+}
+
+// A * A^t + I, which is the shape covariances have
+static void fill_spd(FLT *m, int n) {
+	FLT a[KALMAN_STATE * KALMAN_STATE];
+	fill_random(a, n * n);
+	sv_small_gemm(m, a, a, 0, n, n, n, 1, 0, false, true, false);
+	for (int i = 0; i < n; i++)
+		m[i * n + i] += 1;
+}
+
+static void setup_inputs() {
+	fill_random(rot_a, 9);
+	fill_random(rot_b, 9);
+	fill_spd(P, KALMAN_STATE);
+	memcpy(P_copy, P, sizeof(P));
+	fill_random(H, KALMAN_MEAS * KALMAN_STATE);
+	memset(R, 0, sizeof(R));
+	for (int i = 0; i < KALMAN_MEAS; i++)
+		R[i * KALMAN_MEAS + i] = 1e-3;
+	fill_spd(S7, KALMAN_MEAS);
+	fill_random(L6x4, 6 * 4);
+	fill_random(rho6, 6);
+
+	FLT m[12 * 12];
+	fill_random(m, 12 * 12);
+	sv_small_gemm(M12, m, m, 0, 12, 12, 12, 1, 0, true, false, false);
+}
+
+static bool close_to(const FLT *a, const FLT *b, size_t cnt, FLT tolerance) {
+	for (size_t i = 0; i < cnt; i++) {
+		if (!(fabs(a[i] - b[i]) <= tolerance * (1 + fabs(b[i]))))
+			return false;
+	}
+	return true;
+}
+
+// P = (I - K * H) * P with K = P * H^t * (H * P * H^t + R)^-1; as survive_kalman_update_covariance does it
+static void kalman_covariance(FLT *out) {
+	FLT _PHt[KALMAN_STATE * KALMAN_MEAS], _S[KALMAN_MEAS * KALMAN_MEAS], _iS[KALMAN_MEAS * KALMAN_MEAS];
+	FLT _K[KALMAN_STATE * KALMAN_MEAS], _eye[KALMAN_STATE * KALMAN_STATE], _ikh[KALMAN_STATE * KALMAN_STATE];
+	SvMat Pm = svMat(KALMAN_STATE, KALMAN_STATE, P), Hm = svMat(KALMAN_MEAS, KALMAN_STATE, H);
+	SvMat Rm = svMat(KALMAN_MEAS, KALMAN_MEAS, R), outm = svMat(KALMAN_STATE, KALMAN_STATE, out);
+	SvMat PHt = svMat(KALMAN_STATE, KALMAN_MEAS, _PHt), S = svMat(KALMAN_MEAS, KALMAN_MEAS, _S);
+	SvMat iS = svMat(KALMAN_MEAS, KALMAN_MEAS, _iS), K = svMat(KALMAN_STATE, KALMAN_MEAS, _K);
+	SvMat eye = svMat(KALMAN_STATE, KALMAN_STATE, _eye), ikh = svMat(KALMAN_STATE, KALMAN_STATE, _ikh);
+
+	svGEMM(&Pm, &Hm, 1, 0, 0, &PHt, SV_GEMM_FLAG_B_T);
+	svGEMM(&Hm, &PHt, 1, &Rm, 1, &S, 0);
+	svInvert(&S, &iS, SV_INVERT_METHOD_LU);
+	svGEMM(&PHt, &iS, 1, 0, 0, &K, 0);
+	sv_set_diag_val(&eye, 1);
+	svGEMM(&K, &Hm, -1, &eye, 1, &ikh, 0);
+	svGEMM(&ikh, &Pm, 1, 0, 0, &outm, 0);
+}
+
+static void kalman_covariance_small(FLT *out) {
+	FLT PHt[KALMAN_STATE * KALMAN_MEAS], S[KALMAN_MEAS * KALMAN_MEAS], iS[KALMAN_MEAS * KALMAN_MEAS];
+	FLT K[KALMAN_STATE * KALMAN_MEAS], ikh[KALMAN_STATE * KALMAN_STATE];
+	int piv[KALMAN_MEAS];
+
+	sv_small_gemm(PHt, P, H, 0, KALMAN_STATE, KALMAN_MEAS, KALMAN_STATE, 1, 0, false, true, false);
+	sv_small_gemm(S, H, PHt, R, KALMAN_MEAS, KALMAN_MEAS, KALMAN_STATE, 1, 1, false, false, false);
+	sv_small_lu(S, KALMAN_MEAS, piv);
+	for (int i = 0; i < KALMAN_MEAS * KALMAN_MEAS; i++)
+		iS[i] = i % (KALMAN_MEAS + 1) == 0;
+	sv_small_lu_solve(S, piv, KALMAN_MEAS, iS, KALMAN_MEAS);
+	sv_small_gemm(K, PHt, iS, 0, KALMAN_STATE, KALMAN_MEAS, KALMAN_MEAS, 1, 0, false, false, false);
+	sv_small_gemm(ikh, K, H, 0, KALMAN_STATE, KALMAN_STATE, KALMAN_MEAS, -1, 0, false, false, false);
+	for (int i = 0; i < KALMAN_STATE; i++)
+		ikh[i * KALMAN_STATE + i] += 1;
+	sv_small_gemm(out, ikh, P, 0, KALMAN_STATE, KALMAN_STATE, KALMAN_STATE, 1, 0, false, false, false);
+}
+
+// Checks that u * diag(w) * v^t gives back 'a'; the signs of the singular vectors are up to the backend
+static bool svd_reconstructs(const FLT *a, int n, const FLT *w, const FLT *u, const FLT *v) {
+	FLT uw[12 * 12], usv[12 * 12];
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++)
+			uw[i * n + j] = u[i * n + j] * w[j];
+	}
+	sv_small_gemm(usv, uw, v, 0, n, n, n, 1, 0, false, true, false);
+	return close_to(usv, a, n * n, 1e-9);
+}
+
+static bool backend_is_correct() {
+	FLT out[9], expected[9];
+	SvMat a = svMat(3, 3, rot_a), bm = svMat(3, 3, rot_b), outm = svMat(3, 3, out);
+	svGEMM(&a, &bm, 1, 0, 0, &outm, 0);
+	sv_small_gemm(expected, rot_a, rot_b, 0, 3, 3, 3, 1, 0, false, false, false);
+	if (!close_to(out, expected, 9, 1e-12))
+		return false;
+
+	FLT cov[KALMAN_STATE * KALMAN_STATE], cov_small[KALMAN_STATE * KALMAN_STATE];
+	kalman_covariance(cov);
+	kalman_covariance_small(cov_small);
+	if (!close_to(cov, cov_small, KALMAN_STATE * KALMAN_STATE, 1e-9))
+		return false;
+
+	// Least squares: the residual has to be orthogonal to the columns of L
+	FLT x[4], residual[6], normal[4];
+	SvMat L = svMat(6, 4, L6x4), rho = svMat(6, 1, rho6), xm = svMat(4, 1, x);
+	svSolve(&L, &rho, &xm, SV_INVERT_METHOD_SVD);
+	sv_small_gemm(residual, L6x4, x, rho6, 6, 1, 4, 1, -1, false, false, false);
+	sv_small_gemm(normal, L6x4, residual, 0, 4, 1, 6, 1, 0, true, false, false);
+	FLT zeros[4] = {0};
+	if (!close_to(normal, zeros, 4, 1e-9))
+		return false;
+
+	FLT _a[12 * 12], w[12], u[12 * 12], v[12 * 12];
+	memcpy(_a, M12, sizeof(M12));
+	SvMat am = svMat(12, 12, _a), wm = svMat(12, 1, w), um = svMat(12, 12, u), vm = svMat(12, 12, v);
+	svSVD(&am, &wm, &um, &vm, 0);
+	return svd_reconstructs(M12, 12, w, u, v);
+}
+
+#define MATRIX_BENCH(body)                                                                                             \
+	setup_inputs();                                                                                                    \
+	if (!backend_is_correct()) {                                                                                       \
+		snprintf(b->note, sizeof(b->note), "backend disagrees with the reference kernels");                            \
+		return -1;                                                                                                     \
+	}                                                                                                                  \
+	survive_bench_start(b);                                                                                            \
+	for (uint64_t i = 0; i < b->iterations; i++) {                                                                     \
+		body;                                                                                                          \
+	}                                                                                                                  \
+	survive_bench_stop(b);                                                                                             \
+	return 0;
+
+BENCHMARK(Matrix, Gemm3x3) {
+	FLT out[9];
+	SvMat a = svMat(3, 3, rot_a), bm = svMat(3, 3, rot_b), outm = svMat(3, 3, out);
+	MATRIX_BENCH({
+		svGEMM(&a, &bm, 1, 0, 0, &outm, 0);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Matrix, Gemm3x3Small) {
+	FLT out[9];
+	MATRIX_BENCH({
+		sv_small_gemm(out, rot_a, rot_b, 0, 3, 3, 3, 1, 0, false, false, false);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Matrix, Gemm19x19) {
+	FLT out[KALMAN_STATE * KALMAN_STATE];
+	SvMat Pm = svMat(KALMAN_STATE, KALMAN_STATE, P), Pcm = svMat(KALMAN_STATE, KALMAN_STATE, P_copy),
+		  outm = svMat(KALMAN_STATE, KALMAN_STATE, out);
+	MATRIX_BENCH({
+		svGEMM(&Pm, &Pcm, 1, 0, 0, &outm, 0);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Matrix, Gemm19x19Small) {
+	FLT out[KALMAN_STATE * KALMAN_STATE];
+	MATRIX_BENCH({
+		sv_small_gemm(out, P, P, 0, KALMAN_STATE, KALMAN_STATE, KALMAN_STATE, 1, 0, false, false, false);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Matrix, KalmanCovariance) {
+	FLT out[KALMAN_STATE * KALMAN_STATE];
+	MATRIX_BENCH({
+		kalman_covariance(out);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Matrix, KalmanCovarianceSmall) {
+	FLT out[KALMAN_STATE * KALMAN_STATE];
+	MATRIX_BENCH({
+		kalman_covariance_small(out);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Matrix, Invert7x7) {
+	FLT out[KALMAN_MEAS * KALMAN_MEAS];
+	SvMat S = svMat(KALMAN_MEAS, KALMAN_MEAS, S7), outm = svMat(KALMAN_MEAS, KALMAN_MEAS, out);
+	MATRIX_BENCH({
+		svInvert(&S, &outm, SV_INVERT_METHOD_LU);
+		survive_bench_use(out);
+	});
+}
+
+// The 6x4 least squares problem of the barycentric solver
+BENCHMARK(Matrix, Solve6x4) {
+	FLT x[4];
+	SvMat L = svMat(6, 4, L6x4), rho = svMat(6, 1, rho6), xm = svMat(4, 1, x);
+	MATRIX_BENCH({
+		svSolve(&L, &rho, &xm, SV_INVERT_METHOD_SVD);
+		survive_bench_use(x);
+	});
+}
+
+BENCHMARK(Matrix, SVD3x3) {
+	FLT _a[9], w[3], u[9], v[9];
+	SvMat am = svMat(3, 3, _a), wm = svMat(3, 1, w), um = svMat(3, 3, u), vm = svMat(3, 3, v);
+	MATRIX_BENCH({
+		memcpy(_a, rot_a, sizeof(_a));
+		svSVD(&am, &wm, &um, &vm, SV_SVD_MODIFY_A);
+		survive_bench_use(w);
+	});
+}
+
+// M^t * M of the barycentric solver, whose null space gives the control points
+BENCHMARK(Matrix, SVD12x12) {
+	FLT _a[12 * 12], w[12], u[12 * 12];
+	SvMat am = svMat(12, 12, _a), wm = svMat(12, 1, w), um = svMat(12, 12, u);
+	MATRIX_BENCH({
+		memcpy(_a, M12, sizeof(_a));
+		svSVD(&am, &wm, &um, 0, SV_SVD_MODIFY_A | SV_SVD_U_T);
+		survive_bench_use(u);
+	});
+}
@@ -0,0 +1,173 @@
+#include "bench.h"
+
+#include <math.h>
+#include <mpfit/mpfit.h>
+#include <stdlib.h>
+#include <string.h>
+#include <survive_optimizer.h>
+
+/*
+ * Replays serialized MPFIT problems (see --serialize-lh-mpfit) through the solver under different configurations. One
+ * op is one solve from the problem's serialized starting point, cycling through all the given problems, so the time,
+ * solver iterations, function evaluations and final error of each configuration are directly comparable.
+ */
+
+typedef struct bench_problem {
+	survive_optimizer *opt;
+	FLT *initial_parameters;
+	int *initial_sides;
+} bench_problem;
+
+// Problems are loaded once and reused by every run of the benchmarks
+static bench_problem *problems;
+static int problems_cnt = -1;
+
+static int load_problems() {
+	if (problems_cnt >= 0)
+		return problems_cnt;
+
+	problems_cnt = 0;
+	int cnt = survive_bench_optimizer_problem_count();
+	problems = calloc(cnt, sizeof(bench_problem));
+	for (int i = 0; i < cnt; i++) {
+		bench_problem *p = &problems[problems_cnt];
+		p->opt = survive_optimizer_load(survive_bench_optimizer_problem(i));
+		if (p->opt == 0) {
+			fprintf(stderr, "Could not load optimizer problem %s\n", survive_bench_optimizer_problem(i));
+			continue;
+		}
+		if (p->opt->sos[0]->sensor_locations == 0) {
+			fprintf(stderr, "No device config found for optimizer problem %s\n", survive_bench_optimizer_problem(i));
+			continue;
+		}
+		// Loaded objects have no context, which makes every verbose log in the solver print unconditionally
+		p->opt->sos[0]->ctx = survive_bench_context();
+
+		size_t param_cnt = survive_optimizer_get_parameters_count(p->opt);
+		p->initial_parameters = malloc(sizeof(FLT) * param_cnt);
+		p->initial_sides = malloc(sizeof(int) * param_cnt);
+		memcpy(p->initial_parameters, p->opt->parameters, sizeof(FLT) * param_cnt);
+		for (int j = 0; j < param_cnt; j++)
+			p->initial_sides[j] = p->opt->parameters_info[j].side;
+		problems_cnt++;
+	}
+	return problems_cnt;
+}
+
+// The mp_config survive_optimizer_run builds from the optimizer-* settings, which '--' arguments can change
+static mp_config context_config() {
+	SurviveContext *ctx = survive_bench_context();
+	return (mp_config){.maxiter = survive_configi(ctx, "optimizer-maxiter", SC_GET, 0),
+					   .maxfev = survive_configi(ctx, "optimizer-maxfev", SC_GET, 0),
+					   .ftol = survive_configf(ctx, "optimizer-ftol", SC_GET, 0),
+					   .normtol = survive_configf(ctx, "optimizer-normtol", SC_GET, 0),
+					   .xtol = survive_configf(ctx, "optimizer-xtol", SC_GET, 0),
+					   .gtol = survive_configf(ctx, "optimizer-gtol", SC_GET, 0),
+					   .covtol = survive_configf(ctx, "optimizer-covtol", SC_GET, 0),
+					   .epsfcn = survive_configf(ctx, "optimizer-epsfcn", SC_GET, 0),
+					   .stepfactor = survive_configf(ctx, "optimizer-stepfactor", SC_GET, 0),
+					   .douserscale = survive_configi(ctx, "optimizer-douserscale", SC_GET, 0)};
+}
+
+// Solves problem 'p' from its starting point, leaving the result in its parameters
+static int solve_problem(bench_problem *p, struct mp_result_struct *result) {
+	memcpy(p->opt->parameters, p->initial_parameters, sizeof(FLT) * survive_optimizer_get_parameters_count(p->opt));
+	return survive_optimizer_run(p->opt, result);
+}
+
+// The pool only changes where jacobian columns are evaluated, never their arithmetic, so results must be identical
+static bool pool_matches_serial(SurviveContext *ctx, bench_problem *p, struct survive_thread_pool *pool) {
+	size_t param_cnt = survive_optimizer_get_parameters_count(p->opt);
+	FLT *serial = malloc(sizeof(FLT) * param_cnt);
+	struct mp_result_struct result = {0};
+
+	survive_install_thread_pool(ctx, 0);
+	solve_problem(p, &result);
+	memcpy(serial, p->opt->parameters, sizeof(FLT) * param_cnt);
+	survive_install_thread_pool(ctx, pool);
+	solve_problem(p, &result);
+
+	bool matches = memcmp(serial, p->opt->parameters, sizeof(FLT) * param_cnt) == 0;
+	free(serial);
+	return matches;
+}
+
+/*
+ * 'cfg' of 0 uses the context configuration the same way the posers do. 'numeric' replaces the analytical jacobians
+ * with MPFIT's finite differences, and 'pool' evaluates those on other threads in place of the context's own pool.
+ */
+static int bench_optimizer(survive_bench *b, mp_config *cfg, bool numeric, struct survive_thread_pool *pool) {
+	int cnt = load_problems();
+	if (cnt == 0) {
+		snprintf(b->note, sizeof(b->note), "no problems; pass --optimizer-problem or --optimizer-corpus");
+		return SURVIVE_BENCH_SKIP;
+	}
+
+	SurviveContext *ctx = survive_bench_context();
+	struct survive_thread_pool *ctx_pool = survive_install_thread_pool(ctx, pool);
+	for (int i = 0; i < cnt; i++) {
+		bench_problem *p = &problems[i];
+		p->opt->cfg = cfg;
+		for (int j = 0; j < survive_optimizer_get_parameters_count(p->opt); j++)
+			p->opt->parameters_info[j].side = numeric && p->initial_sides[j] == 3 ? 0 : p->initial_sides[j];
+
+		if (pool && !pool_matches_serial(ctx, p, pool)) {
+			snprintf(b->note, sizeof(b->note), "problem %d solved differently with the thread pool", i);
+			survive_install_thread_pool(ctx, ctx_pool);
+			return -1;
+		}
+	}
+
+	uint64_t iterations = 0, fevs = 0, failures = 0;
+	double final_norm = 0;
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++) {
+		bench_problem *p = &problems[i % cnt];
+		struct mp_result_struct result = {0};
+		int status = solve_problem(p, &result);
+		iterations += result.niter;
+		fevs += result.nfev;
+		if (status <= 0 || !isfinite(result.bestnorm))
+			failures++;
+		else
+			final_norm += result.bestnorm;
+	}
+	survive_bench_stop(b);
+
+	survive_install_thread_pool(ctx, ctx_pool);
+
+	snprintf(b->note, sizeof(b->note), "%d problems", cnt);
+	survive_bench_counter(b, "iterations", (double)iterations / b->iterations);
+	survive_bench_counter(b, "fevs", (double)fevs / b->iterations);
+	survive_bench_counter(b, "final_norm", b->iterations > failures ? final_norm / (b->iterations - failures) : NAN);
+	survive_bench_counter(b, "failures", (double)failures / b->iterations);
+	return 0;
+}
+
+BENCHMARK(Optimizer, Run) { return bench_optimizer(b, 0, false, 0); }
+
+BENCHMARK(Optimizer, RunNumericJacobian) { return bench_optimizer(b, 0, true, 0); }
+
+BENCHMARK(Optimizer, RunNumericJacobianThreaded) {
+	struct survive_thread_pool *pool = survive_thread_pool_create(survive_bench_context(), 4);
+	int rtn = bench_optimizer(b, 0, true, pool);
+	survive_thread_pool_free(pool);
+	return rtn;
+}
+
+// What poser_mpfit uses for lighthouse solves and with --precise
+BENCHMARK(Optimizer, RunPrecise) { return bench_optimizer(b, survive_optimizer_precise_config(), false, 0); }
+
+BENCHMARK(Optimizer, RunLooseTolerance) {
+	mp_config cfg = context_config();
+	cfg.xtol = 1e-3;
+	cfg.normtol = 1e-3;
+	return bench_optimizer(b, &cfg, false, 0);
+}
+
+BENCHMARK(Optimizer, RunTightTolerance) {
+	mp_config cfg = context_config();
+	cfg.xtol = 1e-6;
+	cfg.normtol = 1e-6;
+	return bench_optimizer(b, &cfg, false, 0);
+}
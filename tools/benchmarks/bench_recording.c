@@ -0,0 +1,219 @@
+// Text recording formatting and playback parsing.
+#include "bench.h"
+
+#include <linmath.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../src/survive_str.h"
+
+#define FLT_PRINTF "%0.6f "
+
+static const char *imu_printf_format = "%0.6f %s i %d %u " FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF FLT_PRINTF
+									   FLT_PRINTF " " FLT_PRINTF FLT_PRINTF FLT_PRINTF "%d\r\n";
+
+static size_t format_printf(char *buf, size_t len, double ts, const FLT *accelgyro, uint32_t timecode) {
+	return snprintf(buf, len, imu_printf_format, ts, "T20", 3, timecode, accelgyro[0], accelgyro[1], accelgyro[2],
+					accelgyro[3], accelgyro[4], accelgyro[5], accelgyro[6], accelgyro[7], accelgyro[8], 0);
+}
+
+// The same line built the way survive_recording.c does it now
+static size_t format_fast(char *buf, double ts, const FLT *accelgyro, uint32_t timecode) {
+	char *p = buf;
+	p += str_format_fixed(p, ts, 6);
+	memcpy(p, " T20 i ", 7);
+	p += 7;
+	p += str_format_int(p, 3);
+	*p++ = ' ';
+	p += str_format_uint(p, timecode);
+	*p++ = ' ';
+	for (int i = 0; i < 9; i++) {
+		if (i == 6)
+			*p++ = ' ';
+		p += str_format_fixed(p, accelgyro[i], 6);
+		*p++ = ' ';
+	}
+	p += str_format_int(p, 0);
+	memcpy(p, "\r\n", 3);
+	return p + 2 - buf;
+}
+
+static void random_accelgyro(FLT *accelgyro) {
+	for (int j = 0; j < 9; j++)
+		accelgyro[j] = linmath_normrand(0, j < 3 ? 9.8 : 1.);
+}
+
+BENCHMARK(Recording, FormatImuPrintf) {
+	FLT accelgyro[9];
+	char buf[STR_FORMAT_BUFFER_SIZE * 12];
+	random_accelgyro(accelgyro);
+
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++) {
+		accelgyro[i % 9] += 1e-3;
+		format_printf(buf, sizeof(buf), i * .001, accelgyro, (uint32_t)(i * 48000));
+		survive_bench_use(buf);
+	}
+	survive_bench_stop(b);
+	return 0;
+}
+
+BENCHMARK(Recording, FormatImu) {
+	FLT accelgyro[9];
+	char expected[STR_FORMAT_BUFFER_SIZE * 12], buf[STR_FORMAT_BUFFER_SIZE * 12];
+
+	// Only worth timing if it still produces exactly what printf does
+	for (int i = 0; i < 1000; i++) {
+		random_accelgyro(accelgyro);
+		size_t expected_len = format_printf(expected, sizeof(expected), i * .001, accelgyro, i * 48000);
+		size_t len = format_fast(buf, i * .001, accelgyro, i * 48000);
+		if (expected_len != len || memcmp(expected, buf, len) != 0) {
+			snprintf(b->note, sizeof(b->note), "output differs from printf");
+			return -1;
+		}
+	}
+
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++) {
+		accelgyro[i % 9] += 1e-3;
+		format_fast(buf, i * .001, accelgyro, (uint32_t)(i * 48000));
+		survive_bench_use(buf);
+	}
+	survive_bench_stop(b);
+	return 0;
+}
+
+#define PLAYBACK_LINES 256
+#define PLAYBACK_LINE_SIZE 256
+
+// A mix of lines like a gen2 tracker recording: mostly sweeps and IMU with the odd sync
+static char playback_lines[PLAYBACK_LINES][PLAYBACK_LINE_SIZE];
+
+static void setup_playback_lines() {
+	for (int i = 0; i < PLAYBACK_LINES; i++) {
+		char *line = playback_lines[i];
+		double ts = i * .0005;
+		switch (i % 8) {
+		case 0: {
+			FLT accelgyro[9];
+			random_accelgyro(accelgyro);
+			format_fast(line, ts, accelgyro, i * 24000);
+			break;
+		}
+		case 1:
+			snprintf(line, PLAYBACK_LINE_SIZE, "%0.6f T20 Y %d %u %d %d\n", ts, 3, i * 24000, i % 2, 1);
+			break;
+		case 2:
+		case 3:
+		case 4:
+			snprintf(line, PLAYBACK_LINE_SIZE, "%0.6f T20 W %d %d %u %d\n", ts, 3, i % 22, i * 24000, 0);
+			break;
+		default:
+			snprintf(line, PLAYBACK_LINE_SIZE, "%0.6f T20 B %d %u %u %d %+e\n", ts, 3, i % 22, i * 24000, i % 2,
+					 linmath_normrand(0, .5));
+			break;
+		}
+	}
+}
+
+static int next_ints(char **cursor, int64_t *out, int count) {
+	for (int i = 0; i < count; i++) {
+		char *token = str_next_token(cursor);
+		if (token == 0 || !str_parse_int(token, &out[i]))
+			return i;
+	}
+	return count;
+}
+
+static int next_flts(char **cursor, FLT *out, int count) {
+	for (int i = 0; i < count; i++) {
+		char *token = str_next_token(cursor);
+		if (token == 0 || !str_parse_flt(token, &out[i]))
+			return i;
+	}
+	return count;
+}
+
+// Parses a line the way driver_playback.c does; returns the number of fields read
+static int parse_line(char *line) {
+	char *cursor = line;
+	const char *time_str = str_next_token(&cursor);
+	const char *dev = str_next_token(&cursor);
+	const char *op = str_next_token(&cursor);
+	double time;
+	if (op == 0 || !str_parse_double(time_str, &time))
+		return 0;
+	survive_bench_use(dev);
+
+	int64_t v[4];
+	FLT f[9];
+	switch (op[0]) {
+	case 'I':
+	case 'i': {
+		int cnt = next_ints(&cursor, v, 2);
+		cnt += next_flts(&cursor, f, 9);
+		return cnt + next_ints(&cursor, v + 2, 1);
+	}
+	case 'Y':
+	case 'W':
+		return next_ints(&cursor, v, 4);
+	case 'B':
+		return next_ints(&cursor, v, 4) + next_flts(&cursor, f, 1);
+	}
+	return 0;
+}
+
+// The sscanf based parsing playback used to do, for comparison
+static int parse_line_sscanf(const char *line) {
+	double time;
+	char dev[32], op[32];
+	int end = 0;
+	if (sscanf(line, "%lf %31s %31s %n", &time, dev, op, &end) != 3)
+		return 0;
+
+	const char *rest = line + end;
+	int v[4];
+	FLT f[9];
+	switch (op[0]) {
+	case 'I':
+	case 'i':
+		return sscanf(rest, "%d %d " FLT_sformat " " FLT_sformat " " FLT_sformat " " FLT_sformat " " FLT_sformat
+							" " FLT_sformat " " FLT_sformat " " FLT_sformat " " FLT_sformat " %d",
+					  &v[0], &v[1], &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6], &f[7], &f[8], &v[2]);
+	case 'Y':
+	case 'W':
+		return sscanf(rest, "%d %d %d %d", &v[0], &v[1], &v[2], &v[3]);
+	case 'B':
+		return sscanf(rest, "%d %d %d %d " FLT_sformat, &v[0], &v[1], &v[2], &v[3], &f[0]);
+	}
+	return 0;
+}
+
+BENCHMARK(Playback, ParseLines) {
+	setup_playback_lines();
+	char line[PLAYBACK_LINE_SIZE];
+
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++) {
+		// The tokenizer works in place, so parse a copy like playback does with the line it read
+		strcpy(line, playback_lines[i % PLAYBACK_LINES]);
+		int cnt = parse_line(line);
+		survive_bench_use(&cnt);
+	}
+	survive_bench_stop(b);
+	return 0;
+}
+
+BENCHMARK(Playback, ParseLinesSscanf) {
+	setup_playback_lines();
+	char line[PLAYBACK_LINE_SIZE];
+
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++) {
+		strcpy(line, playback_lines[i % PLAYBACK_LINES]);
+		int cnt = parse_line_sscanf(line);
+		survive_bench_use(&cnt);
+	}
+	survive_bench_stop(b);
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include "bench.h"
+
+#include <linmath.h>
+#include <survive_reproject.h>
+#include <survive_reproject_gen2.h>
+
+#define REPROJECT_INPUTS 256
+
+typedef struct reproject_input {
+	BaseStationCal bcal[2];
+	SurvivePose world2lh, obj2world;
+	LinmathAxisAnglePose world2lh_aa, obj2world_aa;
+	LinmathPoint3d ptInObj;
+} reproject_input;
+
+static reproject_input inputs[REPROJECT_INPUTS];
+
+// Random lighthouse calibrations and objects a couple meters in front of the lighthouse, which looks down -Z
+static void setup_inputs() {
+	for (int i = 0; i < REPROJECT_INPUTS; i++) {
+		reproject_input *in = &inputs[i];
+		FLT *cal = (FLT *)in->bcal;
+		for (int j = 0; j < 2 * sizeof(BaseStationCal) / sizeof(FLT); j++)
+			cal[j] = linmath_normrand(0, .01);
+
+		LinmathEulerAngle lh_euler = {linmath_normrand(0, .1), linmath_normrand(0, .1), linmath_normrand(0, .1)};
+		in->world2lh.Pos[0] = linmath_normrand(0, .1);
+		in->world2lh.Pos[1] = linmath_normrand(0, .1);
+		in->world2lh.Pos[2] = linmath_normrand(0, .1);
+		quatfromeuler(in->world2lh.Rot, lh_euler);
+
+		LinmathEulerAngle obj_euler = {linmath_normrand(0, 1), linmath_normrand(0, 1), linmath_normrand(0, 1)};
+		in->obj2world.Pos[0] = linmath_normrand(0, .5);
+		in->obj2world.Pos[1] = linmath_normrand(0, .5);
+		in->obj2world.Pos[2] = -2 + linmath_normrand(0, .5);
+		quatfromeuler(in->obj2world.Rot, obj_euler);
+
+		for (int j = 0; j < 3; j++)
+			in->ptInObj[j] = linmath_normrand(0, .05);
+
+		copy3d(in->world2lh_aa.Pos, in->world2lh.Pos);
+		quattoaxisanglemag(in->world2lh_aa.AxisAngleRot, in->world2lh.Rot);
+		copy3d(in->obj2world_aa.Pos, in->obj2world.Pos);
+		quattoaxisanglemag(in->obj2world_aa.AxisAngleRot, in->obj2world.Rot);
+	}
+}
+
+#define REPROJECT_BENCH(body)                                                                                          \
+	setup_inputs();                                                                                                    \
+	survive_bench_start(b);                                                                                            \
+	for (uint64_t i = 0; i < b->iterations; i++) {                                                                     \
+		const reproject_input *in = &inputs[i % REPROJECT_INPUTS];                                                     \
+		body;                                                                                                          \
+	}                                                                                                                  \
+	survive_bench_stop(b);                                                                                             \
+	return 0;
+
+BENCHMARK(Reproject, Gen1Full) {
+	SurviveAngleReading out;
+	REPROJECT_BENCH({
+		survive_reproject_full(in->bcal, &in->world2lh, &in->obj2world, in->ptInObj, out);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Reproject, Gen2Full) {
+	SurviveAngleReading out;
+	REPROJECT_BENCH({
+		survive_reproject_full_gen2(in->bcal, &in->world2lh, &in->obj2world, in->ptInObj, out);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Reproject, Gen1JacObjPose) {
+	FLT out[2 * 7];
+	REPROJECT_BENCH({
+		survive_reproject_gen1_model.reprojectFullJacObjPose(out, &in->obj2world, in->ptInObj, &in->world2lh,
+															 in->bcal);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Reproject, Gen2JacObjPose) {
+	FLT out[2 * 7];
+	REPROJECT_BENCH({
+		survive_reproject_gen2_model.reprojectFullJacObjPose(out, &in->obj2world, in->ptInObj, &in->world2lh,
+															 in->bcal);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Reproject, Gen1JacLhPose) {
+	FLT out[2 * 7];
+	REPROJECT_BENCH({
+		survive_reproject_gen1_model.reprojectFullJacLhPose(out, &in->obj2world, in->ptInObj, &in->world2lh,
+															in->bcal);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Reproject, Gen2JacLhPose) {
+	FLT out[2 * 7];
+	REPROJECT_BENCH({
+		survive_reproject_gen2_model.reprojectFullJacLhPose(out, &in->obj2world, in->ptInObj, &in->world2lh,
+															in->bcal);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Reproject, Gen1AxisAngleJacObjPose) {
+	FLT out[2 * 6];
+	REPROJECT_BENCH({
+		survive_reproject_gen1_model.reprojectAxisAngleFullJacObjPose(out, &in->obj2world_aa, in->ptInObj,
+																	  &in->world2lh_aa, in->bcal);
+		survive_bench_use(out);
+	});
+}
+
+BENCHMARK(Reproject, Gen2AxisAngleJacObjPose) {
+	FLT out[2 * 6];
+	REPROJECT_BENCH({
+		survive_reproject_gen2_model.reprojectAxisAngleFullJacObjPose(out, &in->obj2world_aa, in->ptInObj,
+																	  &in->world2lh_aa, in->bcal);
+		survive_bench_use(out);
+	});
+}
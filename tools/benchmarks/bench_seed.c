@@ -0,0 +1,333 @@
+#include "bench.h"
+#include <linmath.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <survive_optimizer.h>
+#include <survive_reproject.h>
+#include "../../src/poser_general_optimizer.h"
+#include "../../src/survive_default_devices.h"
+#include "../../src/survive_internal.h"
+
+#define SEED_SENSORS 24
+#define SEED_LIGHTHOUSES 4
+#define SEED_TIMECODE 48000000
+
+// The simulator's default layout; four lighthouses around an object a meter up
+static const SurvivePose seed_lighthouses[SEED_LIGHTHOUSES] = {
+	{.Pos = {-3, 0, 1}, .Rot = {-0.70710678118, 0, 0.70710678118, 0}},
+	{.Pos = {3, 0, 1}, .Rot = {0.70710678118, 0, 0.70710678118, 0}},
+	{.Pos = {0, 3, 1}, .Rot = {0.70710678118, -0.70710678118, 0, 0}},
+	{.Pos = {0, -3, 1}, .Rot = {0.70710678118, 0.70710678118, 0, 0}},
+};
+
+typedef struct seed_object {
+	SurviveObject *so;
+	void *poser_data;
+
+	SurvivePose obj2world;
+	SurvivePose reported;
+	int reports;
+} seed_object;
+
+static void record_pose(SurviveObject *so, uint32_t lh, const SurvivePose *pose, void *user) {
+	seed_object *obj = user;
+	obj->reported = *pose;
+	obj->reports++;
+}
+
+// An object with every sensor seen by every lighthouse right now, with exact angles
+static void setup_seed_object(SurviveContext *ctx, seed_object *obj, const char *name) {
+	SurviveObject *so = obj->so = survive_create_device(ctx, "BENCH", 0, name, 0);
+	so->sensor_ct = SEED_SENSORS;
+	so->sensor_locations = SV_CALLOC_N(SEED_SENSORS * 3, sizeof(FLT));
+	for (int i = 0; i < SEED_SENSORS; i++) {
+		LinmathVec3d dir = {rand() / (FLT)RAND_MAX - .5, rand() / (FLT)RAND_MAX - .5, rand() / (FLT)RAND_MAX - .5};
+		normalize3d(dir, dir);
+		scale3d(so->sensor_locations + i * 3, dir, .08);
+	}
+	so->has_sensor_locations = true;
+
+	obj->obj2world = (SurvivePose){.Pos = {.1, -.2, 1.1}, .Rot = {1, .1, -.2, .05}};
+	quatnormalize(obj->obj2world.Rot, obj->obj2world.Rot);
+
+	BaseStationCal cal[2] = {0};
+	SurviveSensorActivations *activations = &so->activations;
+	activations->lh_gen = 0;
+	activations->last_light = SEED_TIMECODE;
+	for (int lh = 0; lh < SEED_LIGHTHOUSES; lh++) {
+		SurvivePose world2lh = InvertPoseRtn(&seed_lighthouses[lh]);
+		for (int i = 0; i < SEED_SENSORS; i++) {
+			LinmathPoint3d in_world, in_lh;
+			ApplyPoseToPoint(in_world, &obj->obj2world, so->sensor_locations + i * 3);
+			ApplyPoseToPoint(in_lh, &world2lh, in_world);
+			survive_reproject_xy(cal, in_lh, activations->angles[i][lh]);
+			for (int axis = 0; axis < 2; axis++) {
+				activations->timecode[i][lh][axis] = SEED_TIMECODE;
+				if (lh < NUM_GEN1_LIGHTHOUSES)
+					activations->lengths[i][lh][axis] = 1000;
+			}
+		}
+	}
+}
+
+static PoserCB seed_poser() {
+	static PoserCB poser;
+	if (poser == 0)
+		poser = (PoserCB)GetDriver("PoserBaryCentricSVD");
+	return poser;
+}
+
+// The bench context is shared with other benches, so the seed lighthouses are swapped in around each run
+typedef struct seed_scene {
+	int lh_version, activeLighthouses;
+	BaseStationData bsd[SEED_LIGHTHOUSES];
+} seed_scene;
+
+static void seed_scene_push(SurviveContext *ctx, seed_scene *prior) {
+	prior->lh_version = ctx->lh_version;
+	prior->activeLighthouses = ctx->activeLighthouses;
+	memcpy(prior->bsd, ctx->bsd, sizeof(prior->bsd));
+
+	ctx->lh_version = 0;
+	ctx->activeLighthouses = SEED_LIGHTHOUSES;
+	for (int lh = 0; lh < SEED_LIGHTHOUSES; lh++) {
+		ctx->bsd[lh] = (BaseStationData){.PositionSet = 1, .OOTXSet = 1, .Pose = seed_lighthouses[lh]};
+	}
+}
+
+static void seed_scene_pop(SurviveContext *ctx, const seed_scene *prior) {
+	ctx->lh_version = prior->lh_version;
+	ctx->activeLighthouses = prior->activeLighthouses;
+	memcpy(ctx->bsd, prior->bsd, sizeof(prior->bsd));
+}
+
+/*
+ * Seeding an object that has lost track with four lighthouses in view, which is one pose solve per lighthouse. One op
+ * is one sync event given to the poser. 'threads' is the size of the context thread pool the solves are split across.
+ */
+static int bench_seed(survive_bench *b, seed_object *obj, const char *name, int threads) {
+	SurviveContext *ctx = survive_bench_context();
+	PoserCB poser = seed_poser();
+	if (poser == 0) {
+		snprintf(b->note, sizeof(b->note), "poser_barycentric_svd plugin not found");
+		return SURVIVE_BENCH_SKIP;
+	}
+
+	seed_scene prior;
+	seed_scene_push(ctx, &prior);
+
+	if (obj->so == 0)
+		setup_seed_object(ctx, obj, name);
+
+	struct survive_thread_pool *pool = survive_thread_pool_create(ctx, threads);
+	struct survive_thread_pool *ctx_pool = survive_install_thread_pool(ctx, pool);
+
+	PoserDataLight pd = {
+		.hdr = {.pt = POSERDATA_SYNC, .timecode = SEED_TIMECODE, .poseproc = record_pose, .userdata = obj},
+		.no_lighthouse_solve = true};
+
+	// The bench context is never started, so this thread already holds its lock the way the poser expects
+	obj->reports = 0;
+	poser(obj->so, &obj->poser_data, &pd.hdr);
+
+	int rtn = 0;
+	FLT err = dist3d(obj->reported.Pos, obj->obj2world.Pos);
+	if (obj->reports != 1 || !(err < 1e-3)) {
+		snprintf(b->note, sizeof(b->note), "seed pose is wrong; %d reports, %f off", obj->reports, err);
+		rtn = -1;
+	} else {
+		survive_bench_start(b);
+		for (uint64_t i = 0; i < b->iterations; i++) {
+			poser(obj->so, &obj->poser_data, &pd.hdr);
+		}
+		survive_bench_stop(b);
+	}
+
+	survive_install_thread_pool(ctx, ctx_pool);
+	survive_thread_pool_free(pool);
+	seed_scene_pop(ctx, &prior);
+	return rtn;
+}
+
+BENCHMARK(Seed, BaryCentricSVD) {
+	static seed_object obj;
+	return bench_seed(b, &obj, "SD0", 0);
+}
+
+BENCHMARK(Seed, BaryCentricSVDThreaded) {
+	static seed_object obj;
+	return bench_seed(b, &obj, "SD1", SEED_LIGHTHOUSES - 1);
+}
+
+/*
+ * The same object coming back after tracking dropped out, with its last good pose still recent enough to be checked
+ * against the light instead of running the seed poser. Compare with Seed/BaryCentricSVD.
+ */
+BENCHMARK(Seed, Cached) {
+	static seed_object obj;
+	SurviveContext *ctx = survive_bench_context();
+	if (seed_poser() == 0) {
+		snprintf(b->note, sizeof(b->note), "poser_barycentric_svd plugin not found");
+		return SURVIVE_BENCH_SKIP;
+	}
+
+	seed_scene prior;
+	seed_scene_push(ctx, &prior);
+	if (obj.so == 0)
+		setup_seed_object(ctx, &obj, "SD2");
+
+	GeneralOptimizerData opt;
+	general_optimizer_data_init(&opt, obj.so);
+	PoserDataLight pd = {.hdr = {.pt = POSERDATA_SYNC, .timecode = SEED_TIMECODE}};
+
+	// The first pose has nothing to go on and needs the seed poser; the one after a drop out shouldn't
+	SurvivePose seed = {0}, cached = {0};
+	general_optimizer_data_record_current_pose(&opt, &pd, &seed);
+	general_optimizer_data_record_success(&opt, 0, &obj.obj2world);
+	general_optimizer_data_record_current_pose(&opt, &pd, &cached);
+
+	int rtn = 0;
+	FLT err = dist3d(cached.Pos, obj.obj2world.Pos);
+	if (opt.stats.poser_seed_runs != 1 || opt.stats.seed_cache_hits != 1 || !(err < 1e-10)) {
+		snprintf(b->note, sizeof(b->note), "cache wasn't used; %d seed runs, %d hits, %f off", opt.stats.poser_seed_runs,
+				 opt.stats.seed_cache_hits, err);
+		rtn = -1;
+	} else {
+		survive_bench_start(b);
+		for (uint64_t i = 0; i < b->iterations; i++) {
+			general_optimizer_data_record_current_pose(&opt, &pd, &cached);
+		}
+		survive_bench_stop(b);
+	}
+
+	general_optimizer_data_dtor(&opt);
+	seed_scene_pop(ctx, &prior);
+	return rtn;
+}
+
+// Sensors of the first lighthouse whose readings are replaced as if the sweep had bounced off something
+#define REFLECTED_SENSORS 4
+
+/*
+ * One MPFIT solve of the seed scene, started a few centimeters off, with reflections in the light. 'ransac' runs the
+ * RANSAC pre-solve ahead of each solve, and 'loss' is the optimizer's loss. The counters give the solver iterations and
+ * how far the result ended up from the truth; with neither, the reflections pull it off.
+ */
+static int bench_reflections(survive_bench *b, seed_object *obj, const char *name, bool ransac,
+							 enum survive_optimizer_loss loss) {
+	SurviveContext *ctx = survive_bench_context();
+	seed_scene prior;
+	seed_scene_push(ctx, &prior);
+	if (obj->so == 0)
+		setup_seed_object(ctx, obj, name);
+	SurviveObject *so = obj->so;
+
+	survive_optimizer opt = {
+		.reprojectModel = survive_reproject_model(ctx), .poseLength = 1, .cameraLength = SEED_LIGHTHOUSES, .loss = loss};
+	SURVIVE_OPTIMIZER_SETUP_HEAP_BUFFERS(opt, so);
+	survive_optimizer_setup_cameras(&opt, ctx, true, 1);
+
+	SurvivePose start = obj->obj2world;
+	start.Pos[0] += .03;
+	start.Pos[2] -= .02;
+	survive_optimizer_setup_pose(&opt, &start, false, 1);
+
+	for (int lh = 0; lh < SEED_LIGHTHOUSES; lh++) {
+		for (int sensor = 0; sensor < SEED_SENSORS; sensor++) {
+			for (int axis = 0; axis < 2; axis++) {
+				FLT value = so->activations.angles[sensor][lh][axis];
+				if (lh == 0 && sensor < REFLECTED_SENSORS)
+					value += .1 * (axis ? -1 : 1);
+				opt.measurements[opt.measurementsCnt++] = (survive_optimizer_measurement){
+					.value = value, .variance = 1, .lh = lh, .sensor_idx = sensor, .axis = axis};
+			}
+		}
+	}
+
+	size_t param_cnt = survive_optimizer_get_parameters_count(&opt);
+	FLT *initial_parameters = malloc(sizeof(FLT) * param_cnt);
+	memcpy(initial_parameters, opt.parameters, sizeof(FLT) * param_cnt);
+
+	struct survive_optimizer_ransac *ransac_state = 0;
+	if (ransac) {
+		survive_configi(ctx, "optimizer-ransac-hypotheses", SC_OVERRIDE | SC_SET, 32);
+		ransac_state = survive_optimizer_ransac_create(so);
+		survive_configi(ctx, "optimizer-ransac-hypotheses", SC_OVERRIDE | SC_SET, 0);
+	}
+
+	uint64_t iterations = 0, failures = 0;
+	double pos_error = 0;
+	int rtn = 0;
+	for (uint64_t i = 0; i < b->iterations + 1 && rtn == 0; i++) {
+		// The first solve isn't timed; it checks that the pre-solve found exactly the reflections
+		if (i == 1)
+			survive_bench_start(b);
+
+		memcpy(opt.parameters, initial_parameters, sizeof(FLT) * param_cnt);
+		for (size_t m = 0; m < opt.measurementsCnt; m++)
+			opt.measurements[m].invalid = false;
+
+		if (ransac_state) {
+			int rejected = survive_optimizer_ransac_run(ransac_state, &opt);
+			bool reflections_rejected = true;
+			for (size_t m = 0; m < opt.measurementsCnt; m++) {
+				const survive_optimizer_measurement *meas = &opt.measurements[m];
+				reflections_rejected &= meas->invalid == (meas->lh == 0 && meas->sensor_idx < REFLECTED_SENSORS);
+			}
+			if (i == 0 && (rejected != REFLECTED_SENSORS * 2 || !reflections_rejected)) {
+				snprintf(b->note, sizeof(b->note), "%d measurements rejected, not the %d reflections", rejected,
+						 REFLECTED_SENSORS * 2);
+				rtn = -1;
+			}
+		}
+
+		struct mp_result_struct result = {0};
+		int status = survive_optimizer_run(&opt, &result);
+		if (i == 0) {
+			if (loss > SURVIVE_OPTIMIZER_LOSS_SQUARED && opt.stats.downweighted_meas_cnt < REFLECTED_SENSORS * 2) {
+				snprintf(b->note, sizeof(b->note), "%u measurements downweighted, fewer than the %d reflections",
+						 opt.stats.downweighted_meas_cnt, REFLECTED_SENSORS * 2);
+				rtn = -1;
+			}
+			continue;
+		}
+		iterations += result.niter;
+		if (status <= 0)
+			failures++;
+		pos_error += dist3d(survive_optimizer_get_pose(&opt)->Pos, obj->obj2world.Pos);
+	}
+	if (rtn == 0) {
+		survive_bench_stop(b);
+		survive_bench_counter(b, "iterations", (double)iterations / b->iterations);
+		survive_bench_counter(b, "pos_error_mm", pos_error / b->iterations * 1000.);
+		survive_bench_counter(b, "failures", (double)failures / b->iterations);
+	}
+
+	survive_optimizer_ransac_free(ransac_state);
+	free(initial_parameters);
+	free(opt.sos);
+	SURVIVE_OPTIMIZER_CLEANUP_HEAP_BUFFERS(opt);
+	seed_scene_pop(ctx, &prior);
+	return rtn;
+}
+
+BENCHMARK(Seed, ReflectionsMPFIT) {
+	static seed_object obj;
+	return bench_reflections(b, &obj, "SD3", false, SURVIVE_OPTIMIZER_LOSS_SQUARED);
+}
+
+BENCHMARK(Seed, ReflectionsRANSAC) {
+	static seed_object obj;
+	return bench_reflections(b, &obj, "SD4", true, SURVIVE_OPTIMIZER_LOSS_SQUARED);
+}
+
+BENCHMARK(Seed, ReflectionsHuber) {
+	static seed_object obj;
+	return bench_reflections(b, &obj, "SD5", false, SURVIVE_OPTIMIZER_LOSS_HUBER);
+}
+
+BENCHMARK(Seed, ReflectionsCauchy) {
+	static seed_object obj;
+	return bench_reflections(b, &obj, "SD6", false, SURVIVE_OPTIMIZER_LOSS_CAUCHY);
+}
@@ -0,0 +1,26 @@
+// Decoding of watchman light data packets; only built when the vive driver is.
+#include "bench.h"
+
+#include <string.h>
+
+#include "../../src/driver_vive.h"
+
+// Light packets captured from a watchman device; the same ones the watchman parsing test uses
+static uint8_t packet_short[] = {0xff, 0x09, 0x00, 0x04, 0x00, 0x38, 0xb8, 0xec, 0xe4, 0x9f};
+static uint8_t packet_long[] = {0x88, 0x81, 0xa1, 0x10, 0x00, 0xd3, 0x06, 0x93, 0x03, 0xa3, 0x06, 0xf3, 0x06,
+									  0x83, 0x01, 0xd6, 0x06, 0xe4, 0xa8, 0x0c, 0xd9, 0x07, 0xc1, 0x92, 0xd2};
+
+BENCHMARK(Watchman, ParseLightcap) {
+	LightcapElement les[16];
+
+	survive_bench_start(b);
+	for (uint64_t i = 0; i < b->iterations; i++) {
+		int cnt = (i & 1)
+					  ? parse_watchman_lightcap(0, "WW0", 224, 3761897504u, packet_long, sizeof(packet_long), les, 16)
+					  : parse_watchman_lightcap(0, "WW0", 0, 0, packet_short, sizeof(packet_short), les, 16);
+		survive_bench_use(les);
+		survive_bench_use(&cnt);
+	}
+	survive_bench_stop(b);
+	return 0;
+}
@@ -0,0 +1,641 @@
+// survive-rectool: streaming slice / filter / merge / convert for libsurvive recordings.
+//
+// Every input is read one event at a time and merged by timestamp, so memory use doesn't depend on the size of the
+// recordings. Inputs can be text recordings (as written by --record, optionally gzipped) or the binary format this
+// tool writes; the format is detected from the file contents.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <survive.h>
+
+#include "../../src/survive_gz.h"
+#include "../../src/survive_str.h"
+
+/*
+ * Binary format: the magic below followed by records of
+ *
+ *   double time, uint8_t kind, uint8_t dev_len, uint16_t body_len, char dev[dev_len], uint8_t body[body_len]
+ *
+ * in host byte order. High rate events are stored as packed fields; everything else -- and any line whose fields
+ * wouldn't format back to exactly the same text -- is stored as the original line. Converting to binary and back is
+ * lossless.
+ */
+static const char rectool_magic[8] = {'S', 'V', 'R', 'E', 'C', 'B', '1', '\n'};
+
+enum rectool_kind {
+	REC_TEXT = 0,
+	REC_SWEEP = 1,
+	REC_SWEEP_ANGLE = 2,
+	REC_SYNC = 3,
+	REC_IMU = 4,
+	REC_RAW_IMU = 5,
+};
+
+#pragma pack(push, 1)
+typedef struct rectool_header {
+	double time;
+	uint8_t kind;
+	uint8_t dev_len;
+	uint16_t body_len;
+} rectool_header;
+
+typedef struct rectool_sweep {
+	uint8_t channel;
+	int32_t sensor_id;
+	uint32_t timecode;
+	uint8_t flag;
+} rectool_sweep;
+
+typedef struct rectool_sweep_angle {
+	uint8_t channel;
+	int32_t sensor_id;
+	uint32_t timecode;
+	int8_t plane;
+	double angle;
+} rectool_sweep_angle;
+
+typedef struct rectool_sync {
+	uint8_t channel;
+	uint32_t timecode;
+	uint8_t ootx;
+	uint8_t gen;
+} rectool_sync;
+
+typedef struct rectool_imu {
+	int32_t mask;
+	uint32_t timecode;
+	double accelgyro[9];
+	int32_t id;
+} rectool_imu;
+#pragma pack(pop)
+
+typedef struct rectool_event {
+	double time;
+	enum rectool_kind kind;
+	char dev[32];
+	// The op of the line, or OPTION for config option lines
+	char type[32];
+
+	union {
+		rectool_sweep sweep;
+		rectool_sweep_angle sweep_angle;
+		rectool_sync sync;
+		rectool_imu imu;
+	} v;
+
+	// The full line including its line ending; always valid for text input and for REC_TEXT events
+	cstring text;
+	bool has_text;
+} rectool_event;
+
+typedef struct rectool_input {
+	const char *path;
+	gzFile f;
+	bool binary;
+	bool done;
+	rectool_event ev;
+	cstring scratch;
+	// Where typed events are formatted back to text, to check they round trip
+	cstring check;
+} rectool_input;
+
+#define MAX_FILTERS 32
+typedef struct rectool_options {
+	double start, end;
+	bool binary_output;
+	const char *output;
+
+	const char *devices[MAX_FILTERS];
+	int device_count;
+	const char *types[MAX_FILTERS];
+	int type_count;
+	const char *drop_types[MAX_FILTERS];
+	int drop_type_count;
+} rectool_options;
+
+static bool rectool_read_text_line(gzFile f, cstring *line) {
+	str_clear(line);
+	for (;;) {
+		str_ensure_size(line, line->length + 1024);
+		if (gzgets(f, line->d + line->length, (int)(line->size - line->length)) == 0)
+			break;
+		line->length += strlen(line->d + line->length);
+		if (line->length > 0 && line->d[line->length - 1] == '\n')
+			break;
+	}
+	return line->length > 0;
+}
+
+static void rectool_copy_token(char *dst, size_t len, const char *token) {
+	snprintf(dst, len, "%s", token ? token : "");
+}
+
+// Formats the packed fields of an event the same way the recorder writes them
+static void rectool_format_typed(const rectool_event *ev, cstring *out) {
+	char buf[STR_FORMAT_BUFFER_SIZE];
+	str_clear(out);
+
+#define APPEND_NUM(fn, ...)                                                                                            \
+	fn(buf, __VA_ARGS__);                                                                                              \
+	str_append(out, buf)
+
+	APPEND_NUM(str_format_fixed, ev->time, 6);
+	str_append(out, " ");
+	str_append(out, ev->dev);
+
+	switch (ev->kind) {
+	case REC_SWEEP:
+		str_append(out, " W ");
+		APPEND_NUM(str_format_uint, ev->v.sweep.channel);
+		str_append(out, " ");
+		APPEND_NUM(str_format_int, ev->v.sweep.sensor_id);
+		str_append(out, " ");
+		APPEND_NUM(str_format_uint, ev->v.sweep.timecode);
+		str_append(out, " ");
+		APPEND_NUM(str_format_uint, ev->v.sweep.flag);
+		str_append(out, "\n");
+		break;
+	case REC_SWEEP_ANGLE:
+		str_append(out, " B ");
+		APPEND_NUM(str_format_uint, ev->v.sweep_angle.channel);
+		str_append(out, " ");
+		APPEND_NUM(str_format_uint, (uint32_t)ev->v.sweep_angle.sensor_id);
+		str_append(out, " ");
+		APPEND_NUM(str_format_uint, ev->v.sweep_angle.timecode);
+		str_append(out, " ");
+		APPEND_NUM(str_format_int, ev->v.sweep_angle.plane);
+		str_append(out, " ");
+		APPEND_NUM(str_format_exp, ev->v.sweep_angle.angle, 6, true);
+		str_append(out, "\n");
+		break;
+	case REC_SYNC:
+		str_append(out, " Y ");
+		APPEND_NUM(str_format_uint, ev->v.sync.channel);
+		str_append(out, " ");
+		APPEND_NUM(str_format_uint, ev->v.sync.timecode);
+		str_append(out, " ");
+		APPEND_NUM(str_format_uint, ev->v.sync.ootx);
+		str_append(out, " ");
+		APPEND_NUM(str_format_uint, ev->v.sync.gen);
+		str_append(out, "\n");
+		break;
+	case REC_IMU:
+	case REC_RAW_IMU:
+		str_append(out, ev->kind == REC_IMU ? " I " : " i ");
+		APPEND_NUM(str_format_int, ev->v.imu.mask);
+		str_append(out, " ");
+		APPEND_NUM(str_format_uint, ev->v.imu.timecode);
+		str_append(out, " ");
+		for (int i = 0; i < 9; i++) {
+			if (i == 6)
+				str_append(out, " ");
+			APPEND_NUM(str_format_fixed, ev->v.imu.accelgyro[i], 6);
+			str_append(out, " ");
+		}
+		APPEND_NUM(str_format_int, ev->v.imu.id);
+		str_append(out, "\r\n");
+		break;
+	default:
+		break;
+	}
+#undef APPEND_NUM
+}
+
+static int rectool_parse_ints(char **cursor, int64_t *out, int count) {
+	for (int i = 0; i < count; i++) {
+		char *token = str_next_token(cursor);
+		if (token == 0 || !str_parse_int(token, &out[i]))
+			return i;
+	}
+	return count;
+}
+
+/*
+ * Fills in the packed fields for the op types that have them. Returns false if the line isn't one of those or
+ * doesn't survive a round trip through the packed form, in which case the event stays as text.
+ */
+static bool rectool_parse_typed(rectool_event *ev, char *cursor, cstring *scratch) {
+	int64_t v[4];
+	if (ev->type[1] != 0)
+		return false;
+
+	switch (ev->type[0]) {
+	case 'W':
+		if (rectool_parse_ints(&cursor, v, 4) != 4)
+			return false;
+		ev->kind = REC_SWEEP;
+		ev->v.sweep = (rectool_sweep){
+			.channel = (uint8_t)v[0], .sensor_id = (int32_t)v[1], .timecode = (uint32_t)v[2], .flag = (uint8_t)v[3]};
+		break;
+	case 'B': {
+		char *angle = 0;
+		if (rectool_parse_ints(&cursor, v, 4) != 4 || (angle = str_next_token(&cursor)) == 0)
+			return false;
+		ev->kind = REC_SWEEP_ANGLE;
+		ev->v.sweep_angle = (rectool_sweep_angle){
+			.channel = (uint8_t)v[0], .sensor_id = (int32_t)v[1], .timecode = (uint32_t)v[2], .plane = (int8_t)v[3]};
+		if (!str_parse_double(angle, &ev->v.sweep_angle.angle))
+			return false;
+		break;
+	}
+	case 'Y':
+		if (rectool_parse_ints(&cursor, v, 4) != 4)
+			return false;
+		ev->kind = REC_SYNC;
+		ev->v.sync = (rectool_sync){
+			.channel = (uint8_t)v[0], .timecode = (uint32_t)v[1], .ootx = (uint8_t)v[2], .gen = (uint8_t)v[3]};
+		break;
+	case 'I':
+	case 'i': {
+		if (rectool_parse_ints(&cursor, v, 2) != 2)
+			return false;
+		ev->kind = ev->type[0] == 'I' ? REC_IMU : REC_RAW_IMU;
+		ev->v.imu.mask = (int32_t)v[0];
+		ev->v.imu.timecode = (uint32_t)v[1];
+		for (int i = 0; i < 9; i++) {
+			char *token = str_next_token(&cursor);
+			if (token == 0 || !str_parse_double(token, &ev->v.imu.accelgyro[i]))
+				return false;
+		}
+		if (rectool_parse_ints(&cursor, v, 1) != 1)
+			return false;
+		ev->v.imu.id = (int32_t)v[0];
+		break;
+	}
+	default:
+		return false;
+	}
+
+	rectool_format_typed(ev, scratch);
+	return scratch->length == ev->text.length && memcmp(scratch->d, ev->text.d, scratch->length) == 0;
+}
+
+static bool rectool_read_text(rectool_input *in, bool want_typed) {
+	rectool_event *ev = &in->ev;
+	while (rectool_read_text_line(in->f, &ev->text)) {
+		// Tokenize a copy so the original line can be passed through untouched
+		str_clear(&in->scratch);
+		str_append_n(&in->scratch, ev->text.d, ev->text.length);
+		in->scratch.d[in->scratch.length] = 0;
+
+		char *cursor = in->scratch.d;
+		const char *time_str = str_next_token(&cursor);
+		const char *dev = time_str ? str_next_token(&cursor) : 0;
+		const char *op = dev ? str_next_token(&cursor) : 0;
+		if (op == 0 || !str_parse_double(time_str, &ev->time)) {
+			fprintf(stderr, "%s: skipping unreadable line '%.*s'\n", in->path, (int)ev->text.length, ev->text.d);
+			continue;
+		}
+
+		rectool_copy_token(ev->dev, sizeof(ev->dev), dev);
+		rectool_copy_token(ev->type, sizeof(ev->type), strcmp(dev, "OPTION") == 0 ? dev : op);
+		ev->has_text = true;
+		ev->kind = REC_TEXT;
+
+		if (want_typed && !rectool_parse_typed(ev, cursor, &in->check))
+			ev->kind = REC_TEXT;
+		return true;
+	}
+	return false;
+}
+
+static bool rectool_read_binary(rectool_input *in) {
+	rectool_event *ev = &in->ev;
+	rectool_header hdr;
+	int r = gzread(in->f, &hdr, sizeof(hdr));
+	if (r == 0)
+		return false;
+
+	char dev[256];
+	if (r != sizeof(hdr) || gzread(in->f, dev, hdr.dev_len) != hdr.dev_len) {
+		fprintf(stderr, "%s: truncated record\n", in->path);
+		return false;
+	}
+	dev[hdr.dev_len] = 0;
+
+	ev->time = hdr.time;
+	ev->kind = hdr.kind;
+	ev->has_text = false;
+	rectool_copy_token(ev->dev, sizeof(ev->dev), dev);
+
+	size_t expected = 0;
+	void *dst = &ev->v;
+	switch (ev->kind) {
+	case REC_TEXT:
+		str_clear(&ev->text);
+		dst = str_increase_by(&ev->text, hdr.body_len);
+		expected = hdr.body_len;
+		ev->has_text = true;
+		break;
+	case REC_SWEEP:
+		expected = sizeof(rectool_sweep);
+		break;
+	case REC_SWEEP_ANGLE:
+		expected = sizeof(rectool_sweep_angle);
+		break;
+	case REC_SYNC:
+		expected = sizeof(rectool_sync);
+		break;
+	case REC_IMU:
+	case REC_RAW_IMU:
+		expected = sizeof(rectool_imu);
+		break;
+	default:
+		fprintf(stderr, "%s: unknown record kind %d\n", in->path, ev->kind);
+		return false;
+	}
+
+	if (expected != hdr.body_len || gzread(in->f, dst, hdr.body_len) != hdr.body_len) {
+		fprintf(stderr, "%s: truncated record\n", in->path);
+		return false;
+	}
+
+	if (ev->kind == REC_TEXT) {
+		ev->text.d[ev->text.length] = 0;
+
+		str_clear(&in->scratch);
+		str_append_n(&in->scratch, ev->text.d, ev->text.length);
+		in->scratch.d[in->scratch.length] = 0;
+
+		char *cursor = in->scratch.d;
+		const char *time_str = str_next_token(&cursor);
+		const char *line_dev = time_str ? str_next_token(&cursor) : 0;
+		const char *op = line_dev ? str_next_token(&cursor) : 0;
+		rectool_copy_token(ev->type, sizeof(ev->type),
+						   line_dev && strcmp(line_dev, "OPTION") == 0 ? line_dev : op ? op : "");
+	} else {
+		static const char *types[] = {"", "W", "B", "Y", "I", "i"};
+		rectool_copy_token(ev->type, sizeof(ev->type), types[ev->kind]);
+	}
+	return true;
+}
+
+static bool rectool_next(rectool_input *in, bool want_typed) {
+	if (in->done)
+		return false;
+	bool ok = in->binary ? rectool_read_binary(in) : rectool_read_text(in, want_typed);
+	if (!ok)
+		in->done = true;
+	return ok;
+}
+
+static bool rectool_open(rectool_input *in, const char *path) {
+	in->path = path;
+	in->f = strcmp(path, "-") == 0 ? gzdopen(0, "rb") : gzopen(path, "rb");
+	if (in->f == 0) {
+		fprintf(stderr, "Could not open %s\n", path);
+		return false;
+	}
+
+	char magic[sizeof(rectool_magic)] = {0};
+	int r = gzread(in->f, magic, sizeof(magic));
+	in->binary = r == sizeof(magic) && memcmp(magic, rectool_magic, sizeof(magic)) == 0;
+	if (!in->binary)
+		gzrewind(in->f);
+	return true;
+}
+
+// Is the line global rather than tied to a device? These are kept by device filters.
+static bool rectool_is_global(const rectool_event *ev) {
+	return strcmp(ev->dev, "OPTION") == 0 || strcmp(ev->dev, "INFO") == 0 || strcmp(ev->type, "LH_POSE") == 0;
+}
+
+static bool rectool_in_list(const char *s, const char *const *list, int count) {
+	for (int i = 0; i < count; i++) {
+		if (strcmp(s, list[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+static bool rectool_passes_filters(const rectool_options *opts, const rectool_event *ev) {
+	if (opts->device_count && !rectool_is_global(ev) && !rectool_in_list(ev->dev, opts->devices, opts->device_count))
+		return false;
+	if (opts->type_count && !rectool_in_list(ev->type, opts->types, opts->type_count))
+		return false;
+	if (rectool_in_list(ev->type, opts->drop_types, opts->drop_type_count))
+		return false;
+	return true;
+}
+
+/*
+ * Writes the event, retimed to 'time' if that differs from its own timestamp. Retiming only happens to setup lines from
+ * before a --start, which are always text.
+ */
+static void rectool_write(gzFile out, bool binary, rectool_event *ev, double time, cstring *scratch) {
+	const cstring *text = &ev->text;
+	if (time != ev->time && ev->has_text) {
+		char buf[STR_FORMAT_BUFFER_SIZE];
+		const char *rest = memchr(ev->text.d, ' ', ev->text.length);
+		size_t rest_len = rest ? ev->text.length - (rest - ev->text.d) : 0;
+
+		str_clear(scratch);
+		str_format_fixed(buf, time, 6);
+		str_append(scratch, buf);
+		str_append_n(scratch, rest, rest_len);
+		text = scratch;
+	}
+
+	if (!binary) {
+		if (ev->has_text) {
+			gzwrite(out, text->d, (unsigned)text->length);
+		} else {
+			rectool_format_typed(ev, scratch);
+			gzwrite(out, scratch->d, (unsigned)scratch->length);
+		}
+		return;
+	}
+
+	size_t dev_len = strlen(ev->dev);
+	rectool_header hdr = {.time = time, .kind = ev->kind, .dev_len = (uint8_t)dev_len};
+	const void *body = &ev->v;
+	switch (ev->kind) {
+	case REC_TEXT:
+		body = text->d;
+		hdr.body_len = (uint16_t)text->length;
+		if (text->length > UINT16_MAX) {
+			fprintf(stderr, "Dropping %s line longer than %d bytes from binary output\n", ev->type, UINT16_MAX);
+			return;
+		}
+		break;
+	case REC_SWEEP:
+		hdr.body_len = sizeof(rectool_sweep);
+		break;
+	case REC_SWEEP_ANGLE:
+		hdr.body_len = sizeof(rectool_sweep_angle);
+		break;
+	case REC_SYNC:
+		hdr.body_len = sizeof(rectool_sync);
+		break;
+	case REC_IMU:
+	case REC_RAW_IMU:
+		hdr.body_len = sizeof(rectool_imu);
+		break;
+	}
+
+	gzwrite(out, &hdr, sizeof(hdr));
+	gzwrite(out, ev->dev, (unsigned)dev_len);
+	gzwrite(out, body, hdr.body_len);
+}
+
+// Min-heap of input indices ordered by the time of their pending event; ties go to the earlier input
+typedef struct rectool_heap {
+	rectool_input *inputs;
+	int *idx;
+	int count;
+} rectool_heap;
+
+static bool rectool_heap_less(const rectool_heap *h, int a, int b) {
+	double ta = h->inputs[h->idx[a]].ev.time, tb = h->inputs[h->idx[b]].ev.time;
+	return ta < tb || (ta == tb && h->idx[a] < h->idx[b]);
+}
+
+static void rectool_heap_sift_down(rectool_heap *h, int i) {
+	for (;;) {
+		int smallest = i, l = 2 * i + 1, r = 2 * i + 2;
+		if (l < h->count && rectool_heap_less(h, l, smallest))
+			smallest = l;
+		if (r < h->count && rectool_heap_less(h, r, smallest))
+			smallest = r;
+		if (smallest == i)
+			return;
+		int t = h->idx[i];
+		h->idx[i] = h->idx[smallest];
+		h->idx[smallest] = t;
+		i = smallest;
+	}
+}
+
+static void rectool_usage(const char *name) {
+	fprintf(stderr,
+			"Usage: %s [options] <input>...\n"
+			"Slices, filters and merges libsurvive recordings in one streaming pass.\n"
+			"Multiple inputs are merged in timestamp order. '-' reads from stdin.\n\n"
+			"  -o <file>             Output file; '.gz' names are compressed. Defaults to stdout.\n"
+			"  --binary              Write the binary event format instead of text.\n"
+			"  --start <s>           Drop events before this time. Configs and options from before it are kept,\n"
+			"                        retimed to the start so the slice plays back on its own.\n"
+			"  --end <s>             Drop events after this time.\n"
+			"  --device <name>       Only keep events from this device; repeatable. Global lines are kept.\n"
+			"  --type <op>           Only keep this event type (W, B, Y, I, i, POSE, CONFIG, OPTION, ...); repeatable.\n"
+			"  --drop-type <op>      Drop this event type; repeatable.\n",
+			name);
+}
+
+static bool rectool_add_filter(const char **list, int *count, const char *value) {
+	if (*count >= MAX_FILTERS) {
+		fprintf(stderr, "Too many filters; at most %d of each kind are supported\n", MAX_FILTERS);
+		return false;
+	}
+	list[(*count)++] = value;
+	return true;
+}
+
+int main(int argc, char **argv) {
+	rectool_options opts = {.start = -INFINITY, .end = INFINITY};
+	// Every argument is at most one path
+	const char **paths = SV_CALLOC(argc * sizeof(const char *));
+	int path_count = 0;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (strcmp(arg, "-o") == 0 && has_value) {
+			opts.output = argv[++i];
+		} else if (strcmp(arg, "--binary") == 0) {
+			opts.binary_output = true;
+		} else if (strcmp(arg, "--start") == 0 && has_value) {
+			opts.start = atof(argv[++i]);
+		} else if (strcmp(arg, "--end") == 0 && has_value) {
+			opts.end = atof(argv[++i]);
+		} else if (strcmp(arg, "--device") == 0 && has_value) {
+			if (!rectool_add_filter(opts.devices, &opts.device_count, argv[++i]))
+				return -1;
+		} else if (strcmp(arg, "--type") == 0 && has_value) {
+			if (!rectool_add_filter(opts.types, &opts.type_count, argv[++i]))
+				return -1;
+		} else if (strcmp(arg, "--drop-type") == 0 && has_value) {
+			if (!rectool_add_filter(opts.drop_types, &opts.drop_type_count, argv[++i]))
+				return -1;
+		} else if (arg[0] == '-' && arg[1] != 0) {
+			rectool_usage(argv[0]);
+			return -1;
+		} else {
+			paths[path_count++] = arg;
+		}
+	}
+
+	if (path_count == 0) {
+		rectool_usage(argv[0]);
+		return -1;
+	}
+
+	gzFile out = 0;
+	if (opts.output) {
+		size_t len = strlen(opts.output);
+		bool compress = len > 3 && strcmp(opts.output + len - 3, ".gz") == 0;
+		out = gzopen(opts.output, compress ? "wb6" : "wbT");
+	} else {
+		out = gzdopen(1, "wbT");
+	}
+	if (out == 0) {
+		fprintf(stderr, "Could not open %s for writing\n", opts.output ? opts.output : "stdout");
+		return -1;
+	}
+	if (opts.binary_output)
+		gzwrite(out, rectool_magic, sizeof(rectool_magic));
+
+	rectool_input *inputs = SV_CALLOC(path_count * sizeof(rectool_input));
+	rectool_heap heap = {.inputs = inputs, .idx = SV_CALLOC(path_count * sizeof(int))};
+	for (int i = 0; i < path_count; i++) {
+		if (!rectool_open(&inputs[i], paths[i]))
+			return -1;
+		if (rectool_next(&inputs[i], opts.binary_output))
+			heap.idx[heap.count++] = i;
+	}
+	for (int i = heap.count / 2 - 1; i >= 0; i--)
+		rectool_heap_sift_down(&heap, i);
+
+	cstring scratch = {0};
+	size_t read = 0, written = 0;
+	while (heap.count > 0) {
+		rectool_input *in = &inputs[heap.idx[0]];
+		rectool_event *ev = &in->ev;
+		read++;
+
+		if (ev->time > opts.end) {
+			// Recordings are in time order, so nothing more from this input can pass
+			in->done = true;
+		} else if (rectool_passes_filters(&opts, ev)) {
+			// Configs and options from before the slice are still needed to play the slice back
+			bool is_setup = strcmp(ev->type, "CONFIG") == 0 || strcmp(ev->type, "OPTION") == 0;
+			if (ev->time >= opts.start) {
+				rectool_write(out, opts.binary_output, ev, ev->time, &scratch);
+				written++;
+			} else if (is_setup) {
+				rectool_write(out, opts.binary_output, ev, opts.start, &scratch);
+				written++;
+			}
+		}
+
+		if (!rectool_next(in, opts.binary_output)) {
+			heap.idx[0] = heap.idx[--heap.count];
+		}
+		rectool_heap_sift_down(&heap, 0);
+	}
+
+	fprintf(stderr, "Read %zu events, wrote %zu\n", read, written);
+
+	for (int i = 0; i < path_count; i++) {
+		gzclose(inputs[i].f);
+		str_free(&inputs[i].ev.text);
+		str_free(&inputs[i].scratch);
+		str_free(&inputs[i].check);
+	}
+	str_free(&scratch);
+	free(paths);
+	free(heap.idx);
+	free(inputs);
+	return gzclose(out) == 0 ? 0 : -1;
+}